@@ -58,8 +58,16 @@ struct input_args {
     int cars; // sold cars per year
     int plant; // number of plant lines
     int truck; // number of truck drivers
+    long seed; // random seed
 } input_args;
 
+// Random streams of model parts (the same seed gives the same car sales
+// and lifetimes for any number of plant lines or truck drivers)
+RandomStream car_stream;
+RandomStream life_stream;
+RandomStream truck_stream;
+RandomStream plant_stream;
+
 // Call truck driver when there are 6 batteries to carry
 Facility Notification("Notification");
 
@@ -77,51 +85,56 @@ Histogram car_gen("Car output",  0, YEAR, 20);
 /**
  * @brief Recycling batteries plant.
  */
-class PlantProcessing: public Process{
+class PlantProcessing: public StepProcess{
     void Behavior() {
-        Enter(Plant, 1);
-        Wait(Uniform(8 * HOUR, 12 * HOUR));
+        STEP_BEGIN;
+        STEP_AWAIT(Enter(Plant, 1));
+        STEP_AWAIT(Wait(Uniform(plant_stream, 8 * HOUR, 12 * HOUR)));
         batteries_on_plant--;
         batteries_processed++;
         co2_output -= PLANT_EMISSION;
         Leave(Plant, 1);
+        STEP_END;
     }
 };
 
 /**
  * @brief Ride from the plant to dismantling centre and return.
  */
-class TruckRide : public Process{
+class TruckRide : public StepProcess{
+    double start_trip;
+    int i;
+
     void Behavior() {
-        Enter(Truck, 1);
+        STEP_BEGIN;
+        STEP_AWAIT(Enter(Truck, 1));
         battery_pack--;
         batteries_in_trip += 6;
 
-        double start_trip = Time;
-        Wait(Uniform(0.5 * HOUR, 3.5 * HOUR));
-        double end_trip = Time;
-        co2_output += (end_trip - start_trip) / 60 * EMISSION;
-        co2_truck += (end_trip - start_trip) / 60 * EMISSION;
+        start_trip = Time;
+        STEP_AWAIT(Wait(Uniform(truck_stream, 0.5 * HOUR, 3.5 * HOUR)));
+        co2_output += (Time - start_trip) / 60 * EMISSION;
+        co2_truck += (Time - start_trip) / 60 * EMISSION;
 
         // Batteries loading
-        Wait(Exponential(1 * HOUR));  
+        STEP_AWAIT(Wait(Exponential(truck_stream, 1 * HOUR)));
 
         // Trip from dismantling centre to the plant
         start_trip = Time;
-        Wait(Uniform(0.75 * HOUR, 5.25 * HOUR));
-        end_trip = Time;
-        co2_output += (end_trip - start_trip) / 60 * EMISSION;
-        co2_truck += (end_trip - start_trip) / 60 * EMISSION;
+        STEP_AWAIT(Wait(Uniform(truck_stream, 0.75 * HOUR, 5.25 * HOUR)));
+        co2_output += (Time - start_trip) / 60 * EMISSION;
+        co2_truck += (Time - start_trip) / 60 * EMISSION;
 
         batteries_in_trip-=6;
         // Batteries unloading
-        for (int i = 0; i < 6; i++) {
-            Wait(Exponential(15 * MINUTE));
+        for (i = 0; i < 6; i++) {
+            STEP_AWAIT(Wait(Exponential(truck_stream, 15 * MINUTE)));
             batteries_on_plant ++;
             (new PlantProcessing)->Activate();
         }
 
         Leave(Truck, 1);
+        STEP_END;
     }
 };
 
@@ -165,7 +178,7 @@ class Battery : public Process {
         // Battery End-of-life
         car++;
         double car_life = Time;
-        Wait(Uniform(7 * YEAR, 10 * YEAR));
+        Wait(Uniform(life_stream, 7 * YEAR, 10 * YEAR));
         batteries_sum++;
         batteries_dead++;
         car_hist(Time - car_life);
@@ -201,7 +214,7 @@ class Workshift : public Event {
 class Generator : public Event {
     void Behavior() {
         (new Battery)->Activate();
-        Activate(Time + Exponential(YEAR / input_args.cars));
+        Activate(Time + Exponential(car_stream, YEAR / input_args.cars));
         car_gen(Time);
     }
 };
@@ -213,19 +226,21 @@ void print_help()
 		<< "\t-t or --time : Simulation time in years\n"
 		<< "\t-c or --cars : Number of cars sold per year\n"
 		<< "\t-p or --plant : Number of lines in the plant\n"
-        << "\t-d or --driver : Number of truck drivers\n";
+        << "\t-d or --driver : Number of truck drivers\n"
+        << "\t-s or --seed : Random seed (common random numbers for scenarios)\n";
 }
 
 int parse_arguments(int argc, char **argv) {
     int opt;
 	char *err;
-	static const char *short_opts = "t:c:p:d:";
+	static const char *short_opts = "t:c:p:d:s:";
 	static const struct option long_opts[] = {
         {"help", required_argument, nullptr, 'h'},
 		{"time", required_argument, nullptr, 't'},
 		{"cars", required_argument, nullptr, 'c'},
 		{"plant", required_argument, nullptr, 'p'},
         {"driver", required_argument, nullptr, 'd'},
+        {"seed", required_argument, nullptr, 's'},
 		{nullptr, 0, nullptr, 0},
 	};
 
@@ -233,6 +248,7 @@ int parse_arguments(int argc, char **argv) {
     input_args.time = 1;
     input_args.plant = 1;
     input_args.truck = 1;
+    input_args.seed = time(NULL);
 
     while ((opt = getopt_long(argc, argv, short_opts, long_opts, nullptr)) != -1) {
 		switch (opt) {
@@ -271,6 +287,14 @@ int parse_arguments(int argc, char **argv) {
 				}
 				break;
 
+            case 's':
+				input_args.seed = strtol(optarg, &err, 10);
+				if (*err != '\0') {
+					std::cerr << "Random seed must be an integer.\n";
+					return EXIT_FAILURE;
+				}
+				break;
+
             case 'h':
                 print_help();
                 return EXIT_SUCCESS;
@@ -293,7 +317,11 @@ int main(int argc, char*argv[]) {
     Plant.SetCapacity(input_args.plant);
     Truck.SetCapacity(input_args.truck);
 
-    RandomSeed(time(NULL));
+    RandomSeed(input_args.seed);
+    car_stream = RandomStream(input_args.seed, 0);
+    life_stream = RandomStream(input_args.seed, 1);
+    truck_stream = RandomStream(input_args.seed, 2);
+    plant_stream = RandomStream(input_args.seed, 3);
     Init(0, input_args.time * YEAR); // simulation time
 
     (new Workshift)->Activate();
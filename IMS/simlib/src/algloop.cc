@@ -14,6 +14,7 @@
 #include "simlib.h"
 #include "internal.h"
 
+#include <cfloat>
 #include <cmath>
 
 //#define LOOP_DEBUG
@@ -505,6 +506,199 @@ double Newton::Value()
   return root;
 } // Newton::Value
 
+
+////////////////////////////////////////////////////////////////////////////
+// AlgLoopSystem  --  coupled loops x = g(x), Newton's method:
+//
+//   (I - dg/dx) dx = g(x) - x,   x += lambda*dx
+//
+// lambda is halved while the residual max|x-g(x)| grows (at most 4 times).
+// Inputs of variables are compiled to separate evaluation tape, loop
+// variables of the system are its leaves (the loops are broken there).
+// The solution is checked at each Value() call: it is computed again only
+// if the residual of the last solution (warm start) exceeds Eps.
+//
+AlgLoopSystem::AlgLoopSystem(double eps, unsigned long max_it) :
+  tape(0),
+  lu(0),
+  built(0),
+  compiled(false),
+  compiling(false),
+  solving(false),
+  Eps(eps),
+  MaxIt(max_it),
+  iterations(0)
+{
+}
+
+AlgLoopSystem::~AlgLoopSystem()
+{
+  delete tape;
+  delete lu;
+}
+
+void AlgLoopSystem::Set(double eps, unsigned long max_it)
+{
+  Eps=eps;
+  MaxIt=max_it;
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+// AlgLoopSystem::Compile  --  compile inputs of all variables
+//
+void AlgLoopSystem::Compile()
+{
+  const std::size_t n = var.size();
+  dbgprnt(("AlgLoopSystem::Compile(), n = %lu\n", (unsigned long)n));
+  if(tape==0) tape = new EvaluationTape;
+  if(lu==0) lu = new LUDecomposition;
+  g.assign(n, 0);                       // tape stores results here
+  dx.assign(n, 0);
+  x0.assign(n, 0);
+  J.assign(n*n, 0);
+  compiling=true;
+  tape->Clear();
+  for(std::size_t i=0; i<n; i++)
+    tape->Store(tape->Compile(var[i]->input), &g[i]);
+  compiling=false;
+  built = EvaluationTape::Builds();
+  compiled=true;
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+// AlgLoopSystem::Residual  --  g(x) and max |x-g(x)|
+//
+double AlgLoopSystem::Residual()
+{
+  tape->Run();
+  double r=0;
+  for(std::size_t i=0; i<x.size(); i++)
+    r = max(r, fabs(x[i]-g[i]));
+  return r;
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+// AlgLoopSystem::Linearize  --  Jacobian dg/dx in x (after Residual)
+//
+void AlgLoopSystem::Linearize()
+{
+  const std::size_t n = x.size();
+  if(tape->Linearize(&x[0], n, &g[0], &J[0], 0))
+    return;                             // forward mode derivatives
+  // differences (inputs contain blocks evaluated by Value())
+  for(std::size_t i=0; i<n; i++)
+    x0[i]=g[i];
+  for(std::size_t j=0; j<n; j++) {
+    double xj = x[j];
+    double h = sqrt(DBL_EPSILON) * max(fabs(xj), 1e-3);
+    x[j] = xj + h;
+    h = x[j] - xj;                      // exact difference
+    tape->Run();
+    for(std::size_t i=0; i<n; i++)
+      J[i*n+j] = (g[i] - x0[i]) / h;
+    x[j] = xj;
+  }
+  for(std::size_t i=0; i<n; i++)
+    g[i]=x0[i];
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+// AlgLoopSystem::Solve  --  Newton's method from last solution
+//
+void AlgLoopSystem::Solve()
+{
+  if(!compiled || !SIMLIB_TapeValid || built != EvaluationTape::Builds())
+    Compile();                          // connections changed
+  const std::size_t n = x.size();
+  unsigned long count=0;                // counter of iterations
+  solving=true;
+  double r = Residual();
+  while(r > Eps) {
+    if(count>=MaxIt) {
+      SIMLIB_warning(AL_MaxCount);
+      break;
+    }
+    count++;
+    Linearize();
+    double *m = lu->Matrix(n);
+    for(std::size_t i=0; i<n*n; i++)
+      m[i] = -J[i];
+    for(std::size_t i=0; i<n; i++) {
+      m[i*n+i] += 1.0;
+      dx[i] = g[i]-x[i];
+      x0[i] = x[i];
+    }
+    if(lu->Factor())
+      lu->Solve(&dx[0]);
+    else
+      SIMLIB_warning(AL_SingularJacobian); // dx = g(x)-x
+    double lambda=1.0;
+    for(int k=0; ; k++) {               // damping
+      for(std::size_t i=0; i<n; i++)
+        x[i] = x0[i] + lambda*dx[i];
+      double rn = Residual();
+      if(rn < r || k==4) {
+        r = rn;
+        break;
+      }
+      lambda *= 0.5;
+    }
+    dbgprnt(("AlgLoopSystem: iteration %lu, residual %g\n", count, r));
+  }
+  iterations += count;
+  solving=false;
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+// LoopVariable  --  constructors, destructor
+//
+LoopVariable::LoopVariable(AlgLoopSystem &s, double x0) :
+  LoopVariable(s, 0.0, x0)
+{
+}
+
+LoopVariable::LoopVariable(AlgLoopSystem &s, Input i, double x0) :
+  system(s),
+  index(s.var.size()),
+  input(i)
+{
+  s.var.push_back(this);
+  s.x.push_back(x0);
+  s.compiled=false;
+}
+
+LoopVariable::~LoopVariable()
+{
+  system.var.erase(system.var.begin()+index);
+  system.x.erase(system.x.begin()+index);
+  for(std::size_t i=index; i<system.var.size(); i++)
+    system.var[i]->index = i;
+  system.compiled=false;
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+// LoopVariable::Value  --  solve the system (current guess if in loop)
+//
+double LoopVariable::Value()
+{
+  if(!system.solving)
+    system.Solve();
+  return system.x[index];
+}
+
+unsigned LoopVariable::_Compile(EvaluationTape &t)
+{
+  if(system.compiling)                  // leaf of system tape
+    return t.Load(&system.x[index]);
+  return t.Call(this);
+}
+
 }
 
 // end
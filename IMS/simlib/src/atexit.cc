@@ -20,11 +20,26 @@ SIMLIB_IMPLEMENTATION;
 
 static const int MAX_ATEXIT = 10; // for internal use it is enough
 static int counter = 0; // internal module counter
-static SIMLIB_atexit_function_t atexit_array[MAX_ATEXIT] = { 0, };
+// cleanup functions for simulation context of the thread
+static thread_local SIMLIB_atexit_function_t atexit_array[MAX_ATEXIT] = { 0, };
+static thread_local bool main_thread = false; // modules initialized here
+
+static void SIMLIB_atexit_call();
+
+// other threads: cleanup at thread exit
+// main thread: cleanup by the last module destructor (see below)
+struct SIMLIB_thread_cleanup {
+    ~SIMLIB_thread_cleanup() {
+        if(!main_thread)
+            SIMLIB_atexit_call();
+    }
+};
+static thread_local SIMLIB_thread_cleanup thread_cleanup;
 
 // used in SIMLIB
 void SIMLIB_atexit(SIMLIB_atexit_function_t p) {
     DEBUG(DBG_ATEXIT,("SIMLIB_atexit(%p)", p ));
+    (void) &thread_cleanup; // first use in thread registers its destructor
     int i;
     for(i=0; i<MAX_ATEXIT; i++) {
        if(atexit_array[i]==0) break;
@@ -49,6 +64,7 @@ static void SIMLIB_atexit_call() {
 SIMLIB_module::SIMLIB_module():
     string(0) {
     counter++;
+    main_thread = true;
     DEBUG(DBG_MODULE,("MODULE#%d initialization",counter));
 }
 
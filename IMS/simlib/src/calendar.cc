@@ -21,6 +21,7 @@
 
 #include "simlib.h"
 #include "internal.h"
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 
@@ -72,10 +73,14 @@ class Calendar { // abstract base class
     virtual void     ScheduleAt(Entity *e, double t) = 0;
     /// dequeue first
     virtual Entity * GetFirst() = 0;
+    /// first entity (not removed)
+    virtual Entity * First() = 0;
     /// dequeue
     virtual Entity * Get(Entity *e) = 0;
     /// remove all scheduled entities
     virtual void clear(bool destroy_entities=false) = 0;
+    /// append all items (in order of activation) to v
+    virtual void contents(std::vector<SQS::Item> &v) = 0;
     virtual const char* Name() =0;
 #ifndef NDEBUG
     /// for debugging only
@@ -106,7 +111,7 @@ class Calendar { // abstract base class
     virtual ~Calendar() {} //!< clear is called in derived class dtr
     static void delete_instance();      //!< destroy single instance
   private:
-    static Calendar * _instance;        //!< pointer to single instance
+    static thread_local Calendar * _instance; //!< pointer to single instance (in thread)
   ///////////////////////////////////////////////////////////////////////////
   friend void SetCalendar(const char *name); // sets _instance
 };
@@ -201,10 +206,8 @@ class EventNoticeAllocator {
     EventNoticeLinkBase *l; // single-linked list of freed items
     unsigned freed;
   public:
+    // no destructor: calendar destructor clears the freelist
     EventNoticeAllocator(): l(0), freed(0) {}
-    ~EventNoticeAllocator() {
-        clear();  // delete freelist
-    }
 
     /// free EventNotice, add to freelist for future allocation
     void free(EventNotice *en) {
@@ -242,7 +245,8 @@ class EventNoticeAllocator {
             delete p;
         }
     }
-} allocator;  // global allocator TODO: improve -> singleton
+};
+static thread_local EventNoticeAllocator allocator; // TODO: improve -> singleton
 
 
 
@@ -286,6 +290,11 @@ class CalendarListImplementation {
 
     double first_time() { return (*begin())->time; }
     EventNotice *first() { return *begin(); }
+    /// append all items to v
+    void contents(std::vector<SQS::Item> &v) {
+      for(iterator i = begin(); i != end(); ++i)
+        v.push_back(SQS::Item{(*i)->entity, (*i)->time, (*i)->priority});
+    }
 
 private:
     /// search --- linear search for insert position
@@ -371,8 +380,11 @@ class CalendarList : public Calendar {
     virtual Entity *Get(Entity *p) override;              // remove process p from calendar
     /// dequeue first entity
     virtual Entity *GetFirst() override;
+    /// first entity (not removed)
+    virtual Entity *First() override { return l.first()->entity; }
     /// remove all
     virtual void clear(bool destroy=false) override; // remove/destroy all items
+    virtual void contents(std::vector<SQS::Item> &v) override { l.contents(v); }
 
     /// create calendar instance
     // TODO: we need this only if calendar use is allowed before Init()
@@ -588,8 +600,15 @@ class CalendarQueue : public Calendar {
     virtual Entity *Get(Entity *p) override;              // remove process p from calendar
     /// dequeue first
     virtual Entity *GetFirst() override;
+    /// first entity (not removed)
+    virtual Entity *First() override {
+        if(list_impl())
+            return list.first()->entity;
+        return buckets[time2bucket(MinTime())].first()->entity;
+    }
     /// remove all
     virtual void clear(bool destroy=false) override; // remove/destroy all items
+    virtual void contents(std::vector<SQS::Item> &v) override;
 
     /// create calendar instance
     // TODO: we need this only if calendar use is allowed before Init()
@@ -1116,6 +1135,26 @@ void CalendarQueue::clear(bool destroy)
     SetMinTime(SIMLIB_MAXTIME);
 }
 
+/////////////////////////////////////////////////////////////////////////////
+/// append all items to v (in order of activation)
+//  items with the same time are in single bucket (in right order),
+//  stable sort of buckets keeps it
+void CalendarQueue::contents(std::vector<SQS::Item> &v)
+{
+  size_t n = v.size();
+  if(list_impl()) {
+    list.contents(v);
+    return;
+  }
+  for(unsigned i = 0; i < nbuckets; i++)
+    buckets[i].contents(v);
+  std::stable_sort(v.begin() + n, v.end(),
+                   [](const SQS::Item &a, const SQS::Item &b) {
+                     return a.time < b.time ||
+                            (a.time == b.time && a.priority > b.priority);
+                   });
+}
+
 /////////////////////////////////////////////////////////////////////////////
 /// Destroy calendar queue
 CalendarQueue::~CalendarQueue()
@@ -1198,7 +1237,7 @@ void CalendarQueue::visualize(const char *msg)
 ////////////////////////////////////////////////////////////////////////////
 
 /// static pointer to singleton instance
-Calendar * Calendar::_instance = 0;
+thread_local Calendar * Calendar::_instance = 0;
 
 /// interface to singleton instance
 inline Calendar * Calendar::instance() {
@@ -1281,6 +1320,11 @@ bool SQS::Empty() {                       // used by Run() only
   return Calendar::instance()->Empty();
 }
 
+/// number of scheduled entities
+unsigned SQS::Size() {
+  return Calendar::instance()->Size();
+}
+
 /// schedule entity e at given time t using scheduling priority from e
 /// @param e entity
 /// @param t time of activation
@@ -1342,12 +1386,23 @@ OP_MEASURE=0;
   return ret;
 }
 
+/// entity with minimum activation time (calendar is not empty)
+Entity *SQS::First() {
+  return Calendar::instance()->First();
+}
+
 /// remove all scheduled entities
 void SQS::Clear() {                       // remove all
   Calendar::instance()->clear(true);
   _SetTime(NextTime, Calendar::instance()->MinTime());
 }
 
+/// get all scheduled entities in order of activation (for checkpoint)
+void SQS::Contents(std::vector<SQS::Item> &v) {
+  v.clear();
+  Calendar::instance()->contents(v);
+}
+
 int SQS::debug_print() {                 // for debugging only
   Calendar::instance()->debug_print();
   return Calendar::instance()->Size();
@@ -0,0 +1,584 @@
+/////////////////////////////////////////////////////////////////////////////
+//! \file checkpoint.cc  Save/restore state of simulation run
+//
+// Copyright (c) 1991-2018 Petr Peringer
+//
+// This library is licensed under GNU Library GPL. See the file COPYING.
+//
+
+//
+// Checkpoint file (binary, native byte order):
+//   header          magic, format version, SIMLIB version, sizes
+//   entity types    names of registered entity classes
+//   entity table    class of each saved entity
+//   data            time, random generator, objects, integrators,
+//                   status variables, calendar, data of entities
+// Entities are saved if they are scheduled, in queues, in service or
+// referenced by saved entities (WriteEntity). RestoreCheckpoint creates
+// all entities first (default constructors), so references can be
+// resolved in any order.
+// Processes use stack copies (stack contains pointers), so only Events,
+// StepProcesses and not started Processes can be saved.
+//
+
+////////////////////////////////////////////////////////////////////////////
+// interface
+//
+
+#include "simlib.h"
+#include "internal.h"
+#include "zdelay.h"
+
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <typeindex>
+#include <unordered_map>
+
+////////////////////////////////////////////////////////////////////////////
+// implementation
+//
+
+namespace simlib3 {
+
+SIMLIB_IMPLEMENTATION;
+
+static const char MAGIC[8] = { 'S','I','M','L','I','B','C','P' };
+static const std::uint32_t FORMAT_VERSION = 2;
+
+// file header
+struct CheckpointHeader {
+  char magic[8];
+  std::uint32_t format;         // FORMAT_VERSION
+  std::uint32_t version;        // SIMLIB version
+  std::uint32_t sizes;          // sizeof(long), sizeof(double), byte order
+};
+
+static std::uint32_t Sizes()
+{
+  const std::uint32_t one = 1;
+  unsigned char little;
+  std::memcpy(&little, &one, 1);
+  return sizeof(long) | sizeof(double) << 8 | little << 16;
+}
+
+// tags of saved objects
+enum { TAG_FACILITY = 1, TAG_STORE, TAG_QUEUE, TAG_STAT, TAG_TSTAT,
+       TAG_HISTOGRAM, TAG_POOL };
+
+////////////////////////////////////////////////////////////////////////////
+// registered entity classes (initialized before main, read only later)
+//
+struct CheckpointType {
+  std::string name;
+  Entity *(*create)();
+};
+
+static std::unordered_map<std::type_index, CheckpointType> &Types()
+{
+  static std::unordered_map<std::type_index, CheckpointType> types;
+  return types;
+}
+
+void Checkpoint::_Register(const std::type_info &type, const char *name,
+                           Entity *(*create)())
+{
+  Types()[std::type_index(type)] = CheckpointType{name, create};
+}
+
+////////////////////////////////////////////////////////////////////////////
+// checkpoint data
+//
+struct Checkpoint::Data {
+  std::string buffer;                   // data (after entity table)
+  size_t pos;                           // read position
+  std::vector<Entity*> entities;        // saved/restored entities
+  std::unordered_map<const Entity*, unsigned long> index; // number+1
+  Data() : pos(0) {}
+};
+
+////////////////////////////////////////////////////////////////////////////
+// Checkpoint::Write, Read --- data access
+//
+void Checkpoint::Write(const void *ptr, size_t size)
+{
+  data->buffer.append(static_cast<const char*>(ptr), size);
+}
+
+void Checkpoint::Read(void *ptr, size_t size)
+{
+  if(data->pos + size > data->buffer.size())
+    SIMLIB_error(CheckpointFormatError);
+  std::memcpy(ptr, data->buffer.data() + data->pos, size);
+  data->pos += size;
+}
+
+void Checkpoint::Write(const std::string &s)
+{
+  Write(s.size());
+  Write(s.data(), s.size());
+}
+
+void Checkpoint::Read(std::string &s)
+{
+  size_t n;
+  Read(n);
+  if(data->pos + n > data->buffer.size())
+    SIMLIB_error(CheckpointFormatError);
+  s.assign(data->buffer, data->pos, n);
+  data->pos += n;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Checkpoint::WriteEntity --- entity reference, new entity is saved later
+//
+void Checkpoint::WriteEntity(const Entity *e)
+{
+  unsigned long i = 0;
+  if(e) {
+    auto p = data->index.find(e);
+    if(p == data->index.end()) {
+      data->entities.push_back(const_cast<Entity*>(e));
+      i = data->entities.size();
+      data->index[e] = i;
+    }
+    else
+      i = p->second;
+  }
+  Write(i);
+}
+
+Entity *Checkpoint::ReadEntity()
+{
+  unsigned long i;
+  Read(i);
+  if(i > data->entities.size())
+    SIMLIB_error(CheckpointFormatError);
+  return i ? data->entities[i-1] : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// entity data: common attributes, resume point, user data
+//
+void Checkpoint::SaveEntityData(Entity *e)
+{
+  Process *p = dynamic_cast<Process*>(e);
+  if(p && !p->isPrepared())
+    SIMLIB_error(CheckpointProcessError);
+  Write(e->_Ident);
+  Write(Entity::Priority_t(e->Priority));
+  Write(e->_MarkTime);
+  Write(&e->_RemainingTime, sizeof(double));    // union
+  Write(e->_SPrio);
+  if(StepProcess *s = dynamic_cast<StepProcess*>(e))
+    Write(s->_GetStep());
+  e->SaveState(*this);
+}
+
+void Checkpoint::RestoreEntityData(Entity *e)
+{
+  Read(e->_Ident);
+  Entity::Priority_t p;
+  Read(p);
+  e->Priority = p;
+  Read(e->_MarkTime);
+  Read(&e->_RemainingTime, sizeof(double));
+  Read(e->_SPrio);
+  if(StepProcess *s = dynamic_cast<StepProcess*>(e)) {
+    unsigned step;
+    Read(step);
+    s->_SetStep(step);
+  }
+  e->RestoreState(*this);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Checkpoint::SaveObject --- Facility, Store, Queue, statistics
+//
+void Checkpoint::SaveObject(SimObject *o)
+{
+  if(Facility *f = dynamic_cast<Facility*>(o)) {
+    Write(char(TAG_FACILITY));
+    WriteEntity(f->in);
+    bool own = f->OwnQueue();   // shared queue is saved separately
+    Write(own);
+    if(own)
+      SaveObject(f->Q1);
+    SaveObject(f->Q2);
+    SaveObject(&f->tstat);
+  }
+  else if(FacilityPool *p = dynamic_cast<FacilityPool*>(o)) {
+    Write(char(TAG_POOL));
+    Write(p->Servers());
+    for(const FacilityPool::ServerData &s : p->servers) {
+      WriteEntity(s.in);
+      Write(s.n);
+      Write(s.busy);
+      Write(s.start);
+    }
+    bool own = p->OwnQueue();
+    Write(own);
+    if(own)
+      SaveObject(p->Q);
+    SaveObject(&p->tstat);
+  }
+  else if(Store *s = dynamic_cast<Store*>(o)) {
+    Write(char(TAG_STORE));
+    Write(s->capacity);
+    Write(s->used);
+    bool own = s->OwnQueue();
+    Write(own);
+    if(own)
+      SaveObject(s->Q);
+    SaveObject(&s->tstat);
+  }
+  else if(Queue *q = dynamic_cast<Queue*>(o)) {
+    Write(char(TAG_QUEUE));
+    Write(q->size());
+    for(Queue::iterator i = q->begin(); i != q->end(); ++i)
+      WriteEntity(static_cast<Entity*>(*i));
+    SaveObject(&q->StatN);
+    SaveObject(&q->StatDT);
+  }
+  else if(Stat *s = dynamic_cast<Stat*>(o)) {
+    Write(char(TAG_STAT));
+    Write(s->sx);
+    Write(s->sx2);
+    Write(s->min);
+    Write(s->max);
+    Write(s->n);
+  }
+  else if(TStat *s = dynamic_cast<TStat*>(o)) {
+    Write(char(TAG_TSTAT));
+    Write(s->sxt);
+    Write(s->sx2t);
+    Write(s->min);
+    Write(s->max);
+    Write(s->t0);
+    Write(s->tl);
+    Write(s->xl);
+    Write(s->n);
+  }
+  else if(Histogram *h = dynamic_cast<Histogram*>(o)) {
+    Write(char(TAG_HISTOGRAM));
+    Write(h->low);
+    Write(h->step);
+    Write(h->count);
+    Write(h->dptr, (h->count+2) * sizeof(unsigned));
+    SaveObject(&h->stat);
+  }
+  else
+    SIMLIB_error(CheckpointObjectError);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Checkpoint::RestoreObject --- the same type of object is required
+//
+void Checkpoint::RestoreObject(SimObject *o)
+{
+  char tag;
+  Read(tag);
+  if(Facility *f = dynamic_cast<Facility*>(o)) {
+    if(tag != TAG_FACILITY)
+      SIMLIB_error(CheckpointObjectError);
+    f->Clear();
+    f->in = ReadEntity();
+    bool own;
+    Read(own);
+    if(own != f->OwnQueue())
+      SIMLIB_error(CheckpointObjectError);
+    if(own)
+      RestoreObject(f->Q1);
+    RestoreObject(f->Q2);
+    RestoreObject(&f->tstat);
+  }
+  else if(FacilityPool *p = dynamic_cast<FacilityPool*>(o)) {
+    if(tag != TAG_POOL)
+      SIMLIB_error(CheckpointObjectError);
+    p->Clear();
+    unsigned n;
+    Read(n);
+    if(n != p->Servers())
+      SIMLIB_error(CheckpointObjectError);
+    for(unsigned i = 0; i < n; i++) {
+      FacilityPool::ServerData &s = p->servers[i];
+      s.in = ReadEntity();
+      Read(s.n);
+      Read(s.busy);
+      Read(s.start);
+      if(s.in) {                // busy server
+        p->idle[i / (sizeof(unsigned long) * CHAR_BIT)] &=
+          ~(1UL << (i % (sizeof(unsigned long) * CHAR_BIT)));
+        p->nbusy++;
+      }
+    }
+    bool own;
+    Read(own);
+    if(own != p->OwnQueue())
+      SIMLIB_error(CheckpointObjectError);
+    if(own)
+      RestoreObject(p->Q);
+    RestoreObject(&p->tstat);
+  }
+  else if(Store *s = dynamic_cast<Store*>(o)) {
+    if(tag != TAG_STORE)
+      SIMLIB_error(CheckpointObjectError);
+    s->Clear();
+    Read(s->capacity);
+    Read(s->used);
+    bool own;
+    Read(own);
+    if(own != s->OwnQueue())
+      SIMLIB_error(CheckpointObjectError);
+    if(own)
+      RestoreObject(s->Q);
+    RestoreObject(&s->tstat);
+  }
+  else if(Queue *q = dynamic_cast<Queue*>(o)) {
+    if(tag != TAG_QUEUE)
+      SIMLIB_error(CheckpointObjectError);
+    q->clear();
+    unsigned n;
+    Read(n);
+    for(unsigned i = 0; i < n; i++) {
+      Entity *e = ReadEntity();
+      if(e == 0)
+        SIMLIB_error(CheckpointFormatError);
+      static_cast<List*>(q)->InsLast(e);        // no statistics
+    }
+    RestoreObject(&q->StatN);
+    RestoreObject(&q->StatDT);
+  }
+  else if(Stat *s = dynamic_cast<Stat*>(o)) {
+    if(tag != TAG_STAT)
+      SIMLIB_error(CheckpointObjectError);
+    Read(s->sx);
+    Read(s->sx2);
+    Read(s->min);
+    Read(s->max);
+    Read(s->n);
+  }
+  else if(TStat *s = dynamic_cast<TStat*>(o)) {
+    if(tag != TAG_TSTAT)
+      SIMLIB_error(CheckpointObjectError);
+    Read(s->sxt);
+    Read(s->sx2t);
+    Read(s->min);
+    Read(s->max);
+    Read(s->t0);
+    Read(s->tl);
+    Read(s->xl);
+    Read(s->n);
+  }
+  else if(Histogram *h = dynamic_cast<Histogram*>(o)) {
+    double low, step;
+    unsigned count;
+    if(tag != TAG_HISTOGRAM)
+      SIMLIB_error(CheckpointObjectError);
+    Read(low);
+    Read(step);
+    Read(count);
+    if(low != h->low || step != h->step || count != h->count)
+      SIMLIB_error(CheckpointObjectError);
+    Read(h->dptr, (h->count+2) * sizeof(unsigned));
+    RestoreObject(&h->stat);
+  }
+  else
+    SIMLIB_error(CheckpointObjectError);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// SaveCheckpoint --- write state of simulation to file
+//
+void SaveCheckpoint(const char *filename, const std::vector<SimObject*> &objects)
+{
+  Dprintf(("SaveCheckpoint(\"%s\") Time=%g", filename, double(Time)));
+  Checkpoint::Data d;
+  Checkpoint c(&d);
+  c.Write(SIMLIB_StartTime);
+  c.Write(SIMLIB_Time);
+  c.Write(SIMLIB_Entity_Count);
+  c.Write(SIMLIB_RandomDefault);
+  c.Write(objects.size());
+  for(SimObject *o : objects)
+    c.SaveObject(o);
+  c.Write(IntegratorContainer::Size());
+  for(auto i = IntegratorContainer::Begin(); i != IntegratorContainer::End(); ++i)
+    c.Write((*i)->GetState());
+  c.Write(StatusContainer::Size());
+  for(auto i = StatusContainer::Begin(); i != StatusContainer::End(); ++i)
+    c.Write((*i)->GetState());
+  // calendar, samplers and ZDelay timers are activated by Run()
+  std::vector<SQS::Item> calendar;
+  SQS::Contents(calendar);
+  size_t n = 0;
+  for(SQS::Item &i : calendar)
+    if(dynamic_cast<Sampler*>(i.entity) == 0 &&
+       dynamic_cast<ZDelayTimer*>(i.entity) == 0)
+      calendar[n++] = i;
+  calendar.resize(n);
+  c.Write(n);
+  for(SQS::Item &i : calendar) {
+    c.WriteEntity(i.entity);
+    c.Write(i.time);
+    c.Write(i.priority);
+  }
+  for(size_t i = 0; i < d.entities.size(); i++)  // list can grow
+    c.SaveEntityData(d.entities[i]);
+
+  // entity classes
+  std::vector<std::string> names;
+  std::unordered_map<std::type_index, unsigned> type_no;
+  std::vector<unsigned> table;
+  for(Entity *e : d.entities) {
+    std::type_index t(typeid(*e));
+    auto p = type_no.find(t);
+    if(p == type_no.end()) {
+      auto r = Types().find(t);
+      if(r == Types().end())
+        SIMLIB_error(CheckpointTypeError);
+      p = type_no.emplace(t, names.size()).first;
+      names.push_back(r->second.name);
+    }
+    table.push_back(p->second);
+  }
+  Checkpoint::Data head;
+  Checkpoint h(&head);
+  CheckpointHeader hdr;
+  std::memcpy(hdr.magic, MAGIC, sizeof(MAGIC));
+  hdr.format = FORMAT_VERSION;
+  hdr.version = SIMLIB_version;
+  hdr.sizes = Sizes();
+  h.Write(hdr);
+  h.Write(names.size());
+  for(std::string &s : names)
+    h.Write(s);
+  h.Write(table.size());
+  h.Write(table.data(), table.size() * sizeof(unsigned));
+
+  // new file replaces old one after successful write
+  std::string tmp = std::string(filename) + ".tmp";
+  FILE *f = std::fopen(tmp.c_str(), "wb");
+  if(f == 0)
+    SIMLIB_error(CheckpointFileError);
+  bool ok = std::fwrite(head.buffer.data(), 1, head.buffer.size(), f) == head.buffer.size() &&
+            std::fwrite(d.buffer.data(), 1, d.buffer.size(), f) == d.buffer.size();
+  if(std::fclose(f) != 0 || !ok || std::rename(tmp.c_str(), filename) != 0) {
+    std::remove(tmp.c_str());
+    SIMLIB_error(CheckpointFileError);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////
+// RestoreCheckpoint --- read state of simulation from file
+//
+void RestoreCheckpoint(const char *filename, const std::vector<SimObject*> &objects)
+{
+  Dprintf(("RestoreCheckpoint(\"%s\")", filename));
+  if(SIMLIB_Phase != INITIALIZATION)
+    SIMLIB_error(CheckpointUseError);
+  Checkpoint::Data d;
+  Checkpoint c(&d);
+  FILE *f = std::fopen(filename, "rb");
+  if(f == 0)
+    SIMLIB_error(CheckpointFileError);
+  char buf[4096];
+  size_t len;
+  while((len = std::fread(buf, 1, sizeof(buf), f)) > 0)
+    d.buffer.append(buf, len);
+  bool ok = !std::ferror(f);
+  std::fclose(f);
+  if(!ok)
+    SIMLIB_error(CheckpointFileError);
+
+  CheckpointHeader hdr;
+  c.Read(hdr);
+  if(std::memcmp(hdr.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+     hdr.format != FORMAT_VERSION || hdr.version != SIMLIB_version ||
+     hdr.sizes != Sizes())
+    SIMLIB_error(CheckpointFormatError);
+  // create entities
+  size_t ntypes;
+  c.Read(ntypes);
+  std::vector<Entity *(*)()> create;
+  for(size_t i = 0; i < ntypes; i++) {
+    std::string name;
+    c.Read(name);
+    Entity *(*fn)() = 0;
+    for(auto &t : Types())
+      if(t.second.name == name)
+        fn = t.second.create;
+    if(fn == 0)
+      SIMLIB_error(CheckpointTypeError);
+    create.push_back(fn);
+  }
+  size_t n;
+  c.Read(n);
+  if(n > (d.buffer.size() - d.pos) / sizeof(unsigned)) // corrupted file
+    SIMLIB_error(CheckpointFormatError);
+  std::vector<unsigned> table(n);
+  c.Read(table.data(), n * sizeof(unsigned));
+  SQS::Clear();
+  for(unsigned t : table) {
+    if(t >= create.size())
+      SIMLIB_error(CheckpointFormatError);
+    d.entities.push_back(create[t]());
+  }
+
+  double t0, t;
+  unsigned long count;
+  RandomStream random;
+  c.Read(t0);
+  c.Read(t);
+  c.Read(count);
+  c.Read(random);
+  if(t < t0)
+    SIMLIB_error(CheckpointFormatError);
+  _SetTime(StartTime, t0);
+  _SetTime(Time, t);
+  SIMLIB_RandomDefault = random;
+  c.Read(n);
+  if(n != objects.size())
+    SIMLIB_error(CheckpointObjectError);
+  for(SimObject *o : objects)
+    c.RestoreObject(o);
+  // Run() initializes integrators and status variables by Init()
+  c.Read(n);
+  if(n != IntegratorContainer::Size())
+    SIMLIB_error(CheckpointObjectError);
+  for(auto i = IntegratorContainer::Begin(); i != IntegratorContainer::End(); ++i) {
+    double x;
+    c.Read(x);
+    (*i)->Init(x);
+  }
+  c.Read(n);
+  if(n != StatusContainer::Size())
+    SIMLIB_error(CheckpointObjectError);
+  for(auto i = StatusContainer::Begin(); i != StatusContainer::End(); ++i) {
+    double x;
+    c.Read(x);
+    (*i)->Init(x);
+  }
+  c.Read(n);
+  for(size_t i = 0; i < n; i++) {
+    Entity *e = c.ReadEntity();
+    double at;
+    Entity::Priority_t p;
+    c.Read(at);
+    c.Read(p);
+    if(e == 0 || !e->Idle())
+      SIMLIB_error(CheckpointFormatError);
+    e->Priority = p;            // scheduling priority
+    SQS::ScheduleAt(e, at);
+  }
+  for(Entity *e : d.entities)
+    c.RestoreEntityData(e);
+  if(d.pos != d.buffer.size())
+    SIMLIB_error(CheckpointFormatError);
+  if(SIMLIB_Entity_Count < count)
+    SIMLIB_Entity_Count = count;
+}
+
+}
+// end
@@ -17,6 +17,9 @@
 #include "simlib.h"
 #include "internal.h"
 
+#include <cmath>
+#include <vector>
+
 namespace simlib3 {
 
 
@@ -27,8 +30,8 @@ namespace simlib3 {
 SIMLIB_IMPLEMENTATION;
 
 
-bool SIMLIB_ConditionFlag = false;       // condition vector changed
-aCondition *aCondition::First = 0;       // condition list
+thread_local bool SIMLIB_ConditionFlag = false;       // condition vector changed
+thread_local aCondition *aCondition::First = 0;       // condition list
 
 ////////////////////////////////////////////////////////////////////////////
 // aCondition implementation
@@ -133,6 +136,124 @@ void aCondition::AllActions()
     if(i->Test()) i->Action(); /// Change???? ### !!!!
 }
 
+////////////////////////////////////////////////////////////////////////////
+//  state event location (see SetEventLocation)
+//
+//  Integrators are interpolated by dense output of the integration method
+//  or by cubic Hermite polynomial from values and derivatives at the start
+//  and at the end of the step (methods without dense output), the input of
+//  condition is evaluated for interpolated state only. The crossing is
+//  bracketed and found by Illinois method, the result is the end of the
+//  bracket with new status of condition.
+//
+namespace {
+struct Interpolation {
+  std::vector<double> y0, f0, y1, f1;  // start and end of step
+  std::vector<double> d;               // saved derivatives
+  double t0, t1, dt;                   // step and saved time
+  void Start();
+  void Set(double t);                  // set interpolated state
+  void End();                          // restore state of model
+};
+}
+static thread_local Interpolation interpolation;
+
+void Interpolation::Start()
+{
+  IntegratorContainer::iterator i, end = IntegratorContainer::End();
+  y0.clear(); f0.clear(); y1.clear(); f1.clear(); d.clear();
+  t0 = SIMLIB_StepStartTime;
+  t1 = Time;
+  dt = SIMLIB_DeltaTime;
+  for(i = IntegratorContainer::Begin(); i != end; ++i)
+    d.push_back((*i)->GetDiff());      // can be from sub-step
+  SIMLIB_Dynamic();                    // derivatives at the end of step
+  for(i = IntegratorContainer::Begin(); i != end; ++i) {
+    y0.push_back((*i)->GetOldState());
+    f0.push_back((*i)->GetOldDiff());
+    y1.push_back((*i)->GetState());
+    f1.push_back((*i)->GetDiff());
+  }
+}
+
+void Interpolation::Set(double t)
+{
+  double h = t1 - t0;
+  double s = (t - t0) / h;
+  double h00 = (1 + 2*s) * (1 - s) * (1 - s);
+  double h10 = s * (1 - s) * (1 - s) * h;
+  double h01 = s * s * (3 - 2*s);
+  double h11 = s * s * (s - 1) * h;
+  _SetTime(Time, t);
+  SIMLIB_DeltaTime = t - t0;
+  if(IntegrationMethod::Interpolate(t, IntegratorContainer::State()))
+    return;                            // dense output of the method
+  IntegratorContainer::iterator i, end = IntegratorContainer::End();
+  std::size_t n = 0;
+  for(i = IntegratorContainer::Begin(); i != end; ++i, ++n)
+    (*i)->SetState(h00*y0[n] + h10*f0[n] + h01*y1[n] + h11*f1[n]);
+}
+
+void Interpolation::End()
+{
+  _SetTime(Time, t1);
+  SIMLIB_DeltaTime = dt;
+  IntegratorContainer::iterator i, end = IntegratorContainer::End();
+  std::size_t n = 0;
+  for(i = IntegratorContainer::Begin(); i != end; ++i, ++n) {
+    (*i)->SetState(y1[n]);
+    (*i)->SetDiff(d[n]);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////
+//  aCondition::Locate -- time of first change of condition in the step
+//  returns false if the change can not be bracketed (use step halving)
+//
+bool aCondition::Locate(double &t)
+{
+  Interpolation &ip = interpolation;
+  ip.Start();
+  double tol = SIMLIB_MinStep > 0 ? SIMLIB_MinStep : 0;
+  if(tol < 1e-14*fabs(ip.t1)) tol = 1e-14*fabs(ip.t1);
+  bool ok = true;
+  t = ip.t1;
+  for(aCondition *c = First; c && ok; c = c->Next) {
+    if(!c->Changed())
+      continue;
+    double a = ip.t0, b = t;
+    ip.Set(a);
+    double ga = c->Function();
+    ip.Set(b);
+    double gb = c->Function();
+    if((ga >= 0) == (gb >= 0)) {       // no change until t
+      if(b == ip.t1) ok = false;       // interpolation does not match
+      continue;
+    }
+    int side = 0;                      // last moved end of bracket
+    for(int n = 0; b - a > tol && n < 100; n++) {
+      double x = b - gb * (b - a) / (gb - ga);
+      if(!(x > a && x < b))
+        x = 0.5 * (a + b);
+      ip.Set(x);
+      double gx = c->Function();
+      if((gx >= 0) == (gb >= 0)) {
+        b = x; gb = gx;
+        if(side == 1) ga *= 0.5;       // Illinois modification
+        side = 1;
+      } else {
+        a = x; ga = gx;
+        if(side == -1) gb *= 0.5;
+        side = -1;
+      }
+    }
+    t = b;
+  }
+  ip.End();
+  Dprintf(("aCondition::Locate: %s %.15g", ok ? "located" : "failed", t));
+  return ok;
+}
+
 ////////////////////////////////////////////////////////////////////////////
 //  SIMLIB_DoConditions -- perform reactions to condition change
 //
@@ -21,6 +21,8 @@
 #include "simlib.h"
 #include "internal.h"
 
+#include <typeinfo>
+
 namespace simlib3 {
 
 
@@ -36,7 +38,7 @@ void SIMLIB_Dynamic() // called each step
 {
   StatusContainer::ClearAllValueOK(); // zero flags ###
   StatusContainer::EvaluateAll();     // evaluation (with loop detection) ???
-  IntegratorContainer::EvaluateAll(); // evaluation without loop detection
+  EvaluationTape::Evaluate();         // inputs of integrators (see tape.cc)
 }
 
 
@@ -123,6 +125,30 @@ Input aContiBlock2::SetInput2(Input inp)
 double Expression::Value() { AlgLoopDetector _(this); return InputValue(); }
 
 
+////////////////////////////////////////////////////////////////////////////
+// evaluation tape (see tape.cc) --- derived classes can redefine Value()
+//
+unsigned Constant::_Compile(EvaluationTape &t) {
+  if(typeid(*this) != typeid(Constant)) return t.Call(this);
+  return t.Const(value);
+}
+
+unsigned Variable::_Compile(EvaluationTape &t) {
+  if(typeid(*this) != typeid(Variable)) return t.Call(this);
+  return t.Load(&value);
+}
+
+unsigned Parameter::_Compile(EvaluationTape &t) {
+  if(typeid(*this) != typeid(Parameter)) return t.Call(this);
+  return t.Load(&value);
+}
+
+unsigned Expression::_Compile(EvaluationTape &t) {
+  if(typeid(*this) != typeid(Expression)) return t.Call(this);
+  return t.Forward(this);
+}
+
+
 ////////////////////////////////////////////////////////////////////////////
 // _Xxxx classes are for internal use only -
 // the objects are created automatically in block expressions,
@@ -141,6 +167,9 @@ public:
     Dprintf(("dtr: _Add[%p]", this));
   }
   virtual double Value() override { return Input1Value() + Input2Value(); }
+  virtual unsigned _Compile(EvaluationTape &t) override {
+    return t.Binary(EvaluationTape::ADD, this);
+  }
 #if 0
   virtual const char *Name() const {
       if(HasName()) return _name;
@@ -163,6 +192,9 @@ public:
     Dprintf(("dtr: _Sub[%p]", this));
   }
   virtual double Value() override { return Input1Value() - Input2Value(); }
+  virtual unsigned _Compile(EvaluationTape &t) override {
+    return t.Binary(EvaluationTape::SUB, this);
+  }
 #if 0
   virtual const char *Name() const {
       if(HasName()) return _name;
@@ -185,6 +217,9 @@ public:
     Dprintf(("dtr: _Mul[%p]", this));
   }
   virtual double Value() override { return Input1Value() * Input2Value(); }
+  virtual unsigned _Compile(EvaluationTape &t) override {
+    return t.Binary(EvaluationTape::MUL, this);
+  }
 #if 0
   virtual const char *Name() const {
       if(HasName()) return _name;
@@ -207,6 +242,9 @@ public:
     Dprintf(("dtr: _Div[%p]", this));
   }
   virtual double Value() override { return Input1Value() / Input2Value(); }
+  virtual unsigned _Compile(EvaluationTape &t) override {
+    return t.Binary(EvaluationTape::DIV, this);
+  }
 #if 0
   virtual const char *Name() const {
       if(HasName()) return _name;
@@ -245,6 +283,9 @@ public:
     Dprintf(("dtr: _UMinus[%p]", this));
   }
   virtual double Value() override    { return -InputValue(); }
+  virtual unsigned _Compile(EvaluationTape &t) override {
+    return t.Unary(EvaluationTape::NEG, this);
+  }
 #if 0
   virtual const char *Name() const {
       if(HasName()) return _name;
@@ -267,6 +308,9 @@ class _Time: public aContiBlock {
  public:
   _Time() {}
   virtual double Value () override { return Time; }
+  virtual unsigned _Compile(EvaluationTape &t) override {
+    return t.Load(&SIMLIB_Time);
+  }
   virtual std::string Name() const override { return "T(Time)"; }
 };
 
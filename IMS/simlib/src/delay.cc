@@ -12,7 +12,7 @@
 //  classes:
 //     Delay -- real delay blocks
 //     SIMLIB_Delay -- internal class for registration of delay blocks
-//     SIMLIB_DelayBuffer -- delay memory
+//     SIMLIB_DelayBuffer -- delay memory (ring buffer)
 //
 // LIMITS:
 //     dt <= MaxStep --- problem with too small delay time
@@ -27,8 +27,8 @@
 #include "delay.h"              // extra header, TODO: move to simlib.h
 #include "internal.h"
 
-#include <deque>                // for buffer implementation
-#include <list>                 // for registration list of all delay blocks
+#include <algorithm>
+#include <vector>               // buffer, registration of all delay blocks
 
 
 ////////////////////////////////////////////////////////////////////////////
@@ -42,19 +42,20 @@ SIMLIB_IMPLEMENTATION;
 ////////////////////////////////////////////////////////////////////////////
 /// continuous delay block
 class SIMLIB_Delay {
-    static std::list<Delay *> *listptr; //!< list of delay objects -- singleton
+    static thread_local std::vector<Delay *> *listptr; //!< all delay objects -- singleton
+    static thread_local double last_sample; //!< time of the last sampling
   public:
     static void Register(Delay *p) {    //!< must be called by Delay ctr
         if( listptr == 0 ) Initialize();
         listptr->push_back(p);
     }
       static void UnRegister(Delay *p) {//!< must be called from Delay destructor
-        listptr->remove(p);
+        listptr->erase(std::find(listptr->begin(), listptr->end(), p));
         if( listptr->empty() ) Destroy();// is really important???
     }
   private:
     static void Initialize() {          //!< initialize delay subsystem
-        listptr = new std::list<Delay*>();      // create new list of delays
+        listptr = new std::vector<Delay*>();    // create new list of delays
         // install 'hooks' into simulation control algorithm:
         INSTALL_HOOK( Delay, SIMLIB_Delay::SampleAll );
         INSTALL_HOOK( DelayInit, SIMLIB_Delay::InitAll );
@@ -69,21 +70,48 @@ class SIMLIB_Delay {
     /// function to scan inputs of all delay objects
     static void SampleAll() {   // called each continuous step (and more)
         if( listptr == 0 ) return;      // ### should never be reached (2remove)
-        std::list<Delay *>::iterator i;
-        for( i=listptr->begin(); i!=listptr->end(); ++i) // for each delay object
-            (*i)->Sample();     // sample input value
+        if( Time > last_sample && IntegratorContainer::isAny() )
+            SampleInside();     // samples inside the step (dense output)
+        for( Delay *d : *listptr )      // for each delay object
+            d->Sample();        // sample input value
+        last_sample = Time;
+    }
+    /// sample inputs inside the last step (if the integration method can
+    /// interpolate), the step can be longer than the delay resolution
+    static void SampleInside() {
+        const int N = 4;                // samples per step
+        static thread_local std::vector<double> y1; // state at end of step
+        const std::size_t count = IntegratorContainer::Size();
+        double *y = IntegratorContainer::State();
+        const double t0 = last_sample, t1 = Time;
+        y1.resize(count);
+        if( !IntegrationMethod::Interpolate(t1, &y1[0]) )
+            return;             // method without dense output
+        y1.assign(y, y + count);
+        for( int k=1; k<N; k++ ) {
+            double t = t0 + (t1 - t0) * k / N;
+            if( !IntegrationMethod::Interpolate(t, y) )
+                continue;       // not in the last step
+            _SetTime( Time, t );
+            for( Delay *d : *listptr )
+                d->Sample();
+        }
+        _SetTime( Time, t1 );
+        for( std::size_t j=0; j<count; j++ )
+            y[j] = y1[j];
     }
     /// function to initialize all delay objects
     static void InitAll() {     // called at Init()
+        last_sample = Time;
         if( listptr == 0 ) return;      // no delays ###
-        std::list<Delay *>::iterator i;
-        for( i=listptr->begin(); i!=listptr->end(); ++i) // for each delay object
-            (*i)->Init();       // set initial value
+        for( Delay *d : *listptr )      // for each delay object
+            d->Init();          // set initial value
     }
 };
 
 // static member must be initializad
-std::list<Delay *> *SIMLIB_Delay::listptr = 0;
+thread_local std::vector<Delay *> *SIMLIB_Delay::listptr = 0;
+thread_local double SIMLIB_Delay::last_sample = 0;
 
 
 #ifndef SIMLIB_public_Delay_Buffer
@@ -92,6 +120,7 @@ struct Delay::Buffer {
     virtual void put(double value, double time) = 0;    //!< store value
     virtual double get(double time) = 0;        //!< read interpolated value
     virtual void clear() = 0;                   //!< initialize buffer
+    virtual void set_order(unsigned) {}         //!< interpolation order
     virtual ~Buffer() {};
 };
 #endif
@@ -101,28 +130,74 @@ struct Delay::Buffer {
 ///
 /// This buffer inherits interface from Delay::Buffer (we can use various
 /// implementations later)
-/// method get() does linear interpolation ? TODO: should be split
+/// Samples are stored in ring buffer (size is power of 2, doubled if
+/// full), the read cursor moves with time (binary search if the time goes
+/// back). Method get() interpolates by polynomial of order 1 (linear,
+/// default), 2 or 3 through samples around the time.
 ///
 class SIMLIB_DelayBuffer : public Delay::Buffer { // memory for delayed signal
     /// pair (t,val) for storing in buffer TODO: use std::tuple
     struct Pair {
         double time;    //<! sample time
         double value;   //<! sampled value
-        Pair(double t, double v) : time(t), value(v) {}
+        Pair(double t=0, double v=0) : time(t), value(v) {}
         bool operator == (Pair &p) { return p.time==time && p.value==value; }
     };
-    std::deque<Pair> buf;       //!< storage for samples
+    std::vector<Pair> ring;     //!< storage for samples
+    std::size_t first;          //!< position of the oldest sample
+    std::size_t count;          //!< number of samples
+    std::size_t cursor;         //!< first sample after the last read time
+    unsigned order;             //!< order of interpolation
     Pair last_insert;           //!< last inserted value (for optimization)
 
+    Pair &at(std::size_t i) { return ring[(first + i) & (ring.size() - 1)]; }
+
+    void grow() {               // double the size of ring buffer
+        std::vector<Pair> r(2 * ring.size());
+        for( std::size_t i=0; i<count; i++ )
+            r[i] = at(i);
+        ring.swap(r);
+        first = 0;
+    }
+
+    /// interpolation polynomial through samples around interval j-1, j
+    double interpolate(std::size_t j, double time) {
+        std::size_t k = order;
+        if( count < k+1 )
+            k = count-1;
+        std::size_t s = j-1 >= (k-1)/2 ? j-1 - (k-1)/2 : 0;
+        if( s + k >= count )    // no samples in future
+            s = count-1 - k;
+        for( std::size_t m=s; m<s+k && k>1; m++ )
+            if( at(m).time >= at(m+1).time )
+                k = 1;          // discontinuity (event), linear
+        if( k == 1 ) {          // linear interpolation
+            const Pair &l = at(j-1), &p = at(j);
+            return l.value + (p.value-l.value)*(time-l.time)/(p.time-l.time);
+        }
+        double y = 0;           // Lagrange polynomial
+        for( std::size_t m=s; m<=s+k; m++ ) {
+            double w = at(m).value;
+            for( std::size_t q=s; q<=s+k; q++ )
+                if( q != m )
+                    w *= (time - at(q).time) / (at(m).time - at(q).time);
+            y += w;
+        }
+        return y;
+    }
+
  public:
 
-    SIMLIB_DelayBuffer(): buf(), last_insert(-2,0) { /*empty*/ }
+    SIMLIB_DelayBuffer(): ring(16), first(0), count(0), cursor(0), order(1),
+                          last_insert(-2,0) { /*empty*/ }
 
     virtual void clear() override {
         last_insert = Pair(-2,0); // we need it for optimization
-        buf.clear();            // empty buffer
+        first = count = cursor = 0; // empty buffer
     }
 
+    virtual void set_order(unsigned k) override { order = k; }
+
     virtual void put(double value, double time) override {
         Pair p(time,value);
 #ifndef NO_DELAY_OPTIMIZATION
@@ -131,44 +206,51 @@ class SIMLIB_DelayBuffer : public Delay::Buffer { // memory for delayed signal
             return;
         last_insert = p;
 #endif
-        buf.push_back(p);       // add at buffer end
+        while( count > 0 && at(count-1).time > time )
+            count--;            // time goes back: remove newer samples
+        if( cursor > count )
+            cursor = count;
+        if( count == ring.size() )
+            grow();
+        at(count++) = p;        // add at buffer end
     }
 
     virtual double get(double time) override // get delayed value (with interpolation)
     {
-        // TODO: this code is EXPERIMENTAL ### (needs optimization)
-        Pair p(-1,0);
-        Pair l(-1,0);
-        std::deque<Pair>::iterator i;
-        int n; // number of records (samples) skipped
         // ASSERT: there should be at least one record in the buffer
-        for( n=0, i=buf.begin(); i!=buf.end(); ++i ) {
-            l = p;
-            p = *i;
-            n++;
-            if( p.time > time ) break;
+        // find first sample after time (cursor moves forward)
+        std::size_t j = cursor;
+        if( j > 0 && at(j-1).time > time ) {   // time goes back
+            std::size_t lo = 0, hi = j-1;       // binary search
+            while( lo < hi ) {
+                std::size_t m = (lo + hi) / 2;
+                if( at(m).time > time ) hi = m; else lo = m + 1;
+            }
+            j = lo;
         }
-        // ASSERT: n>0
-        if( n < 2 )     // we want time before first recorded sample
-            return p.value;     // use first buffer value as default
-        else {          // there are at least two samples recorded
-            if( p.time < time ) {          // delay too small ###
+        while( j < count && at(j).time <= time )
+            j++;
+        cursor = j;
+        if( j == 0 )    // we want time before first recorded sample
+            return at(0).value; // use first buffer value as default
+        if( j == count ) {      // time of the last sample (or after)
+            if( count > 1 && at(count-1).time < time ) { // delay too small ###
                 SIMLIB_error(DelayTimeErr);// TODO: ### do it better
             }
-            // standard situation
-            const int LIMIT=2; // >=2  --- allows change of delay if bigger
-                               // WARNING: slow for bigger LIMIT
-            // remove old items in buffer
-            for(; n>LIMIT; n--)
-                buf.pop_front(); // remove front records
-            // linear interpolation
-            double dt = p.time - l.time;
-            double dy = p.value - l.value;
-            if( dt <= 0.0) { // ASSERT: dt > 0
-                SIMLIB_error(DelayTimeErr);
-            }
-            return l.value + dy*(time-l.time)/dt;
+            return at(count-1).value;
+        }
+        // standard situation
+        double value = interpolate(j, time);
+        // remove old items in buffer, keep items for the whole step
+        // (a rejected step starts again at SIMLIB_StepStartTime)
+        const double keep = time - SIMLIB_DeltaTime;
+        const std::size_t m = order - (order-1)/2; // # of samples before
+        while( count > m+1 && at(m).time <= keep ) {
+            first = (first + 1) & (ring.size() - 1); // remove front records
+            count--;
+            cursor--;
         }
+        return value;
     } // get
 }; // class SIMLIB_DelayBuffer
 
@@ -244,5 +326,17 @@ double Delay::Set(double newdelay)
    return last;
 }
 
+/////////////////////////////////////////////////////////////////////////////
+/// change interpolation order of delayed values
+///
+/// higher order needs smooth input (integrator outputs)
+///
+void Delay::SetOrder(unsigned k)
+{
+   if( k<1 || k>3 )
+      SIMLIB_error(DelayOrderErr);
+   buffer->set_order(k);
+}
+
 } // namespace
 
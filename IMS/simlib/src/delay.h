@@ -34,6 +34,7 @@ class Delay : public aContiBlock1 {
         virtual void put(double value, double time) = 0; //!< sample
         virtual double get(double time) = 0; //!< get interpolated value
         virtual void clear() = 0; //!< initialize buffer
+        virtual void set_order(unsigned) {} //!< interpolation order
         virtual ~Buffer() {};
     };
 #else
@@ -53,6 +54,7 @@ class Delay : public aContiBlock1 {
     void Sample();              //!< sample input (called automatically)
     double Value() override;    //!< output of continuous delay block
     double Set(double newDT);   //!< change delay time (EXPERIMENTAL)
+    void SetOrder(unsigned k);  //!< interpolation order 1 (default), 2, 3
 }; // class Delay
 
 } // namespace
@@ -0,0 +1,345 @@
+/////////////////////////////////////////////////////////////////////////////
+//! \file ensemble.cc  Ensemble of continuous model (many parameter sets)
+//
+// Copyright (c) 1991-2018 Petr Peringer
+//
+// This library is licensed under GNU Library GPL. See the file COPYING.
+//
+
+//
+// Inputs of integrators are compiled to separate evaluation tape (see
+// tape.cc), the tape is evaluated for group of members at once: value k
+// of member l is stored in array[k*w+l] (w = # of members in group), so
+// the inner loops over members use vector instructions. Parameters of
+// members are inputs of tape like states of integrators.
+// Members of group are integrated by Dormand-Prince 5(4) method with
+// common step (the greatest error of all members). Groups are
+// independent: they are integrated in worker threads, the results do not
+// depend on the number of threads.
+//
+
+////////////////////////////////////////////////////////////////////////////
+// interface
+//
+
+#include "simlib.h"
+#include "internal.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <typeinfo>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////
+// implementation
+//
+
+namespace simlib3 {
+
+SIMLIB_IMPLEMENTATION;
+
+////////////////////////////////////////////////////////////////////////////
+// group of members integrated together
+//
+struct EnsembleGroup {
+  std::size_t first, w;         // first member, # of members
+  double t, h;                  // time, next step
+  std::vector<double> y;        // states of integrators [n*w]
+  std::vector<double> x;        // inputs of tape: state, parameters
+  std::vector<double> a;        // derivatives of stages [7*n*w]
+  std::vector<double> s;        // slots of tape
+  bool fsal;                    // a1 = f(t,y) is valid
+  bool accuracy;                // accuracy can not be achieved
+  unsigned long steps;          // # of accepted steps
+};
+
+struct Ensemble::Data {
+  unsigned members, lanes;
+  EvaluationTape tape;          // compiled inputs of integrators
+  std::size_t n;                // # of integrators
+  std::vector<const double *> param;            // blocks of parameters
+  std::vector<std::vector<double> > pval;       // values for members
+  std::vector<Integrator *> ivar;               // integrators
+  std::vector<std::vector<double> > ival;       // initial values
+  std::vector<EnsembleGroup> groups;
+  bool ready;                   // Init was called
+  double abs_err, rel_err;      // accuracy (copy for worker threads)
+  double min_step, max_step;
+  void Integrate(EnsembleGroup &g, double t1) const;
+};
+
+////////////////////////////////////////////////////////////////////////////
+// Ensemble --- constructor, destructor
+//
+Ensemble::Ensemble(unsigned members, unsigned lanes) : data(new Data)
+{
+  data->members = members;
+  data->lanes = lanes > 0 ? lanes : 1;
+  data->n = 0;
+  data->ready = false;
+}
+
+Ensemble::~Ensemble()
+{
+  delete data;
+}
+
+unsigned Ensemble::Size() const
+{
+  return data->members;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Member --- value of parameter (block value p) for member
+//
+double *Ensemble::Member(const double *p, unsigned member)
+{
+  if(member >= data->members)
+    SIMLIB_error(EnsembleBadMember);
+  std::size_t j = std::find(data->param.begin(), data->param.end(), p)
+                - data->param.begin();
+  if(j == data->param.size()) {
+    data->param.push_back(p);
+    data->pval.push_back(std::vector<double>(data->members, *p));
+  }
+  data->ready = false;
+  return &data->pval[j][member];
+}
+
+void Ensemble::Set(Parameter &p, unsigned member, double value)
+{
+  *Member(&p.value, member) = value;
+}
+
+void Ensemble::Set(Variable &v, unsigned member, double value)
+{
+  *Member(&v.value, member) = value;
+}
+
+void Ensemble::Init(Integrator &i, unsigned member, double value)
+{
+  if(member >= data->members)
+    SIMLIB_error(EnsembleBadMember);
+  std::size_t j = std::find(data->ivar.begin(), data->ivar.end(), &i)
+                - data->ivar.begin();
+  if(j == data->ivar.size()) {
+    data->ivar.push_back(&i);
+    data->ival.push_back(std::vector<double>(data->members, i.initval));
+  }
+  data->ival[j][member] = value;
+  data->ready = false;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Init --- compile model, initial state of all members
+//
+void Ensemble::Init(double t0)
+{
+  Data &d = *data;
+  const std::size_t n = IntegratorContainer::Size();
+  const std::size_t np = d.param.size();
+  Dprintf(("Ensemble::Init(%g), %u members, n = %lu", t0, d.members,
+           (unsigned long)n));
+  d.n = n;
+  d.tape.Clear();
+  std::vector<Integrator *> intg;
+  IntegratorContainer::iterator i, end = IntegratorContainer::End();
+  for(i = IntegratorContainer::Begin(); i != end; ++i) {
+    Integrator *p = *i;
+    if(typeid(*p) != typeid(Integrator))        // can redefine Eval()
+      SIMLIB_error(EnsembleNotCompiled);
+    d.tape.Store(d.tape.Compile(p->input), &IntegratorContainer::Diff()[p->index]);
+    intg.push_back(p);
+  }
+  std::vector<const double *> in;               // inputs: states, parameters
+  for(std::size_t k = 0; k < n; k++)
+    in.push_back(&IntegratorContainer::State()[k]);
+  in.insert(in.end(), d.param.begin(), d.param.end());
+  if(!d.tape.Bind(in.data(), in.size(), IntegratorContainer::Diff()))
+    SIMLIB_error(EnsembleNotCompiled);
+  d.groups.clear();
+  for(std::size_t first = 0; first < d.members; first += d.lanes) {
+    EnsembleGroup g;
+    const std::size_t w = std::min<std::size_t>(d.lanes, d.members - first);
+    g.first = first;
+    g.w = w;
+    g.t = t0;
+    g.h = 0;
+    g.y.resize(n*w);
+    g.x.resize((n+np)*w);
+    g.a.resize(7*n*w);
+    g.s.resize(d.tape.Slots()*w);
+    g.fsal = false;
+    g.accuracy = false;
+    g.steps = 0;
+    for(Integrator *p : intg)
+      for(std::size_t l = 0; l < w; l++)
+        g.y[p->index*w + l] = p->initval;
+    for(std::size_t j = 0; j < d.ivar.size(); j++)
+      for(std::size_t l = 0; l < w; l++)
+        g.y[d.ivar[j]->index*w + l] = d.ival[j][first + l];
+    for(std::size_t j = 0; j < np; j++)
+      for(std::size_t l = 0; l < w; l++)
+        g.x[(n+j)*w + l] = d.pval[j][first + l];
+    d.tape.InitLanes(w, g.s.data());
+    d.groups.push_back(g);
+  }
+  d.ready = true;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Integrate --- Dormand-Prince 5(4) method, common step of group
+// (called in worker threads: no access to simulation context)
+//
+void Ensemble::Data::Integrate(EnsembleGroup &g, double t1) const
+{
+  const Data &d = *this;
+  const double safety = 0.9;    // keeps the new step from growing too large
+  const double max_ratio = 4.0; // ditto
+  const double pshrnk = 0.25;   // coefficient for reducing step
+  const double pgrow  = 0.20;   // coefficient for increasing step
+  const std::size_t w = g.w, nw = d.n*w;
+  double *y = g.y.data(), *x = g.x.data(), *s = g.s.data();
+  double *a1 = g.a.data(), *a2 = a1 + nw, *a3 = a2 + nw, *a4 = a3 + nw;
+  double *a5 = a4 + nw, *a6 = a5 + nw, *a7 = a6 + nw;
+  std::size_t i;
+
+  if(nw == 0 || g.t >= t1)
+    return;
+  if(!g.fsal) {                 // derivatives at start
+    for(i=0; i<nw; i++)
+      x[i] = y[i];
+    d.tape.RunLanes(w, x, g.t, a1, s);
+    g.fsal = true;
+  }
+  if(g.h <= 0)
+    g.h = std::max(std::min(d.max_step, 0.01*(t1 - g.t)), d.min_step);
+
+  while(g.t < t1) {
+    double h = std::min(g.h, d.max_step);
+    bool last = g.t + 1.01*h >= t1;       // last step (to t1)
+    if(last)
+      h = t1 - g.t;
+    const double t = g.t;
+
+    // stages (derivatives a1..a7 without h)
+    for(i=0; i<nw; i++)
+      x[i] = y[i] + h*0.2*a1[i];
+    d.tape.RunLanes(w, x, t + 0.2*h, a2, s);
+    for(i=0; i<nw; i++)
+      x[i] = y[i] + h*(3.0/40.0*a1[i] + 9.0/40.0*a2[i]);
+    d.tape.RunLanes(w, x, t + 0.3*h, a3, s);
+    for(i=0; i<nw; i++)
+      x[i] = y[i] + h*(44.0/45.0*a1[i] - 56.0/15.0*a2[i] + 32.0/9.0*a3[i]);
+    d.tape.RunLanes(w, x, t + 0.8*h, a4, s);
+    for(i=0; i<nw; i++)
+      x[i] = y[i] + h*(19372.0/6561.0*a1[i] - 25360.0/2187.0*a2[i]
+                     + 64448.0/6561.0*a3[i] - 212.0/729.0*a4[i]);
+    d.tape.RunLanes(w, x, t + 8.0/9.0*h, a5, s);
+    for(i=0; i<nw; i++)
+      x[i] = y[i] + h*(9017.0/3168.0*a1[i] - 355.0/33.0*a2[i]
+                     + 46732.0/5247.0*a3[i] + 49.0/176.0*a4[i]
+                     - 5103.0/18656.0*a5[i]);
+    d.tape.RunLanes(w, x, t + h, a6, s);
+    for(i=0; i<nw; i++)         // final state
+      x[i] = y[i] + h*(35.0/384.0*a1[i] + 500.0/1113.0*a3[i]
+                     + 125.0/192.0*a4[i] - 2187.0/6784.0*a5[i]
+                     + 11.0/84.0*a6[i]);
+    d.tape.RunLanes(w, x, t + h, a7, s);
+
+    // greatest ratio of estimated error to allowed error
+    double errmax = 0;
+    for(i=0; i<nw; i++) {
+      double eerr = fabs(h*(71.0/57600.0*a1[i] - 71.0/16695.0*a3[i]
+                          + 71.0/1920.0*a4[i] - 17253.0/339200.0*a5[i]
+                          + 22.0/525.0*a6[i] - 1.0/40.0*a7[i]));
+      double terr = fabs(d.abs_err) + fabs(d.rel_err*x[i]);
+      if(eerr > errmax*terr)    // avoid arithmetic overflow
+        errmax = terr > 0 ? eerr/terr : HUGE_VAL;
+    }
+
+    if(errmax > 1.0 && h > d.min_step) {  // reduce step, compute again
+      double ratio = safety*pow(errmax, -pshrnk);
+      g.h = std::max(ratio*h, d.min_step);
+      continue;
+    }
+    if(errmax > 1.0)
+      g.accuracy = true;        // requested accuracy cannot be achieved
+
+    // accept step
+    for(i=0; i<nw; i++) {
+      y[i] = x[i];
+      a1[i] = a7[i];            // first same as last
+    }
+    g.t = last ? t1 : t + h;
+    g.steps++;
+    double ratio = errmax > 0 ? std::min(safety*pow(errmax, -pgrow), max_ratio)
+                              : max_ratio;
+    double next = std::min(ratio*h, d.max_step);
+    g.h = last ? std::min(g.h, next) : next; // short last step
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Run --- integrate all members to t1
+//
+void Ensemble::Run(double t1, unsigned threads)
+{
+  Data &d = *data;
+  if(!d.ready || d.n != IntegratorContainer::Size())
+    SIMLIB_error(EnsembleNotInit);
+  d.abs_err = SIMLIB_AbsoluteError;
+  d.rel_err = SIMLIB_RelativeError;
+  d.min_step = SIMLIB_MinStep;
+  d.max_step = SIMLIB_MaxStep;
+  if(threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  threads = std::min<std::size_t>(threads, d.groups.size());
+  std::atomic<std::size_t> next(0);
+  auto worker = [&d, &next, t1]() {
+    std::size_t g;
+    while((g = next++) < d.groups.size())
+      d.Integrate(d.groups[g], t1);
+  };
+  if(threads <= 1)
+    worker();
+  else {
+    std::vector<std::thread> pool;
+    for(unsigned k = 0; k < threads; k++)
+      pool.emplace_back(worker);
+    for(std::thread &th : pool)
+      th.join();
+  }
+  bool accuracy = false;
+  for(EnsembleGroup &g : d.groups) {
+    accuracy = accuracy || g.accuracy;
+    g.accuracy = false;
+  }
+  if(accuracy)
+    SIMLIB_warning(AccuracyError);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Value --- state of integrator for member
+//
+double Ensemble::Value(Integrator &i, unsigned member) const
+{
+  const Data &d = *data;
+  if(member >= d.members || !d.ready)
+    SIMLIB_error(EnsembleBadMember);
+  const EnsembleGroup &g = d.groups[member / d.lanes];
+  return g.y[i.index*g.w + member % d.lanes];
+}
+
+unsigned long Ensemble::Steps() const
+{
+  unsigned long n = 0;
+  for(const EnsembleGroup &g : data->groups)
+    n += g.steps;
+  return n;
+}
+
+}
+// end
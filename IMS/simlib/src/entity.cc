@@ -15,6 +15,8 @@
 #include "simlib.h"
 #include "internal.h"
 
+#include <cstddef>
+
 ////////////////////////////////////////////////////////////////////////////
 // implementation
 //
@@ -24,15 +26,16 @@ namespace simlib3 {
 SIMLIB_IMPLEMENTATION;
 
 /// current number of entities in model
-static unsigned long SIMLIB_Entity_Count = 0L; // # of entities in model
+thread_local unsigned long SIMLIB_Entity_Count = 0L; // # of entities in model
 /// serial number of created entity
-unsigned long Entity::_Number = 0L;     // # of entity creations
+thread_local unsigned long Entity::_Number = 0L;     // # of entity creations
 
 ////////////////////////////////////////////////////////////////////////////
 ///  constructor
 Entity::Entity(Priority_t p) :
   _Ident(SIMLIB_Entity_Count++), // unique identification
   _MarkTime(0.0),
+  _QueueKey(0),
   _SPrio(0),
   Priority(p),
   _evn(0) // pointer to calendar item
@@ -41,6 +44,23 @@ Entity::Entity(Priority_t p) :
   Dprintf(("Entity#%lu{%p}::Entity(%d)", _Ident, this, p));
 }
 
+////////////////////////////////////////////////////////////////////////////
+///  priority change: index of queue with waiting entity is updated
+void EntityPriority::Set(EntityPriority_t p)
+{
+  if(p == value)
+    return;
+  value = p;
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winvalid-offsetof"
+  // the attribute is member Entity::Priority
+  Entity *e = reinterpret_cast<Entity*>(reinterpret_cast<char*>(this) -
+                                        offsetof(Entity, Priority));
+#pragma GCC diagnostic pop
+  if(Queue *q = dynamic_cast<Queue*>(e->Where()))
+    q->KeyChanged(e);
+}
+
 ////////////////////////////////////////////////////////////////////////////
 ///  destructor
 Entity::~Entity() {
@@ -59,6 +79,7 @@ void Entity::Activate(double t)
     SQS::Get(this);             // remove from calendar
   }
   SQS::ScheduleAt(this,t);
+  SIMLIB_TRACE(TRACE_ACTIVATE, 0, this, t);
 }
 
 
@@ -69,6 +90,7 @@ void Entity::Passivate()
 {
   if(!Idle())           // if scheduled
       SQS::Get(this);   // remove from calendar
+  SIMLIB_TRACE(TRACE_PASSIVATE, 0, this, 0);
 }
 
 
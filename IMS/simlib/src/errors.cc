@@ -33,65 +33,98 @@ static const char _Errors[] = {
 /* 19 */ "Scheduling before current Time\0"
 /* 20 */ "Calendar is empty\0"
 /* 21 */ "Procesis is not initialized\0"
-/* 22 */ "Bad histogram step (step<=0)\0"
-/* 23 */ "Bad histogram interval count (max=10000)\0"
-/* 24 */ "List does not have active item\0"
-/* 25 */ "Empty list\0"
-/* 26 */ "Bad queue reference\0"
-/* 27 */ "Empty WaitUntilList - can't Get() (internal error)\0"
-/* 28 */ "Bad entity reference\0"
-/* 29 */ "Entity not scheduled\0"
-/* 30 */ "Time statistic not initialized\0"
-/* 31 */ "Can't create new integrator in dynamic section\0"
-/* 32 */ "Can't destroy integrator in dynamic section\0"
-/* 33 */ "Can't create new status variable in dynamic section\0"
-/* 34 */ "Can't destroy status variable in dynamic section\0"
-/* 35 */ "Seize(): Can't interrupt facility service\0"
-/* 36 */ "Release(): Facility is released by other than currently serviced process\0"
-/* 37 */ "Release(): Can't release empty facility\0"
-/* 38 */ "Enter() request exceeded the store capacity\0"
-/* 39 */ "Leave() leaves more than currently used\0"
-/* 40 */ "SetCapacity(): can't reduce store capacity\0"
-/* 41 */ "SetQueue(): deleted (old) queue is not empty\0"
-/* 42 */ "Weibul(): lambda<=0.0 or alfa<=1.0\0"
-/* 43 */ "Erlang(): beta<1\0"
-/* 44 */ "NegBin(): q<=0 or k<=0\0"
-/* 45 */ "NegBinM(): m<=0\0"
-/* 46 */ "NegBinM(): p not in range 0..1\0"
-/* 47 */ "Poisson(lambda): lambda<=0\0"
-/* 48 */ "Geom(): q<=0\0"
-/* 49 */ "HyperGeom(): m<=0\0"
-/* 50 */ "HyperGeom(): p not in range 0..1\0"
-/* 51 */ "Can't write output file\0"
-/* 52 */ "Output file can't be open between Init() and Run()\0"
-/* 53 */ "Can't open output file\0"
-/* 54 */ "Can't close output file\0"
-/* 55 */ "Algebraic loop detected\0"
-/* 56 */ "Parameter low>=high\0"
-/* 57 */ "Parameter of quantizer <= 0\0"
-/* 58 */ "Library and header (simlib.h) version mismatch \0"
-/* 59 */ "Semaphore::V() -- bad call\0"
-/* 60 */ "Uniform(l,h) -- bad arguments\0"
-/* 61 */ "Stat::MeanValue()  No record in statistics\0"
-/* 62 */ "Stat::Disp()  Can't compute (n<2)\0"
-/* 63 */ "AlgLoop: t_min>=t_max\0"
-/* 64 */ "AlgLoop: t0 not in  <t_min,t_max>\0"
-/* 65 */ "AlgLoop: method not convergent\0"
-/* 66 */ "AlgLoop: iteration limit exceeded\0"
-/* 67 */ "AlgLoop: iterative block is not in loop\0"
-/* 68 */ "Unknown integration method\0"
-/* 69 */ "Integration method name not unique\0"
-/* 70 */ "Integration step <=0\0"
-/* 71 */ "Start-method is not single-step\0"
-/* 72 */ "Method is not multi-step\0"
-/* 73 */ "Can't switch methods in dynamic section\0"
-/* 74 */ "Can't switch start-methods in dynamic section\0"
-/* 75 */ "Rline: argument n<2\0"
-/* 76 */ "Rline: array is not sorted\0"
-/* 77 */ "Library compiled without debugging support\0"
-/* 78 */ "Dealy is too small (<=MaxStep)\0"
-/* 79 */ "Parameter can not be changed during simulation run\0"
-/* 80 */ "General error\0"
+/* 22 */ "Can't allocate process stack\0"
+/* 23 */ "Process stacks are not implemented on this system\0"
+/* 24 */ "Bad histogram step (step<=0)\0"
+/* 25 */ "Bad histogram interval count (max=10000)\0"
+/* 26 */ "Histograms with different intervals can't be merged\0"
+/* 27 */ "List does not have active item\0"
+/* 28 */ "Empty list\0"
+/* 29 */ "Bad queue reference\0"
+/* 30 */ "Empty WaitUntilList - can't Get() (internal error)\0"
+/* 31 */ "WaitUntilObserved: condition does not read any Observable\0"
+/* 32 */ "Bad entity reference\0"
+/* 33 */ "Entity not scheduled\0"
+/* 34 */ "Time statistic not initialized\0"
+/* 35 */ "Can't create new integrator in dynamic section\0"
+/* 36 */ "Can't destroy integrator in dynamic section\0"
+/* 37 */ "Can't create new status variable in dynamic section\0"
+/* 38 */ "Can't destroy status variable in dynamic section\0"
+/* 39 */ "Seize(): Can't interrupt facility service\0"
+/* 40 */ "Release(): Facility is released by other than currently serviced process\0"
+/* 41 */ "Release(): Can't release empty facility\0"
+/* 42 */ "Enter() request exceeded the store capacity\0"
+/* 43 */ "Leave() leaves more than currently used\0"
+/* 44 */ "SetCapacity(): can't reduce store capacity\0"
+/* 45 */ "SetQueue(): deleted (old) queue is not empty\0"
+/* 46 */ "FacilityPool: number of servers must be positive\0"
+/* 47 */ "FacilityPool: bad server number\0"
+/* 48 */ "Weibul(): lambda<=0.0 or alfa<=1.0\0"
+/* 49 */ "Erlang(): beta<1\0"
+/* 50 */ "NegBin(): q<=0 or k<=0\0"
+/* 51 */ "NegBinM(): m<=0\0"
+/* 52 */ "NegBinM(): p not in range 0..1\0"
+/* 53 */ "Poisson(lambda): lambda<=0\0"
+/* 54 */ "Geom(): q<=0\0"
+/* 55 */ "HyperGeom(): m<=0\0"
+/* 56 */ "HyperGeom(): p not in range 0..1\0"
+/* 57 */ "Can't write output file\0"
+/* 58 */ "Output file can't be open between Init() and Run()\0"
+/* 59 */ "Can't open output file\0"
+/* 60 */ "Can't close output file\0"
+/* 61 */ "Algebraic loop detected\0"
+/* 62 */ "Parameter low>=high\0"
+/* 63 */ "Parameter of quantizer <= 0\0"
+/* 64 */ "Library and header (simlib.h) version mismatch \0"
+/* 65 */ "Semaphore::V() -- bad call\0"
+/* 66 */ "Uniform(l,h) -- bad arguments\0"
+/* 67 */ "Stat::MeanValue()  No record in statistics\0"
+/* 68 */ "Stat::Disp()  Can't compute (n<2)\0"
+/* 69 */ "AlgLoop: t_min>=t_max\0"
+/* 70 */ "AlgLoop: t0 not in  <t_min,t_max>\0"
+/* 71 */ "AlgLoop: method not convergent\0"
+/* 72 */ "AlgLoop: iteration limit exceeded\0"
+/* 73 */ "AlgLoop: iterative block is not in loop\0"
+/* 74 */ "AlgLoopSystem: singular Jacobian, simple iteration used\0"
+/* 75 */ "Ensemble: model contains blocks evaluated by Value()\0"
+/* 76 */ "Ensemble: member number out of range\0"
+/* 77 */ "Ensemble: Init(t0) should be called before Run\0"
+/* 78 */ "Unknown integration method\0"
+/* 79 */ "Integration method name not unique\0"
+/* 80 */ "Integration step <=0\0"
+/* 81 */ "Start-method is not single-step\0"
+/* 82 */ "Method is not multi-step\0"
+/* 83 */ "Can't switch methods in dynamic section\0"
+/* 84 */ "Can't switch start-methods in dynamic section\0"
+/* 85 */ "Singular iteration matrix in implicit integration method\0"
+/* 86 */ "Rline: argument n<2\0"
+/* 87 */ "Rline: array is not sorted\0"
+/* 88 */ "Library compiled without debugging support\0"
+/* 89 */ "Dealy is too small (<=MaxStep)\0"
+/* 90 */ "Delay: interpolation order should be 1, 2 or 3\0"
+/* 91 */ "TraceExport: can't open output file\0"
+/* 92 */ "RunReplications: number of replications is 0\0"
+/* 93 */ "RunReplications: worker failed\0"
+/* 94 */ "Replications in processes are not implemented on this system\0"
+/* 95 */ "ReplicationStat: confidence interval needs 2 replications\0"
+/* 96 */ "LogicalProcess: lookahead must be > 0\0"
+/* 97 */ "LogicalProcess can't be created/deleted in RunParallel\0"
+/* 98 */ "LogicalProcess::Send: not running in RunParallel\0"
+/* 99 */ "LogicalProcess::Send: time is less than Time+lookahead\0"
+/* 100 */ "LogicalProcess::Send: entity is scheduled or in queue\0"
+/* 101 */ "RunParallel: no logical process defined\0"
+/* 102 */ "Checkpoint: can't read/write file\0"
+/* 103 */ "RestoreCheckpoint: bad file format or version\0"
+/* 104 */ "RestoreCheckpoint: use after Init() and before Run()\0"
+/* 105 */ "SaveCheckpoint: can't save Process with stack (use StepProcess)\0"
+/* 106 */ "Checkpoint: entity class is not registered (CHECKPOINT_ENTITY)\0"
+/* 107 */ "Checkpoint: object can't be saved or does not match file\0"
+/* 108 */ "OnSignal: bad signal number\0"
+/* 109 */ "RecordStart/ReplayStart: can't open file\0"
+/* 110 */ "ReplayStart: bad record file format\0"
+/* 111 */ "Replay: simulation run differs from record\0"
+/* 112 */ "Parameter can not be changed during simulation run\0"
+/* 113 */ "General error\0"
 };
 
 const char *_ErrMsg(enum _ErrEnum N)
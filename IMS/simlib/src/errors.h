@@ -29,65 +29,98 @@ enum _ErrEnum {
 /* 19 */ SchedulingBeforeTime,
 /* 20 */ EmptyCalendar,
 /* 21 */ ProcessNotInitialized,
-/* 22 */ HistoStepError,
-/* 23 */ HistoCountError,
-/* 24 */ ListActivityError,
-/* 25 */ ListEmptyError,
-/* 26 */ QueueRefError,
-/* 27 */ EmptyWUListError,
-/* 28 */ EntityRefError,
-/* 29 */ EntityIsNotScheduled,
-/* 30 */ TStatNotInitialized,
-/* 31 */ CantCreateIntg,
-/* 32 */ CantDestroyIntg,
-/* 33 */ CantCreateStatus,
-/* 34 */ CantDestroyStatus,
-/* 35 */ FacInterruptError,
-/* 36 */ ReleaseError,
-/* 37 */ ReleaseNotSeized,
-/* 38 */ EnterCapError,
-/* 39 */ LeaveManyError,
-/* 40 */ SetCapacityError,
-/* 41 */ SetQueueError,
-/* 42 */ WeibullError,
-/* 43 */ ErlangError,
-/* 44 */ NegBinError,
-/* 45 */ NegBinMError1,
-/* 46 */ NegBinMError2,
-/* 47 */ PoissonError,
-/* 48 */ GeomError,
-/* 49 */ HyperGeomError1,
-/* 50 */ HyperGeomError2,
-/* 51 */ OutFilePutError,
-/* 52 */ OutFileOpenError,
-/* 53 */ CantOpenOutFile,
-/* 54 */ CantCloseOutFile,
-/* 55 */ AlgLoopDetected,
-/* 56 */ LowGreaterHigh,
-/* 57 */ BadQntzrStep,
-/* 58 */ InconsistentHeader,
-/* 59 */ SemaphoreError,
-/* 60 */ BadUniformParam,
-/* 61 */ StatNoRecError,
-/* 62 */ StatDispError,
-/* 63 */ AL_BadBounds,
-/* 64 */ AL_BadInitVal,
-/* 65 */ AL_Diverg,
-/* 66 */ AL_MaxCount,
-/* 67 */ AL_NotInLoop,
-/* 68 */ NI_UnknownMeth,
-/* 69 */ NI_MultDefMeth,
-/* 70 */ NI_IlStepSize,
-/* 71 */ NI_NotSingleStep,
-/* 72 */ NI_NotMultiStep,
-/* 73 */ NI_CantSetMethod,
-/* 74 */ NI_CantSetStarter,
-/* 75 */ RlineErr1,
-/* 76 */ RlineErr2,
-/* 77 */ NoDebugErr,
-/* 78 */ DelayTimeErr,
-/* 79 */ ParameterChangeErr,
-/* 80 */ UserError,
+/* 22 */ ProcessStackError,
+/* 23 */ ProcessStackNotImpl,
+/* 24 */ HistoStepError,
+/* 25 */ HistoCountError,
+/* 26 */ HistoMergeError,
+/* 27 */ ListActivityError,
+/* 28 */ ListEmptyError,
+/* 29 */ QueueRefError,
+/* 30 */ EmptyWUListError,
+/* 31 */ WaitUntilObservedError,
+/* 32 */ EntityRefError,
+/* 33 */ EntityIsNotScheduled,
+/* 34 */ TStatNotInitialized,
+/* 35 */ CantCreateIntg,
+/* 36 */ CantDestroyIntg,
+/* 37 */ CantCreateStatus,
+/* 38 */ CantDestroyStatus,
+/* 39 */ FacInterruptError,
+/* 40 */ ReleaseError,
+/* 41 */ ReleaseNotSeized,
+/* 42 */ EnterCapError,
+/* 43 */ LeaveManyError,
+/* 44 */ SetCapacityError,
+/* 45 */ SetQueueError,
+/* 46 */ PoolServersError,
+/* 47 */ PoolServerError,
+/* 48 */ WeibullError,
+/* 49 */ ErlangError,
+/* 50 */ NegBinError,
+/* 51 */ NegBinMError1,
+/* 52 */ NegBinMError2,
+/* 53 */ PoissonError,
+/* 54 */ GeomError,
+/* 55 */ HyperGeomError1,
+/* 56 */ HyperGeomError2,
+/* 57 */ OutFilePutError,
+/* 58 */ OutFileOpenError,
+/* 59 */ CantOpenOutFile,
+/* 60 */ CantCloseOutFile,
+/* 61 */ AlgLoopDetected,
+/* 62 */ LowGreaterHigh,
+/* 63 */ BadQntzrStep,
+/* 64 */ InconsistentHeader,
+/* 65 */ SemaphoreError,
+/* 66 */ BadUniformParam,
+/* 67 */ StatNoRecError,
+/* 68 */ StatDispError,
+/* 69 */ AL_BadBounds,
+/* 70 */ AL_BadInitVal,
+/* 71 */ AL_Diverg,
+/* 72 */ AL_MaxCount,
+/* 73 */ AL_NotInLoop,
+/* 74 */ AL_SingularJacobian,
+/* 75 */ EnsembleNotCompiled,
+/* 76 */ EnsembleBadMember,
+/* 77 */ EnsembleNotInit,
+/* 78 */ NI_UnknownMeth,
+/* 79 */ NI_MultDefMeth,
+/* 80 */ NI_IlStepSize,
+/* 81 */ NI_NotSingleStep,
+/* 82 */ NI_NotMultiStep,
+/* 83 */ NI_CantSetMethod,
+/* 84 */ NI_CantSetStarter,
+/* 85 */ NI_SingularMatrix,
+/* 86 */ RlineErr1,
+/* 87 */ RlineErr2,
+/* 88 */ NoDebugErr,
+/* 89 */ DelayTimeErr,
+/* 90 */ DelayOrderErr,
+/* 91 */ TraceFileError,
+/* 92 */ ReplicationCountError,
+/* 93 */ ReplicationError,
+/* 94 */ ReplicationNotImpl,
+/* 95 */ ReplicationStatError,
+/* 96 */ LPLookaheadError,
+/* 97 */ LPUseError,
+/* 98 */ LPSendError,
+/* 99 */ LPSendTimeError,
+/* 100 */ LPSendEntityError,
+/* 101 */ LPNoProcessError,
+/* 102 */ CheckpointFileError,
+/* 103 */ CheckpointFormatError,
+/* 104 */ CheckpointUseError,
+/* 105 */ CheckpointProcessError,
+/* 106 */ CheckpointTypeError,
+/* 107 */ CheckpointObjectError,
+/* 108 */ SignalError,
+/* 109 */ RecordFileError,
+/* 110 */ RecordFormatError,
+/* 111 */ ReplayDivergence,
+/* 112 */ ParameterChangeErr,
+/* 113 */ UserError,
 };
 
 extern const char *_ErrMsg(enum _ErrEnum N);
@@ -121,6 +121,7 @@ void Facility::Seize(Entity * e, ServicePriority_t sp)
     if (!Busy()) {
         in = e;                 // seize by entity
         tstat(1);               // update statistics
+        SIMLIB_TRACE(TRACE_SEIZE, this, e, 1);
         return;
     }
     if (sp > in->_SPrio) {      // special case: service interrupted
@@ -131,8 +132,10 @@ void Facility::Seize(Entity * e, ServicePriority_t sp)
         in->_RemainingTime = in->ActivationTime() - Time;
         QueueIn2(*in);          // insert interrupted entity into queue2
         in->Passivate();        // wait in queue2 =====================
+        SIMLIB_TRACE(TRACE_RELEASE, this, in, 0);
         in = e;                 // seize by entity
         tstat(1);               // update statistics
+        SIMLIB_TRACE(TRACE_SEIZE, this, e, 1);
     } else {                    // go into main queue
         QueueIn(e, sp);         // insert in priority queue
         e->Passivate();         // wait in queue, activated by Release()
@@ -162,6 +165,7 @@ void Facility::Release(Entity * e)
     in = NULL;                  // empty
     tstat(0);                   // record
     tstat.n--;                  // correction !!
+    SIMLIB_TRACE(TRACE_RELEASE, this, e, 0);
 
     bool flag = false;          // correction: 5.12.91, bool:1998/08/10
     if (!(Q1->empty() || Q2->empty())) {
@@ -180,6 +184,7 @@ void Facility::Release(Entity * e)
         in = ent;               // seize again
         tstat(1);
         tstat.n--;              // correction !!!
+        SIMLIB_TRACE(TRACE_SEIZE, this, ent, 1);
         ent->Activate(Time + ent->_RemainingTime);  // schedule end of service
         return;
     }
@@ -189,6 +194,7 @@ void Facility::Release(Entity * e)
         ent->Out();             // remove from queue
         in = ent;               // seize by entity [should be here]
         tstat(1);               // update statistics
+        SIMLIB_TRACE(TRACE_SEIZE, this, ent, 1);
         ent->Activate();        // activation of entity behavior
         return;
     }
@@ -205,38 +211,42 @@ void Facility::QueueIn(Entity * e, ServicePriority_t sp)
     Dprintf((" %s --> Q1 of %s ", e->Name().c_str(), Name().c_str()));
     CHECKENTITY(e);
     e->_SPrio = sp;
+    Queue::iterator p = Q1->end();
+    // index of sorted queue (negative priority is compared as unsigned)
+    if (e->Priority < 0 || !Q1->Find(e, Queue::SERVICE_KEY, p)) {
 #if  0                          // _INS_FROM_BEGIN_SLOWER ?
-    Queue::iterator p = Q1->begin();
-    Queue::iterator end = Q1->end();
-    ServicePriority_t Sprio = e->_SPrio;
-    for (; p != end && static_cast<Entity *>(*p)->_SPrio > Sprio;       // higher service priority first
-         ++p);
-    ServicePriority_t prio = e->Priority;
-    for (; p != end && static_cast<Entity *>(*p)->_SPrio == Sprio && static_cast<Entity *>(*p)->Priority >= prio;       // higher priority first
-         ++p);
+        p = Q1->begin();
+        Queue::iterator end = Q1->end();
+        ServicePriority_t Sprio = e->_SPrio;
+        for (; p != end && static_cast<Entity *>(*p)->_SPrio > Sprio;   // higher service priority first
+             ++p);
+        ServicePriority_t prio = e->Priority;
+        for (; p != end && static_cast<Entity *>(*p)->_SPrio == Sprio && static_cast<Entity *>(*p)->Priority >= prio;   // higher priority first
+             ++p);
 #else
-    Queue::iterator begin = Q1->begin();
-    Queue::iterator p = Q1->end();
-    ServicePriority_t Sprio = e->_SPrio;
-    while (p != begin) {
-        Queue::iterator q = p;
-        --p;
-        if (static_cast<Entity *>(*p)->_SPrio >= Sprio) {       // higher service priority first
-            p = q;
-            break;
+        Queue::iterator begin = Q1->begin();
+        p = Q1->end();
+        ServicePriority_t Sprio = e->_SPrio;
+        while (p != begin) {
+            Queue::iterator q = p;
+            --p;
+            if (static_cast<Entity *>(*p)->_SPrio >= Sprio) {   // higher service priority first
+                p = q;
+                break;
+            }
         }
-    }
-    ServicePriority_t prio = e->Priority;
-    while (p != begin) {
-        Queue::iterator q = p;
-        --p;
-        if (static_cast<Entity *>(*p)->_SPrio > Sprio ||
-            static_cast<Entity *>(*p)->Priority >= prio) { // higher priority first
-            p = q;
-            break;
+        ServicePriority_t prio = e->Priority;
+        while (p != begin) {
+            Queue::iterator q = p;
+            --p;
+            if (static_cast<Entity *>(*p)->_SPrio > Sprio ||
+                static_cast<Entity *>(*p)->Priority >= prio) {  // higher priority first
+                p = q;
+                break;
+            }
         }
-    }
 #endif
+    }
     Q1->PredIns(e, p);
 }
 
@@ -246,16 +256,20 @@ void Facility::QueueIn(Entity * e, ServicePriority_t sp)
 void Facility::QueueIn2(Entity * e)
 {
     Dprintf((" %s --> Q2 of %s", e->Name().c_str(), Name().c_str()));
-    ServicePriority_t ps = e->_SPrio;
-    Queue::iterator p = Q2->begin();
-    for (; p != Q2->end()
-            && static_cast<Entity *>(*p)->_SPrio > ps;    // higher service priority first
-         ++p) { /*empty*/ }
-    ServicePriority_t prio = e->Priority;
-    for (; p != Q2->end()
-            && static_cast<Entity *>(*p)->_SPrio == ps
-            && static_cast<Entity *>(*p)->Priority >= prio;    // higher priority first
-         ++p) { /*empty*/ }
+    Queue::iterator p = Q2->end();
+    // index of sorted queue (negative priority is compared as unsigned)
+    if (e->Priority < 0 || !Q2->Find(e, Queue::SERVICE_KEY, p)) {
+        ServicePriority_t ps = e->_SPrio;
+        p = Q2->begin();
+        for (; p != Q2->end()
+                && static_cast<Entity *>(*p)->_SPrio > ps;    // higher service priority first
+             ++p) { /*empty*/ }
+        ServicePriority_t prio = e->Priority;
+        for (; p != Q2->end()
+                && static_cast<Entity *>(*p)->_SPrio == ps
+                && static_cast<Entity *>(*p)->Priority >= prio;    // higher priority first
+             ++p) { /*empty*/ }
+    }
     // next sorting -- _RestTime? FIXME ###
     Q2->PredIns(e, p);
 }
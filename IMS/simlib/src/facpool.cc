@@ -0,0 +1,301 @@
+/////////////////////////////////////////////////////////////////////////////
+//! \file  facpool.cc  Pool of facilities (multi-server station)
+//
+// Copyright (c) 1991-2018 Petr Peringer
+//
+// This library is licensed under GNU Library GPL. See the file COPYING.
+//
+
+//
+//  class FacilityPool implementation
+//
+//  c servers share single input queue. Idle servers are marked in bitmap,
+//  seize takes the idle server with the lowest number (as the usual loop
+//  over array of Facility objects). Release passes the server directly
+//  to the first entity in queue, so the bitmap changes only if the queue
+//  is empty.
+//
+
+////////////////////////////////////////////////////////////////////////////
+//  interface
+//
+
+#include "simlib.h"
+#include "internal.h"
+
+#include <climits>
+#include <cstdio>
+
+
+////////////////////////////////////////////////////////////////////////////
+//  implementation
+//
+
+namespace simlib3 {
+
+SIMLIB_IMPLEMENTATION;
+
+#define _OWNQ 0x01
+
+#define CHECKQUEUE(qptr)    do { if (!qptr) SIMLIB_error(QueueRefError); }while(0)
+#define CHECKENTITY(eptr)   do { if (!eptr) SIMLIB_error(EntityRefError); }while(0)
+
+static const unsigned BITS = sizeof(unsigned long) * CHAR_BIT;
+
+////////////////////////////////////////////////////////////////////////////
+//  constructors
+//
+FacilityPool::FacilityPool(const char *name, unsigned n, Queue *queue) :
+  _Qflag(0),
+  servers(n),
+  idle((n + BITS - 1) / BITS),
+  nbusy(0),
+  Q(queue)
+{
+  CHECKQUEUE(queue);
+  Dprintf(("FacilityPool::FacilityPool(\"%s\",%u,%s)",
+           name ? name : "", n, queue->Name().c_str()));
+  if (n == 0)
+    SIMLIB_error(PoolServersError);
+  if (name)
+    SetName(name);
+  Clear();
+}
+
+FacilityPool::FacilityPool(const char *name, unsigned n) :
+  FacilityPool(name, n, new Queue("Q"))
+{
+  _Qflag = _OWNQ;
+}
+
+FacilityPool::FacilityPool(unsigned n) :
+  FacilityPool(0, n)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////
+//  destructor
+//
+FacilityPool::~FacilityPool()
+{
+  Dprintf(("FacilityPool::~FacilityPool() // \"%s\" ", Name().c_str()));
+  Clear();
+  if (OwnQueue())
+    delete Q;
+}
+
+////////////////////////////////////////////////////////////////////////////
+//  SetQueue
+//
+void FacilityPool::SetQueue(Queue *queue)
+{
+  CHECKQUEUE(queue);
+  if (OwnQueue()) {
+    if (QueueLen() > 0)
+      SIMLIB_warning(SetQueueError);
+    delete Q;           // delete internal queue
+    _Qflag &= ~_OWNQ;
+  }
+  Q = queue;
+}
+
+bool FacilityPool::OwnQueue() const
+{
+  return (_Qflag & _OWNQ) != 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+//  FirstIdle --- the lowest number of idle server (pool is not full)
+//
+unsigned FacilityPool::FirstIdle() const
+{
+  unsigned w = 0;
+  while (idle[w] == 0)
+    w++;
+  unsigned long x = idle[w];
+#if defined(__GNUC__)
+  return w * BITS + __builtin_ctzl(x);
+#else
+  unsigned i = 0;
+  while ((x & 1) == 0) { x >>= 1; i++; }
+  return w * BITS + i;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////
+//  Start --- start service of entity at server i
+//
+void FacilityPool::Start(unsigned i, Entity *e)
+{
+  servers[i].in = e;
+  servers[i].n++;
+  servers[i].start = Time;
+  SIMLIB_TRACE(TRACE_SEIZE, this, e, nbusy);
+}
+
+////////////////////////////////////////////////////////////////////////////
+//  Seize --- seize idle server or wait in queue
+//
+void FacilityPool::Seize(Entity *e)
+{
+  Dprintf(("%s.Seize(%s)", Name().c_str(), e->Name().c_str()));
+  CHECKENTITY(e);
+  if (e != Current)
+    SIMLIB_error(EntityRefError);
+  if (!Full()) {
+    unsigned i = FirstIdle();
+    idle[i / BITS] &= ~(1UL << (i % BITS));
+    nbusy++;
+    tstat(nbusy);               // update statistics
+    Start(i, e);
+    return;
+  }
+  QueueIn(e);                   // insert in priority queue
+  e->Passivate();               // wait in queue, activated by Release()
+  // =======================================================
+  // continue after activation
+  Dprintf(("%s.Seize(%s) from Q", Name().c_str(), e->Name().c_str()));
+}
+
+////////////////////////////////////////////////////////////////////////////
+//  Release --- release server, the first entity in queue seizes it
+//
+void FacilityPool::Release(Entity *e)
+{
+  Dprintf(("%s.Release(%s)", Name().c_str(), e->Name().c_str()));
+  CHECKENTITY(e);
+  if (nbusy == 0)
+    SIMLIB_error(ReleaseNotSeized);     // not seized
+  int i = Server(e);
+  if (i < 0)
+    SIMLIB_error(ReleaseError);         // seized by other entity
+  ServerData &s = servers[i];
+  s.busy += Time - s.start;
+  s.in = nullptr;
+  SIMLIB_TRACE(TRACE_RELEASE, this, e, nbusy - 1);
+  if (!Q->empty()) {            // server passed to first waiting entity
+    Entity *ent = Q->front();
+    ent->Out();                 // remove from queue
+    Start(i, ent);
+    ent->Activate();            // activation of entity behavior
+    return;
+  }
+  idle[i / BITS] |= 1UL << (i % BITS);
+  nbusy--;
+  tstat(nbusy);                 // record
+}
+
+////////////////////////////////////////////////////////////////////////////
+//  QueueIn --- go into input queue
+//
+void FacilityPool::QueueIn(Entity *e)
+{
+  Dprintf((" %s --> Q of %s ", e->Name().c_str(), Name().c_str()));
+  CHECKENTITY(e);
+  Q->Insert(e);
+}
+
+////////////////////////////////////////////////////////////////////////////
+//  servers
+//
+Entity *FacilityPool::In(unsigned i) const
+{
+  if (i >= servers.size())
+    SIMLIB_error(PoolServerError);
+  return servers[i].in;
+}
+
+int FacilityPool::Server(Entity *e) const
+{
+  for (unsigned i = 0; i < servers.size(); i++)
+    if (servers[i].in == e)
+      return i;
+  return -1;
+}
+
+unsigned long FacilityPool::Requests(unsigned i) const
+{
+  if (i >= servers.size())
+    SIMLIB_error(PoolServerError);
+  return servers[i].n;
+}
+
+double FacilityPool::Utilization(unsigned i) const
+{
+  if (i >= servers.size())
+    SIMLIB_error(PoolServerError);
+  double t = Time - tstat.StartTime();
+  if (t <= 0)
+    return 0;
+  const ServerData &s = servers[i];
+  return (s.busy + (s.in ? Time - s.start : 0)) / t;
+}
+
+double FacilityPool::Utilization() const
+{
+  if (Time <= tstat.StartTime())
+    return 0;
+  return tstat.MeanValue() / servers.size();
+}
+
+////////////////////////////////////////////////////////////////////////////
+//  initialization
+//
+void FacilityPool::Clear()
+{
+  Dprintf(("%s.Clear()", Name().c_str()));
+  if (OwnQueue())
+    Q->Clear();
+  for (ServerData &s : servers)
+    s = ServerData{ nullptr, 0, 0.0, 0.0 };
+  for (unsigned long &w : idle)
+    w = ~0UL;
+  if (servers.size() % BITS)    // unused bits of the last word
+    idle.back() = (1UL << (servers.size() % BITS)) - 1;
+  nbusy = 0;
+  tstat.Clear();
+}
+
+////////////////////////////////////////////////////////////////////////////
+//  Output
+//
+void FacilityPool::Output() const
+{
+  char s[100];
+  Print("+----------------------------------------------------------+\n");
+  Print("| FACILITY POOL %-42s |\n", Name().c_str());
+  Print("+----------------------------------------------------------+\n");
+  sprintf(s, " Servers = %u  (%u busy, %u idle) ",
+          Servers(), nbusy, Servers() - nbusy);
+  Print("| %-56s |\n", s);
+  unsigned long n = 0;
+  for (const ServerData &sd : servers)
+    n += sd.n;
+  if (n > 0) {
+    sprintf(s, " Time interval = %g - %g ", tstat.StartTime(), (double)Time);
+    Print(  "| %-56s |\n", s);
+    Print(  "|  Number of requests = %-28lu       |\n", n);
+    if (Time > tstat.StartTime()) {
+      Print("|  Average busy servers = %-26g       |\n", tstat.MeanValue());
+      Print("|  Average utilization = %-27g       |\n", Utilization());
+    }
+    Print("+----------------------------------------------------------+\n");
+    Print("|  server      requests    utilization                     |\n");
+    for (unsigned i = 0; i < Servers(); i++)
+      Print("|  %6u  %12lu  %13g                     |\n",
+            i, servers[i].n, Utilization(i));
+  }
+  Print("+----------------------------------------------------------+\n");
+  if (OwnQueue()) {
+    if (Q->StatN.Number() > 0) { // used
+      Print("  Input queue '%s.Q'\n", Name().c_str());
+      Q->Output();
+    }
+  }
+  else
+    Print("  External input queue '%s'\n", Q->Name().c_str());
+  Print("\n");
+}
+
+}
+// end
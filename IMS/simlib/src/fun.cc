@@ -19,6 +19,7 @@
 #include "internal.h"
 
 #include <cmath>          // functions
+#include <typeinfo>
 
 ////////////////////////////////////////////////////////////////////////////
 // implementation
@@ -42,6 +43,11 @@ double Function1::Value() {
   return ret;
 }
 
+unsigned Function1::_Compile(EvaluationTape &t) {
+  if(typeid(*this) != typeid(Function1)) return t.Call(this);
+  return t.Function(f, this);
+}
+
 #if 0
 const char *Function1::Name() const {
   if(HasName()) return _name;
@@ -63,6 +69,11 @@ double Function2::Value() {
   return ret;
 }
 
+unsigned Function2::_Compile(EvaluationTape &t) {
+  if(typeid(*this) != typeid(Function2)) return t.Call(this);
+  return t.Function(f, this);
+}
+
 #if 0
 const char *Function2::Name() const {
   if(HasName()) return _name;
@@ -53,6 +53,8 @@
 #  error "simlib.h should be included first"
 #endif
 
+#include <unordered_map>
+
 namespace simlib3 {
 
 ////////////////////////////////////////////////////////////////////////////
@@ -82,7 +84,7 @@ enum SIMLIB_Phase_t {
 };
 //! This variable contains the current phase of experiment
 //! (used for internal checking)
-extern const SIMLIB_Phase_t &Phase;
+extern thread_local const SIMLIB_Phase_t &Phase;
 
 ////////////////////////////////////////////////////////////////////////////
 // debugging ...
@@ -94,7 +96,7 @@ extern const SIMLIB_Phase_t &Phase;
 #   define DEBUG(c,s)
 #   define DEBUG_INFO
 #else
-    extern double SIMLIB_Time;            // simulation time
+    extern thread_local double SIMLIB_Time; // simulation time
 #   define DEBUG_INFO "/debug"
     extern unsigned long SIMLIB_debug_flag; // debugging flags
 #   define Dprintf(f) \
@@ -181,34 +183,35 @@ typedef void (*VoidFunctionPtr)(); // ptr to void function
 // internal variables:
 //
 
-extern bool SIMLIB_DynamicFlag;             // in dynamic section
-extern bool SIMLIB_ResetStatus;             // restart flag
+extern thread_local bool SIMLIB_DynamicFlag;    // in dynamic section
+extern thread_local bool SIMLIB_ResetStatus;    // restart flag
 
-extern SIMLIB_Phase_t SIMLIB_Phase;         // phase of simulation experiment
+extern thread_local SIMLIB_Phase_t SIMLIB_Phase; // phase of simulation experiment
 
-extern Entity *SIMLIB_Current;              // currently active entity
+extern thread_local Entity *SIMLIB_Current;     // currently active entity
 
-extern int SIMLIB_ERRNO;                    // error number
+extern thread_local int SIMLIB_ERRNO;           // error number
 
-extern bool SIMLIB_ConditionFlag;           // change of condition vector
-extern bool SIMLIB_ContractStepFlag;        // requests shorter step
-extern double SIMLIB_ContractStep;          // requested step size
+extern thread_local bool SIMLIB_ConditionFlag;      // change of condition vector
+extern thread_local bool SIMLIB_ContractStepFlag;   // requests shorter step
+extern thread_local double SIMLIB_ContractStep;     // requested step size
+extern thread_local bool SIMLIB_EventLocation;      // locate state events
 
-extern double SIMLIB_StepStartTime;         // last step time
-extern double SIMLIB_DeltaTime;             // Time-s_StepStartTime
+extern thread_local double SIMLIB_StepStartTime;    // last step time
+extern thread_local double SIMLIB_DeltaTime;        // Time-s_StepStartTime
 
-extern double SIMLIB_OptStep;               // optimal step
-extern double SIMLIB_MinStep;               // minimal step
-extern double SIMLIB_MaxStep;               // max. step
-extern double SIMLIB_StepSize;              // actual step
+extern thread_local double SIMLIB_OptStep;          // optimal step
+extern thread_local double SIMLIB_MinStep;          // minimal step
+extern thread_local double SIMLIB_MaxStep;          // max. step
+extern thread_local double SIMLIB_StepSize;         // actual step
 
-extern double SIMLIB_AbsoluteError;         // absolute error tolerance
-extern double SIMLIB_RelativeError;         // relative error
+extern thread_local double SIMLIB_AbsoluteError;    // absolute error tolerance
+extern thread_local double SIMLIB_RelativeError;    // relative error
 
-extern double SIMLIB_StartTime;       // time of simulation start
-extern double SIMLIB_Time;            // simulation time
-extern double SIMLIB_NextTime;        // next-event time
-extern double SIMLIB_EndTime;         // time of simulation end
+extern thread_local double SIMLIB_StartTime;   // time of simulation start
+extern thread_local double SIMLIB_Time;        // simulation time
+extern thread_local double SIMLIB_NextTime;    // next-event time
+extern thread_local double SIMLIB_EndTime;     // time of simulation end
 
 // TODO: move to context (public methods with prefix calendar::?)
 
@@ -218,10 +221,18 @@ extern double SIMLIB_EndTime;         // time of simulation end
 namespace SQS {
     void ScheduleAt(Entity *e, double t);// time t
     Entity *GetFirst();                  // remove first item
+    Entity *First();                     // first item (not removed)
     void Get(Entity *e);                 // remove entity e
     bool Empty();                        // ?empty calendar
+    unsigned Size();                     // number of scheduled entities
     void Clear();                        // remove all items
     int debug_print();
+    struct Item {                        // scheduled entity
+        Entity *entity;
+        double time;
+        EntityPriority_t priority;       // scheduling priority
+    };
+    void Contents(std::vector<Item> &v); // all items in order (checkpoint)
 };
 
 /// macro for simple assignement to internal time variables
@@ -234,10 +245,60 @@ void SIMLIB_DoConditions();          // perform state events
 void SIMLIB_WUClear();               // clear WUList
 
 
+//////////////////////////////////////////////////////////////////////////
+// trace recording (see trace.cc), active after TraceStart()
+//
+enum SIMLIB_TraceType_t {
+  TRACE_RUN,            // entity behavior (value = wall-clock duration)
+  TRACE_ACTIVATE,       // value = activation time
+  TRACE_PASSIVATE,
+  TRACE_QUEUE_IN,       // value = queue length
+  TRACE_QUEUE_OUT,
+  TRACE_SEIZE,
+  TRACE_RELEASE,
+  TRACE_ENTER,          // value = used capacity
+  TRACE_LEAVE
+};
+extern thread_local bool SIMLIB_Tracing;
+void SIMLIB_TraceRecord(SIMLIB_TraceType_t t, const SimObject *o,
+                        const Entity *e, double value);
+void SIMLIB_TraceRunBegin(const Entity *e);
+void SIMLIB_TraceRunEnd();
+unsigned SIMLIB_TraceSerial(const SimObject *o); // assign serial number
+
+/// record trace item if tracing is active (cheap test only)
+#define SIMLIB_TRACE(type,object,entity,value) do { \
+        if(SIMLIB_Tracing) \
+            SIMLIB_TraceRecord(type, object, entity, value); \
+        } while(0)
+
+// record and replay of simulation runs (see replay.cc)
+extern thread_local bool SIMLIB_Recording;
+void SIMLIB_RecordRandom(double r);
+void SIMLIB_RecordBegin(const Entity *e);
+void SIMLIB_RecordEnd();
+
+extern thread_local unsigned long SIMLIB_Entity_Count; // entity identification counter
+
+// Run() calls SIMLIB_Poll() (user break, signals, progress reports)
+// when the counter (decremented by each event/step) reaches zero
+extern thread_local unsigned long SIMLIB_PollCount;
+void SIMLIB_Poll();
+
+// threads of parallel runs inherit actions of signals (see signals.cc)
+struct SIMLIB_SignalActions;
+const SIMLIB_SignalActions *SIMLIB_SignalGet();       // actions of thread
+void SIMLIB_SignalInherit(const SIMLIB_SignalActions *parent);
+
+extern thread_local RandomStream SIMLIB_RandomDefault; // default stream of base generator
+void SIMLIB_RandomStream(const RandomStream &base, unsigned long i); // select stream i of base
+double (*SIMLIB_RandomBaseSet(double (*gen)()))(); // set base generator, returns previous one
+
+
 //////////////////////////////////////////////////////////////////////////
 // MACROS --- Hooks into simulation control algorithm
 //
-// we use static pointers to void function()
+// we use static (thread-local) pointers to void function()
 // function can be installed by calling INSTALL_HOOK(hook_name,function)
 // used mainly in run.cc
 
@@ -265,7 +326,7 @@ void SIMLIB_WUClear();               // clear WUList
 // can be used at global scope
 //
 #define DEFINE_HOOK(name)  \
-        static void (* HOOK_PTR_NAME(name) )() = 0; \
+        static thread_local void (* HOOK_PTR_NAME(name) )() = 0; \
         void HOOK_INST_NAME(name)(void (*f)())  { HOOK_PTR_NAME(name) = f; }
 
 
@@ -321,6 +382,83 @@ class AlgLoopDetector {
 };
 
 
+////////////////////////////////////////////////////////////////////////////
+//! evaluation tape --- inputs of all integrators compiled to flat sequence
+//! of instructions in topological order (see tape.cc) <br>
+//! Blocks with known semantics are compiled to operations on slots (pure
+//! blocks shared in expressions are evaluated once), other blocks are
+//! called by Value().
+class EvaluationTape {
+ public:
+  enum Op { LOAD, CALL, NEG, ADD, SUB, MUL, DIV, FUN1, FUN2, STORE, EVAL };
+ private:
+  struct Instruction {
+    Op op;
+    unsigned r, a, b;                   // result and operand slots
+    union {
+      const double *p;                  // LOAD
+      double *q;                        // STORE
+      aContiBlock *block;               // CALL
+      Integrator *integrator;           // EVAL
+      double (*f1)(double);             // FUN1
+      double (*f2)(double, double);     // FUN2
+    };
+  };
+  std::vector<Instruction> code;
+  std::vector<double> slot;             // constants and results
+  std::vector<bool> pure;               // slot is not result of CALL
+  std::unordered_map<aContiBlock *, unsigned> done; // compiled pure blocks
+  bool linear;                          // no calls (can be differentiated)
+  std::size_t lanes;                    // # of inputs of lanes (see Bind)
+  std::vector<double> da, db, ds;       // partial derivatives, tangents
+  static thread_local EvaluationTape *instance;
+  static thread_local unsigned long builds; // # of Build() calls
+  unsigned Slot(bool p);
+  Instruction &Emit(Op op, unsigned r);
+  void Build();                         // compile inputs of integrators
+ public:
+  void Clear();                         // empty tape
+  void Store(unsigned a, double *q);    // output: *q = slot a
+  void Run();                           // evaluate
+  //! forward mode derivatives of outputs f[0..n) by variables x[0..n)
+  bool Linearize(const double *x, std::size_t n, const double *f,
+                 double *J, double *dfdt);
+  //! lanes (ensembles): LOAD of *x[k] reads lanes of input k, STORE to
+  //! f[k] writes lanes of output k, false if tape contains calls
+  bool Bind(const double *const *x, std::size_t nx, const double *f);
+  std::size_t Slots() const { return slot.size(); }
+  void InitLanes(std::size_t w, double *s) const; // constants in all lanes
+  void RunLanes(std::size_t w, const double *x, double t, double *f,
+                double *s) const;       // evaluate w lanes (slots s)
+  unsigned Compile(aContiBlock *b);     // block output (with loop check)
+  unsigned Compile(const Input &i) { return Compile(i.bp); }
+  unsigned Forward(aContiBlock1 *b) { return Compile(b->input); }
+  unsigned Const(double x);
+  unsigned Load(const double *p);
+  unsigned Call(aContiBlock *b);
+  unsigned Unary(Op op, aContiBlock1 *b);
+  unsigned Binary(Op op, aContiBlock2 *b);
+  unsigned Function(double (*f)(double), aContiBlock1 *b);
+  unsigned Function(double (*f)(double, double), aContiBlock2 *b);
+  static void Evaluate();               // evaluate inputs of integrators
+  static bool Jacobian(double *J, double *dfdt); // d(inputs)/d(states)
+  //! version of integrator tape (other tapes are compiled again)
+  static unsigned long Builds() { return builds; }
+};
+
+////////////////////////////////////////////////////////////////////////////
+//! dense LU decomposition with partial pivoting (see lu.cc)
+class LUDecomposition {
+  std::vector<double> a;                // matrix, factors (row-major)
+  std::vector<std::size_t> p;           // pivot rows
+  std::size_t n;
+ public:
+  LUDecomposition(): n(0) {}
+  double *Matrix(std::size_t size);     // set size, matrix to fill
+  bool Factor();                        // false: singular matrix
+  void Solve(double *b) const;          // solve A x = b, x overwrites b
+};
+
 ////////////////////////////////////////////////////////////////////////////
 // printf-like function for creating name strings
 std::string SIMLIB_create_tmp_name(const char *fmt, ...);
@@ -20,6 +20,7 @@
 #include "internal.h"
 
 #include <cmath>
+#include <typeinfo>
 
 
 ////////////////////////////////////////////////////////////////////////////
@@ -29,34 +30,35 @@ namespace simlib3 {
 
 SIMLIB_IMPLEMENTATION;
 
-int SIMLIB_ERRNO=0;
+thread_local int SIMLIB_ERRNO=0;
 
-double SIMLIB_StepStartTime;         //!< last step time
-double SIMLIB_DeltaTime;             //!< Time-SIMLIB_StepStartTime
+thread_local double SIMLIB_StepStartTime;   //!< last step time
+thread_local double SIMLIB_DeltaTime;       //!< Time-SIMLIB_StepStartTime
 
-double SIMLIB_OptStep;               //!< optimal step
-double SIMLIB_MinStep=1e-10;         //!< minimal step
-double SIMLIB_MaxStep=1;             //!< max. step
-double SIMLIB_StepSize;              //!< actual step
+thread_local double SIMLIB_OptStep;         //!< optimal step
+thread_local double SIMLIB_MinStep=1e-10;   //!< minimal step
+thread_local double SIMLIB_MaxStep=1;       //!< max. step
+thread_local double SIMLIB_StepSize;        //!< actual step
 
-double SIMLIB_AbsoluteError=0;       //!< absolute error
-double SIMLIB_RelativeError=0.001;   //!< relative error
+thread_local double SIMLIB_AbsoluteError=0;     //!< absolute error
+thread_local double SIMLIB_RelativeError=0.001; //!< relative error
 
 // step limits
-const double &MinStep=SIMLIB_MinStep;        //!< minimal integration step
-const double &MaxStep=SIMLIB_MaxStep;        //!< maximal integration step
-const double &StepSize=SIMLIB_StepSize;      //!< actual integration step
-const double &OptStep=SIMLIB_OptStep;        //!< optimal integration step
+thread_local const double &MinStep=SIMLIB_MinStep;   //!< minimal integration step
+thread_local const double &MaxStep=SIMLIB_MaxStep;   //!< maximal integration step
+thread_local const double &StepSize=SIMLIB_StepSize; //!< actual integration step
+thread_local const double &OptStep=SIMLIB_OptStep;   //!< optimal integration step
 //const double &StepStartTime=SIMLIB_StepStartTime; // start of step
 
 // error params
-const double &AbsoluteError=SIMLIB_AbsoluteError; //!< max. abs. error of integration
-const double &RelativeError=SIMLIB_RelativeError; //!< max. rel. error
+thread_local const double &AbsoluteError=SIMLIB_AbsoluteError; //!< max. abs. error of integration
+thread_local const double &RelativeError=SIMLIB_RelativeError; //!< max. rel. error
 
-bool SIMLIB_DynamicFlag = false;          //!< in dynamic section
+thread_local bool SIMLIB_DynamicFlag = false;          //!< in dynamic section
 
-bool SIMLIB_ContractStepFlag = false;     //!< requests shorter step
-double  SIMLIB_ContractStep = SIMLIB_MAXTIME;    //!< requested step size
+thread_local bool SIMLIB_ContractStepFlag = false;    //!< requests shorter step
+thread_local double SIMLIB_ContractStep = SIMLIB_MAXTIME; //!< requested step size
+thread_local bool SIMLIB_EventLocation = false;       //!< locate state events
 
 
 ////////////////////////////////////////////////////////////////////////////
@@ -83,7 +85,7 @@ void ContractStep(double time)
 ////////////////////////////////////////////////////////////////////////////
 /// \var bool SIMLIB_ResetStatus
 /// flag set if there is a need for integration method restart
-bool SIMLIB_ResetStatus = false;
+thread_local bool SIMLIB_ResetStatus = false;
 
 
 ////////////////////////////////////////////////////////////////////////////
@@ -119,11 +121,23 @@ void SetAccuracy(double relerr)
 }
 
 
+////////////////////////////////////////////////////////////////////////////
+//  SetEventLocation -- locate state events by root finding (see cond.cc)
+//
+void SetEventLocation(bool on)
+{
+  SIMLIB_EventLocation = on;
+  Dprintf(("SetEventLocation(%d)", on));
+}
+
+
 ////////////////////////////////////////////////////////////////////////////
 //  SIMLIB_ContinueInit -- initialize continuous subsystem
 //
 void SIMLIB_ContinueInit()
 {
+  SIMLIB_TapeValid = false;               // compile model at start
+
   SIMLIB_OptStep = SIMLIB_MaxStep;        // initial step size
   SIMLIB_StepStartTime = SIMLIB_Time;
   SIMLIB_DeltaTime = 0.0;
@@ -157,6 +171,7 @@ void Integrator::CtrInit() {
   }
   // put integrator into list & retain position of it
   it_list=IntegratorContainer::Insert(this);
+  SIMLIB_TapeValid = false;  // compile again
   // Dprintf(("constructor: Integrator[%p]  #%d", this, Number));
   SIMLIB_ResetStatus = true; //???????????????????????????????
 }
@@ -214,13 +229,15 @@ Integrator::~Integrator()
     SIMLIB_error(CantDestroyIntg);  // can't in 'dynamic section' !!!
   }
   IntegratorContainer::Erase(it_list);  // remove integrator from list
+  SIMLIB_TapeValid = false;  // compile again
 }
 
 
 ////////////////////////////////////////////////////////////////////////////
 /// set initial value of integrator
 void Integrator::Init(double initvalue) {
-  ss = initval = initvalue;
+  initval = initvalue;
+  SetState(initvalue);
   SIMLIB_ResetStatus = true; // if in simulation
 }
 
@@ -229,7 +246,7 @@ void Integrator::Init(double initvalue) {
 /// set the integrator status value (step change)
 void Integrator::Set(double value)
 {
-  ss = value;
+  SetState(value);
   SIMLIB_ResetStatus = true;  // always
 }
 
@@ -239,8 +256,8 @@ void Integrator::Set(double value)
 void Integrator::Eval()
 {
 //  Dprintf(("START: Integrator[%p]::Eval()", this));
-  dd = InputValue();
-//  Dprintf(("STOP: Integrator[%p]::Eval() %g ", this, dd));
+  SetDiff(InputValue());
+//  Dprintf(("STOP: Integrator[%p]::Eval() %g ", this, GetDiff()));
 }
 
 
@@ -248,8 +265,15 @@ void Integrator::Eval()
 /// get integrator status (output value)
 double Integrator::Value()
 {
-//  Dprintf(("Integrator[%p]::Value() = %g ", this, ss));
-  return ss;
+//  Dprintf(("Integrator[%p]::Value() = %g ", this, GetState()));
+  return GetState();
+}
+
+/// evaluation tape: state of integrator (see tape.cc)
+unsigned Integrator::_Compile(EvaluationTape &t)
+{
+  if(typeid(*this) != typeid(Integrator)) return t.Call(this);
+  return t.Load(&IntegratorContainer::State()[index]);
 }
 
 
@@ -268,7 +292,9 @@ const char *Integrator::Name() const
 /**********************************************************/
 
 /// list of integrators
-std::list<Integrator*>* IntegratorContainer::ListPtr=NULL;
+thread_local std::list<Integrator*>* IntegratorContainer::ListPtr=NULL;
+/// arrays of integrator values
+thread_local IntegratorContainer::Arrays* IntegratorContainer::ArraysPtr=NULL;
 
 ////////////////////////////////////////////////////////////////////////////
 //  IntegratorContainer::Instance
@@ -279,6 +305,7 @@ std::list<Integrator*>* IntegratorContainer::Instance(void)
   Dprintf(("IntegratorContainer::Instance()(%p)",ListPtr));
   if(ListPtr==NULL) {  // list is not created
     ListPtr = new std::list<Integrator*>;  // create it
+    ArraysPtr = new Arrays;
     Dprintf(("created: %p", ListPtr));
   }
   return ListPtr;
@@ -293,6 +320,11 @@ IntegratorContainer::iterator IntegratorContainer::Insert(Integrator* ptr)
 {
   Dprintf(("IntegratorContainer::Insert(%p)",ptr));
   (void)Instance();  // create list if it is not created
+  ptr->index = ListPtr->size();  // at the end of arrays
+  ArraysPtr->s.push_back(0.0);
+  ArraysPtr->sl.push_back(0.0);
+  ArraysPtr->d.push_back(0.0);
+  ArraysPtr->dl.push_back(0.0);
   return ListPtr->insert(ListPtr->end(),ptr);  // insert element
 } // Insert
 
@@ -304,7 +336,14 @@ void IntegratorContainer::Erase(IntegratorContainer::iterator it)
 {
   Dprintf(("IntegratorContainer::Erase(...)"));
   if(ListPtr!=NULL) {  // list is created
-    ListPtr->erase(it);  // exclude element
+    std::size_t i = (*it)->index;
+    Arrays &a = *ArraysPtr;
+    a.s.erase(a.s.begin()+i);    // move values of next integrators
+    a.sl.erase(a.sl.begin()+i);
+    a.d.erase(a.d.begin()+i);
+    a.dl.erase(a.dl.begin()+i);
+    for(iterator ip=ListPtr->erase(it); ip!=ListPtr->end(); ++ip)
+      (*ip)->index--;
   }
 } // Erase
 
@@ -317,10 +356,8 @@ void IntegratorContainer::NtoL()
 {
   Dprintf(("IntegratorContainer::NtoL()"));
   if(ListPtr!=NULL) {  // list is created
-    iterator end_it=ListPtr->end();
-    for(iterator ip=ListPtr->begin(); ip!=end_it; ++ip) {
-      (*ip)->Save();
-    }
+    ArraysPtr->sl = ArraysPtr->s;
+    ArraysPtr->dl = ArraysPtr->d;
   }
 } // NtoL
 
@@ -332,10 +369,8 @@ void IntegratorContainer::LtoN()
 {
   Dprintf(("IntegratorContainer::LtoN)"));
   if(ListPtr!=NULL) {  // list is created
-    iterator end_it=ListPtr->end();
-    for(iterator ip=ListPtr->begin(); ip!=end_it; ++ip) {
-      (*ip)->Restore();
-    }
+    ArraysPtr->s = ArraysPtr->sl;
+    ArraysPtr->d = ArraysPtr->dl;
   }
 } // LtoN
 
@@ -478,7 +513,7 @@ void Status::Eval()
 /******************************************************/
 
 /// list of status variables
-std::list<Status*>* StatusContainer::ListPtr=NULL;
+thread_local std::list<Status*>* StatusContainer::ListPtr=NULL;
 
 
 ////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,98 @@
+/////////////////////////////////////////////////////////////////////////////
+//! \file lu.cc  Dense LU decomposition (implicit integration methods)
+//
+// Copyright (c) 1991-2018 Petr Peringer
+//
+// This library is licensed under GNU Library GPL. See the file COPYING.
+//
+
+//
+// Gaussian elimination with partial pivoting, factors are stored in
+// place of the matrix (row-major), L has unit diagonal.
+//
+
+////////////////////////////////////////////////////////////////////////////
+// interface
+//
+
+#include "simlib.h"
+#include "internal.h"
+
+#include <cmath>
+#include <utility>
+
+////////////////////////////////////////////////////////////////////////////
+// implementation
+//
+
+namespace simlib3 {
+
+SIMLIB_IMPLEMENTATION;
+
+////////////////////////////////////////////////////////////////////////////
+// Matrix --- set size, returns matrix to fill (content is undefined)
+//
+double *LUDecomposition::Matrix(std::size_t size)
+{
+  n = size;
+  a.resize(n * n);
+  p.resize(n);
+  return a.data();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Factor --- decomposition PA = LU, false if the matrix is singular
+//
+bool LUDecomposition::Factor()
+{
+  for(std::size_t k = 0; k < n; k++) {
+    std::size_t m = k;                  // pivot row
+    double big = std::fabs(a[k*n + k]);
+    for(std::size_t i = k + 1; i < n; i++)
+      if(std::fabs(a[i*n + k]) > big) {
+        big = std::fabs(a[i*n + k]);
+        m = i;
+      }
+    p[k] = m;
+    if(big == 0 || !std::isfinite(big))
+      return false;
+    if(m != k)
+      for(std::size_t j = 0; j < n; j++)
+        std::swap(a[k*n + j], a[m*n + j]);
+    double *rk = &a[k*n];
+    for(std::size_t i = k + 1; i < n; i++) {
+      double *ri = &a[i*n];
+      double l = ri[k] /= rk[k];
+      if(l != 0)
+        for(std::size_t j = k + 1; j < n; j++)
+          ri[j] -= l * rk[j];
+    }
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Solve --- solve A x = b using factors, x overwrites b
+//
+void LUDecomposition::Solve(double *b) const
+{
+  for(std::size_t k = 0; k < n; k++) { // permutation and forward substitution
+    if(p[k] != k)
+      std::swap(b[k], b[p[k]]);
+    const double *rk = &a[k*n];
+    double s = b[k];
+    for(std::size_t j = 0; j < k; j++)
+      s -= rk[j] * b[j];
+    b[k] = s;
+  }
+  for(std::size_t k = n; k-- > 0; ) {   // back substitution
+    const double *rk = &a[k*n];
+    double s = b[k];
+    for(std::size_t j = k + 1; j < n; j++)
+      s -= rk[j] * b[j];
+    b[k] = s / rk[k];
+  }
+}
+
+}
+// end
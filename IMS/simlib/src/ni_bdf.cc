@@ -0,0 +1,356 @@
+/////////////////////////////////////////////////////////////////////////////
+// ni_bdf.cc
+//
+// Copyright (c) 1991-2018 Petr Peringer
+//
+// This library is licensed under GNU Library GPL. See the file COPYING.
+//
+
+//
+//  numerical integration: backward differentiation formulas (stiff systems)
+//
+
+////////////////////////////////////////////////////////////////////////////
+//  interface
+//
+#include "simlib.h"
+#include "internal.h"
+#include "ni_bdf.h"
+#include <cmath>
+#include <cstddef>
+
+
+////////////////////////////////////////////////////////////////////////////
+//  implementation
+//
+namespace simlib3 {
+
+SIMLIB_IMPLEMENTATION;
+
+
+////////////////////////////////////////////////////////////////////////////
+//  BDF of order k with variable coefficients
+//
+/*  Formula:
+
+    p(t) interpolates y(t1), y(t0), y(t-1), ... y(t1-k)    (t1 = t0 + h)
+    p'(t1) = f(t1, y(t1))                          --- solved by Newton
+    i.e.   a0*y + sum(j=1..k) aj*y(t1-j) = f(t1, y)
+           aj = derivative of Lagrange basis polynomial j in t1
+
+    predictor: polynomial of degree k through y(t0) ... y(t0-k)
+    error:     h/(t1-t0-k) * (y - predictor)
+
+    Order is changed (by one) after k+1 steps with the same order, the
+    order allowing the largest next step is used.  The method starts by
+    order 1 (backward Euler), history is cleared if the state of
+    integrators is changed by event.
+*/
+
+////////////////////////////////////////////////////////////////////////////
+//  BDF::Extrapolate
+//  value of polynomial through q+1 points of history in time t
+//
+void BDF::Extrapolate(int q, double t, double *p)
+{
+  const size_t count = IntegratorContainer::Size();
+  double w[hist_size];  // Lagrange coefficients
+  int j, m;
+  size_t i;
+  for(j=0; j<=q; j++) {
+    w[j] = 1.0;
+    for(m=0; m<=q; m++)
+      if(m != j)
+        w[j] *= (t - HistoryTime(m)) / (HistoryTime(j) - HistoryTime(m));
+  }
+  for(i=0; i<count; i++)
+    p[i] = 0.0;
+  for(j=0; j<=q; j++) {
+    const double *yj = History(j);
+    for(i=0; i<count; i++)
+      p[i] += w[j]*yj[i];
+  }
+}
+
+
+void BDF::Integrate(void)
+{
+  const double safety = 0.9;   // keeps the new step from growing too large
+  const double max_ratio = 2.0; // ditto (stability of variable step)
+  const double min_ratio = 0.2; // limit of reducing step
+  const double conv = 0.1;     // Newton iteration tolerance (to error)
+  const int max_iter = 4;      // # of Newton iterations
+  size_t i;   // auxiliary variables for loops
+  int j, m;
+  double err;       // ratio of estimated error to allowed error
+  double ratio;     // ratio for next step computation
+  int order;        // order for next step
+  bool fresh;       // Jacobian computed in this step
+
+  Dprintf((" BDF integration step, order %d ", Order));
+  Dprintf((" Time = %g, optimal step = %g", (double)Time, OptStep));
+
+  // arrays of integrator values and auxiliary values
+  const size_t count = IntegratorContainer::Size();
+  double *y = IntegratorContainer::State();
+  const double *yl = IntegratorContainer::OldState();
+  double *dy = IntegratorContainer::Diff();
+  const double *dyl = IntegratorContainer::OldDiff();
+  double *pred = PRED.Data(), *psi = PSI.Data();
+  double *delta = DELTA.Data(), *e = ERR.Data();
+
+  // history is valid if the start point is the last result
+  if(Points > 0) {
+    double t0 = HistoryTime(0);
+    const double *y0 = History(0);
+    if(fabs(t0 - SIMLIB_StepStartTime) > 1e-10*(fabs(t0)+SIMLIB_StepSize))
+      Points = 0;
+    for(i=0; i<count && Points>0; i++)
+      if(y0[i] != yl[i])
+        Points = 0;
+  }
+  if(Points == 0) { // start of method (order 1)
+    Dprintf(("BDF: start, Time = %g", (double)Time));
+    double *y0 = History(0);
+    for(i=0; i<count; i++)
+      y0[i] = yl[i];
+    Points = 1;
+    Order = 1;
+    Steps = 0;
+    JacobianOK = false;
+  }
+  HistoryTime(0) = SIMLIB_StepStartTime;
+
+  //--------------------------------------------------------------------------
+  //  Step of method
+  //--------------------------------------------------------------------------
+
+begin_step:
+
+  ///////////////////////////////////////////////////////// beginning of step
+
+  SIMLIB_StepSize = max(SIMLIB_StepSize, SIMLIB_MinStep); // low step limit
+
+  SIMLIB_ContractStepFlag = false;           // clear reduce step flag
+  SIMLIB_ContractStep = 0.5*SIMLIB_StepSize; // implicitly reduce to half step
+  const double h = SIMLIB_StepSize;
+  const double t1 = SIMLIB_StepStartTime + h;
+  const int k = Order;
+
+  // coefficients of formula
+  double a[bdf_ord+1];
+  a[0] = 0.0;
+  for(m=0; m<k; m++)
+    a[0] += 1.0 / (t1 - HistoryTime(m));
+  for(j=1; j<=k; j++) {
+    double tj = HistoryTime(j-1);
+    a[j] = 1.0 / (tj - t1);
+    for(m=0; m<k; m++)
+      if(m != j-1)
+        a[j] *= (t1 - HistoryTime(m)) / (tj - HistoryTime(m));
+  }
+  for(i=0; i<count; i++)
+    psi[i] = 0.0;
+  for(j=1; j<=k; j++) {
+    const double *yj = History(j-1);
+    for(i=0; i<count; i++)
+      psi[i] += a[j]*yj[i];
+  }
+
+  // predictor
+  if(Points > k) {
+    Extrapolate(k, t1, pred);
+  } else { // start: explicit Euler
+    for(i=0; i<count; i++)
+      pred[i] = yl[i] + h*dyl[i];
+  }
+  for(i=0; i<count; i++)
+    y[i] = pred[i];
+
+  _SetTime(Time, t1);       // end of step
+  SIMLIB_DeltaTime = SIMLIB_StepSize;
+
+  ////////////////////////////////////////////////////////// Newton iteration
+
+  fresh = false;
+newton:
+  if(!JacobianOK) {
+    SIMLIB_Dynamic();
+    Jacobian(false);
+    Gamma = 0.0;          // new decomposition
+    fresh = true;
+  }
+  if(a[0] != Gamma) {
+    Gamma = a[0];
+    if(!Factor(Gamma)) {  // singular matrix, try smaller step
+      Gamma = 0.0;
+      if(h > SIMLIB_MinStep) {
+        SIMLIB_StepSize = max(0.5*h, SIMLIB_MinStep);
+        IsEndStepEvent = false;
+        goto begin_step;
+      }
+      SIMLIB_error(NI_SingularMatrix);
+    }
+  }
+  {
+    bool converged = false;
+    double dn = 0.0, dn_old = 0.0;
+    for(int iter=0; iter<max_iter && !converged; iter++) {
+      SIMLIB_Dynamic();  // evaluate new state of model (y'=f(t,y))
+      for(i=0; i<count; i++)
+        delta[i] = dy[i] - a[0]*y[i] - psi[i];
+      M.Solve(delta);
+      for(i=0; i<count; i++)
+        y[i] += delta[i];
+      dn = Norm(delta, y);
+      if(dn <= conv)
+        converged = true;
+      else if(iter > 0) {
+        double rate = dn/dn_old;
+        if(rate >= 0.9)
+          break;          // diverges
+        converged = rate/(1.0-rate)*dn <= conv;
+      }
+      dn_old = dn;
+    }
+    if(!converged) {
+      Dprintf(("BDF: Newton iteration failed (%g)", dn));
+      for(i=0; i<count; i++)
+        y[i] = pred[i];
+      if(!fresh) {        // old Jacobian, compute it again
+        JacobianOK = false;
+        goto newton;
+      }
+      if(h > SIMLIB_MinStep) {
+        SIMLIB_StepSize = max(0.25*h, SIMLIB_MinStep);
+        IsEndStepEvent = false;
+        goto begin_step;
+      }
+      SIMLIB_warning(AccuracyError);
+    }
+  }
+
+  SIMLIB_Dynamic();  // derivatives at the end of step
+
+  //--------------------------------------------------------------------------
+  //  Check on accuracy of numerical integration, estimate error
+  //--------------------------------------------------------------------------
+
+  SIMLIB_ERRNO = 0; // OK
+  {
+    double c = Points > k ? h / (t1 - HistoryTime(k)) : 0.5;
+    for(i=0; i<count; i++)
+      e[i] = c*(y[i] - pred[i]);
+  }
+  err = Norm(e, y);
+  Dprintf(("E: %g",err));
+
+  if(!(err <= 1.0)) { // error is too large, reduce stepsize
+    if(SIMLIB_StepSize > SIMLIB_MinStep) {  // reducing step is possible
+      ratio = max(safety*pow(err,-1.0/(k+1)), min_ratio);
+      SIMLIB_OptStep = max(ratio*SIMLIB_StepSize, SIMLIB_MinStep);
+      SIMLIB_StepSize = SIMLIB_OptStep;
+      IsEndStepEvent = false; // no event will be at the end of the step
+      goto begin_step;        // compute again with smaller step
+    }
+    // reducing step is unpossible
+    SIMLIB_ERRNO++;          // requested accuracy cannot be achieved
+    SIMLIB_warning(AccuracyError);
+  }
+
+  //--------------------------------------------------------------------------
+  //  Analyse system at the end of the step
+  //--------------------------------------------------------------------------
+
+  if(StateCond()) { // check on changes of state conditions at end of step
+    goto begin_step;
+  }
+
+  //--------------------------------------------------------------------------
+  //  Results of step have been accepted, choose order and step
+  //--------------------------------------------------------------------------
+
+  ratio = err > 0 ? pow(err,-1.0/(k+1)) : 1e10;
+  order = k;
+  if(Steps >= k && Points > k) {
+    if(k > 1) {               // lower order
+      double c = h / (t1 - HistoryTime(k-1));
+      Extrapolate(k-1, t1, pred);
+      for(i=0; i<count; i++)
+        e[i] = c*(y[i] - pred[i]);
+      double en = Norm(e, y);
+      double r = en > 0 ? pow(en,-1.0/k) : 1e10;
+      if(r > ratio) {
+        ratio = r;
+        order = k-1;
+      }
+    }
+    if(k < bdf_ord && Points > k+1) { // higher order
+      double c = h / (t1 - HistoryTime(k+1));
+      Extrapolate(k+1, t1, pred);
+      for(i=0; i<count; i++)
+        e[i] = c*(y[i] - pred[i]);
+      double en = Norm(e, y);
+      double r = en > 0 ? pow(en,-1.0/(k+2)) : 1e10;
+      if(r > ratio) {
+        ratio = r;
+        order = k+1;
+      }
+    }
+  }
+  if(order != k) {
+    Dprintf(("BDF: order %d", order));
+    Order = order;
+    Steps = 0;
+  } else {
+    Steps++;
+  }
+
+  // remember the result
+  First = (First + hist_size - 1) % hist_size;
+  if(Points < hist_size)
+    Points++;
+  HistoryTime(0) = t1;
+  double *y0 = History(0);
+  for(i=0; i<count; i++)
+    y0[i] = y[i];
+
+  // next step (keep the step if the change is small)
+  ratio = min(safety*ratio, max_ratio);
+  if(ratio >= 1.0 && ratio < 1.2)
+    ratio = 1.0;
+  if(!IsStartMode()) { // method is not used for start multi-step method
+    SIMLIB_OptStep = min(ratio*SIMLIB_StepSize, SIMLIB_MaxStep);
+  }
+
+} // BDF::Integrate
+
+
+////////////////////////////////////////////////////////////////////////////
+//  BDF::PrepareStep
+//  prepare object for integration step
+//
+bool BDF::PrepareStep(void)
+{
+  Dprintf(("BDF::PrepareStep()"));
+  if(ImplicitMethod::PrepareStep()) {
+    Points = 0;  // method will have to be restarted
+    return true;  // some changes
+  }
+  return false; // no changes
+} // BDF::PrepareStep
+
+
+////////////////////////////////////////////////////////////////////////////
+//  BDF::TurnOff
+//  turn off integration method
+//
+void BDF::TurnOff(void)
+{
+  ImplicitMethod::TurnOff();
+  Points = 0;
+}
+
+}
+// end of ni_bdf.cc
+
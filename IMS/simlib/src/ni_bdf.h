@@ -0,0 +1,54 @@
+/////////////////////////////////////////////////////////////////////////////
+//! \file ni_bdf.h  Backward differentiation formulas (stiff systems)
+//
+// Copyright (c) 1991-2018 Petr Peringer
+//
+// This library is licensed under GNU Library GPL. See the file COPYING.
+//
+
+//
+//  numerical integration: variable order, variable step BDF (1..5)
+//
+
+
+#include "ni_implicit.h"
+
+namespace simlib3 {
+
+// maximal order of the BDF method
+const int bdf_ord=5;
+
+
+////////////////////////////////////////////////////////////////////////////
+//  class representing the integration method
+//
+class BDF : public ImplicitMethod {
+private:
+  static const int hist_size = bdf_ord+2;  // # of remembered points
+  Memory Y[hist_size];  // auxiliary memories -- history of states
+  double T[hist_size];  // times of history
+  int First;   // index of the newest point in history
+  int Points;  // # of valid points in history
+  int Order;   // current order of the method
+  int Steps;   // # of steps with current order
+  double Gamma;  // leading coefficient of decomposed iteration matrix
+  Memory PRED, PSI, DELTA, ERR;  // auxiliary memories
+  double *History(int k) { return Y[(First+k)%hist_size].Data(); }
+  double &HistoryTime(int k) { return T[(First+k)%hist_size]; }
+  void Extrapolate(int q, double t, double *p); // polynomial from history
+public:
+  BDF(const char* name) :  // registrate method and name it
+    ImplicitMethod(name),
+    First(0), Points(0), Order(1), Steps(0), Gamma(0)
+  { /*NOTHING*/ }
+  virtual ~BDF()  // destructor
+  { /*NOTHING*/ }
+  virtual void Integrate(void) override;  // integration method
+  virtual bool PrepareStep(void) override;  // prepare object for integration step
+  virtual void TurnOff(void) override;  // turn off integration method
+}; // class BDF
+
+}
+
+// end of ni_bdf.h
+
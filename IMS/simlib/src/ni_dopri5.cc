@@ -0,0 +1,323 @@
+/////////////////////////////////////////////////////////////////////////////
+// ni_dopri5.cc
+//
+// Copyright (c) 1991-2018 Petr Peringer
+//
+// This library is licensed under GNU Library GPL. See the file COPYING.
+//
+
+//
+//  numerical integration: Dormand-Prince's method 5th order
+//
+
+////////////////////////////////////////////////////////////////////////////
+//  interface
+//
+#include "simlib.h"
+#include "internal.h"
+#include "ni_dopri5.h"
+#include <cmath>
+#include <cstddef>
+
+
+////////////////////////////////////////////////////////////////////////////
+//  implementation
+//
+namespace simlib3 {
+
+SIMLIB_IMPLEMENTATION;
+
+
+////////////////////////////////////////////////////////////////////////////
+//  Dormand-Prince's method 5th order with embedded 4th order error
+//  estimation and continuous extension 4th order (dense output)
+//
+/*  Formula:
+
+    k1  = h*f(t,y);                  (derivative from the previous step)
+    k2  = h*f(t+h/5,    y + k1/5);
+    k3  = h*f(t+3*h/10, y + 3/40*k1 + 9/40*k2);
+    k4  = h*f(t+4*h/5,  y + 44/45*k1 - 56/15*k2 + 32/9*k3);
+    k5  = h*f(t+8*h/9,  y + 19372/6561*k1 - 25360/2187*k2
+                          + 64448/6561*k3 - 212/729*k4);
+    k6  = h*f(t+h,      y + 9017/3168*k1 - 355/33*k2 + 46732/5247*k3
+                          + 49/176*k4 - 5103/18656*k5);
+    y  +=   35/384*k1 + 500/1113*k3 + 125/192*k4
+          - 2187/6784*k5 + 11/84*k6;
+    k7  = h*f(t+h, y);                    (first stage of the next step)
+    err = fabs(  71/57600*k1 - 71/16695*k3 + 71/1920*k4
+               - 17253/339200*k5 + 22/525*k6 - 1/40*k7);
+
+    dense output (s = (t-t0)/h):
+    y(t) = r1 + s*(r2 + (1-s)*(r3 + s*(r4 + (1-s)*r5)))
+*/
+
+void DOPRI5::Integrate(void)
+{
+  const double safety = 0.9; // keeps the new step from growing too large
+  const double max_ratio = 4.0; // ditto
+  const double pshrnk = 0.25;   // coefficient for reducing step
+  const double pgrow  = 0.20;   // coefficient for increasing step
+  // coefficients of dense output
+  const double d1 = -12715105075.0 / 11282082432.0;
+  const double d3 =  87487479700.0 / 32700410799.0;
+  const double d4 = -10690763975.0 / 1880347072.0;
+  const double d5 = 701980252875.0 / 199316789632.0;
+  const double d6 =  -1453857185.0 / 822651844.0;
+  const double d7 =     69997945.0 / 29380423.0;
+  size_t i;   // auxiliary variables for loops
+  double ratio;     // ratio for next step computation
+  double next_step; // recommended stepsize for next step
+  size_t n;       // integrator with the greatest error
+
+  Dprintf((" DOPRI5 integration step ")); // print debugging info
+  Dprintf((" Time = %g, optimal step = %g", (double)Time, OptStep));
+
+  // arrays of integrator values and coefficients (vectorized loops)
+  const size_t count = IntegratorContainer::Size();
+  double *y = IntegratorContainer::State();
+  const double *yl = IntegratorContainer::OldState();
+  const double *dy = IntegratorContainer::Diff();
+  const double *dyl = IntegratorContainer::OldDiff();
+  double *a1 = A1.Data(), *a2 = A2.Data(), *a3 = A3.Data();
+  double *a4 = A4.Data(), *a5 = A5.Data(), *a6 = A6.Data();
+  double *a7 = A7.Data();
+
+  //--------------------------------------------------------------------------
+  //  Step of method
+  //--------------------------------------------------------------------------
+
+begin_step:
+
+  ///////////////////////////////////////////////////////// beginning of step
+
+  SIMLIB_StepSize = max(SIMLIB_StepSize, SIMLIB_MinStep); // low step limit
+
+  SIMLIB_ContractStepFlag = false;           // clear reduce step flag
+  SIMLIB_ContractStep = 0.5*SIMLIB_StepSize; // implicitly reduce to half step
+  const double h = SIMLIB_StepSize;
+  DenseOK = false;  // new step
+
+  for(i=0; i<count; i++) {
+    a1[i] = h*dyl[i]; // compute coefficient (first same as last)
+    y[i] = yl[i] + 0.2*a1[i]; // state (y) for next sub-step
+  }
+
+  ////////////////////////////////////////////////////////////// 0.2 of step
+
+  _SetTime(Time,SIMLIB_StepStartTime + 0.2*SIMLIB_StepSize); // substep's time
+  SIMLIB_DeltaTime = double(Time) - SIMLIB_StepStartTime;
+
+  SIMLIB_Dynamic();  // evaluate new state of model (y'=f(t,y))      (1)
+
+  for(i=0; i<count; i++) {
+    a2[i] = h*dy[i];
+    y[i] = yl[i] + 3.0 / 40.0 * a1[i]
+                 + 9.0 / 40.0 * a2[i];
+  }
+
+  ////////////////////////////////////////////////////////////// 0.3 of step
+
+  _SetTime(Time,SIMLIB_StepStartTime + 0.3*SIMLIB_StepSize); //substep's time
+  SIMLIB_DeltaTime = double(Time) - SIMLIB_StepStartTime;
+
+  SIMLIB_Dynamic();  // evaluate new state of model                  (2)
+
+  for(i=0; i<count; i++) {
+    a3[i] = h*dy[i];
+    y[i] = yl[i] + 44.0 / 45.0 * a1[i]
+                 - 56.0 / 15.0 * a2[i]
+                 + 32.0 /  9.0 * a3[i];
+  }
+
+  ////////////////////////////////////////////////////////////// 0.8 of step
+
+  _SetTime(Time, SIMLIB_StepStartTime+0.8*SIMLIB_StepSize);
+  SIMLIB_DeltaTime = double(Time)-SIMLIB_StepStartTime;
+
+  SIMLIB_Dynamic();  // evaluate new state of model                  (3)
+
+  for(i=0; i<count; i++) {
+    a4[i] = h*dy[i];
+    y[i] = yl[i] + 19372.0 / 6561.0 * a1[i]
+                 - 25360.0 / 2187.0 * a2[i]
+                 + 64448.0 / 6561.0 * a3[i]
+                 -   212.0 /  729.0 * a4[i];
+  }
+
+  ////////////////////////////////////////////////////////////// 8/9 of step
+
+  _SetTime(Time, SIMLIB_StepStartTime+8.0/9.0*SIMLIB_StepSize);
+  SIMLIB_DeltaTime = double(Time)-SIMLIB_StepStartTime;
+
+  SIMLIB_Dynamic();  // evaluate new state of model                  (4)
+
+  for(i=0; i<count; i++) {
+    a5[i] = h*dy[i];
+    y[i] = yl[i] +  9017.0 /  3168.0 * a1[i]
+                 -   355.0 /    33.0 * a2[i]
+                 + 46732.0 /  5247.0 * a3[i]
+                 +    49.0 /   176.0 * a4[i]
+                 -  5103.0 / 18656.0 * a5[i];
+  }
+
+  ////////////////////////////////////////////////////////////// 1.0 of step
+
+  _SetTime(Time, SIMLIB_StepStartTime+SIMLIB_StepSize);
+  SIMLIB_DeltaTime = double(Time)-SIMLIB_StepStartTime;
+
+  SIMLIB_Dynamic();  // evaluate new state of model                  (5)
+
+  for(i=0; i<count; i++) {
+    a6[i] = h*dy[i];
+    y[i] = yl[i] +   35.0 /  384.0 * a1[i] // final state
+                 +  500.0 / 1113.0 * a3[i]
+                 +  125.0 /  192.0 * a4[i]
+                 - 2187.0 / 6784.0 * a5[i]
+                 +   11.0 /   84.0 * a6[i];
+  }
+
+  ////////////////////////////////////////////////////////////// end of step
+
+  _SetTime(Time, SIMLIB_StepStartTime+SIMLIB_StepSize); // go to end of step
+  SIMLIB_DeltaTime = SIMLIB_StepSize;
+  SIMLIB_Dynamic();  // first stage of the next step                 (6)
+
+  //--------------------------------------------------------------------------
+  //  Check on accuracy of numerical integration, estimate error
+  //--------------------------------------------------------------------------
+
+  SIMLIB_ERRNO = 0; // OK
+  ratio = 32.0;     // 2^5 - ratio for stepsize computation - initial value
+  n=0;              // integrator with greatest error
+  for(i=0; i<count; i++) {
+    double eerr; // estimated error
+    double terr; // greatest allowed error
+
+    a7[i] = h*dy[i];
+    eerr = fabs(     71.0 /  57600.0 * a1[i] // estimation
+                -    71.0 /  16695.0 * a3[i]
+                +    71.0 /   1920.0 * a4[i]
+                - 17253.0 / 339200.0 * a5[i]
+                +    22.0 /    525.0 * a6[i]
+                -     1.0 /     40.0 * a7[i]);
+    terr = fabs(SIMLIB_AbsoluteError)
+         + fabs(SIMLIB_RelativeError*y[i]);
+    if(terr < eerr*ratio) { // avoid arithmetic overflow
+      ratio = terr/eerr;    // find the lowest ratio
+      n=i;                  // remember the integrator
+    }
+  } // for
+
+  Dprintf(("R: %g",ratio));
+
+  if(ratio < 1.0) { // error is too large, reduce stepsize
+    ratio = pow(ratio,pshrnk); // coefficient for reduce
+    Dprintf(("Down: %g",ratio));
+    if(SIMLIB_StepSize > SIMLIB_MinStep) {  // reducing step is possible
+      SIMLIB_OptStep = max(safety*ratio*SIMLIB_StepSize, SIMLIB_MinStep);
+      SIMLIB_StepSize = SIMLIB_OptStep;
+      IsEndStepEvent = false; // no event will be at the end of the step
+      goto begin_step;        // compute again with smaller step
+    }
+    // reducing step is unpossible
+    SIMLIB_ERRNO++;          // requested accuracy cannot be achieved
+    _Print("\n Integrator[%lu] ",(unsigned long)n);
+    SIMLIB_warning(AccuracyError);
+    next_step = SIMLIB_StepSize;
+  } else { // allowed tolerantion is fulfiled
+    if(!IsStartMode()) { // method is not used for start multi-step method
+      ratio = min(pow(ratio,pgrow),max_ratio); // coefficient for increase
+      Dprintf(("Up: %g",ratio));
+      next_step = min(safety*ratio*SIMLIB_StepSize, SIMLIB_MaxStep);
+    } else {
+      next_step = SIMLIB_StepSize;
+    }
+  }
+
+  //--------------------------------------------------------------------------
+  //  Dense output of the step
+  //--------------------------------------------------------------------------
+
+  {
+    double *r1 = R1.Data(), *r2 = R2.Data(), *r3 = R3.Data();
+    double *r4 = R4.Data(), *r5 = R5.Data();
+    for(i=0; i<count; i++) {
+      r1[i] = yl[i];
+      r2[i] = y[i] - yl[i];
+      r3[i] = a1[i] - r2[i];
+      r4[i] = r2[i] - a7[i] - r3[i];
+      r5[i] = d1*a1[i] + d3*a3[i] + d4*a4[i] + d5*a5[i] + d6*a6[i] + d7*a7[i];
+    }
+  }
+  DenseOK = true;
+  DenseSize = count;
+  DenseStart = SIMLIB_StepStartTime;
+  DenseStep = h;
+
+  //--------------------------------------------------------------------------
+  //  Analyse system at the end of the step
+  //--------------------------------------------------------------------------
+
+  if(StateCond()) { // check on changes of state conditions at end of step
+    goto begin_step;
+  }
+
+  //--------------------------------------------------------------------------
+  //  Results of step have been accepted, take fresh step
+  //--------------------------------------------------------------------------
+
+  // increase step, if accuracy is good
+  SIMLIB_OptStep = next_step;
+
+} // DOPRI5::Integrate
+
+
+////////////////////////////////////////////////////////////////////////////
+//  DOPRI5::DenseOutput
+//  state of integrators in time t inside of the last step
+//
+bool DOPRI5::DenseOutput(double t, double *y)
+{
+  const double eps = 1e-12*(fabs(DenseStart)+DenseStep); // rounding
+  if(!DenseOK || DenseSize != IntegratorContainer::Size() ||
+     t < DenseStart-eps || t > DenseStart+DenseStep+eps)
+    return false;   // t is not in the last step
+  const double s = (t - DenseStart) / DenseStep;
+  const double s1 = 1.0 - s;
+  const double *r1 = R1.Data(), *r2 = R2.Data(), *r3 = R3.Data();
+  const double *r4 = R4.Data(), *r5 = R5.Data();
+  for(size_t i=0; i<DenseSize; i++)
+    y[i] = r1[i] + s*(r2[i] + s1*(r3[i] + s*(r4[i] + s1*r5[i])));
+  return true;
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+//  DOPRI5::PrepareStep
+//  prepare object for integration step
+//
+bool DOPRI5::PrepareStep(void)
+{
+  Dprintf(("DOPRI5::PrepareStep()"));
+  if(SingleStepMethod::PrepareStep()) {
+    DenseOK = false;  // memories has been resized
+    return true;
+  }
+  return false;
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+//  DOPRI5::TurnOff
+//  turn off integration method
+//
+void DOPRI5::TurnOff(void)
+{
+  SingleStepMethod::TurnOff();
+  DenseOK = false;
+}
+
+}
+// end of ni_dopri5.cc
+
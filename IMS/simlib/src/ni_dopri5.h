@@ -0,0 +1,45 @@
+/////////////////////////////////////////////////////////////////////////////
+//! \file ni_dopri5.h   Dormand-Prince 5(4) with dense output
+//
+// Copyright (c) 1991-2018 Petr Peringer
+//
+// This library is licensed under GNU Library GPL. See the file COPYING.
+//
+
+//
+//  numerical integration: Dormand-Prince's method 5th order
+//
+
+#include "simlib.h"
+
+namespace simlib3 {
+
+////////////////////////////////////////////////////////////////////////////
+//  class representing the integration method
+//
+class DOPRI5 : public SingleStepMethod {
+private:
+  Memory A1, A2, A3, A4, A5, A6, A7;  // auxiliary memories
+  Memory R1, R2, R3, R4, R5;  // coefficients of dense output
+  bool DenseOK;       // dense output of the last step is valid
+  size_t DenseSize;   // # of integrators in the last step
+  double DenseStart;  // start time of the last step
+  double DenseStep;   // size of the last step
+public:
+  DOPRI5(const char* name) :  // registrate method and name it
+    SingleStepMethod(name),
+    DenseOK(false), DenseSize(0), DenseStart(0), DenseStep(0)
+  { /*NOTHING*/ }
+  virtual ~DOPRI5()  // destructor
+  { /*NOTHING*/ }
+  virtual void Integrate(void) override;  // integration method
+  virtual bool PrepareStep(void) override;  // prepare object for integration step
+  virtual void TurnOff(void) override;  // turn off integration method
+  virtual bool HasDenseOutput(void) override { return true; }
+  virtual bool DenseOutput(double t, double *y) override;  // interpolation
+}; // class DOPRI5
+
+}
+
+// end of ni_dopri5.h
+
@@ -46,10 +46,10 @@ SIMLIB_IMPLEMENTATION;
 void EULER::Integrate(void)
 {
   const double err_coef = 0.02; // limits an error range
-  static double dthlf;   // half step
+  static thread_local double dthlf;   // half step
   size_t i;   // auxiliary variables for loops to go through list
   Iterator ip, end_it; // of integrators
-  static bool DoubleStepFlag; // flag - allow increasing (doubling) the step
+  static thread_local bool DoubleStepFlag; // flag - allow increasing (doubling) the step
 
   Dprintf((" Euler integration step ")); // print debugging info
   Dprintf((" Time = %g, optimal step = %g", (double)Time, OptStep));
@@ -53,10 +53,10 @@ void FW::Integrate(void)
   bool FWMayDouble;       // accuracy has been very good
   // WARNING: following variables must be static!
   // others are static only for efficiency
-  static int FWDoubleCount;   // counter of doubling step requestes in FW
-  static int EulDoubleCount;  // counter of doubling step requestes in Euler
-  static double Eul_StepSize; // step of Euler's method
-  static double PrevStep;     // previous FW step
+  static thread_local int FWDoubleCount;   // counter of doubling step requestes in FW
+  static thread_local int EulDoubleCount;  // counter of doubling step requestes in Euler
+  static thread_local double Eul_StepSize; // step of Euler's method
+  static thread_local double PrevStep;     // previous FW step
 
   Dprintf((" Fowler-Warten integration step ")); // print debugging info
   Dprintf((" Time = %g, optimal step = %g", (double)Time, OptStep));
@@ -0,0 +1,145 @@
+/////////////////////////////////////////////////////////////////////////////
+// ni_implicit.cc
+//
+// Copyright (c) 1991-2018 Petr Peringer
+//
+// This library is licensed under GNU Library GPL. See the file COPYING.
+//
+
+//
+//  numerical integration: base of implicit methods
+//
+
+////////////////////////////////////////////////////////////////////////////
+//  interface
+//
+#include "simlib.h"
+#include "internal.h"
+#include "ni_implicit.h"
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+
+
+////////////////////////////////////////////////////////////////////////////
+//  implementation
+//
+namespace simlib3 {
+
+SIMLIB_IMPLEMENTATION;
+
+
+////////////////////////////////////////////////////////////////////////////
+//  ImplicitMethod::Jacobian
+//  compute Jacobian (and df/dt) in current state, derivatives of
+//  integrators (f) have to be evaluated
+//
+void ImplicitMethod::Jacobian(bool time)
+{
+  const size_t n = IntegratorContainer::Size();
+  Dprintf(("ImplicitMethod::Jacobian(), n = %lu", (unsigned long)n));
+  J.resize(n*n);
+  dfdt.resize(n);
+  JacobianOK = true;
+  if(EvaluationTape::Jacobian(&J[0], time ? &dfdt[0] : 0))
+    return;                     // forward mode derivatives
+  // differences (model contains blocks evaluated by Value())
+  double *y = IntegratorContainer::State();
+  double *dy = IntegratorContainer::Diff();
+  double *f = f0.Data();
+  size_t i, j;
+  for(i=0; i<n; i++)
+    f[i] = dy[i];
+  for(j=0; j<n; j++) {
+    double yj = y[j];
+    double h = sqrt(DBL_EPSILON) * max(fabs(yj), 1e-3);
+    y[j] = yj + h;
+    h = y[j] - yj;              // exact difference
+    SIMLIB_Dynamic();
+    for(i=0; i<n; i++)
+      J[i*n+j] = (dy[i] - f[i]) / h;
+    y[j] = yj;
+  }
+  if(time) {
+    double t = Time;
+    double dt = SIMLIB_DeltaTime;
+    double h = sqrt(DBL_EPSILON) * max(fabs(t), SIMLIB_StepSize);
+    _SetTime(Time, t + h);
+    h = double(Time) - t;
+    SIMLIB_DeltaTime = dt + h;
+    SIMLIB_Dynamic();
+    for(i=0; i<n; i++)
+      dfdt[i] = (dy[i] - f[i]) / h;
+    _SetTime(Time, t);
+    SIMLIB_DeltaTime = dt;
+  }
+  for(i=0; i<n; i++)            // values in current state
+    dy[i] = f[i];
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+//  ImplicitMethod::Factor
+//  LU decomposition of iteration matrix gamma*I - J
+//
+bool ImplicitMethod::Factor(double gamma)
+{
+  const size_t n = IntegratorContainer::Size();
+  double *m = M.Matrix(n);
+  for(size_t i=0; i<n*n; i++)
+    m[i] = -J[i];
+  for(size_t i=0; i<n; i++)
+    m[i*n+i] += gamma;
+  return M.Factor();
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+//  ImplicitMethod::Norm
+//  maximal ratio of error to allowed error
+//
+double ImplicitMethod::Norm(const double *e, const double *y)
+{
+  const size_t n = IntegratorContainer::Size();
+  double r = 0;
+  for(size_t i=0; i<n; i++) {
+    double eerr = fabs(e[i]);   // error
+    double terr = fabs(SIMLIB_AbsoluteError)
+                + fabs(SIMLIB_RelativeError*y[i]); // greatest allowed error
+    if(eerr > r*terr)           // avoid arithmetic overflow
+      r = terr > 0 ? eerr/terr : HUGE_VAL;
+  }
+  return r;
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+//  ImplicitMethod::PrepareStep
+//  prepare object for integration step
+//
+bool ImplicitMethod::PrepareStep(void)
+{
+  if(SingleStepMethod::PrepareStep()) {
+    JacobianOK = false;         // # of integrators has been changed
+    return true;
+  }
+  return false;
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+//  ImplicitMethod::TurnOff
+//  turn off integration method, free matrices
+//
+void ImplicitMethod::TurnOff(void)
+{
+  SingleStepMethod::TurnOff();
+  J.clear();
+  dfdt.clear();
+  (void)M.Matrix(0);
+  JacobianOK = false;
+}
+
+}
+// end of ni_implicit.cc
+
@@ -0,0 +1,52 @@
+/////////////////////////////////////////////////////////////////////////////
+//! \file ni_implicit.h  Base of implicit (stiff) integration methods
+//
+// Copyright (c) 1991-2018 Petr Peringer
+//
+// This library is licensed under GNU Library GPL. See the file COPYING.
+//
+
+//
+//  numerical integration: Jacobian of model and iteration matrix
+//
+
+#ifndef __SIMLIB__NI_IMPLICIT_H__
+#define __SIMLIB__NI_IMPLICIT_H__
+
+#include "simlib.h"
+#include "internal.h"
+
+namespace simlib3 {
+
+////////////////////////////////////////////////////////////////////////////
+//  base class of implicit methods
+//  Jacobian J = df/dy is computed from evaluation tape (forward mode
+//  derivatives) or by differences if the model contains other blocks
+//
+class ImplicitMethod : public SingleStepMethod {
+protected:
+  std::vector<double> J;      // Jacobian J[i*n+j] = df[i]/dy[j]
+  std::vector<double> dfdt;   // df/dt
+  LUDecomposition M;          // iteration matrix gamma*I - J
+  Memory f0;                  // derivatives in point of Jacobian
+  bool JacobianOK;            // J is computed in current point
+  void Jacobian(bool time);   // compute J (and df/dt) in current state
+  bool Factor(double gamma);  // decomposition of gamma*I - J
+  static double Norm(const double *e, const double *y); // weighted norm
+public:
+  ImplicitMethod(const char* name) :
+    SingleStepMethod(name),
+    JacobianOK(false)
+  { /*NOTHING*/ }
+  virtual ~ImplicitMethod()
+  { /*NOTHING*/ }
+  virtual void TurnOff(void) override;      // free matrices
+  virtual bool PrepareStep(void) override;  // new size of system
+}; // class ImplicitMethod
+
+}
+
+#endif
+
+// end of ni_implicit.h
+
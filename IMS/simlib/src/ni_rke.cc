@@ -54,16 +54,23 @@ SIMLIB_IMPLEMENTATION;
 void RKE::Integrate(void)
 {
   static const double err_coef = 0.02; // limits an error range
-  static double dthlf;         // half step
-  static double dtqrt;         // quater step
-  static bool DoubleStepFlag;  // flag - allow increasing (doubling) the step
-  size_t i;   // auxiliary variables for loops to go through list
-  Iterator ip, end_it; // of integrators
+  static thread_local double dthlf;         // half step
+  static thread_local double dtqrt;         // quater step
+  static thread_local bool DoubleStepFlag;  // flag - allow increasing (doubling) the step
+  size_t i;   // auxiliary variables for loops
 
   Dprintf((" RKE integration step ")); // print debugging info
   Dprintf((" Time = %g, optimal step = %g", (double)Time, OptStep));
 
-  end_it=LastIntegrator(); // end of container of integrators
+  // arrays of integrator values and coefficients (vectorized loops)
+  const size_t count = IntegratorContainer::Size();
+  double *y = IntegratorContainer::State();
+  const double *yl = IntegratorContainer::OldState();
+  const double *dy = IntegratorContainer::Diff();
+  const double *dyl = IntegratorContainer::OldDiff();
+  double *a1 = A1.Data(), *a2 = A2.Data(), *a3 = A3.Data(), *a4 = A4.Data();
+  double *a5 = A5.Data(), *a6 = A6.Data(), *a7 = A7.Data();
+  const double *yh = si.Data(); // state in 1/2 of step
 
   //--------------------------------------------------------------------------
   //  Step of method
@@ -76,13 +83,14 @@ begin_step:
   SIMLIB_StepSize = max(SIMLIB_StepSize, SIMLIB_MinStep); // low step limit
   dthlf = 0.5*SIMLIB_StepSize; // half step
   dtqrt = 0.5*dthlf;           // quater step
+  const double h = dthlf;
 
   SIMLIB_ContractStepFlag = false; // clear reduce step flag
   SIMLIB_ContractStep = dtqrt;     // implicitly reduce to quater of step
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A1[i] = dthlf*(*ip)->GetOldDiff();     // compute coefficient
-    (*ip)->SetState((*ip)->GetOldState()+0.5*A1[i]); // state (y) for next sub-step
+  for(i=0; i<count; i++) {
+    a1[i] = h*dyl[i];     // compute coefficient
+    y[i] = yl[i]+0.5*a1[i]; // state (y) for next sub-step
   }
 
   ////////////////////////////////////////////////////////////// 1/4 of step
@@ -92,16 +100,16 @@ begin_step:
 
   SIMLIB_Dynamic();  // evaluate new state of model (y'=f(t,y))      (1)
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A2[i] = dthlf*(*ip)->GetDiff();
-    (*ip)->SetState((*ip)->GetOldState() + 0.25*(A1[i]+A2[i]));
+  for(i=0; i<count; i++) {
+    a2[i] = h*dy[i];
+    y[i] = yl[i] + 0.25*(a1[i]+a2[i]);
   }
 
   SIMLIB_Dynamic();  // evaluate new state of model                  (2)
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A3[i] = dthlf*(*ip)->GetDiff();
-    (*ip)->SetState((*ip)->GetOldState() - A2[i] + A3[i] + A3[i]);
+  for(i=0; i<count; i++) {
+    a3[i] = h*dy[i];
+    y[i] = yl[i] - a2[i] + a3[i] + a3[i];
   }
 
   //////////////////////////////////////////////////////////////
@@ -113,9 +121,9 @@ begin_step:
 
   SIMLIB_Dynamic();  // evaluate new state of model                  (3)
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A4[i] = dthlf*(*ip)->GetDiff();
-    (*ip)->SetState((*ip)->GetOldState() + (A1[i] + 4.0*A3[i] + A4[i]) / 6.0);
+  for(i=0; i<count; i++) {
+    a4[i] = h*dy[i];
+    y[i] = yl[i] + (a1[i] + 4.0*a3[i] + a4[i]) / 6.0;
   }
 
   if(StateCond()) { // check on changes of state conditions in 1/2 of step
@@ -130,9 +138,9 @@ begin_step:
 
   SIMLIB_Dynamic();  // evaluate new state of model                  (4)
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A5[i] = dthlf*(*ip)->GetDiff();
-    (*ip)->SetState(si[i] + 0.5*A5[i]);
+  for(i=0; i<count; i++) {
+    a5[i] = h*dy[i];
+    y[i] = yh[i] + 0.5*a5[i];
   }
 
   ////////////////////////////////////////////////////////////// 3/4 of step
@@ -142,24 +150,24 @@ begin_step:
 
   SIMLIB_Dynamic();  // evaluate new state of model                  (5)
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A6[i] = dthlf * (*ip)->GetDiff();
-    (*ip)->SetState(si[i] + 0.25*(A5[i] + A6[i]));
+  for(i=0; i<count; i++) {
+    a6[i] = h * dy[i];
+    y[i] = yh[i] + 0.25*(a5[i] + a6[i]);
   }
 
   SIMLIB_Dynamic();  // evaluate new state of model                  (6)
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A7[i] = dthlf*(*ip)->GetDiff();
-    (*ip)->SetState((*ip)->GetOldState()
-      + (         - A1[i]
-          -  96.0 * A2[i]
-          +  92.0 * A3[i]
-          - 121.0 * A4[i]
-          + 144.0 * A5[i]
-          +   6.0 * A6[i]
-          -  12.0 * A7[i]
-        ) / 6.0);
+  for(i=0; i<count; i++) {
+    a7[i] = h*dy[i];
+    y[i] = yl[i]
+      + (         - a1[i]
+          -  96.0 * a2[i]
+          +  92.0 * a3[i]
+          - 121.0 * a4[i]
+          + 144.0 * a5[i]
+          +   6.0 * a6[i]
+          -  12.0 * a7[i]
+        ) / 6.0;
   }
 
   //////////////////////////////////////////////////////////// end of step
@@ -175,18 +183,18 @@ begin_step:
 
   DoubleStepFlag = true;
   SIMLIB_ERRNO = 0;
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
+  for(i=0; i<count; i++) {
     double eerr; // estimated error
     double terr; // greatest allowed error
 
-    eerr = fabs((         - A1[i]
-                  +   4.0 * A3[i]
-                  +  17.0 * A4[i]
-                  -  23.0 * A5[i]
-                  +   4.0 * A7[i]
-                  - dthlf * (*ip)->GetDiff()
+    eerr = fabs((         - a1[i]
+                  +   4.0 * a3[i]
+                  +  17.0 * a4[i]
+                  -  23.0 * a5[i]
+                  +   4.0 * a7[i]
+                  - h * dy[i]
                 ) / 90.0);  // error estimation
-    terr = SIMLIB_AbsoluteError + fabs(SIMLIB_RelativeError*si[i]);
+    terr = SIMLIB_AbsoluteError + fabs(SIMLIB_RelativeError*yh[i]);
 
     if(eerr < err_coef*terr) // allowed tolerantion is fulfiled with provision
       continue;
@@ -224,8 +232,8 @@ begin_step:
 
     GoToState(di, si, xi);
 
-    for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-      (*ip)->SetState(si[i] - A6[i] + A7[i] + A7[i]);
+    for(i=0; i<count; i++) {
+      y[i] = yh[i] - a6[i] + a7[i] + a7[i];
     }
 
     SIMLIB_StepStartTime += dthlf;
@@ -233,9 +241,9 @@ begin_step:
 
     SIMLIB_Dynamic();  // evaluate new state of model                (8)
 
-    for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
+    for(i=0; i<count; i++) {
       // new state
-      (*ip)->SetState(si[i] + (A5[i] + 4.0*A7[i] + dthlf*(*ip)->GetDiff()) / 6.0);
+      y[i] = yh[i] + (a5[i] + 4.0*a7[i] + h*dy[i]) / 6.0;
     }
 
     if(StateCond()) { // check on changes of state conditions at end of step
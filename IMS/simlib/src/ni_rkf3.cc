@@ -50,7 +50,6 @@ void RKF3::Integrate(void)
   const double pshrnk = 0.5;     // coefficient for reducing step
   const double pgrow  = 1.0/3.0; // coefficient for increasing step
   size_t i;   // auxiliary variables for loops
-  Iterator ip, end_it; // to go through list of integrators
   double ratio;     // ratio for next step computation
   double next_step; // recommended stepsize for next step
   size_t n;         // integrator with greatest error
@@ -58,7 +57,13 @@ void RKF3::Integrate(void)
   Dprintf((" RKF3 integration step ")); // print debugging info
   Dprintf((" Time = %g, optimal step = %g", (double)Time, OptStep));
 
-  end_it=LastIntegrator(); // end of container of integrators
+  // arrays of integrator values and coefficients (vectorized loops)
+  const size_t count = IntegratorContainer::Size();
+  double *y = IntegratorContainer::State();
+  const double *yl = IntegratorContainer::OldState();
+  const double *dy = IntegratorContainer::Diff();
+  const double *dyl = IntegratorContainer::OldDiff();
+  double *a1 = A1.Data(), *a2 = A2.Data(), *a3 = A3.Data();
 
   //--------------------------------------------------------------------------
   //  Step of method
@@ -73,9 +78,10 @@ begin_step:
   SIMLIB_ContractStepFlag = false;           // clear reduce step flag
   SIMLIB_ContractStep = 0.5*SIMLIB_StepSize; // implicitly reduce to half step
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A1[i]  = SIMLIB_StepSize*(*ip)->GetOldDiff(); // compute coefficient
-    (*ip)->SetState((*ip)->GetOldState() + 0.5*A1[i]); // state (y) for next sub-step
+  const double h = SIMLIB_StepSize;
+  for(i=0; i<count; i++) {
+    a1[i] = h*dyl[i];         // compute coefficient
+    y[i] = yl[i] + 0.5*a1[i]; // state (y) for next sub-step
   }
 
   ////////////////////////////////////////////////////////////// 1/2 of step
@@ -85,9 +91,9 @@ begin_step:
 
   SIMLIB_Dynamic();  // evaluate new state of model (y'=f(t,y))      (1)
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A2[i]  = SIMLIB_StepSize*(*ip)->GetDiff();
-    (*ip)->SetState((*ip)->GetOldState() + 0.75*A2[i]);
+  for(i=0; i<count; i++) {
+    a2[i] = h*dy[i];
+    y[i] = yl[i] + 0.75*a2[i];
   }
 
   ////////////////////////////////////////////////////////////// 3/4 of step
@@ -97,10 +103,9 @@ begin_step:
 
   SIMLIB_Dynamic();  // evaluate new state of model                  (2)
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A3[i]  = SIMLIB_StepSize*(*ip)->GetDiff();
-    (*ip)->SetState((*ip)->GetOldState()
-                 + (2.0*A1[i] + 3.0*A2[i] + 4.0*A3[i]) / 9.0);
+  for(i=0; i<count; i++) {
+    a3[i] = h*dy[i];
+    y[i] = yl[i] + (2.0*a1[i] + 3.0*a2[i] + 4.0*a3[i]) / 9.0;
   }
 
   ////////////////////////////////////////////////////////////// 1.0 of step
@@ -117,17 +122,17 @@ begin_step:
   SIMLIB_ERRNO = 0; // OK
   ratio = 8.0;      // 2^3 - ratio for next step computation - initial value
   n=0;              // integrator with greatest error
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
+  for(i=0; i<count; i++) {
     double eerr; // estimated error
     double terr; // greatest allowed error
 
-    eerr = fabs(  -5.0*A1[i]  // estimation
-                 + 6.0*A2[i]
-                 + 8.0*A3[i]
-                 - 9.0*SIMLIB_StepSize*(*ip)->GetDiff()
+    eerr = fabs(  -5.0*a1[i]  // estimation
+                 + 6.0*a2[i]
+                 + 8.0*a3[i]
+                 - 9.0*h*dy[i]
                ) / 72.0;
     terr = fabs(SIMLIB_AbsoluteError)
-         + fabs(SIMLIB_RelativeError*(*ip)->GetState());
+         + fabs(SIMLIB_RelativeError*y[i]);
     if(terr < eerr*ratio) { // avoid arithmetic overflow
       ratio = terr/eerr;    // find the lowest ratio
       n=i;                  // remember the integrator
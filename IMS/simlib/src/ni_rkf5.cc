@@ -62,8 +62,7 @@ void RKF5::Integrate(void)
   const double max_ratio = 4.0; // ditto
   const double pshrnk = 0.25;   // coefficient for reducing step
   const double pgrow  = 0.20;   // coefficient for increasing step
-  size_t i;   // auxiliary variables for loops to go through list
-  Iterator ip, end_it; // of integrators
+  size_t i;   // auxiliary variables for loops
   double ratio;     // ratio for next step computation
   double next_step; // recommended stepsize for next step
   size_t n;       // integrator with the greatest error
@@ -71,7 +70,14 @@ void RKF5::Integrate(void)
   Dprintf((" RKF5 integration step ")); // print debugging info
   Dprintf((" Time = %g, optimal step = %g", (double)Time, OptStep));
 
-  end_it=LastIntegrator(); // end of container of integrators
+  // arrays of integrator values and coefficients (vectorized loops)
+  const size_t count = IntegratorContainer::Size();
+  double *y = IntegratorContainer::State();
+  const double *yl = IntegratorContainer::OldState();
+  const double *dy = IntegratorContainer::Diff();
+  const double *dyl = IntegratorContainer::OldDiff();
+  double *a1 = A1.Data(), *a2 = A2.Data(), *a3 = A3.Data();
+  double *a4 = A4.Data(), *a5 = A5.Data(), *a6 = A6.Data();
 
   //--------------------------------------------------------------------------
   //  Step of method
@@ -85,10 +91,11 @@ begin_step:
 
   SIMLIB_ContractStepFlag = false;           // clear reduce step flag
   SIMLIB_ContractStep = 0.5*SIMLIB_StepSize; // implicitly reduce to half step
+  const double h = SIMLIB_StepSize;
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A1[i] = SIMLIB_StepSize*(*ip)->GetOldDiff(); // compute coefficient
-    (*ip)->SetState((*ip)->GetOldState() + 0.2*A1[i]); // state (y) for next sub-step
+  for(i=0; i<count; i++) {
+    a1[i] = h*dyl[i]; // compute coefficient
+    y[i] = yl[i] + 0.2*a1[i]; // state (y) for next sub-step
   }
 
   ////////////////////////////////////////////////////////////// 0.2 of step
@@ -98,9 +105,9 @@ begin_step:
 
   SIMLIB_Dynamic();  // evaluate new state of model (y'=f(t,y))      (1)
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A2[i] = SIMLIB_StepSize*(*ip)->GetDiff();
-    (*ip)->SetState((*ip)->GetOldState() + (3.0*A1[i] + 9.0*A2[i]) / 40.0);
+  for(i=0; i<count; i++) {
+    a2[i] = h*dy[i];
+    y[i] = yl[i] + (3.0*a1[i] + 9.0*a2[i]) / 40.0;
   }
 
   ////////////////////////////////////////////////////////////// 0.3 of step
@@ -110,9 +117,9 @@ begin_step:
 
   SIMLIB_Dynamic();  // evaluate new state of model                  (2)
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A3[i] = SIMLIB_StepSize*(*ip)->GetDiff();
-    (*ip)->SetState((*ip)->GetOldState() + 0.3 * A1[i] - 0.9 * A2[i] + 1.2 * A3[i]);
+  for(i=0; i<count; i++) {
+    a3[i] = h*dy[i];
+    y[i] = yl[i] + 0.3 * a1[i] - 0.9 * a2[i] + 1.2 * a3[i];
   }
 
   ////////////////////////////////////////////////////////////// 0.6 of step
@@ -122,12 +129,12 @@ begin_step:
 
   SIMLIB_Dynamic();  // evaluate new state of model                  (3)
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A4[i] = SIMLIB_StepSize*(*ip)->GetDiff();
-    (*ip)->SetState((*ip)->GetOldState() - 11.0 / 54.0 * A1[i]
-                                   +  2.5        * A2[i]
-                                   - 70.0 / 27.0 * A3[i]
-                                   + 35.0 / 27.0 * A4[i]);
+  for(i=0; i<count; i++) {
+    a4[i] = h*dy[i];
+    y[i] = yl[i] - 11.0 / 54.0 * a1[i]
+                 +  2.5        * a2[i]
+                 - 70.0 / 27.0 * a3[i]
+                 + 35.0 / 27.0 * a4[i];
   }
 
   ////////////////////////////////////////////////////////////// 1.0 of step
@@ -137,13 +144,13 @@ begin_step:
 
   SIMLIB_Dynamic();  // evaluate new state of model                  (4)
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A5[i] = SIMLIB_StepSize*(*ip)->GetDiff();
-    (*ip)->SetState((*ip)->GetOldState() +  1631.0 /  55296.0 * A1[i]
-                                   +   175.0 /    512.0 * A2[i]
-                                   +   575.0 /  13824.0 * A3[i]
-                                   + 44275.0 / 110592.0 * A4[i]
-                                   +   253.0 /   4096.0 * A5[i]);
+  for(i=0; i<count; i++) {
+    a5[i] = h*dy[i];
+    y[i] = yl[i] +  1631.0 /  55296.0 * a1[i]
+                 +   175.0 /    512.0 * a2[i]
+                 +   575.0 /  13824.0 * a3[i]
+                 + 44275.0 / 110592.0 * a4[i]
+                 +   253.0 /   4096.0 * a5[i];
   }
 
   ///////////////////////////////////////////////////////////// 0.875 of step
@@ -153,12 +160,12 @@ begin_step:
 
   SIMLIB_Dynamic();  // evaluate new state of model                  (5)
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A6[i] = SIMLIB_StepSize*(*ip)->GetDiff();
-    (*ip)->SetState((*ip)->GetOldState() +  37.0 /  378.0 * A1[i] // final state
-                                   + 250.0 /  621.0 * A3[i]
-                                   + 125.0 /  594.0 * A4[i]
-                                   + 512.0 / 1771.0 * A6[i]);
+  for(i=0; i<count; i++) {
+    a6[i] = h*dy[i];
+    y[i] = yl[i] +  37.0 /  378.0 * a1[i] // final state
+                 + 250.0 /  621.0 * a3[i]
+                 + 125.0 /  594.0 * a4[i]
+                 + 512.0 / 1771.0 * a6[i];
   }
 
   ////////////////////////////////////////////////////////////// end of step
@@ -174,17 +181,17 @@ begin_step:
   SIMLIB_ERRNO = 0; // OK
   ratio = 32.0;     // 2^5 - ratio for stepsize computation - initial value
   n=0;              // integrator with greatest error
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
+  for(i=0; i<count; i++) {
     double eerr; // estimated error
     double terr; // greatest allowed error
 
-    eerr = fabs(  -277.0 /  64512.0 * A1[i] // estimation
-                + 6925.0 / 370944.0 * A3[i]
-                - 6925.0 / 202752.0 * A4[i]
-                -  277.0 /  14336.0 * A5[i]
-                +  277.0 /   7084.0 * A6[i]);
+    eerr = fabs(  -277.0 /  64512.0 * a1[i] // estimation
+                + 6925.0 / 370944.0 * a3[i]
+                - 6925.0 / 202752.0 * a4[i]
+                -  277.0 /  14336.0 * a5[i]
+                +  277.0 /   7084.0 * a6[i]);
     terr = fabs(SIMLIB_AbsoluteError)
-         + fabs(SIMLIB_RelativeError*(*ip)->GetState());
+         + fabs(SIMLIB_RelativeError*y[i]);
     if(terr < eerr*ratio) { // avoid arithmetic overflow
       ratio = terr/eerr;    // find the lowest ratio
       n=i;                  // remember the integrator
@@ -45,7 +45,6 @@ void RKF8::Integrate(void)
   const double pshrnk = 1.0/7.0; // coefficient for reducing step
   const double pgrow  = 1.0/8.0; // coefficient for increasing step
   size_t i;   // auxiliary variables for loops
-  Iterator ip, end_it; // to go through list of integrators
   double ratio;     // ratio for next stepsize computation
   double next_step; // recommended stepsize for next step
   size_t n;         // integrator with greatest error
@@ -53,7 +52,17 @@ void RKF8::Integrate(void)
   Dprintf((" RKF8 integration step ")); // print debugging info
   Dprintf((" Time = %g, optimal step = %g", (double)Time, OptStep));
 
-  end_it=LastIntegrator(); // end of container of integrators
+  // arrays of integrator values and coefficients (vectorized loops)
+  const size_t count = IntegratorContainer::Size();
+  double *y = IntegratorContainer::State();
+  const double *yl = IntegratorContainer::OldState();
+  const double *dy = IntegratorContainer::Diff();
+  const double *dyl = IntegratorContainer::OldDiff();
+  double *a1 = A1.Data(), *a2 = A2.Data(), *a3 = A3.Data();
+  double *a4 = A4.Data(), *a5 = A5.Data(), *a6 = A6.Data();
+  double *a7 = A7.Data(), *a8 = A8.Data(), *a9 = A9.Data();
+  double *a10 = A10.Data(), *a11 = A11.Data(), *a12 = A12.Data();
+  double *a13 = A13.Data();
 
   //--------------------------------------------------------------------------
   //  Step of method
@@ -67,10 +76,11 @@ begin_step:
 
   SIMLIB_ContractStepFlag = false;           // clear reduce step flag
   SIMLIB_ContractStep = 0.5*SIMLIB_StepSize; // implicitly reduce to half step
+  const double h = SIMLIB_StepSize;
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A1[i]  = SIMLIB_StepSize*(*ip)->GetOldDiff(); // compute coefficient
-    (*ip)->SetState((*ip)->GetOldState() + 0.25*A1[i]); // state (y) for next substep
+  for(i=0; i<count; i++) {
+    a1[i]  = h*dyl[i]; // compute coefficient
+    y[i] = yl[i] + 0.25*a1[i]; // state (y) for next substep
   }
 
   ////////////////////////////////////////////////////////////// 1/4 of step
@@ -80,9 +90,9 @@ begin_step:
 
   SIMLIB_Dynamic();  // evaluate new state of model (y'=f(t,y))      (1)
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A2[i]  = SIMLIB_StepSize*(*ip)->GetDiff();
-    (*ip)->SetState((*ip)->GetOldState() + (5.0*A1[i] + A2[i]) / 72.0);
+  for(i=0; i<count; i++) {
+    a2[i]  = h*dy[i];
+    y[i] = yl[i] + (5.0*a1[i] + a2[i]) / 72.0;
   }
 
   ////////////////////////////////////////////////////////////// 1/12 of step
@@ -92,9 +102,9 @@ begin_step:
 
   SIMLIB_Dynamic();  // evaluate new state of model                  (2)
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A3[i]  = SIMLIB_StepSize*(*ip)->GetDiff();
-    (*ip)->SetState((*ip)->GetOldState() + (A1[i] + 3.0*A3[i]) / 32.0);
+  for(i=0; i<count; i++) {
+    a3[i]  = h*dy[i];
+    y[i] = yl[i] + (a1[i] + 3.0*a3[i]) / 32.0;
   }
 
   ////////////////////////////////////////////////////////////// 1/8 of step
@@ -104,12 +114,12 @@ begin_step:
 
   SIMLIB_Dynamic();  // evaluate new state of model                  (3)
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A4[i]  = SIMLIB_StepSize*(*ip)->GetDiff();
-    (*ip)->SetState((*ip)->GetOldState() + (   106.0 * A1[i]
-                         - 408.0 * A3[i]
-                         + 352.0 * A4[i]
-                       ) / 125.0);
+  for(i=0; i<count; i++) {
+    a4[i]  = h*dy[i];
+    y[i] = yl[i] + (   106.0 * a1[i]
+                     - 408.0 * a3[i]
+                     + 352.0 * a4[i]
+                   ) / 125.0;
   }
 
   ////////////////////////////////////////////////////////////// 2/5 of step
@@ -119,11 +129,11 @@ begin_step:
 
   SIMLIB_Dynamic();  // evaluate new state of model                  (4)
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A5[i]  = SIMLIB_StepSize*(*ip)->GetDiff();
-    (*ip)->SetState((*ip)->GetOldState() +   1.0 /  48.0 * A1[i]
-                     +   8.0 /  33.0 * A4[i]
-                     + 125.0 / 528.0 * A5[i]);
+  for(i=0; i<count; i++) {
+    a5[i]  = h*dy[i];
+    y[i] = yl[i] +   1.0 /  48.0 * a1[i]
+                 +   8.0 /  33.0 * a4[i]
+                 + 125.0 / 528.0 * a5[i];
   }
 
   ///////////////////////////////////////////////////////////// 1/2 of step
@@ -133,12 +143,12 @@ begin_step:
 
   SIMLIB_Dynamic();  // evaluate new state of model                  (5)
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A6[i]  = SIMLIB_StepSize*(*ip)->GetDiff();
-    (*ip)->SetState((*ip)->GetOldState() -  1263.0 /  2401.0 * A1[i]
-                     + 39936.0 / 26411.0 * A4[i]
-                     - 64125.0 / 26411.0 * A5[i]
-                     +  5520.0 /  2401.0 * A6[i]);
+  for(i=0; i<count; i++) {
+    a6[i]  = h*dy[i];
+    y[i] = yl[i] -  1263.0 /  2401.0 * a1[i]
+                 + 39936.0 / 26411.0 * a4[i]
+                 - 64125.0 / 26411.0 * a5[i]
+                 +  5520.0 /  2401.0 * a6[i];
   }
 
   ///////////////////////////////////////////////////////////// 6/7 of step
@@ -148,12 +158,12 @@ begin_step:
 
   SIMLIB_Dynamic();  // evaluate new state of model                  (6)
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A7[i]  = SIMLIB_StepSize*(*ip)->GetDiff();
-    (*ip)->SetState((*ip)->GetOldState() +   37.0 /  392.0 * A1[i]
-                     + 1625.0 / 9408.0 * A5[i]
-                     -    2.0 /   15.0 * A6[i]
-                     +   61.0 / 6720.0 * A7[i]);
+  for(i=0; i<count; i++) {
+    a7[i]  = h*dy[i];
+    y[i] = yl[i] +   37.0 /  392.0 * a1[i]
+                 + 1625.0 / 9408.0 * a5[i]
+                 -    2.0 /   15.0 * a6[i]
+                 +   61.0 / 6720.0 * a7[i];
   }
 
   ///////////////////////////////////////////////////////////// 1/7 of step
@@ -163,14 +173,14 @@ begin_step:
 
   SIMLIB_Dynamic();  // evaluate new state of model                  (7)
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A8[i]  = SIMLIB_StepSize*(*ip)->GetDiff();
-    (*ip)->SetState((*ip)->GetOldState() + 17176.0 /  25515.0 * A1[i]
-                     - 47104.0 /  25515.0 * A4[i]
-                     +  1325.0 /    504.0 * A5[i]
-                     - 41792.0 /  25515.0 * A6[i]
-                     + 20237.0 / 145800.0 * A7[i]
-                     +  4312.0 /   6075.0 * A8[i]);
+  for(i=0; i<count; i++) {
+    a8[i]  = h*dy[i];
+    y[i] = yl[i] + 17176.0 /  25515.0 * a1[i]
+                 - 47104.0 /  25515.0 * a4[i]
+                 +  1325.0 /    504.0 * a5[i]
+                 - 41792.0 /  25515.0 * a6[i]
+                 + 20237.0 / 145800.0 * a7[i]
+                 +  4312.0 /   6075.0 * a8[i];
   }
 
   ///////////////////////////////////////////////////////////// 2/3 of step
@@ -180,15 +190,15 @@ begin_step:
 
   SIMLIB_Dynamic();  // evaluate new state of model                  (8)
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A9[i]  = SIMLIB_StepSize*(*ip)->GetDiff();
-    (*ip)->SetState((*ip)->GetOldState() -  23834.0 /  180075.0 * A1[i]
-                     -  77824.0 / 1980825.0 * A4[i]
-                     - 636635.0 /  633864.0 * A5[i]
-                     + 254048.0 /  300125.0 * A6[i]
-                     -    183.0 /    7000.0 * A7[i]
-                     +      8.0 /      11.0 * A8[i]
-                     -    324.0 /    3773.0 * A9[i]);
+  for(i=0; i<count; i++) {
+    a9[i]  = h*dy[i];
+    y[i] = yl[i] -  23834.0 /  180075.0 * a1[i]
+                 -  77824.0 / 1980825.0 * a4[i]
+                 - 636635.0 /  633864.0 * a5[i]
+                 + 254048.0 /  300125.0 * a6[i]
+                 -    183.0 /    7000.0 * a7[i]
+                 +      8.0 /      11.0 * a8[i]
+                 -    324.0 /    3773.0 * a9[i];
   }
 
   ///////////////////////////////////////////////////////////// 2/7 of step
@@ -198,16 +208,16 @@ begin_step:
 
   SIMLIB_Dynamic();  // evaluate new state of model                  (9)
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A10[i]  = SIMLIB_StepSize*(*ip)->GetDiff();
-    (*ip)->SetState((*ip)->GetOldState() +  12733.0 /   7600.0 * A1[i]
-                     -  20032.0 /   5225.0 * A4[i]
-                     + 456485.0 /  80256.0 * A5[i]
-                     -  42599.0 /   7125.0 * A6[i]
-                     + 339227.0 / 912000.0 * A7[i]
-                     -   1029.0 /   4180.0 * A8[i]
-                     +   1701.0 /   1408.0 * A9[i]
-                     +   5145.0 /   2432.0 * A10[i]);
+  for(i=0; i<count; i++) {
+    a10[i]  = h*dy[i];
+    y[i] = yl[i] +  12733.0 /   7600.0 * a1[i]
+                 -  20032.0 /   5225.0 * a4[i]
+                 + 456485.0 /  80256.0 * a5[i]
+                 -  42599.0 /   7125.0 * a6[i]
+                 + 339227.0 / 912000.0 * a7[i]
+                 -   1029.0 /   4180.0 * a8[i]
+                 +   1701.0 /   1408.0 * a9[i]
+                 +   5145.0 /   2432.0 * a10[i];
   }
 
   ///////////////////////////////////////////////////////////// 1/1 of step
@@ -217,16 +227,16 @@ begin_step:
 
   SIMLIB_Dynamic();  // evaluate new state of model                  (10)
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A11[i]  = SIMLIB_StepSize*(*ip)->GetDiff();
-    (*ip)->SetState((*ip)->GetOldState() -   27061.0 /  204120.0 * A1[i]
-                     +   40448.0 /  280665.0 * A4[i]
-                     - 1353775.0 / 1197504.0 * A5[i]
-                     +   17662.0 /   25515.0 * A6[i]
-                     -   71687.0 / 1166400.0 * A7[i]
-                     +      98.0 /     225.0 * A8[i]
-                     +       1.0 /      16.0 * A9[i]
-                     +    3773.0 /   11664.0 * A10[i]);
+  for(i=0; i<count; i++) {
+    a11[i]  = h*dy[i];
+    y[i] = yl[i] -   27061.0 /  204120.0 * a1[i]
+                 +   40448.0 /  280665.0 * a4[i]
+                 - 1353775.0 / 1197504.0 * a5[i]
+                 +   17662.0 /   25515.0 * a6[i]
+                 -   71687.0 / 1166400.0 * a7[i]
+                 +      98.0 /     225.0 * a8[i]
+                 +       1.0 /      16.0 * a9[i]
+                 +    3773.0 /   11664.0 * a10[i];
   }
 
   ///////////////////////////////////////////////////////////// 1/3 of step
@@ -236,17 +246,17 @@ begin_step:
 
   SIMLIB_Dynamic();  // evaluate new state of model                  (11)
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A12[i]  = SIMLIB_StepSize*(*ip)->GetDiff();
-    (*ip)->SetState((*ip)->GetOldState() +   11203.0 /    8680.0 * A1[i]
-                     -   38144.0 /   11935.0 * A4[i]
-                     + 2354425.0 /  458304.0 * A5[i]
-                     -   84046.0 /   16275.0 * A6[i]
-                     +  673309.0 / 1636800.0 * A7[i]
-                     +    4704.0 /    8525.0 * A8[i]
-                     +    9477.0 /   10912.0 * A9[i]
-                     -    1029.0 /     992.0 * A10[i]
-                     +     729.0 /     341.0 * A12[i]);
+  for(i=0; i<count; i++) {
+    a12[i]  = h*dy[i];
+    y[i] = yl[i] +   11203.0 /    8680.0 * a1[i]
+                 -   38144.0 /   11935.0 * a4[i]
+                 + 2354425.0 /  458304.0 * a5[i]
+                 -   84046.0 /   16275.0 * a6[i]
+                 +  673309.0 / 1636800.0 * a7[i]
+                 +    4704.0 /    8525.0 * a8[i]
+                 +    9477.0 /   10912.0 * a9[i]
+                 -    1029.0 /     992.0 * a10[i]
+                 +     729.0 /     341.0 * a12[i];
   }
 
   ////////////////////////////////////////////////////////////// 1/1 of step
@@ -256,12 +266,12 @@ begin_step:
 
   SIMLIB_Dynamic();  // evaluate new state of model                  (9)
 
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
-    A13[i]  = SIMLIB_StepSize*(*ip)->GetDiff();
-    (*ip)->SetState((*ip)->GetOldState()+   31.0/720.0   * (A1[i]+A13[i])
-                    +   16.0/75.0    *  A6[i]
-                    +16807.0/79200.0 * (A7[i]+A8[i])
-                    +  243.0/1760.0  * (A9[i]+A12[i]));
+  for(i=0; i<count; i++) {
+    a13[i]  = h*dy[i];
+    y[i] = yl[i]+   31.0/720.0   * (a1[i]+a13[i])
+                +   16.0/75.0    *  a6[i]
+                +16807.0/79200.0 * (a7[i]+a8[i])
+                +  243.0/1760.0  * (a9[i]+a12[i]);
   }
 
   //--------------------------------------------------------------------------
@@ -271,21 +281,21 @@ begin_step:
   SIMLIB_ERRNO = 0; // OK
   ratio = 256.0;    // 2^8 - ratio for stepsize computation - initial value
   n=0;              // integrator with greatest error
-  for(ip=FirstIntegrator(),i=0; ip!=end_it; ip++,i++) {
+  for(i=0; i<count; i++) {
     double eerr; // estimated error
     double terr; // greatest allowed error
-    eerr = fabs(    -1.0 /    480.0 * A1[i]
-                -   16.0 /    375.0 * A6[i]
-                - 2401.0 / 528000.0 * A7[i]
-                + 2401.0 / 132000.0 * A8[i]
-                +  243.0 /  14080.0 * A9[i]
-                - 2401.0 /  19200.0 * A10[i]
-                -   19.0 /    450.0 * A11[i]
-                +  243.0 /   1760.0 * A12[i]
-                +   31.0 /    720.0 * A13[i]
+    eerr = fabs(    -1.0 /    480.0 * a1[i]
+                -   16.0 /    375.0 * a6[i]
+                - 2401.0 / 528000.0 * a7[i]
+                + 2401.0 / 132000.0 * a8[i]
+                +  243.0 /  14080.0 * a9[i]
+                - 2401.0 /  19200.0 * a10[i]
+                -   19.0 /    450.0 * a11[i]
+                +  243.0 /   1760.0 * a12[i]
+                +   31.0 /    720.0 * a13[i]
                );
     terr = fabs(SIMLIB_AbsoluteError)
-         + fabs(SIMLIB_RelativeError*(*ip)->GetState());
+         + fabs(SIMLIB_RelativeError*y[i]);
     if(terr < eerr*ratio) { // avoid arithmetic overflow
       ratio = terr/eerr;    // find the lowest ratio
       n=i;                  // remember the integrator
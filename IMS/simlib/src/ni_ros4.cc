@@ -0,0 +1,201 @@
+/////////////////////////////////////////////////////////////////////////////
+// ni_ros4.cc
+//
+// Copyright (c) 1991-2018 Petr Peringer
+//
+// This library is licensed under GNU Library GPL. See the file COPYING.
+//
+
+//
+//  numerical integration: Rosenbrock's method 4th order (stiff systems)
+//
+
+////////////////////////////////////////////////////////////////////////////
+//  interface
+//
+#include "simlib.h"
+#include "internal.h"
+#include "ni_ros4.h"
+#include <cmath>
+#include <cstddef>
+
+
+////////////////////////////////////////////////////////////////////////////
+//  implementation
+//
+namespace simlib3 {
+
+SIMLIB_IMPLEMENTATION;
+
+
+////////////////////////////////////////////////////////////////////////////
+//  Rosenbrock's method 4th order with embedded 3rd order error estimation
+//  (Shampine's parameters), Jacobian J and df/dt at start of step
+//
+/*  Formula:
+
+    A = I/(gam*h) - J
+    A g1 = f(t,y) + h*c1x*dfdt
+    A g2 = f(t+a2x*h, y + a21*g1) + h*c2x*dfdt + c21*g1/h
+    A g3 = f(t+a3x*h, y + a31*g1 + a32*g2) + h*c3x*dfdt + (c31*g1 + c32*g2)/h
+    A g4 = f(t+a3x*h, y + a31*g1 + a32*g2) + h*c4x*dfdt
+                                    + (c41*g1 + c42*g2 + c43*g3)/h
+    y  += b1*g1 + b2*g2 + b3*g3 + b4*g4
+    err = e1*g1 + e2*g2 + e3*g3 + e4*g4
+*/
+
+void ROS4::Integrate(void)
+{
+  const double gam = 1.0/2.0;
+  const double a21 = 2.0,          a31 = 48.0/25.0,   a32 = 6.0/25.0;
+  const double c21 = -8.0,         c31 = 372.0/25.0,  c32 = 12.0/5.0;
+  const double c41 = -112.0/125.0, c42 = -54.0/125.0, c43 = -2.0/5.0;
+  const double b1 = 19.0/9.0,      b2 = 1.0/2.0;
+  const double b3 = 25.0/108.0,    b4 = 125.0/108.0;
+  const double e1 = 17.0/54.0,     e2 = 7.0/36.0,     e4 = 125.0/108.0;
+  const double c1x = 1.0/2.0,      c2x = -3.0/2.0;
+  const double c3x = 121.0/50.0,   c4x = 29.0/250.0;
+  const double a2x = 1.0,          a3x = 3.0/5.0;
+  const double safety = 0.9;     // keeps the new step from growing too large
+  const double grow = 1.5;       // max. ratio for increasing step
+  const double shrnk = 0.5;      // min. ratio for reducing step
+  const double pgrow = -0.25;    // coefficient for increasing step
+  const double pshrnk = -1.0/3.0; // coefficient for reducing step
+  const double errcon = pow(grow/safety, 1.0/pgrow);
+  size_t i;   // auxiliary variables for loops
+  double errmax;    // greatest ratio of error to allowed error
+  double next_step; // recommended stepsize for next step
+
+  Dprintf((" ROS4 integration step ")); // print debugging info
+  Dprintf((" Time = %g, optimal step = %g", (double)Time, OptStep));
+
+  // arrays of integrator values and coefficients
+  const size_t count = IntegratorContainer::Size();
+  double *y = IntegratorContainer::State();
+  const double *yl = IntegratorContainer::OldState();
+  double *dy = IntegratorContainer::Diff();
+  const double *dyl = IntegratorContainer::OldDiff();
+  double *g1 = G1.Data(), *g2 = G2.Data(), *g3 = G3.Data(), *g4 = G4.Data();
+  double *err = ERR.Data();
+
+  JacobianOK = false;  // new start point
+
+  //--------------------------------------------------------------------------
+  //  Step of method
+  //--------------------------------------------------------------------------
+
+begin_step:
+
+  ///////////////////////////////////////////////////////// beginning of step
+
+  SIMLIB_StepSize = max(SIMLIB_StepSize, SIMLIB_MinStep); // low step limit
+
+  SIMLIB_ContractStepFlag = false;           // clear reduce step flag
+  SIMLIB_ContractStep = 0.5*SIMLIB_StepSize; // implicitly reduce to half step
+  const double h = SIMLIB_StepSize;
+
+  if(!JacobianOK) { // Jacobian in start point of step
+    for(i=0; i<count; i++) {
+      y[i] = yl[i];
+      dy[i] = dyl[i];
+    }
+    _SetTime(Time, SIMLIB_StepStartTime);
+    SIMLIB_DeltaTime = 0.0;
+    Jacobian(true);
+  }
+  if(!Factor(1.0/(gam*h))) { // singular matrix, try smaller step
+    if(h > SIMLIB_MinStep) {
+      SIMLIB_StepSize = max(0.5*h, SIMLIB_MinStep);
+      IsEndStepEvent = false;
+      goto begin_step;
+    }
+    SIMLIB_error(NI_SingularMatrix);
+  }
+
+  for(i=0; i<count; i++)
+    g1[i] = dyl[i] + h*c1x*dfdt[i];
+  M.Solve(g1);
+  for(i=0; i<count; i++)
+    y[i] = yl[i] + a21*g1[i];
+
+  _SetTime(Time, SIMLIB_StepStartTime + a2x*h); // substep's time
+  SIMLIB_DeltaTime = double(Time) - SIMLIB_StepStartTime;
+
+  SIMLIB_Dynamic();  // evaluate new state of model (y'=f(t,y))      (1)
+
+  for(i=0; i<count; i++)
+    g2[i] = dy[i] + h*c2x*dfdt[i] + c21*g1[i]/h;
+  M.Solve(g2);
+  for(i=0; i<count; i++)
+    y[i] = yl[i] + a31*g1[i] + a32*g2[i];
+
+  _SetTime(Time, SIMLIB_StepStartTime + a3x*h); // substep's time
+  SIMLIB_DeltaTime = double(Time) - SIMLIB_StepStartTime;
+
+  SIMLIB_Dynamic();  // evaluate new state of model                  (2)
+
+  for(i=0; i<count; i++)
+    g3[i] = dy[i] + h*c3x*dfdt[i] + (c31*g1[i] + c32*g2[i])/h;
+  M.Solve(g3);
+  for(i=0; i<count; i++)
+    g4[i] = dy[i] + h*c4x*dfdt[i] + (c41*g1[i] + c42*g2[i] + c43*g3[i])/h;
+  M.Solve(g4);
+  for(i=0; i<count; i++) {
+    y[i] = yl[i] + b1*g1[i] + b2*g2[i] + b3*g3[i] + b4*g4[i];
+    err[i] = e1*g1[i] + e2*g2[i] + e4*g4[i];
+  }
+
+  ////////////////////////////////////////////////////////////// end of step
+
+  _SetTime(Time, SIMLIB_StepStartTime+SIMLIB_StepSize); // go to end of step
+  SIMLIB_DeltaTime = SIMLIB_StepSize;
+  SIMLIB_Dynamic();
+
+  //--------------------------------------------------------------------------
+  //  Check on accuracy of numerical integration, estimate error
+  //--------------------------------------------------------------------------
+
+  SIMLIB_ERRNO = 0; // OK
+  errmax = Norm(err, y);
+  Dprintf(("E: %g",errmax));
+
+  if(!(errmax <= 1.0)) { // error is too large, reduce stepsize
+    if(SIMLIB_StepSize > SIMLIB_MinStep) {  // reducing step is possible
+      SIMLIB_OptStep = max(safety*h*pow(errmax,pshrnk), shrnk*h);
+      SIMLIB_OptStep = max(SIMLIB_OptStep, SIMLIB_MinStep);
+      SIMLIB_StepSize = SIMLIB_OptStep;
+      IsEndStepEvent = false; // no event will be at the end of the step
+      goto begin_step;        // compute again with smaller step
+    }
+    // reducing step is unpossible
+    SIMLIB_ERRNO++;          // requested accuracy cannot be achieved
+    SIMLIB_warning(AccuracyError);
+    next_step = SIMLIB_StepSize;
+  } else { // allowed tolerantion is fulfiled
+    if(!IsStartMode()) { // method is not used for start multi-step method
+      next_step = errmax > errcon ? safety*h*pow(errmax,pgrow) : grow*h;
+      next_step = min(next_step, SIMLIB_MaxStep);
+    } else {
+      next_step = SIMLIB_StepSize;
+    }
+  }
+
+  //--------------------------------------------------------------------------
+  //  Analyse system at the end of the step
+  //--------------------------------------------------------------------------
+
+  if(StateCond()) { // check on changes of state conditions at end of step
+    goto begin_step;
+  }
+
+  //--------------------------------------------------------------------------
+  //  Results of step have been accepted, take fresh step
+  //--------------------------------------------------------------------------
+
+  SIMLIB_OptStep = next_step;
+
+} // ROS4::Integrate
+
+}
+// end of ni_ros4.cc
+
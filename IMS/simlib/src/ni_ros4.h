@@ -0,0 +1,36 @@
+/////////////////////////////////////////////////////////////////////////////
+//! \file ni_ros4.h  Rosenbrock method 4th order (stiff systems)
+//
+// Copyright (c) 1991-2018 Petr Peringer
+//
+// This library is licensed under GNU Library GPL. See the file COPYING.
+//
+
+//
+//  numerical integration: Rosenbrock's method 4th order (Shampine)
+//
+
+
+#include "ni_implicit.h"
+
+namespace simlib3 {
+
+////////////////////////////////////////////////////////////////////////////
+//  class representing the integration method
+//
+class ROS4 : public ImplicitMethod {
+private:
+  Memory G1, G2, G3, G4, ERR;  // auxiliary memories
+public:
+  ROS4(const char* name) :  // registrate method and name it
+    ImplicitMethod(name)
+  { /*NOTHING*/ }
+  virtual ~ROS4()  // destructor
+  { /*NOTHING*/ }
+  virtual void Integrate(void) override;  // integration method
+}; // class ROS4
+
+}
+
+// end of ni_ros4.h
+
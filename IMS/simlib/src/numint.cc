@@ -18,14 +18,19 @@
 #include "simlib.h"
 #include "internal.h"
 #include "ni_abm4.h"
+#include "ni_bdf.h"
+#include "ni_dopri5.h"
 #include "ni_euler.h"
 #include "ni_fw.h"
+#include "ni_ros4.h"
 #include "ni_rke.h"
 #include "ni_rkf3.h"
 #include "ni_rkf5.h"
 #include "ni_rkf8.h"
+#include <cmath>
 #include <cstddef>
 #include <cstring>
+#include <vector>
 
 
 ////////////////////////////////////////////////////////////////////////////
@@ -59,6 +64,8 @@ void IntegrationMethod::StepSim(void)
   if(Prepare()) { // initialize integration step (condition is not changed)
     if(IntegratorContainer::isAny()) { // are there any integrators?
       CurrentMethodPtr->Integrate(); // * numerical integration *
+      if(double(Time) > double(NextTime))
+        DenseEvents(); // step with dense output goes over event
     } else {     // model without integrators
       Iterate(); // compute new values of state blocks
     }
@@ -119,7 +126,7 @@ void IntegrationMethod::Summarize(void)
   IntegratorContainer::NtoL();
   StatusContainer::NtoL();
   if(IsEndStepEvent)          // event at the end of step
-    _SetTime(Time, NextTime); // suppress inaccuracy of float
+    _SetTime(Time, EndStepTime); // suppress inaccuracy of float
 } // IntegrationMethod::Summarize
 
 
@@ -134,9 +141,17 @@ bool IntegrationMethod::Prepare(void)
  // If an event is scheduled within the step,
   // set on flag, that will be event at the end of the step
   IsEndStepEvent=(bool)(double(Time)+1.01*SIMLIB_StepSize>=NextTime);//1.1???
+  EndStepTime = NextTime;
+  // method with dense output goes over events (see DenseEvents),
+  // the step is limited by the end of simulation only
+  if(IsEndStepEvent && double(Time)+SIMLIB_StepSize>NextTime &&
+     CurrentMethodPtr->HasDenseOutput() && !StatusContainer::isAny()) {
+    EndStepTime = SIMLIB_EndTime;
+    IsEndStepEvent=(bool)(double(Time)+1.01*SIMLIB_StepSize>=EndStepTime);
+  }
   // and adjust step size, so that event will take place at end of step
   if(IsEndStepEvent)
-    SIMLIB_StepSize = double(NextTime)-double(Time);
+    SIMLIB_StepSize = EndStepTime-double(Time);
 
   // set up auxiliary variables
   SIMLIB_StepStartTime = Time; // start time of integration
@@ -170,6 +185,65 @@ bool IntegrationMethod::Prepare(void)
 }
 
 
+////////////////////////////////////////////////////////////////////////////
+///  state of integrators in time t inside of the last step
+///  (dense output of the method, not possible for status blocks)
+bool IntegrationMethod::Interpolate(double t, double *y)
+{
+  if(StatusContainer::isAny())
+    return false;
+  return CurrentMethodPtr->DenseOutput(t, y);
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+///  step of method with dense output went over the next event:
+///  samplers inside the step are called with interpolated state,
+///  step is reduced to the first other event (interpolated state)
+void IntegrationMethod::DenseEvents(void)
+{
+  Dprintf(("IntegrationMethod::DenseEvents()"));
+  static thread_local std::vector<double> y1; // state at the end of step
+  const size_t count = IntegratorContainer::Size();
+  double *y = IntegratorContainer::State();
+  const double t1 = Time;
+  const double dt = SIMLIB_DeltaTime;
+  y1.assign(y, y + count);
+  while(double(NextTime) < t1 && !SQS::Empty() &&
+        dynamic_cast<Sampler*>(SQS::First())) {
+    double t = NextTime;
+    if(!Interpolate(t, y))
+      break;
+    _SetTime(Time, t);
+    SIMLIB_DeltaTime = t - SIMLIB_StepStartTime;
+    SIMLIB_DynamicFlag = false;   // sampler is called as an event
+    SIMLIB_Current = SQS::GetFirst();
+    SIMLIB_DoActions();
+    SIMLIB_DynamicFlag = true;
+    if(SIMLIB_ResetStatus) {      // state changed by sampler, end of step
+      Condition::TestAll();
+      IsEndStepEvent = false;
+      return;
+    }
+  }
+  _SetTime(Time, t1);
+  SIMLIB_DeltaTime = dt;
+  for(size_t i=0; i<count; i++)
+    y[i] = y1[i];
+  if(double(NextTime) < t1) {     // other event inside the step
+    double t = NextTime;
+    if(!Interpolate(t, y))
+      return;                     // can not happen (method without output)
+    _SetTime(Time, t);            // step ends at the event
+    SIMLIB_DeltaTime = t - SIMLIB_StepStartTime;
+    SIMLIB_Dynamic();
+    Condition::TestAll();         // status of conditions in new end of step
+    EndStepTime = t;
+    IsEndStepEvent = true;
+  }
+}
+
+
 ////////////////////////////////////////////////////////////////////////////
 ///  check on changes of state conditions
 bool IntegrationMethod::StateCond(void)
@@ -180,6 +254,14 @@ bool IntegrationMethod::StateCond(void)
 
   if(SIMLIB_ContractStepFlag && SIMLIB_StepSize>SIMLIB_MinStep) {
     // step reducing is requested and it is possible
+    double t;
+    if(SIMLIB_EventLocation && SIMLIB_ConditionFlag &&
+       !StatusContainer::isAny() && aCondition::Locate(t)) {
+      // state event located at time t
+      if(t >= double(Time) - max(SIMLIB_MinStep, 1e-14*fabs(double(Time))))
+        return false;                   // step ends at the state event
+      SIMLIB_ContractStep = max(t - SIMLIB_StepStartTime, SIMLIB_MinStep);
+    }
     SIMLIB_StepSize = SIMLIB_ContractStep; // reduce step to demanded size
                                            // implicitly to quater of step
     IsEndStepEvent = false; // no event will be scheduled at end of step
@@ -570,15 +652,15 @@ void StatusMethod::StatusResize(size_t size)
 void StatusMethod::StoreState(Memory& di, Memory& si, StatusMemory& xi)
 {
   size_t i;
-  IntegratorContainer::iterator ip, end_it;
   StatusContainer::iterator sp, status_end_it;
 
-  for(ip=IntegratorContainer::Begin(), end_it=IntegratorContainer::End(), i=0;
-      ip!=end_it;
-      ++ip, i++)
-  {
-    di[i]=(*ip)->GetDiff();
-    si[i]=(*ip)->GetState();
+  const size_t count = IntegratorContainer::Size();
+  const double *dy = IntegratorContainer::Diff();
+  const double *y = IntegratorContainer::State();
+  double *d = di.Data(), *s = si.Data();
+  for(i=0; i<count; i++) {
+    d[i]=dy[i];
+    s[i]=y[i];
   }
 
   for(sp=StatusContainer::Begin(), status_end_it=StatusContainer::End(), i=0;
@@ -595,15 +677,15 @@ void StatusMethod::RestoreState(double dthlf, Memory& di, Memory& si,
                                 StatusMemory& xi)
 {
   size_t i;
-  IntegratorContainer::iterator ip, end_it;
   StatusContainer::iterator sp, status_end_it;
 
-  for(ip=IntegratorContainer::Begin(), end_it=IntegratorContainer::End(), i=0;
-      ip!=end_it;
-      ++ip, i++)
-  {
-    (*ip)->SetDiff(di[i]);
-    (*ip)->SetState(si[i]);
+  const size_t count = IntegratorContainer::Size();
+  double *dy = IntegratorContainer::Diff();
+  double *y = IntegratorContainer::State();
+  const double *d = di.Data(), *s = si.Data();
+  for(i=0; i<count; i++) {
+    dy[i]=d[i];
+    y[i]=s[i];
   }
 
   for(sp=StatusContainer::Begin(), status_end_it=StatusContainer::End(), i=0;
@@ -622,15 +704,15 @@ void StatusMethod::RestoreState(double dthlf, Memory& di, Memory& si,
 void StatusMethod::GoToState(Memory& di, Memory& si, StatusMemory& xi)
 {
   size_t i;
-  IntegratorContainer::iterator ip, end_it;
   StatusContainer::iterator sp, status_end_it;
 
-  for(ip=IntegratorContainer::Begin(), end_it=IntegratorContainer::End(), i=0;
-      ip!=end_it;
-      ++ip, i++)
-  {
-    (*ip)->SetOldDiff(di[i]);
-    (*ip)->SetOldState(si[i]);
+  const size_t count = IntegratorContainer::Size();
+  double *dyl = IntegratorContainer::OldDiff();
+  double *yl = IntegratorContainer::OldState();
+  const double *d = di.Data(), *s = si.Data();
+  for(i=0; i<count; i++) {
+    dyl[i]=d[i];
+    yl[i]=s[i];
   }
 
   for(sp=StatusContainer::Begin(), status_end_it=StatusContainer::End(), i=0;
@@ -648,39 +730,46 @@ void StatusMethod::GoToState(Memory& di, Memory& si, StatusMemory& xi)
 const size_t IntegrationMethod::Memory::page_size = 256;
 
 // flag - will be event at the end of the step?
-bool IntegrationMethod::IsEndStepEvent=false;
+thread_local bool IntegrationMethod::IsEndStepEvent=false;
+thread_local double IntegrationMethod::EndStepTime=0;
 
 // list of registered methods
-std::list<IntegrationMethod*>* IntegrationMethod::MthLstPtr=NULL;
+thread_local std::list<IntegrationMethod*>* IntegrationMethod::MthLstPtr=NULL;
 
 // pointer to the filled list of memories
-std::list<IntegrationMethod::Memory*>* IntegrationMethod::PtrMList;
+thread_local std::list<IntegrationMethod::Memory*>* IntegrationMethod::PtrMList;
 
 // pointer to the filled list of status memories
-std::list<IntegrationMethod::Memory*>* StatusMethod::PtrStatusMList;
+thread_local std::list<IntegrationMethod::Memory*>* StatusMethod::PtrStatusMList;
 
 
 ////////////////////////////////////////////////////////////////////////////
 // instantiate integration methods
 
 /// Adams-Bashforth-Moulton, 4th order
-ABM4 abm4("abm4", "rkf5");
+thread_local ABM4 abm4("abm4", "rkf5");
+/// Backward differentiation formulas, order 1..5 (stiff systems)
+thread_local BDF bdf("bdf");
+/// Dormand-Prince, 5th order with dense output
+thread_local DOPRI5 dopri5("dopri5");
 /// Euler method
-EULER euler("euler");
+thread_local EULER euler("euler");
 /// Fowler-Warten (Warning: needs testing, do not use)
-FW fw("fw");
+thread_local FW fw("fw");
 /// Runge-Kutta-England, 4th order?
-RKE rke("rke");
+thread_local RKE rke("rke");
+/// Rosenbrock, 4th order (stiff systems)
+thread_local ROS4 ros4("ros4");
 /// Runge-Kutta-Fehlberg, 3rd order
-RKF3 rkf3("rkf3");
+thread_local RKF3 rkf3("rkf3");
 /// Runge-Kutta-Fehlberg, 5th order
-RKF5 rkf5("rkf5");
+thread_local RKF5 rkf5("rkf5");
 /// Runge-Kutta-Fehlberg, 8th order
-RKF8 rkf8("rkf8");
+thread_local RKF8 rkf8("rkf8");
 
 /// pointer to the method currently used
 /// "rke" is a predefined method (historical reasons, we need rk45)
-IntegrationMethod* IntegrationMethod::CurrentMethodPtr = &rke;
+thread_local IntegrationMethod* IntegrationMethod::CurrentMethodPtr = &rke;
 
 } // namespace
 
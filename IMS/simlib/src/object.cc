@@ -13,6 +13,7 @@
 #include "simlib.h"
 #include "internal.h"
 #include <unordered_map>          // used by name dictionary
+#include <mutex>
 
 ////////////////////////////////////////////////////////////////////////////
 namespace simlib3 {
@@ -21,14 +22,17 @@ SIMLIB_IMPLEMENTATION;
 ////////////////////////////////////////////////////////////////////////////
 
 // static flag for IsAllocated()
-static bool SimObject_allocated = false;
+static thread_local bool SimObject_allocated = false;
 
 // NameDict singleton: dictionary for partial SimObject->name mapping
 // Naming is not performance sensitive part of SIMLIB/C++
 // We use this approach to save memory (64bit: sizeof(std::string)==32)
+// The dictionary is shared by threads (names of objects created by one
+// thread are visible in others), access is locked.
 class NameDict {
     using TNameDict = std::unordered_map<SimObject*,std::string>;
     static TNameDict *dict;
+    static std::mutex lock;
   public:
     NameDict() {
         if(dict==nullptr) {     // can be created before construction
@@ -39,12 +43,14 @@ class NameDict {
     // can be used before singleton construction
     // Warning: do not use in destructors!
     void Set(SimObject *o, const std::string &name) {
+        std::lock_guard<std::mutex> guard(lock);
         if(dict==nullptr) {
             dict = new TNameDict;
         }
         (*dict)[o] = name;
     }
     std::string Get(const SimObject *o) const {
+        std::lock_guard<std::mutex> guard(lock);
         if(dict==nullptr)
             return ""; // name dictionary not created -> empty name
         TNameDict::iterator it = dict->find(const_cast<SimObject*>(o));
@@ -53,16 +59,19 @@ class NameDict {
         return it->second;
     }
     void Erase(SimObject *o) {
+        std::lock_guard<std::mutex> guard(lock);
         if(dict!=nullptr)
             dict->erase(o);
     }
     ~NameDict() {       // remove dictionary, all named objects -> ""
+        std::lock_guard<std::mutex> guard(lock);
         delete dict;
         dict=nullptr;   // important for Get called after dict destruction
     }
 };
 
 NameDict::TNameDict *NameDict::dict = nullptr; // static member initialization
+std::mutex NameDict::lock;
 static NameDict name_dict; // SINGLETON, possible problems (empty names) if used after destruction
 
 ////////////////////////////////////////////////////////////////////////////
@@ -99,7 +108,8 @@ void SimObject::operator delete(void *ptr) {
 //
 SimObject::SimObject() :
   //_name(0),
-  _flags(0)
+  _flags(0),
+  _serial(0)
 {
 //  Dprintf(("SimObject::SimObject() this=%p ", this));
   if(SimObject_allocated) {
@@ -110,6 +110,14 @@ void Process::Output() const
   Print(" PROCESS %-38s %10s \n", Name().c_str(), isCurrent()?"Current":" ");
 }
 
+////////////////////////////////////////////////////////////////////////////
+//  StepProcess::Output
+//
+void StepProcess::Output() const
+{
+  Print(" PROCESS %-38s %10s \n", Name().c_str(), this==Current?"Current":" ");
+}
+
 ////////////////////////////////////////////////////////////////////////////
 //  Queue::Output
 //
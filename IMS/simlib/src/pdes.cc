@@ -0,0 +1,306 @@
+/////////////////////////////////////////////////////////////////////////////
+//! \file pdes.cc  Conservative parallel simulation (logical processes)
+//
+// Copyright (c) 1991-2018 Petr Peringer
+//
+// This library is licensed under GNU Library GPL. See the file COPYING.
+//
+
+//
+// Each LogicalProcess (LP) runs ordinary Run() in own thread with own
+// simulation context. All LPs advance in time windows: window ends at
+//
+//     W = min over LPs (next event time + lookahead)
+//
+// so no LP can receive message with time less than W from other LP.
+// High priority synchronization event at time W in each LP waits for all
+// LPs (barrier), delivers messages sent in the window to calendar of
+// its LP, and computes the next window. Messages are delivered in order
+// of sender LPs, so the result does not depend on thread scheduling.
+//
+
+////////////////////////////////////////////////////////////////////////////
+// interface
+//
+
+#include "simlib.h"
+#include "internal.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+////////////////////////////////////////////////////////////////////////////
+// implementation
+//
+
+namespace simlib3 {
+
+SIMLIB_IMPLEMENTATION;
+
+// all logical processes (created by main thread)
+static std::vector<LogicalProcess*> LP_list;
+
+// LP running in this thread
+static thread_local LogicalProcess *LP_current = 0;
+
+// shared state of RunParallel
+static struct LP_State {
+  std::mutex mutex;
+  std::condition_variable cond;
+  bool running;                 // RunParallel in progress
+  bool sequential;              // one LP at a time
+  unsigned active;              // LPs in simulation run
+  unsigned waiting;             // LPs waiting at barrier
+  unsigned long generation;     // barrier counter
+  unsigned turn;                // sequential mode: LP in window
+  unsigned order;               // LP calling finish function
+  double window;                // end of next time window
+  const SIMLIB_SignalActions *signals; // actions of calling thread
+
+  // all methods are called with locked mutex
+  void ComputeWindow();
+  void BarrierDone();
+  void Barrier(std::unique_lock<std::mutex> &lock);
+  void PassTurn(unsigned i);
+} LP_state;
+
+////////////////////////////////////////////////////////////////////////////
+// LP_State::ComputeWindow --- end of next time window
+//
+void LP_State::ComputeWindow()
+{
+  double w = SIMLIB_MAXTIME;
+  for(LogicalProcess *lp : LP_list)
+    if(!lp->done && lp->next < SIMLIB_MAXTIME && lp->next + lp->lookahead < w)
+      w = lp->next + lp->lookahead;
+  window = w;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// LP_State::BarrierDone --- all LPs arrived to barrier
+//
+void LP_State::BarrierDone()
+{
+  ComputeWindow();
+  if(sequential) {              // first active LP starts next window
+    turn = 0;
+    if(LP_list[0]->done)
+      PassTurn(0);
+  }
+  waiting = 0;
+  generation++;
+  cond.notify_all();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// LP_State::Barrier --- wait for all active LPs
+//
+void LP_State::Barrier(std::unique_lock<std::mutex> &lock)
+{
+  unsigned long gen = generation;
+  if(++waiting == active)
+    BarrierDone();
+  else
+    cond.wait(lock, [this, gen]{ return generation != gen; });
+}
+
+////////////////////////////////////////////////////////////////////////////
+// LP_State::PassTurn --- sequential mode: next active LP after i can run
+//
+void LP_State::PassTurn(unsigned i)
+{
+  unsigned n = LP_list.size();
+  while(++i < n && LP_list[i]->done)
+    ;
+  turn = i;
+  cond.notify_all();
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+// synchronization event (end of time window)
+//
+class LP_Sync : public Event {
+  LogicalProcess *lp;
+  void Behavior() override {
+    double w = lp->_Synchronize();
+    if(w <= EndTime)
+      Activate(w);              // next window, else the event is deleted
+  }
+ public:
+  LP_Sync(LogicalProcess *p) : Event(HIGHEST_PRIORITY), lp(p) {}
+};
+
+
+////////////////////////////////////////////////////////////////////////////
+// LogicalProcess constructor/destructor
+//
+LogicalProcess::LogicalProcess(const char *name, double la,
+                               void (*s)(), void (*f)()) :
+  lookahead(la), setup(s), finish(f),
+  index(0), next(0), done(false),
+  windows(0), messages(0)
+{
+  Dprintf(("LogicalProcess::LogicalProcess(\"%s\",%g)", name, la));
+  if(LP_state.running)
+    SIMLIB_error(LPUseError);
+  if(!(la > 0))
+    SIMLIB_error(LPLookaheadError);
+  SetName(name);
+  LP_list.push_back(this);
+}
+
+LogicalProcess::~LogicalProcess()
+{
+  Dprintf(("LogicalProcess::~LogicalProcess() // \"%s\" ", Name().c_str()));
+  if(LP_state.running)
+    SIMLIB_error(LPUseError);
+  for(unsigned i = 0; i < LP_list.size(); i++)
+    if(LP_list[i] == this) {
+      LP_list.erase(LP_list.begin() + i);
+      break;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+// LogicalProcess::Send --- activate new entity in this LP at time t
+// called by (other) LP, delivered at the end of time window
+//
+void LogicalProcess::Send(Entity *e, double t)
+{
+  LogicalProcess *src = LP_current;
+  if(!LP_state.running || src == 0)
+    SIMLIB_error(LPSendError);
+  if(!e->Idle() || e->Where() != 0)
+    SIMLIB_error(LPSendEntityError);
+  if(t < Time + src->lookahead)
+    SIMLIB_error(LPSendTimeError);
+  if(src == this)
+    e->Activate(t);             // local, no synchronization
+  else
+    src->out[index].push_back(Message{t, e});
+}
+
+////////////////////////////////////////////////////////////////////////////
+// LogicalProcess::_Synchronize --- end of time window
+// returns end of next window
+//
+double LogicalProcess::_Synchronize()
+{
+  Dprintf(("LogicalProcess(%s)::_Synchronize() Time=%g", Name().c_str(),
+           double(Time)));
+  std::unique_lock<std::mutex> lock(LP_state.mutex);
+  if(LP_state.sequential && LP_state.turn == index)
+    LP_state.PassTurn(index);
+  LP_state.Barrier(lock);       // all messages of window are sent
+  lock.unlock();
+  for(LogicalProcess *lp : LP_list) {   // in order of senders
+    for(Message &m : lp->out[index])
+      m.entity->Activate(m.time);
+    messages += lp->out[index].size();
+    lp->out[index].clear();
+  }
+  // continuous part can send message at any time
+  if(IntegratorContainer::isAny() || StatusContainer::isAny())
+    next = Time;
+  else
+    next = NextTime;
+  lock.lock();
+  LP_state.Barrier(lock);       // window computed
+  double w = LP_state.window;
+  if(LP_state.sequential)
+    LP_state.cond.wait(lock, [this]{ return LP_state.turn == index; });
+  windows++;
+  return w;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// LogicalProcess::_Thread --- simulation run of LP
+//
+void LogicalProcess::_Thread(double t0, double t1, RandomStream base)
+{
+  LP_current = this;
+  SIMLIB_SignalInherit(LP_state.signals);
+  SIMLIB_RandomStream(base, index);
+  Init(t0, t1);
+  (new LP_Sync(this))->Activate(t0);    // first window
+  if(setup)
+    setup();
+  Run();
+  std::unique_lock<std::mutex> lock(LP_state.mutex);
+  done = true;
+  LP_state.active--;
+  if(LP_state.sequential && LP_state.turn == index)
+    LP_state.PassTurn(index);
+  if(LP_state.waiting > 0 && LP_state.waiting == LP_state.active)
+    LP_state.BarrierDone();     // do not wait for this LP
+  if(LP_state.active == 0)
+    LP_state.cond.notify_all();
+  LP_state.cond.wait(lock, []{ return LP_state.active == 0; });
+  LP_state.cond.wait(lock, [this]{ return LP_state.order == index; });
+  lock.unlock();
+  if(finish)
+    finish();                   // results, in order of LPs
+  lock.lock();
+  LP_state.order++;
+  LP_state.cond.notify_all();
+  LP_current = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// LogicalProcess::Output
+//
+void LogicalProcess::Output() const
+{
+  Print("+----------------------------------------------------------+\n");
+  Print("| LOGICAL PROCESS %-40s |\n", Name().c_str());
+  Print("+----------------------------------------------------------+\n");
+  Print("|  Lookahead = %-25g                   |\n", lookahead);
+  Print("|  Time windows = %-25lu                |\n", windows);
+  Print("|  Received messages = %-25lu           |\n", messages);
+  Print("+----------------------------------------------------------+\n");
+}
+
+////////////////////////////////////////////////////////////////////////////
+// RunParallel --- run all logical processes
+//
+void RunParallel(double t0, double t1, bool sequential)
+{
+  Dprintf(("RunParallel(%g,%g%s)", t0, t1, sequential ? ",sequential" : ""));
+  unsigned n = LP_list.size();
+  if(n == 0)
+    SIMLIB_error(LPNoProcessError);
+  for(unsigned i = 0; i < n; i++) {
+    LogicalProcess *lp = LP_list[i];
+    lp->index = i;
+    lp->next = t0;
+    lp->done = false;
+    lp->windows = lp->messages = 0;
+    lp->out.assign(n, std::vector<LogicalProcess::Message>());
+  }
+  LP_state.running = true;
+  LP_state.sequential = sequential;
+  LP_state.active = n;
+  LP_state.waiting = 0;
+  LP_state.generation = 0;
+  LP_state.turn = n;
+  LP_state.order = 0;
+  LP_state.signals = SIMLIB_SignalGet();
+  RandomStream base = SIMLIB_RandomDefault;
+  std::vector<std::thread> threads;
+  for(LogicalProcess *lp : LP_list)
+    threads.emplace_back(&LogicalProcess::_Thread, lp, t0, t1, base);
+  for(auto &t : threads)
+    t.join();
+  LP_state.running = false;
+  for(LogicalProcess *lp : LP_list) {   // messages after end time
+    for(auto &box : lp->out)
+      for(LogicalProcess::Message &m : box)
+        delete m.entity;
+    lp->out.clear();
+  }
+}
+
+}
+// end
@@ -26,8 +26,9 @@
 //       params/locals, call Current->Behavior (uses new stack for this)
 //       return: set SP back, ...
 //       Process destructor: free stack
-// TODO: add implementation with stack switching (not copying)
-//       as compile-time option
+// DONE: implementation with stack switching (not copying) as run-time
+//       option SetProcessStackSize(), each process has own mmap-ed stack
+//       with guard page (Linux, FreeBSD)
 // TODO: add implementation using C++20 coroutines?
 
 
@@ -41,6 +42,15 @@
 #include <csetjmp>
 #include <cstring>
 
+#if defined(__linux__) || defined(__FreeBSD__)
+# define PROCESS_STACKS 1       // processes with own stack are implemented
+# include <sys/mman.h>
+# include <ucontext.h>
+# include <unistd.h>
+#else
+# define PROCESS_STACKS 0
+#endif
+
 // basic operating system test
 #if !(defined(__MSDOS__)||defined(__linux__)|| \
       defined(__WIN32__)||defined(__FreeBSD__))
@@ -124,13 +134,140 @@ struct P_Context_t {
 };
 
 ////////////////////////////////////////////////////////////////////////////
-// global variables (should be volatile)
-static jmp_buf P_DispatcherStatusBuffer; //!< setjmp() state before dispatch
-static char *volatile P_StackBase = 0;   //!< global start of stack area
-static char *volatile P_StackBase2 = 0;  //!< for checking start of stack
+// global variables (should be volatile), each thread has own dispatcher
+static thread_local jmp_buf P_DispatcherStatusBuffer; //!< setjmp() state before dispatch
+static thread_local char *volatile P_StackBase = 0;   //!< global start of stack area
+static thread_local char *volatile P_StackBase2 = 0;  //!< for checking start of stack
+
+static thread_local P_Context_t *volatile P_Context = 0; //!< temporary global process state
+static thread_local volatile size_t P_StackSize = 0;     //!< temporary global stack size
+
+////////////////////////////////////////////////////////////////////////////
+// processes with own stack (SetProcessStackSize)
+////////////////////////////////////////////////////////////////////////////
+
+static thread_local size_t P_OwnStackSize = 0; //!< size of new stacks, 0 == copying
+
+#if PROCESS_STACKS
 
-static P_Context_t *volatile P_Context = 0; //!< temporary global process state
-static volatile size_t P_StackSize = 0;     //!< temporary global stack size
+/**
+ * internal structure for process with own stack
+ * memory layout (stack grows down): | guard page | stack ... |
+ * @ingroup process
+ */
+struct P_Stack_t {
+    ucontext_t context; //!< stored CPU context of process
+    char *area;         //!< mmap-ed area (guard page + stack)
+    size_t size;        //!< size of stack (without guard page)
+    P_Stack_t *next;    //!< link in list of free stacks
+};
+
+static thread_local ucontext_t P_DispatcherContext; //!< dispatcher state (own stacks)
+static thread_local P_Stack_t *P_FreeStacks = 0;    //!< terminated process stacks
+static thread_local bool P_StackEnd = false;        //!< Behavior() returned
+
+/// size of guard page
+static size_t P_PageSize() {
+    static const size_t page = sysconf(_SC_PAGESIZE);
+    return page;
+}
+
+/// get stack for new process: reuse free stack or map new one
+/// physical memory is used only if the stack pages are touched
+static P_Stack_t *P_StackAlloc()
+{
+    if (P_FreeStacks != 0) {
+        P_Stack_t *s = P_FreeStacks;
+        P_FreeStacks = s->next;
+        return s;
+    }
+    size_t page = P_PageSize();
+    void *a = mmap(0, P_OwnStackSize + page, PROT_READ|PROT_WRITE,
+                   MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+    if (a == MAP_FAILED)
+        SIMLIB_error(ProcessStackError);
+    if (mprotect(a, page, PROT_NONE) != 0)      // guard page
+        SIMLIB_error(ProcessStackError);
+    P_Stack_t *s = new P_Stack_t;
+    s->area = (char *) a;
+    s->size = P_OwnStackSize;
+    s->next = 0;
+    DEBUG(DBG_THREAD,("| process stack %p allocated, size=%lu",
+                      s->area, (unsigned long) s->size));
+    return s;
+}
+
+/// unmap stack memory
+static void P_StackUnmap(P_Stack_t *s)
+{
+    munmap(s->area, s->size + P_PageSize());
+    delete s;
+}
+
+/// unmap all free stacks
+static void P_StackFreeAll()
+{
+    while (P_FreeStacks != 0) {
+        P_Stack_t *s = P_FreeStacks;
+        P_FreeStacks = s->next;
+        P_StackUnmap(s);
+    }
+}
+
+/// return stack of terminated process (keep it for next process)
+/// the free stacks of thread are unmapped at thread exit
+static void P_StackFree(P_Stack_t *s)
+{
+    static thread_local bool registered = false;
+    if (s->size != P_OwnStackSize) {    // stack size changed
+        P_StackUnmap(s);
+        return;
+    }
+    if (!registered) {
+        SIMLIB_atexit(P_StackFreeAll);
+        registered = true;
+    }
+    s->next = P_FreeStacks;
+    P_FreeStacks = s;
+}
+
+/// start of process behavior on own stack
+static void P_StackStart()
+{
+    static_cast<Process *>(SIMLIB_Current)->Behavior();
+    P_StackEnd = true;
+    setcontext(&P_DispatcherContext);   // never returns
+}
+
+/// interrupt execution of process, continue after next dispatch
+static void P_StackSwitch(P_Stack_t *s)
+{
+    swapcontext(&s->context, &P_DispatcherContext);
+}
+
+#endif // PROCESS_STACKS
+
+////////////////////////////////////////////////////////////////////////////
+/// set size of stack for processes created later
+/// 0 == use stack copying (default)
+void SetProcessStackSize(size_t size)
+{
+    Dprintf(("SetProcessStackSize(%lu)", (unsigned long) size));
+#if PROCESS_STACKS
+    if (size != 0) {    // round up to page size
+        size_t page = P_PageSize();
+        size = (size + page - 1) / page * page;
+    }
+    if (size != P_OwnStackSize) {
+        P_OwnStackSize = size;
+        P_StackFreeAll();       // free stacks have different size
+    }
+#else
+    if (size != 0)
+        SIMLIB_error(ProcessStackNotImpl);
+    P_OwnStackSize = 0;
+#endif
+}
 
 ////////////////////////////////////////////////////////////////////////////
 // Support for THREADS implementation debugging:
@@ -204,20 +341,39 @@ static void THREAD_DEBUG_f(int n) {
 ////////////////////////////////////////////////////////////////////////////
 
 static void THREAD_INTERRUPT_f() __attribute__ ((noinline)); // special function
+static void THREAD_RESTORE_f() __attribute__ ((noinline,noreturn));
+
+#if PROCESS_STACKS
+/// switch to dispatcher if the process has own stack
+# define STACK_INTERRUPT()  P_StackSwitch((P_Stack_t *) this->_context)
+/// jump to dispatcher, process stack is not used any more
+# define STACK_EXIT()       setcontext(&P_DispatcherContext)
+#else
+# define STACK_INTERRUPT()
+# define STACK_EXIT()
+#endif
 
 /// interrupt process behavior execution, continue after return
 #define THREAD_INTERRUPT()                                              \
 { /* This should be MACRO */                                            \
   /* if(!isCurrent())  SIMLIB_error("Can't interrupt..."); */           \
   this->_status = _INTERRUPTED;                                         \
-  THREAD_INTERRUPT_f();                                                 \
+  if (this->_own_stack) {                                               \
+    STACK_INTERRUPT();                                                  \
+  } else {                                                              \
+    THREAD_INTERRUPT_f();                                               \
+    this->_context = 0;                                                 \
+  }                                                                     \
   this->_status = _RUNNING;                                             \
-  this->_context = 0;                                                   \
 }
 
 /// does not save context
-#define THREAD_EXIT() \
-    longjmp(P_DispatcherStatusBuffer, 2)  // jump to dispatcher
+#define THREAD_EXIT()                                                   \
+{                                                                       \
+  if (this->_own_stack)                                                 \
+    STACK_EXIT();                                                       \
+  longjmp(P_DispatcherStatusBuffer, 2);  /* jump to dispatcher */       \
+}
 
 // TODO: allocation/freeing memory is expensive, should be optimized
 
@@ -250,6 +406,7 @@ static void FREE_CONTEXT() {
 Process::Process(Priority_t p) : Entity(p) {
   Dprintf(("Process::Process(%d)", p));
   _wait_until = false;
+  _own_stack = false;
   _context = 0;                 // pointer to process context
   _status = _PREPARED;          // prepared for running
 }
@@ -266,6 +423,11 @@ Process::~Process()
     //if(this==Current) SIMLIB_warning("Currently running process self-destructed");
 
     // destroy context data
+#if PROCESS_STACKS
+    if (_own_stack)
+        P_StackFree((P_Stack_t *) _context);
+    else
+#endif
     delete [] (char*)_context;
     _context = 0;
 
@@ -357,6 +519,22 @@ void Process::Release(Facility & f)
     f.Release(this);            // polymorphic interface
 }
 
+////////////////////////////////////////////////////////////////////////////
+/// Seize idle server of pool p
+/// possibly waiting in input queue, if all servers are busy
+void Process::Seize(FacilityPool & p)
+{
+    p.Seize(this);              // polymorphic interface
+}
+
+////////////////////////////////////////////////////////////////////////////
+/// Release server of pool p
+/// possibly pass it to the first waiting entity in queue
+void Process::Release(FacilityPool & p)
+{
+    p.Release(this);            // polymorphic interface
+}
+
 ////////////////////////////////////////////////////////////////////////////
 /// Enter - use cap capacity of store s
 /// possibly waiting in input queue, if not enough free capacity
@@ -463,6 +641,11 @@ void Process::_Run() noexcept // no exceptions
     if (_status != _INTERRUPTED && _status != _PREPARED)
         SIMLIB_error(ProcessNotInitialized);
 
+    if (_own_stack || (_status == _PREPARED && P_OwnStackSize != 0)) {
+        _RunOnStack();  // process with own stack, no copying
+        return;
+    }
+
     // Mark the stack base address
     volatile long mylocal = CANARY1;     // should be automatic = on stack
     // Warning: DO NOT USE ANY OTHER LOCAL VARIABLES in this function!
@@ -537,13 +720,11 @@ void Process::_Run() noexcept // no exceptions
             // ==========================================================
             SET_STACK_PTR(P_StackBase2); // === BEGIN inconsistent state!
             // Warning: We can not use any local variables here!
+            // (thread-local variable addresses can be kept in locals, too)
 
-            // c) Copy saved stack contents back to stack
-            memcpy((void *) (P_StackBase - P_StackSize), P_Context->stack, P_StackSize);
-            THREAD_DEBUG(0xC);
-
+            // c) Copy saved stack contents back to stack, and
             // 4) Restore proces status (SP,IP,...)
-            longjmp(P_Context->status, 1); // === END inconsistent state!
+            THREAD_RESTORE_f();          // === END inconsistent state!
             // ===========================================================
             // never reach this point - longjmp never returns
 
@@ -577,6 +758,55 @@ void Process::_Run() noexcept // no exceptions
     // return to simulation control
 }
 
+////////////////////////////////////////////////////////////////////////////
+/**
+ * \fn Process::_RunOnStack
+ * Process dispatch method for processes with own stack
+ *
+ * The first call allocates stack and starts Behavior() on it,
+ * next calls switch context back to interrupted Behavior().
+ * The stack is returned for reuse when the process terminates.
+ *
+ * @ingroup process
+ */
+void Process::_RunOnStack()
+{
+#if PROCESS_STACKS
+    P_Stack_t *s = (P_Stack_t *) _context;
+    if (s == 0) {       // process start
+        s = P_StackAlloc();
+        getcontext(&s->context);
+        s->context.uc_stack.ss_sp = s->area + P_PageSize();
+        s->context.uc_stack.ss_size = s->size;
+        s->context.uc_link = 0;
+        makecontext(&s->context, P_StackStart, 0);
+        _context = s;
+        _own_stack = true;
+    }
+    _status = _RUNNING;
+    P_StackEnd = false;
+    swapcontext(&P_DispatcherContext, &s->context); // run Behavior()
+    // WARNING: do not use local variables here (clobbered)
+    // back from Behavior() - interrupted or terminated
+    if (P_StackEnd)
+        _status = _TERMINATED;
+    if (isTerminated()) {
+        DEBUG(DBG_THREAD,("| --- Process::Behavior() END "));
+        P_StackFree((P_Stack_t *) _context);
+        _own_stack = false;
+        _context = 0;
+        if (Where() != 0)       // Entity linked in queue
+            Out();              // Remove from queue, no warning
+        if (!Idle())
+            SQS::Get(this);     // Remove from calendar
+        if (isAllocated())
+            delete this;        // destroy process
+    }
+#else
+    SIMLIB_error(ProcessStackNotImpl);
+#endif
+}
+
 
 ////////////////////////////////////////////////////////////////////////////
 #define CANARY2 0xDEADBEEFUL
@@ -644,5 +874,24 @@ static void THREAD_INTERRUPT_f()
     // return and continue in Process::Behavior() execution
 }
 
+////////////////////////////////////////////////////////////////////////////
+/**
+ * \fn THREAD_RESTORE_f
+ * Special function called from Process::_Run() after stack pointer shift.
+ * It has own stack frame under the restored area, so it can use
+ * (thread-local) global variables safely.
+ *
+ *  1) copies saved stack contents back to stack
+ *  2) restores CPU context using longjmp() (continues in THREAD_INTERRUPT_f)
+ *
+ * @ingroup process
+ */
+static void THREAD_RESTORE_f()
+{
+    memcpy((void *) (P_StackBase - P_StackSize), P_Context->stack, P_StackSize);
+    THREAD_DEBUG(0xC);
+    longjmp(P_Context->status, 1);
+}
+
 } // namespace
 
@@ -0,0 +1,179 @@
+/////////////////////////////////////////////////////////////////////////////
+//! \file progress.cc  Progress reports of long simulation runs
+//
+// Copyright (c) 1991-2018 Petr Peringer
+//
+// This library is licensed under GNU Library GPL. See the file COPYING.
+//
+
+//
+// Run() polls after batches of events and integration steps (see
+// SIMLIB_Poll), wall clock is read after given number of polls. The
+// number is computed from current speed to check the clock about ten
+// times per report interval.
+//
+
+////////////////////////////////////////////////////////////////////////////
+// interface
+//
+
+#include "simlib.h"
+#include "internal.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#if defined(__linux__)
+# include <unistd.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////
+// implementation
+//
+
+namespace simlib3 {
+
+SIMLIB_IMPLEMENTATION;
+
+typedef std::chrono::steady_clock Clock;
+
+// progress report state (thread-local)
+static thread_local struct {
+  double interval;              // report interval [s], 0 = off
+  std::string filename;         // status file or empty (stderr)
+  Clock::time_point start;      // start of Run()
+  Clock::time_point check;      // last check of clock
+  Clock::time_point report;     // last report
+  unsigned long batch;          // polls between clock checks
+  unsigned long count;          // polls to next clock check
+  unsigned long last;           // events+steps at last report
+} progress = { 0, "", {}, {}, {}, 0, 0, 0 };
+
+////////////////////////////////////////////////////////////////////////////
+// resident set size [MB]
+//
+static double RSS()
+{
+#if defined(__linux__)
+  long pages = 0, rss = 0;
+  FILE *f = std::fopen("/proc/self/statm", "r");
+  if(f) {
+    if(std::fscanf(f, "%ld %ld", &pages, &rss) != 2)
+      rss = 0;
+    std::fclose(f);
+  }
+  return double(rss) * sysconf(_SC_PAGESIZE) / (1024.0*1024.0);
+#else
+  return 0;
+#endif
+}
+
+// format time interval [s] as h:mm:ss
+static std::string HMS(double s)
+{
+  char buf[40];
+  unsigned long t = (unsigned long)(s + 0.5);
+  std::snprintf(buf, sizeof(buf), "%lu:%02lu:%02lu", t/3600, t/60%60, t%60);
+  return buf;
+}
+
+static unsigned long Count()
+{
+  return SIMLIB_statistics.EventCount + SIMLIB_statistics.StepCount;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Report --- print one line to stderr or rewrite status file
+//
+static void Report(Clock::time_point now, bool done)
+{
+  double elapsed = std::chrono::duration<double>(now - progress.start).count();
+  double dt = std::chrono::duration<double>(now - progress.report).count();
+  double rate = dt > 0 ? (Count() - progress.last) / dt : 0;
+  char line[256];
+  int n = std::snprintf(line, sizeof(line), "Time=%g", double(Time));
+  if(EndTime < SIMLIB_MAXTIME && EndTime > StartTime)
+    n += std::snprintf(line+n, sizeof(line)-n, " (%.1f%%)",
+                       100 * (Time - StartTime) / (EndTime - StartTime));
+  n += std::snprintf(line+n, sizeof(line)-n,
+                     " events=%ld steps=%ld calendar=%u | %.3g /s, RSS %.1f MB, elapsed %s",
+                     SIMLIB_statistics.EventCount, SIMLIB_statistics.StepCount,
+                     SQS::Size(), rate, RSS(), HMS(elapsed).c_str());
+  if(done)
+    std::snprintf(line+n, sizeof(line)-n, ", done");
+  else if(EndTime < SIMLIB_MAXTIME && Time > StartTime)
+    std::snprintf(line+n, sizeof(line)-n, ", ETA %s",
+                  HMS(elapsed * (EndTime - Time) / (Time - StartTime)).c_str());
+  if(progress.filename.empty())
+    std::fprintf(stderr, "%s\n", line);
+  else {                        // readers see complete file
+    std::string tmp = progress.filename + ".tmp";
+    FILE *f = std::fopen(tmp.c_str(), "w");
+    if(f) {
+      std::fprintf(f, "%s\n", line);
+      std::fclose(f);
+      std::rename(tmp.c_str(), progress.filename.c_str());
+    }
+  }
+  progress.report = now;
+  progress.last = Count();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// ProgressPoll --- called by SIMLIB_Poll(), check clock
+//
+static void ProgressPoll()
+{
+  if(--progress.count > 0)
+    return;
+  Clock::time_point now = Clock::now();
+  double dt = std::chrono::duration<double>(now - progress.check).count();
+  if(std::chrono::duration<double>(now - progress.report).count() >= progress.interval)
+    Report(now, false);
+  // next check after about interval/10
+  double b = dt > 0 ? progress.batch * progress.interval / (10 * dt) : 2.0 * progress.batch;
+  if(b > 4.0 * progress.batch)
+    b = 4.0 * progress.batch;   // limited growth
+  progress.batch = b < 1 ? 1 : (unsigned long)b;
+  progress.check = now;
+  progress.count = progress.batch;
+}
+
+// start of Run()
+static void StartReports()
+{
+  progress.start = progress.check = progress.report = Clock::now();
+  progress.batch = progress.count = 1;
+  progress.last = 0;
+}
+
+// end of Run()
+static void EndReports()
+{
+  Report(Clock::now(), true);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// SetProgress --- set report interval and output
+//
+void SetProgress(double interval, const char *filename)
+{
+  Dprintf(("SetProgress(%g,\"%s\")", interval, filename ? filename : ""));
+  progress.interval = interval > 0 ? interval : 0;
+  progress.filename = filename ? filename : "";
+  if(progress.interval > 0) {
+    INSTALL_HOOK(ProgressStart, StartReports);
+    INSTALL_HOOK(Progress, ProgressPoll);
+    INSTALL_HOOK(ProgressEnd, EndReports);
+    if(Phase == SIMULATION)     // called from Run()
+      StartReports();
+  }
+  else {
+    INSTALL_HOOK(ProgressStart, 0);
+    INSTALL_HOOK(Progress, 0);
+    INSTALL_HOOK(ProgressEnd, 0);
+  }
+}
+
+}
+// end
@@ -9,10 +9,26 @@
 //
 //  implementation of queue
 //
+//  Queue sorted by key (priority, or service priority and priority for
+//  Facility) has index: runs of entities with equal key in descending
+//  order, each run points to its last entity. Priority insert goes after
+//  the last entity of the nearest run with key >= new key, i.e. to the
+//  same position as the linear search from the end. The search is
+//  O(log k), the update of the run table O(k) (k is the number of
+//  distinct keys). The key of entity is stored at insertion (_QueueKey),
+//  change of priority of waiting entity (EntityPriority) moves it to
+//  the run of the new key, as by a new insert at the same position.
+//  Insertion out of order drops the index (linear search is used), it
+//  is rebuilt when the entity out of order leaves the queue. List
+//  operations without Queue (restore of checkpoint) are detected by the
+//  number of indexed entities.
+//
 
 #include "simlib.h"
 #include "internal.h"
 
+#include <algorithm>
+
 
 ////////////////////////////////////////////////////////////////////////////
 //  implementation
@@ -26,12 +42,12 @@ SIMLIB_IMPLEMENTATION;
 ////////////////////////////////////////////////////////////////////////////
 //  constructors
 //
-Queue::Queue()
+Queue::Queue() : indexed(0), keys(EMPTY), unsorted(0)
 {
   Dprintf(("Queue{%p}::Queue()", this));
 }
 
-Queue::Queue(const char *name)
+Queue::Queue(const char *name) : indexed(0), keys(EMPTY), unsorted(0)
 {
   Dprintf(("Queue{%p}::Queue(\"%s\")", this, name));
   SetName(name);
@@ -44,26 +60,176 @@ Queue::~Queue() {
   Dprintf(("Queue{%p}::~Queue() // \"%s\" ", this, Name().c_str()));
 }
 
+////////////////////////////////////////////////////////////////////////////
+// index of sorted queue
+//
+long Queue::Key(Entity *e) const
+{
+  if(keys == SERVICE_KEY)       // Facility: service priority, priority
+    return (long(e->_SPrio) << 8) + (e->Priority + 128);
+  return e->Priority;
+}
+
+// find run with key (runs are in descending order)
+std::vector<Queue::Run>::iterator Queue::FindRun(long key)
+{
+  return std::lower_bound(runs.begin(), runs.end(), key,
+                          [](const Run &r, long k) { return r.key > k; });
+}
+
+// Rebuild --- index of all entities (current keys)
+void Queue::Rebuild()
+{
+  if(keys == EMPTY)
+    keys = PRIORITY_KEY;
+  runs.clear();
+  indexed = 0;
+  unsorted = 0;
+  for(iterator p = begin(); p != end(); ++p) {
+    Entity *e = static_cast<Entity*>(*p);
+    long key = Key(e);
+    if(!runs.empty() && runs.back().key < key) { // not sorted
+      unsorted = e;
+      runs.clear();
+      return;
+    }
+    if(runs.empty() || runs.back().key != key)
+      runs.push_back(Run{key, e, 0});
+    runs.back().last = e;
+    runs.back().count++;
+    e->_QueueKey = key;
+    indexed++;
+  }
+}
+
+// Find --- position for insertion of entity, false if no index
+bool Queue::Find(Entity *e, unsigned char k, iterator &pos)
+{
+  if(unsorted)
+    return false;
+  if(keys != k) {               // other ordering: check all
+    keys = k;
+    Rebuild();
+  }
+  else if(indexed != size())    // changed by List operations
+    Rebuild();
+  if(unsorted)
+    return false;
+  // after the last entity with key >= Key(e)
+  long key = Key(e);
+  std::vector<Run>::iterator r = std::upper_bound(runs.begin(), runs.end(), key,
+                          [](long k, const Run &r) { return k > r.key; });
+  if(r == runs.begin())
+    pos = begin();
+  else {
+    pos = iterator((r-1)->last);
+    ++pos;
+  }
+  return true;
+}
+
+// IndexIn --- add inserted entity to index
+void Queue::IndexIn(Entity *e)
+{
+  if(keys == EMPTY)             // insert at position
+    keys = PRIORITY_KEY;
+  if(unsorted)
+    return;
+  if(indexed + 1 != size()) {   // changed by List operations
+    Rebuild();
+    return;
+  }
+  long key = Key(e);
+  iterator p(e);
+  iterator pred = p; --pred;
+  iterator succ = p; ++succ;
+  if((pred != end() && static_cast<Entity*>(*pred)->_QueueKey < key) ||
+     (succ != end() && static_cast<Entity*>(*succ)->_QueueKey > key)) {
+    unsorted = e;               // out of order: no index
+    runs.clear();
+    return;
+  }
+  e->_QueueKey = key;
+  indexed++;
+  std::vector<Run>::iterator r = FindRun(key);
+  if(r == runs.end() || r->key != key)
+    runs.insert(r, Run{key, e, 1});
+  else {
+    r->count++;
+    if(succ == end() || static_cast<Entity*>(*succ)->_QueueKey != key)
+      r->last = e;              // at the end of run
+  }
+}
+
+// IndexOut --- remove entity from index
+void Queue::IndexOut(Entity *e, iterator pred)
+{
+  if(empty()) {                 // the next insert sets ordering
+    keys = EMPTY;
+    runs.clear();
+    indexed = 0;
+    unsorted = 0;
+    return;
+  }
+  if(unsorted) {                // index of the rest
+    if(e == unsorted)
+      Rebuild();
+    return;
+  }
+  if(indexed != size() + 1) {   // changed by List operations
+    Rebuild();
+    return;
+  }
+  std::vector<Run>::iterator r = FindRun(e->_QueueKey);
+  if(r == runs.end() || r->key != e->_QueueKey)
+    SIMLIB_internal_error();
+  indexed--;
+  if(--r->count == 0)
+    runs.erase(r);
+  else if(r->last == e)
+    r->last = static_cast<Entity*>(*pred);
+}
+
+// KeyChanged --- priority of waiting entity changed
+void Queue::KeyChanged(Entity *e)
+{
+  if(keys == EMPTY || unsorted || indexed != size() || Key(e) == e->_QueueKey)
+    return;                     // no index, or rebuilt by next Find()
+  iterator pred(e);
+  --pred;
+  std::vector<Run>::iterator r = FindRun(e->_QueueKey);
+  if(r == runs.end() || r->key != e->_QueueKey)
+    SIMLIB_internal_error();
+  indexed--;
+  if(--r->count == 0)
+    runs.erase(r);
+  else if(r->last == e)
+    r->last = static_cast<Entity*>(*pred);
+  IndexIn(e);                   // new key at the same position
+}
+
 ////////////////////////////////////////////////////////////////////////////
 // Insert --- priority insert into queue
 //
 void Queue::Insert(Entity *ent)
 {
   Dprintf(("%s::Insert(%s)", Name().c_str(), ent->Name().c_str() ));
-  Entity::Priority_t prio = ent->Priority;
-  // find (higher priority is first)
+  Queue::iterator p = end();
+  if(!Find(ent, PRIORITY_KEY, p)) {     // not sorted: linear search
+    Entity::Priority_t prio = ent->Priority;
+    // find (higher priority is first)
 #if 0 // _INS_FROM_BEGIN
-  Queue::iterator p = begin();
-  for( ; p!=end() && ((Entity*)(*p))->Priority >= prio; ++p);
+    p = begin();
+    for( ; p!=end() && ((Entity*)(*p))->Priority >= prio; ++p);
 #else
-  // this is faster (items are inserted at end usually)
-  Queue::iterator p = end();
-  while(p!=begin()) {
-        Queue::iterator q = p;
-        --p;
-        if( ((Entity*)(*p))->Priority >= prio ) { p = q; break; }
-  }
+    // this is faster (items are inserted at end usually)
+    while(p!=begin()) {
+          Queue::iterator q = p;
+          --p;
+          if( ((Entity*)(*p))->Priority >= prio ) { p = q; break; }
+    }
 #endif
+  }
   PredIns(ent,p); // works for end()
 }
 
@@ -103,8 +269,10 @@ void Queue::PredIns(Entity *ent, iterator pos)
 {
   Dprintf(("%s::PredIns(%s,pos:%p)", Name().c_str(), ent->Name().c_str(), *pos ));
   List::PredIns(ent, *pos); // insert before pos, can be end()
+  IndexIn(ent);
   ent->_MarkTime = Time;    // marks input time
   StatN(size());            // length statistic
+  SIMLIB_TRACE(TRACE_QUEUE_IN, this, ent, size());
 }
 
 ////////////////////////////////////////////////////////////////////////////
@@ -133,9 +301,12 @@ Entity *Queue::GetLast()
 Entity *Queue::Get(iterator pos)
 {
   Dprintf(("%s::Get(pos:%p)", Name().c_str(), *pos));
+  iterator pred = pos; --pred;
   Entity *ent = static_cast<Entity*>(List::Get(*pos));
+  IndexOut(ent, pred);
   StatDT(Time - ent->_MarkTime);
   StatN(size());  StatN.n--; // the number of samples correction
+  SIMLIB_TRACE(TRACE_QUEUE_OUT, this, ent, size());
   return ent;
 }
 
@@ -148,6 +319,10 @@ void Queue::clear()
   StatN.Clear();
   StatDT.Clear();
   List::clear(); // problem with WARNING
+  keys = EMPTY;
+  runs.clear();
+  indexed = 0;
+  unsorted = 0;
   StatN.Clear();
   StatDT.Clear();
 }
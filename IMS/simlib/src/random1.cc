@@ -25,67 +25,165 @@
 
 namespace simlib3 {
 
-// external functions
-void   RandomSeed(long seed);     // initialize random number seed
-double Random();                  // base uniform generator 0-0.999999...
-void   SetBaseRandomGenerator(double (*new_gen)()); // change base gen.
-
 SIMLIB_IMPLEMENTATION;
 
 
-// TODO: change the basic generator to something better
+////////////////////////////////////////////////////////////////////////////
+// generator xoshiro256++ (D. Blackman, S. Vigna: Scrambled linear
+// pseudorandom number generators, 2018), period 2^256-1
+//
 
-#if (LONG_MAX<(1ULL<<32))
-typedef long myint32;     // long has 32 bits
-#else
-typedef int myint32;      // long has >32 bits
-#endif
+static inline unsigned long long rotl(unsigned long long x, int k)
+{
+  return (x << k) | (x >> (64 - k));
+}
+
+// linear transformation of state (one step of generator)
+static inline void Step(unsigned long long s[4])
+{
+  const unsigned long long t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl(s[3], 45);
+}
 
 ////////////////////////////////////////////////////////////////////////////
-// some constants for base generator
+// RandomStream::Seed --- state is expanded from seed by splitmix64
 //
+void RandomStream::Seed(unsigned long long seed)
+{
+  for(int i = 0; i < 4; i++) {
+    unsigned long long z = (seed += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    s[i] = z ^ (z >> 31);
+  }
+}
+
+RandomStream::RandomStream(unsigned long long seed)
+{
+  Seed(seed);
+}
+
+RandomStream::RandomStream(unsigned long long seed, unsigned long i)
+{
+  Seed(seed);
+  while(i--)
+    Jump();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// RandomStream::Next --- next 64 bits
+//
+unsigned long long RandomStream::Next()
+{
+  const unsigned long long r = rotl(s[0] + s[3], 23) + s[0];
+  Step(s);
+  return r;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// jump ahead --- multiplication by polynomial x^k (mod characteristic
+// polynomial of generator), k = 2^128 or 2^192
+//
+static void JumpBy(unsigned long long s[4], const unsigned long long poly[4])
+{
+  unsigned long long t[4] = { 0, 0, 0, 0 };
+  for(int i = 0; i < 4; i++)
+    for(int b = 0; b < 64; b++) {
+      if(poly[i] & (1ULL << b))
+        for(int j = 0; j < 4; j++)
+          t[j] ^= s[j];
+      Step(s);
+    }
+  for(int j = 0; j < 4; j++)
+    s[j] = t[j];
+}
 
-const myint32 INICONST   = 1537L;
-const myint32 MULCONST   = 1220703125L;
-// period = 536870912 only!
+void RandomStream::Jump()
+{
+  static const unsigned long long JUMP[4] = {
+    0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL,
+    0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL };
+  JumpBy(s, JUMP);
+}
 
-const myint32 MAXLONGINT = 0x7FFFFFFFUL;
-const myint32 SIGNBIT    = 0x80000000UL;
+void RandomStream::LongJump()
+{
+  static const unsigned long long LONG_JUMP[4] = {
+    0x76E15D3EFEFDCBBFULL, 0xC5004E441C522FB3ULL,
+    0x77710069854EE241ULL, 0x39109BB02ACBE635ULL };
+  JumpBy(s, LONG_JUMP);
+}
+
+bool RandomStream::operator==(const RandomStream &a) const
+{
+  return s[0] == a.s[0] && s[1] == a.s[1] && s[2] == a.s[2] && s[3] == a.s[3];
+}
 
 ////////////////////////////////////////////////////////////////////////////
-// random generator seed
+// default stream and stream used by Random()
 //
 
-static myint32 SIMLIB_RandomSeed = INICONST ;
+thread_local RandomStream SIMLIB_RandomDefault;
+static thread_local RandomStream *SIMLIB_RandomCurrent = &SIMLIB_RandomDefault;
 
 ////////////////////////////////////////////////////////////////////////////
 // RandomSeed - initialization of random generator
 //
 void RandomSeed(long seed)
 {
-  SIMLIB_RandomSeed = seed;
+  SIMLIB_RandomDefault.Seed(seed);
 }
 
 ////////////////////////////////////////////////////////////////////////////
-// SIMLIB_RandomBase --- default base uniform random number generator
+// SetRandomStream - select stream used by Random()
 //
-// uses linear congruential method
-// (not very good)
+RandomStream *SetRandomStream(RandomStream *s)
+{
+  RandomStream *old = SIMLIB_RandomCurrent;
+  SIMLIB_RandomCurrent = s ? s : &SIMLIB_RandomDefault;
+  return old;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// SIMLIB_RandomStream - select stream i of base for default generator
+//
+// stream i starts 2^128*i numbers after base, the last stream is
+// remembered (replications of one thread use increasing numbers i,
+// each of them needs one jump only)
+//
+void SIMLIB_RandomStream(const RandomStream &base, unsigned long i)
+{
+  static thread_local RandomStream last_base, last;
+  static thread_local unsigned long last_i = 0;
+  static thread_local bool valid = false;
+  if(!valid || base != last_base || i < last_i) {
+    last_base = last = base;
+    last_i = 0;
+    valid = true;
+  }
+  for( ; last_i < i; last_i++)
+    last.Jump();
+  SIMLIB_RandomDefault = last;
+  SIMLIB_RandomCurrent = &SIMLIB_RandomDefault;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// SIMLIB_RandomBase --- default base uniform random number generator
 //
 double SIMLIB_RandomBase()  // range <0..1)
 {
-  SIMLIB_RandomSeed *= MULCONST;
-  SIMLIB_RandomSeed &= MAXLONGINT; // strip sign bit
-//  _Print("random=%lx\n", (long)SIMLIB_RandomSeed);
-  double r = static_cast<double>(SIMLIB_RandomSeed)/MAXLONGINT;
-  // assert: if( r<0.0 || r>=1.0 ) SIMLIB_error("Random() out of range");
-  return r;
+  return SIMLIB_RandomCurrent->Random();
 }
 
 ////////////////////////////////////////////////////////////////////////////
 // pointer to base generator
 //
-static double (*SIMLIB_RandomBasePtr)() = SIMLIB_RandomBase;
+static thread_local double (*SIMLIB_RandomBasePtr)() = SIMLIB_RandomBase;
 
 ////////////////////////////////////////////////////////////////////////////
 // Random --- base uniform random number generator
@@ -94,7 +192,12 @@ static double (*SIMLIB_RandomBasePtr)() = SIMLIB_RandomBase;
 //
 double Random()
 {
-  return SIMLIB_RandomBasePtr();
+  double r = (SIMLIB_RandomBasePtr == SIMLIB_RandomBase)
+             ? SIMLIB_RandomCurrent->Random()  // direct call (fast)
+             : SIMLIB_RandomBasePtr();
+  if(SIMLIB_Recording)
+    SIMLIB_RecordRandom(r);     // see replay.cc
+  return r;
 }
 
 ////////////////////////////////////////////////////////////////////////////
@@ -102,10 +205,20 @@ double Random()
 //
 void SetBaseRandomGenerator(double (*new_gen)())
 {
-  if(new_gen)
-    SIMLIB_RandomBasePtr = new_gen;
-  else
-    SIMLIB_RandomBasePtr = SIMLIB_RandomBase; // default value
+  SIMLIB_RandomBaseSet(new_gen);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// SIMLIB_RandomBaseSet --- change base generator, returns previous one
+//
+// used by generators with explicit stream (they use the stream even if
+// the base generator is replaced)
+//
+double (*SIMLIB_RandomBaseSet(double (*gen)()))()
+{
+  double (*old)() = SIMLIB_RandomBasePtr;
+  SIMLIB_RandomBasePtr = gen ? gen : SIMLIB_RandomBase; // 0: default value
+  return old;
 }
 
 }
@@ -17,7 +17,7 @@
 #include "simlib.h"
 #include "internal.h"
 
-#include <cmath>  // exp() floor() log() pow() sqrt()
+#include <cmath>  // exp() fabs() floor() log() pow() sqrt()
 
 
 ////////////////////////////////////////////////////////////////////////////
@@ -74,6 +74,103 @@ double Uniform(double l, double h)
   return(l+(h-l)*Random());
 }
 
+////////////////////////////////////////////////////////////////////////////
+//  ziggurat method (G. Marsaglia, W. W. Tsang: The ziggurat method for
+//  generating random variables, 2000; J. A. Doornik: An improved ziggurat
+//  method to generate normal random samples, 2005)
+//
+//  the area under density f(x) is covered by N layers of the same area V:
+//  layer 0 is rectangle [0,x1]*[0,f(x1)] with the tail x > x1, layer i is
+//  rectangle [0,x_i]*[f(x_i),f(x_i+1)], x_N = 0.  Random point of random
+//  layer inside the box [0,x_i+1] is accepted immediately (~99%), other
+//  points are tested against f(x) or generated from the tail.
+//
+//  the layer is given by the high bits of Random(), the position
+//  in the layer by the rest of bits (they are independent)
+//
+namespace {
+template <int N>
+struct Ziggurat {
+  double x[N+1];        // x[0] = V/f(R) (base layer with tail), x[1] = R
+  double ratio[N];      // x[i+1]/x[i]
+  double f[N+1];        // f(x[i])
+  // R = start of tail, V = area of layer
+  Ziggurat(double R, double V, double (*fn)(double), double (*inv)(double)) {
+    x[0] = V / fn(R);
+    x[1] = R;
+    for(int i = 1; i < N-1; i++)
+      x[i+1] = inv(V/x[i] + fn(x[i]));
+    x[N] = 0.0;
+    for(int i = 0; i < N; i++)
+      ratio[i] = x[i+1] / x[i];
+    for(int i = 0; i <= N; i++)
+      f[i] = fn(x[i]);
+  }
+};
+
+double NormalDensity(double x) { return std::exp(-0.5*x*x); }
+double NormalInverse(double y) { return std::sqrt(-2.0*std::log(y)); }
+double ExpDensity(double x) { return std::exp(-x); }
+double ExpInverse(double y) { return -std::log(y); }
+
+const Ziggurat<128> &NormalTable()
+{
+  static const Ziggurat<128> z(3.442619855899, 9.91256303526217e-3,
+                               NormalDensity, NormalInverse);
+  return z;
+}
+
+const Ziggurat<256> &ExpTable()
+{
+  static const Ziggurat<256> z(7.697117470131487, 3.949659822581572e-3,
+                               ExpDensity, ExpInverse);
+  return z;
+}
+
+// standard normal distribution N(0,1)
+double ZigguratNormal()
+{
+  const Ziggurat<128> &z = NormalTable();
+  for(;;) {
+    double r = Random() * 128;
+    int i = int(r);
+    double u = 2.0*(r - i) - 1.0;       // range -1..1
+    if(std::fabs(u) < z.ratio[i])
+      return u * z.x[i];
+    if(i == 0) {                        // tail x > R
+      const double R = z.x[1];
+      double a, b;
+      do {
+        a = std::log(1.0-Random()) / R;
+        b = std::log(1.0-Random());
+      } while(-2.0*b < a*a);
+      return u < 0 ? a - R : R - a;
+    }
+    double x = u * z.x[i];
+    if(z.f[i] + Random()*(z.f[i+1] - z.f[i]) < NormalDensity(x))
+      return x;
+  }
+}
+
+// exponential distribution with mean value 1
+double ZigguratExponential()
+{
+  const Ziggurat<256> &z = ExpTable();
+  for(;;) {
+    double r = Random() * 256;
+    int i = int(r);
+    double u = r - i;                   // range 0..1
+    if(u < z.ratio[i])
+      return u * z.x[i];
+    if(i == 0)                          // tail x > R (memoryless)
+      return z.x[1] - std::log(1.0-Random());
+    double x = u * z.x[i];
+    if(z.f[i] + Random()*(z.f[i+1] - z.f[i]) < ExpDensity(x))
+      return x;
+  }
+}
+}
+
 ////////////////////////////////////////////////////////////////////////////
 //  Normal(mi,sigma)
 //  mi    = mean value
@@ -81,10 +178,7 @@ double Uniform(double l, double h)
 //
 double Normal(double mi, double sigma)
 {
-  int i;
-  double SUM = 0.0;
-  for (i=0; i<12; i++)  SUM += Random();
-  return (SUM-6.0)*sigma + mi;
+  return ZigguratNormal()*sigma + mi;
 }
 
 ////////////////////////////////////////////////////////////////////////////
@@ -151,9 +245,7 @@ double Gamma(double alfa, double beta)
 //
 double Exponential(double mv)
 {
-  double exp = -mv * std::log(1.0-Random());
-//  _Print("Exponential(%g),%g = %g\n", mv, r, exp);
-  return exp;
+  return mv * ZigguratExponential();
 }
 
 
@@ -312,5 +404,55 @@ int Binom(unsigned n, double theta)
 }
 */
 
+////////////////////////////////////////////////////////////////////////////
+//  generators using explicit stream
+//  the stream is selected for Random() during the call, the default base
+//  generator is used (the stream is not ignored if SetBaseRandomGenerator
+//  replaced it)
+//
+namespace {
+class StreamSelect {
+  RandomStream *old;
+  double (*old_base)();
+ public:
+  StreamSelect(RandomStream &s):
+    old(SetRandomStream(&s)), old_base(SIMLIB_RandomBaseSet(0)) {}
+  ~StreamSelect() { SIMLIB_RandomBaseSet(old_base); SetRandomStream(old); }
+};
+}
+
+double Random(RandomStream &s)
+{ StreamSelect sel(s); return Random(); }
+double Beta(RandomStream &s, double th, double fi, double min, double max)
+{ StreamSelect sel(s); return Beta(th, fi, min, max); }
+double Erlang(RandomStream &s, double alfa, int beta)
+{ StreamSelect sel(s); return Erlang(alfa, beta); }
+double Exponential(RandomStream &s, double mv)
+{ StreamSelect sel(s); return Exponential(mv); }
+double Gamma(RandomStream &s, double alfa, double beta)
+{ StreamSelect sel(s); return Gamma(alfa, beta); }
+int Geom(RandomStream &s, double q)
+{ StreamSelect sel(s); return Geom(q); }
+int HyperGeom(RandomStream &s, double p, int n, int m)
+{ StreamSelect sel(s); return HyperGeom(p, n, m); }
+double Logar(RandomStream &s, double mi, double delta)
+{ StreamSelect sel(s); return Logar(mi, delta); }
+int NegBinM(RandomStream &s, double p, int m)
+{ StreamSelect sel(s); return NegBinM(p, m); }
+int NegBin(RandomStream &s, double q, int k)
+{ StreamSelect sel(s); return NegBin(q, k); }
+double Normal(RandomStream &s, double mi, double sigma)
+{ StreamSelect sel(s); return Normal(mi, sigma); }
+int Poisson(RandomStream &s, double lambda)
+{ StreamSelect sel(s); return Poisson(lambda); }
+double Rayle(RandomStream &s, double delta)
+{ StreamSelect sel(s); return Rayle(delta); }
+double Triag(RandomStream &s, double mod, double min, double max)
+{ StreamSelect sel(s); return Triag(mod, min, max); }
+double Uniform(RandomStream &s, double l, double h)
+{ StreamSelect sel(s); return Uniform(l, h); }
+double Weibul(RandomStream &s, double lambda, double alfa)
+{ StreamSelect sel(s); return Weibul(lambda, alfa); }
+
 } // end
 
@@ -0,0 +1,254 @@
+/////////////////////////////////////////////////////////////////////////////
+//! \file replay.cc  Deterministic record and replay of simulation runs
+//
+// Copyright (c) 1991-2018 Petr Peringer
+//
+// This library is licensed under GNU Library GPL. See the file COPYING.
+//
+
+//
+// Record contains one item for each dispatched event (behavior of
+// entity): entity identification (relative to the first entity created
+// after RecordStart, so that the record can be replayed later in the
+// same program), time, number of random numbers
+// generated since previous item and hash of these numbers. Replay
+// reads the record and checks the run: entity and time before the
+// behavior, random numbers after it. The first difference is reported
+// and the run is stopped. The test of SIMLIB_Recording flag (in Random()
+// and SIMLIB_DoActions()) is the only cost of disabled recording.
+//
+// file format: "SIMLIBRR" version, items, end mark
+//   item = 1, id (zigzag varint), time (8 bytes), draws (varint), hash (8 bytes)
+//
+
+////////////////////////////////////////////////////////////////////////////
+// interface
+//
+
+#include "simlib.h"
+#include "internal.h"
+
+#include <cstdio>
+#include <cstring>
+
+////////////////////////////////////////////////////////////////////////////
+// implementation
+//
+
+namespace simlib3 {
+
+SIMLIB_IMPLEMENTATION;
+
+thread_local bool SIMLIB_Recording = false;
+
+static const char MAGIC[8] = { 'S','I','M','L','I','B','R','R' };
+static const unsigned char FORMAT_VERSION = 1;
+static const int ITEM = 1, END = 0;
+static const unsigned long long HASH_INIT = 0xcbf29ce484222325ULL; // FNV-1a
+static const unsigned long long HASH_MUL  = 0x100000001b3ULL;
+
+////////////////////////////////////////////////////////////////////////////
+// record/replay state (thread-local)
+//
+static thread_local struct {
+  std::FILE *f;                 // open file or 0
+  bool replay;                  // replay mode
+  bool diverged;                // replay: difference found
+  unsigned long items;          // number of items
+  unsigned long draws;          // random numbers since last item
+  unsigned long long hash;      // hash of these numbers
+  unsigned long base;           // entity counter at start
+  unsigned long id;             // current entity (relative to base)
+  double time;                  // time of current behavior
+  std::string name;             // name of current entity (replay)
+} rec = { 0, false, false, 0, 0, HASH_INIT, 0, 0, 0, "" };
+
+static void PutVarint(unsigned long long x)
+{
+  while(x >= 0x80) {
+    std::putc(int(x & 0x7f) | 0x80, rec.f);
+    x >>= 7;
+  }
+  std::putc(int(x), rec.f);
+}
+
+static unsigned long long GetVarint()
+{
+  unsigned long long x = 0;
+  int c, shift = 0;
+  while((c = std::getc(rec.f)) != EOF) {
+    x |= (unsigned long long)(c & 0x7f) << shift;
+    if((c & 0x80) == 0)
+      return x;
+    shift += 7;
+  }
+  SIMLIB_error(RecordFormatError);
+  return 0;
+}
+
+// signed numbers
+static void PutZigzag(long x)
+{
+  PutVarint(x < 0 ? ~((unsigned long long)x << 1) : (unsigned long long)x << 1);
+}
+
+static long GetZigzag()
+{
+  unsigned long long x = GetVarint();
+  return (x & 1) ? ~(long)(x >> 1) : (long)(x >> 1);
+}
+
+template<class T> static void Put(const T &x)
+{
+  std::fwrite(&x, sizeof(x), 1, rec.f);
+}
+
+template<class T> static void Get(T &x)
+{
+  if(std::fread(&x, sizeof(x), 1, rec.f) != 1)
+    SIMLIB_error(RecordFormatError);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Diverged --- report the first difference and stop the run
+//
+static void Diverged(const char *what)
+{
+  SIMLIB_warning(ReplayDivergence);
+  _Print("  item %lu: %s, entity %s (id %ld) at time %.17g\n",
+         rec.items, what, rec.name.c_str(), long(rec.id), rec.time);
+  rec.diverged = true;
+  SIMLIB_Recording = false;     // no more checks
+  Stop();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// SIMLIB_RecordRandom --- random number generated (see Random())
+//
+void SIMLIB_RecordRandom(double r)
+{
+  unsigned long long bits;
+  std::memcpy(&bits, &r, sizeof(bits));
+  rec.hash = (rec.hash ^ bits) * HASH_MUL;
+  rec.draws++;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// behavior of entity (see SIMLIB_DoActions)
+// (entity can be deleted at the end)
+//
+void SIMLIB_RecordBegin(const Entity *e)
+{
+  rec.id = e->id() - rec.base;
+  rec.time = Time;
+  if(!rec.replay)
+    return;
+  rec.name = e->Name();
+  int tag = std::getc(rec.f);
+  if(tag == END || tag == EOF) {
+    Diverged("event not in record");
+    return;
+  }
+  if(tag != ITEM)
+    SIMLIB_error(RecordFormatError);
+  unsigned long id = GetZigzag();
+  double t;
+  Get(t);
+  if(id != rec.id) {
+    Diverged("different entity");
+    _Print("  record: id %ld at time %.17g\n", long(id), t);
+  }
+  else if(std::memcmp(&t, &rec.time, sizeof(t)) != 0) {
+    Diverged("different time");
+    _Print("  record: time %.17g\n", t);
+  }
+}
+
+void SIMLIB_RecordEnd()
+{
+  if(!rec.replay) {
+    std::putc(ITEM, rec.f);
+    PutZigzag(long(rec.id));
+    Put(rec.time);
+    PutVarint(rec.draws);
+    Put(rec.hash);
+  }
+  else {
+    unsigned long draws = GetVarint();
+    unsigned long long hash;
+    Get(hash);
+    if(draws != rec.draws || hash != rec.hash) {
+      Diverged("different random numbers");
+      _Print("  record: %lu numbers, run: %lu numbers%s\n", draws, rec.draws,
+             draws == rec.draws ? " (other values)" : "");
+    }
+  }
+  rec.items++;
+  rec.draws = 0;
+  rec.hash = HASH_INIT;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// start recording/replay
+//
+static void Open(const char *filename, bool replay)
+{
+  RecordStop();
+  rec.f = std::fopen(filename, replay ? "rb" : "wb");
+  if(rec.f == 0)
+    SIMLIB_error(RecordFileError);
+  if(replay) {
+    char magic[sizeof(MAGIC)];
+    if(std::fread(magic, sizeof(magic), 1, rec.f) != 1 ||
+       std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 ||
+       std::getc(rec.f) != FORMAT_VERSION)
+      SIMLIB_error(RecordFormatError);
+  }
+  else {
+    std::fwrite(MAGIC, sizeof(MAGIC), 1, rec.f);
+    std::putc(FORMAT_VERSION, rec.f);
+  }
+  rec.replay = replay;
+  rec.diverged = false;
+  rec.items = rec.draws = 0;
+  rec.base = SIMLIB_Entity_Count;
+  rec.hash = HASH_INIT;
+  SIMLIB_Recording = true;
+}
+
+void RecordStart(const char *filename)
+{
+  Dprintf(("RecordStart(\"%s\")", filename));
+  Open(filename, false);
+}
+
+void ReplayStart(const char *filename)
+{
+  Dprintf(("ReplayStart(\"%s\")", filename));
+  Open(filename, true);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// RecordStop --- stop recording or replay, close file
+//
+bool RecordStop()
+{
+  if(rec.f == 0)
+    return true;
+  Dprintf(("RecordStop()"));
+  bool ok = !rec.diverged;
+  if(!rec.replay)
+    std::putc(END, rec.f);
+  else if(ok && std::getc(rec.f) != END) {
+    SIMLIB_warning(ReplayDivergence);
+    _Print("  item %lu: record contains more events\n", rec.items);
+    ok = false;
+  }
+  std::fclose(rec.f);
+  rec.f = 0;
+  SIMLIB_Recording = false;
+  return ok;
+}
+
+}
+// end
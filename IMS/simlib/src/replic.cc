@@ -0,0 +1,513 @@
+/////////////////////////////////////////////////////////////////////////////
+//! \file replic.cc  Independent replications of simulation experiment
+//
+// Copyright (c) 1991-2018 Petr Peringer
+//
+// This library is licensed under GNU Library GPL. See the file COPYING.
+//
+
+//
+// RunReplications runs replications in worker threads (each thread has
+// own simulation context) or in worker processes. Workers take next
+// replication number from shared counter (dynamic load balancing).
+// Each replication uses own stream of the base random generator.
+//
+// ReplicationStat records made by collect function inside replication
+// are stored in log and applied after all replications in order of
+// replication numbers, so the results do not depend on the number of
+// workers or on their scheduling.
+//
+
+////////////////////////////////////////////////////////////////////////////
+// interface
+//
+
+#include "simlib.h"
+#include "internal.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <new>          // placement new
+#include <thread>
+#include <vector>
+
+#if defined(__linux__) || defined(__FreeBSD__)
+#define REPLICATION_PROCESSES   // worker processes implemented
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////
+// implementation
+//
+
+namespace simlib3 {
+
+SIMLIB_IMPLEMENTATION;
+
+////////////////////////////////////////////////////////////////////////////
+// record types of ReplicationStat
+//
+enum {
+  REC_VALUE,    // x
+  REC_STAT,     // mean, sx, sx2, min, max, n
+  REC_HISTO     // mean, sx, sx2, min, max, n, low, step, count, dptr[count+2]
+};
+
+////////////////////////////////////////////////////////////////////////////
+// log of records of single replication: header + data
+//
+struct RecordHeader {
+  ReplicationStat *object;
+  int kind;
+  unsigned n;                   // number of data items
+};
+typedef std::vector<char> ReplicationLog;
+
+// log of running replication (0 = record directly)
+static thread_local ReplicationLog *SIMLIB_ReplicationLog = 0;
+
+static void Replay(const ReplicationLog &rlog)
+{
+  size_t pos = 0;
+  while(pos < rlog.size()) {
+    RecordHeader h;
+    std::memcpy(&h, &rlog[pos], sizeof(h));
+    pos += sizeof(h);
+    std::vector<double> data(h.n);
+    std::memcpy(data.data(), &rlog[pos], h.n * sizeof(double));
+    pos += h.n * sizeof(double);
+    h.object->_Apply(h.kind, data.data());
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+// Student's t-distribution quantile (for confidence intervals)
+//
+
+// continued fraction for incomplete beta function (modified Lentz's method)
+static double BetaCF(double a, double b, double x)
+{
+  const double EPS = 1e-15, FPMIN = 1e-300;
+  double qab = a + b, qap = a + 1, qam = a - 1;
+  double c = 1, d = 1 - qab*x/qap;
+  if(std::fabs(d) < FPMIN) d = FPMIN;
+  d = 1/d;
+  double h = d;
+  for(int m = 1; m <= 300; m++) {
+    int m2 = 2*m;
+    double aa = m*(b - m)*x/((qam + m2)*(a + m2));
+    d = 1 + aa*d;  if(std::fabs(d) < FPMIN) d = FPMIN;
+    c = 1 + aa/c;  if(std::fabs(c) < FPMIN) c = FPMIN;
+    d = 1/d;
+    h *= d*c;
+    aa = -(a + m)*(qab + m)*x/((a + m2)*(qap + m2));
+    d = 1 + aa*d;  if(std::fabs(d) < FPMIN) d = FPMIN;
+    c = 1 + aa/c;  if(std::fabs(c) < FPMIN) c = FPMIN;
+    d = 1/d;
+    double del = d*c;
+    h *= del;
+    if(std::fabs(del - 1) < EPS) break;
+  }
+  return h;
+}
+
+// regularized incomplete beta function I_x(a,b)
+static double IncompleteBeta(double a, double b, double x)
+{
+  if(x <= 0) return 0;
+  if(x >= 1) return 1;
+  double bt = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b)
+                       + a*std::log(x) + b*std::log(1 - x));
+  if(x < (a + 1)/(a + b + 2))
+    return bt*BetaCF(a, b, x)/a;
+  return 1 - bt*BetaCF(b, a, 1 - x)/b;
+}
+
+// P(T <= t) for t >= 0, df degrees of freedom
+static double StudentCDF(double t, double df)
+{
+  return 1 - 0.5*IncompleteBeta(df/2, 0.5, df/(df + t*t));
+}
+
+// t such that P(T <= t) = p, p >= 0.5 (bisection)
+static double StudentQuantile(double p, double df)
+{
+  double lo = 0, hi = 1;
+  while(StudentCDF(hi, df) < p && hi < 1e10)
+    hi *= 2;
+  for(int i = 0; i < 200 && hi - lo > 1e-12*hi; i++) {
+    double mid = (lo + hi)/2;
+    if(StudentCDF(mid, df) < p) lo = mid;
+    else                        hi = mid;
+  }
+  return (lo + hi)/2;
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+//  ReplicationStat constructors/destructor
+//
+ReplicationStat::ReplicationStat() : histo(0)
+{
+  Dprintf(("ReplicationStat::ReplicationStat()"));
+}
+
+ReplicationStat::ReplicationStat(const char *name) : histo(0)
+{
+  Dprintf(("ReplicationStat::ReplicationStat(\"%s\")", name));
+  SetName(name);
+}
+
+ReplicationStat::~ReplicationStat()
+{
+  Dprintf(("ReplicationStat::~ReplicationStat() // \"%s\" ", Name().c_str()));
+  delete histo;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// ReplicationStat::Clear --- initialize
+//
+void ReplicationStat::Clear()
+{
+  values.Clear();
+  pooled.Clear();
+  delete histo;
+  histo = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// ReplicationStat::_Record --- store to log of replication or apply
+//
+void ReplicationStat::_Record(int kind, const double *data, unsigned n)
+{
+  ReplicationLog *rlog = SIMLIB_ReplicationLog;
+  if(rlog == 0) {               // not in replication
+    _Apply(kind, data);
+    return;
+  }
+  RecordHeader h = { this, kind, n };
+  size_t pos = rlog->size();
+  rlog->resize(pos + sizeof(h) + n*sizeof(double));
+  std::memcpy(&(*rlog)[pos], &h, sizeof(h));
+  std::memcpy(&(*rlog)[pos + sizeof(h)], data, n*sizeof(double));
+}
+
+////////////////////////////////////////////////////////////////////////////
+// ReplicationStat::_Apply --- add results of replication
+//
+void ReplicationStat::_Apply(int kind, const double *data)
+{
+  values(data[0]);
+  if(kind == REC_VALUE)
+    return;
+  Stat s;                       // records of replication
+  s.sx  = data[1];
+  s.sx2 = data[2];
+  s.min = data[3];
+  s.max = data[4];
+  s.n   = (unsigned long)data[5];
+  pooled += s;
+  if(kind == REC_HISTO) {
+    double low = data[6], step = data[7];
+    unsigned count = (unsigned)data[8];
+    if(histo == 0) {
+      histo = new Histogram(low, step, count);
+      if(HasName())
+        histo->SetName(Name());
+    }
+    Histogram h(low, step, count);
+    for(unsigned i = 0; i < count + 2; i++)
+      h.dptr[i] = (unsigned)data[9 + i];
+    h.stat += s;
+    *histo += h;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////
+// ReplicationStat::operator () --- record result of replication
+//
+void ReplicationStat::operator () (double x)
+{
+  _Record(REC_VALUE, &x, 1);
+}
+
+void ReplicationStat::operator () (const Stat &s)
+{
+  double data[6] = { s.MeanValue(), s.sx, s.sx2, s.min, s.max, double(s.n) };
+  _Record(REC_STAT, data, 6);
+}
+
+void ReplicationStat::operator () (const TStat &s)
+{
+  double x = s.MeanValue();
+  _Record(REC_VALUE, &x, 1);
+}
+
+void ReplicationStat::operator () (const Histogram &h)
+{
+  std::vector<double> data(9 + h.count + 2);
+  const Stat &s = h.stat;
+  data[0] = s.MeanValue();
+  data[1] = s.sx;  data[2] = s.sx2;
+  data[3] = s.min; data[4] = s.max;
+  data[5] = double(s.n);
+  data[6] = h.low; data[7] = h.step;
+  data[8] = h.count;
+  for(unsigned i = 0; i < h.count + 2; i++)
+    data[9 + i] = h.dptr[i];
+  _Record(REC_HISTO, data.data(), data.size());
+}
+
+////////////////////////////////////////////////////////////////////////////
+// ReplicationStat::HalfWidth --- half-width of confidence interval
+// of mean value (Student's t-distribution)
+//
+double ReplicationStat::HalfWidth(double level) const
+{
+  unsigned long n = values.Number();
+  if(n < 2 || level <= 0 || level >= 1)
+    SIMLIB_error(ReplicationStatError);
+  double t = StudentQuantile((1 + level)/2, n - 1);
+  return t * values.StdDev() / std::sqrt(double(n));
+}
+
+////////////////////////////////////////////////////////////////////////////
+// ReplicationStat::Output
+//
+void ReplicationStat::Output() const
+{
+  unsigned long n = values.Number();
+  Print("+----------------------------------------------------------+\n");
+  Print("| REPLICATIONS %-43s |\n", Name().c_str());
+  Print("+----------------------------------------------------------+\n");
+  if (n==0)
+    Print("|  no record                                               |\n");
+  else
+  {
+    Print(  "|  Number of replications = %-21lu          |\n", n);
+    Print(  "|  Min = %-15g         Max = %-15g     |\n",
+            values.Min(), values.Max());
+    Print(  "|  Average value = %-25g               |\n", MeanValue());
+    if (n>1) {
+      Print("|  Standard deviation = %-25g          |\n", StdDev());
+      Print("|  95%% confidence interval = +- %-16g           |\n",
+            HalfWidth(0.95));
+    }
+  }
+  Print("+----------------------------------------------------------+\n");
+  if (histo)
+    histo->Output();            // includes pooled statistics
+  else if (pooled.Number()>0) {
+    Print("| pooled records:                                          |\n");
+    pooled.Output();
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+// replication workers
+//
+struct ReplicationJob {
+  unsigned count;               // number of replications
+  RandomStream base;            // initial state of base generator
+  void (*setup)(unsigned);
+  void (*collect)(unsigned);
+  std::atomic<unsigned> *next;  // next replication number
+  const SIMLIB_SignalActions *signals; // actions of calling thread
+};
+
+// run single replication, records are stored in log
+static void RunReplication(const ReplicationJob &job, unsigned i,
+                           ReplicationLog &rlog)
+{
+  Dprintf(("RunReplication(%u)", i));
+  SIMLIB_RandomStream(job.base, i); // independent stream
+  SIMLIB_ReplicationLog = &rlog;
+  job.setup(i);
+  Run();
+  job.collect(i);
+  SIMLIB_ReplicationLog = 0;
+}
+
+// thread worker: replications until counter reaches count
+static void ThreadWorker(const ReplicationJob *job,
+                         std::vector<ReplicationLog> *logs)
+{
+  unsigned i;
+  SIMLIB_SignalInherit(job->signals);
+  while((i = job->next->fetch_add(1)) < job->count)
+    RunReplication(*job, i, (*logs)[i]);
+}
+
+static void RunInThreads(ReplicationJob &job, unsigned workers,
+                         std::vector<ReplicationLog> &logs)
+{
+  std::atomic<unsigned> next(0);
+  job.next = &next;
+  std::vector<std::thread> threads;
+  for(unsigned w = 0; w < workers; w++)
+    threads.emplace_back(ThreadWorker, &job, &logs);
+  for(auto &t : threads)
+    t.join();
+}
+
+#ifdef REPLICATION_PROCESSES
+
+// header of log sent by worker process through pipe
+struct LogHeader {
+  unsigned replication;
+  size_t size;
+};
+
+static bool WriteAll(int fd, const void *p, size_t n)
+{
+  const char *s = static_cast<const char *>(p);
+  while(n > 0) {
+    ssize_t r = write(fd, s, n);
+    if(r < 0) return false;
+    s += r;
+    n -= r;
+  }
+  return true;
+}
+
+// process worker: sends log of each replication through pipe, never returns
+[[noreturn]] static void ProcessWorker(const ReplicationJob &job, int fd)
+{
+  unsigned i;
+  int status = 0;
+  while((i = job.next->fetch_add(1)) < job.count) {
+    ReplicationLog rlog;
+    RunReplication(job, i, rlog);
+    LogHeader h = { i, rlog.size() };
+    if(!WriteAll(fd, &h, sizeof(h)) || !WriteAll(fd, rlog.data(), rlog.size())) {
+      status = 1;
+      break;
+    }
+  }
+  std::fflush(0);
+  _exit(status);
+}
+
+static void RunInProcesses(ReplicationJob &job, unsigned workers,
+                           std::vector<ReplicationLog> &logs)
+{
+  void *shared = mmap(0, sizeof(std::atomic<unsigned>), PROT_READ|PROT_WRITE,
+                      MAP_SHARED|MAP_ANONYMOUS, -1, 0);
+  if(shared == MAP_FAILED)
+    SIMLIB_error(ReplicationError);
+  job.next = new(shared) std::atomic<unsigned>(0);
+  std::fflush(0);               // do not duplicate buffered output
+  std::vector<pid_t> pids;
+  std::vector<pollfd> fds;
+  for(unsigned w = 0; w < workers; w++) {
+    int fd[2];
+    if(pipe(fd) != 0)
+      break;
+    pid_t pid = fork();
+    if(pid == 0) {              // worker
+      close(fd[0]);
+      for(auto &p : fds)
+        close(p.fd);
+      ProcessWorker(job, fd[1]);
+    }
+    close(fd[1]);
+    if(pid < 0) {
+      close(fd[0]);
+      break;
+    }
+    pids.push_back(pid);
+    pollfd p = { fd[0], POLLIN, 0 };
+    fds.push_back(p);
+  }
+  // read logs from all workers
+  std::vector<ReplicationLog> buffers(fds.size());
+  std::vector<bool> done(job.count, false);
+  unsigned active = fds.size();
+  while(active > 0) {
+    if(poll(fds.data(), fds.size(), -1) < 0)
+      continue;                 // EINTR
+    for(unsigned w = 0; w < fds.size(); w++) {
+      if(fds[w].fd < 0 || fds[w].revents == 0)
+        continue;
+      char chunk[65536];
+      ssize_t r = read(fds[w].fd, chunk, sizeof(chunk));
+      if(r <= 0) {              // end of worker output
+        close(fds[w].fd);
+        fds[w].fd = -1;
+        active--;
+        continue;
+      }
+      ReplicationLog &b = buffers[w];
+      b.insert(b.end(), chunk, chunk + r);
+      LogHeader h;
+      while(b.size() >= sizeof(h)) { // complete logs
+        std::memcpy(&h, b.data(), sizeof(h));
+        if(b.size() < sizeof(h) + h.size)
+          break;
+        if(h.replication < job.count) {
+          logs[h.replication].assign(b.begin() + sizeof(h),
+                                     b.begin() + sizeof(h) + h.size);
+          done[h.replication] = true;
+        }
+        b.erase(b.begin(), b.begin() + sizeof(h) + h.size);
+      }
+    }
+  }
+  bool ok = !pids.empty();
+  for(pid_t pid : pids) {
+    int status;
+    if(waitpid(pid, &status, 0) != pid || !WIFEXITED(status)
+       || WEXITSTATUS(status) != 0)
+      ok = false;
+  }
+  munmap(shared, sizeof(std::atomic<unsigned>));
+  for(unsigned i = 0; i < job.count; i++)
+    if(!done[i]) ok = false;
+  if(!ok)
+    SIMLIB_error(ReplicationError);
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////
+// RunReplications --- run count independent replications
+//
+void RunReplications(unsigned count, unsigned threads,
+                     void (*setup)(unsigned), void (*collect)(unsigned),
+                     bool processes)
+{
+  Dprintf(("RunReplications(%u,%u,%s)", count, threads,
+           processes ? "processes" : "threads"));
+  if(count == 0)
+    SIMLIB_error(ReplicationCountError);
+  if(threads == 0)
+    threads = std::thread::hardware_concurrency();
+  if(threads == 0)
+    threads = 1;
+  if(threads > count)
+    threads = count;
+  ReplicationJob job = { count, SIMLIB_RandomDefault, setup, collect, 0,
+                         SIMLIB_SignalGet() };
+  std::vector<ReplicationLog> logs(count);
+  if(processes) {
+#ifdef REPLICATION_PROCESSES
+    RunInProcesses(job, threads, logs);
+#else
+    SIMLIB_error(ReplicationNotImpl);
+#endif
+  }
+  else
+    RunInThreads(job, threads, logs);
+  for(unsigned i = 0; i < count; i++)   // in order of replications
+    Replay(logs[i]);
+}
+
+}
+// end
@@ -36,29 +36,32 @@ SIMLIB_IMPLEMENTATION;
 //
 
 
+//  All variables are thread-local (simulation context of the thread)
+//
+
 // time-related variables
-double SIMLIB_StartTime;       // time of simulation start
-double SIMLIB_Time;            // simulation time
-double SIMLIB_NextTime;        // next-event time
-double SIMLIB_EndTime;         // time of simulation end
+thread_local double SIMLIB_StartTime;   // time of simulation start
+thread_local double SIMLIB_Time;        // simulation time
+thread_local double SIMLIB_NextTime;    // next-event time
+thread_local double SIMLIB_EndTime;     // time of simulation end
 
 // read-only references to time variables
 // ASSERTION: StartTime <= Time <= NextTime <= EndTime
-const double & StartTime = SIMLIB_StartTime;    // time of simulation start
-const double & Time      = SIMLIB_Time;         // simulation time
-const double & NextTime  = SIMLIB_NextTime;     // next-event time
-const double & EndTime   = SIMLIB_EndTime;      // time of simulation end
+thread_local const double & StartTime = SIMLIB_StartTime; // time of simulation start
+thread_local const double & Time      = SIMLIB_Time;      // simulation time
+thread_local const double & NextTime  = SIMLIB_NextTime;  // next-event time
+thread_local const double & EndTime   = SIMLIB_EndTime;   // time of simulation end
 
 // current entity pointer
-Entity *SIMLIB_Current = NULL;
-Entity *const &Current = SIMLIB_Current;        // read-only reference
+thread_local Entity *SIMLIB_Current = NULL;
+thread_local Entity *const &Current = SIMLIB_Current;     // read-only reference
 
 // phase of simulation experiment
-SIMLIB_Phase_t SIMLIB_Phase = START;
-const SIMLIB_Phase_t & Phase = SIMLIB_Phase;    // read-only reference
+thread_local SIMLIB_Phase_t SIMLIB_Phase = START;
+thread_local const SIMLIB_Phase_t & Phase = SIMLIB_Phase; // read-only reference
 
 // experiment counter
-unsigned long SIMLIB_experiment_no = 0;
+thread_local unsigned long SIMLIB_experiment_no = 0;
 
 ////////////////////////////////////////////////////////////////////////////
 /// internal statistical information
@@ -74,13 +77,13 @@ void SIMLIB_statistics_t::Init() {
     EndTime = -1;
 }
 
-static SIMLIB_statistics_t SIMLIB_run_statistics;
-const SIMLIB_statistics_t &SIMLIB_statistics = SIMLIB_run_statistics;
+static thread_local SIMLIB_statistics_t SIMLIB_run_statistics;
+thread_local const SIMLIB_statistics_t &SIMLIB_statistics = SIMLIB_run_statistics;
 
 ////////////////////////////////////////////////////////////////////////////
 // private module variables
 
-static bool StopFlag = false;           // if set, stop simulation run
+static thread_local bool StopFlag = false; // if set, stop simulation run
 
 ////////////////////////////////////////////////////////////////////////////
 // support for Delay blocks (internal)
@@ -96,6 +99,18 @@ void SampleDelays() { // used at step-wise changes !!!###
 // ZDelays:
 DEFINE_HOOK(ZDelayTimerInit); // called in Run()
 
+////////////////////////////////////////////////////////////////////////////
+// polling in Run(): SIMLIB_PollCount is decremented after each event and
+// each integration step, SIMLIB_Poll() is called if it reaches zero
+// (no indirect calls in the main loop)
+//
+const unsigned long POLL_BATCH = 256;   // events+steps between polls
+thread_local unsigned long SIMLIB_PollCount = POLL_BATCH;
+static thread_local unsigned long PollBatch = POLL_BATCH;
+
+DEFINE_HOOK(Signals);   // pending signals (see signals.cc)
+DEFINE_HOOK(Progress);  // progress reports (see progress.cc)
+
 ////////////////////////////////////////////////////////////////////////////
 // support for simulation interrupt (user-level)
 //
@@ -103,6 +118,20 @@ DEFINE_HOOK(Break);     // called in Run()
 
 void InstallBreak(void (*f)()) { // for user interface (in simlib.h)
     INSTALL_HOOK( Break, f );
+    PollBatch = f ? 1 : POLL_BATCH;     // break function: each step
+    if(SIMLIB_PollCount > PollBatch)
+        SIMLIB_PollCount = PollBatch;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// SIMLIB_Poll --- user break, signals, progress reports
+//
+void SIMLIB_Poll()
+{
+    SIMLIB_PollCount = PollBatch;
+    CALL_HOOK(Break);   // user can stop simulation by key or GUI
+    CALL_HOOK(Signals); // signal can stop simulation
+    CALL_HOOK(Progress);
 }
 
 ////////////////////////////////////////////////////////////////////////////
@@ -129,13 +158,28 @@ void SIMLIB_WUClear() // should be removed -- ise CALL_HOOK instead
 // special WaitUntil processing
 DEFINE_HOOK(WUget_next);
 ////////////////////////////////////////////////////////////////////////////
+// clear trace buffer (see trace.cc)
+DEFINE_HOOK(TraceInit);
+////////////////////////////////////////////////////////////////////////////
+// progress reports (see progress.cc)
+DEFINE_HOOK(ProgressStart);     // called at start of Run()
+DEFINE_HOOK(ProgressEnd);       // called at end of Run()
+////////////////////////////////////////////////////////////////////////////
 // SIMLIB_DoActions --- central calling of interruptable procedures
 // WARNING: SIMLIB_Current->_Run() should be called from this place only!
 //
 void SIMLIB_DoActions()
 {
   do {
+    if(SIMLIB_Tracing)
+      SIMLIB_TraceRunBegin(SIMLIB_Current);
+    if(SIMLIB_Recording)
+      SIMLIB_RecordBegin(SIMLIB_Current);
     SIMLIB_Current->_Run(); // perform event-dispatch
+    if(SIMLIB_Recording)
+      SIMLIB_RecordEnd();
+    if(SIMLIB_Tracing)
+      SIMLIB_TraceRunEnd();
     SIMLIB_Current = 0;
     CALL_HOOK(WUget_next);  // check and activate next in WUlist
   }while( SIMLIB_Current != 0 );
@@ -206,14 +250,14 @@ void SIMLIB_Init(double T0, double T1, unsigned version)
 //  MinStep = MaxStep/1000;
 
   // TODO: add SIMLIB_RunNumber++
-  // TODO: add real-time stderr/cerr output message for long computations?
-  //       on-demand print of "RunNumber:Time   ETArun:minutes" each minute?
+  // (real-time progress reports: see SetProgress)
 
   // ADD list of functions to call: (dynamically!, priority)
   // something like atexit(): atInit, atRunStart, atRunEnd
 
   SQS::Clear();                 // initialize calendar
   SIMLIB_WUClear();             // initialize WaitUntilList
+  CALL_HOOK(TraceInit);         // clear trace of previous run
   SIMLIB_ContinueInit();        // initialize status variables 1 ###
 
   CALL_HOOK(SamplerInit);       // initialize all Samplers
@@ -239,6 +283,7 @@ void Run() {
   // initialize variables
   SIMLIB_Phase = SIMULATION;
   StopFlag = false;               // flag for stop simulation
+  SIMLIB_PollCount = PollBatch;
 
   SIMLIB_run_statistics.Init();       // initialize internal statistics
   SIMLIB_run_statistics.StartTime = Time;
@@ -249,6 +294,7 @@ void Run() {
   CALL_HOOK(ZDelayTimerInit);     // activate all ZDelayTimers
   CALL_HOOK(SamplerAct);          // activate all Samplers
   CALL_HOOK(Break);               // user can stop simulation by any key?
+  CALL_HOOK(ProgressStart);       // start progress reports
 
 // TODO: try using special lowest priority end-event to stop simulation
 //       It should be simpler
@@ -266,7 +312,8 @@ void Run() {
               SIMLIB_ResetStatus = true;   // don't use previous step buffers
                                            // TODO: is it really needed always?
               CALL_HOOK(Delay);            // DELAY: sample input
-              while( Time < NextTime )  {  // do continuous steps
+              while( Time < NextTime && Time < EndTime )  {
+                                           // do continuous steps
                                            // until scheduled event or end ...
                   IntegrationMethod::StepSim(); // *** continuous step ***
 
@@ -281,8 +328,8 @@ void Run() {
 
                   SIMLIB_DoConditions();   // perform state events
                   CALL_HOOK(Delay);        // DELAY: sample input at each step
-                  CALL_HOOK(Break); // user can stop simulation by any key?
-                                    // TODO: use signal handler, ^C=SIGINT
+                  if(--SIMLIB_PollCount == 0)
+                      SIMLIB_Poll();       // user break, signals, ...
                   if(StopFlag)
                       break;        // end of simulation run was required
                                     // by a state-event
@@ -305,9 +352,11 @@ void Run() {
           SIMLIB_DoActions();  // perform actions (see waitunti.cc)
           SIMLIB_run_statistics.EventCount++;   // internal statistics
           // assert: SIMLIB_Current is NULL
-          CALL_HOOK(Break); // Callback: user can stop simulation by key or GUI
+          if(--SIMLIB_PollCount == 0)
+              SIMLIB_Poll();                   // user break, signals, ...
         }
   } // main loop
+  CALL_HOOK(ProgressEnd);               // final progress report
   IntegrationMethod::IntegrationDone(); // terminate integration run
   SQS::Clear();                         // terminate all scheduled events/processes
   SIMLIB_Phase = TERMINATION;
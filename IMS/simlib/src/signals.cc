@@ -0,0 +1,183 @@
+/////////////////////////////////////////////////////////////////////////////
+//! \file signals.cc  Asynchronous stop of simulation run by signals
+//
+// Copyright (c) 1991-2018 Petr Peringer
+//
+// This library is licensed under GNU Library GPL. See the file COPYING.
+//
+
+//
+// Signal handler only increments counter of the signal. The counter is
+// checked by SIMLIB_Poll() after batches of events/steps (see run.cc),
+// the action (e.g. SaveCheckpoint) and Stop() are done there, after
+// the current event is finished. Each thread has its own actions and
+// compares the counter with number of signals already handled. Threads
+// of RunParallel() and RunReplications() inherit the actions of the calling
+// thread, so that one signal stops all parallel runs (see pdes.cc,
+// replic.cc). The handler is installed by sigaction() while at least
+// one thread uses the signal, then the previous handler is restored.
+//
+
+////////////////////////////////////////////////////////////////////////////
+// interface
+//
+
+#include "simlib.h"
+#include "internal.h"
+
+#include <atomic>
+#include <csignal>
+#include <mutex>
+#include <signal.h>     // sigaction()
+
+////////////////////////////////////////////////////////////////////////////
+// implementation
+//
+
+namespace simlib3 {
+
+SIMLIB_IMPLEMENTATION;
+
+#ifndef NSIG
+# define NSIG 65
+#endif
+
+// number of received signals (shared by all threads)
+static std::atomic<unsigned long> pending[NSIG];
+
+extern "C" void SIMLIB_SignalHandler(int sig)
+{
+  pending[sig].fetch_add(1, std::memory_order_relaxed);
+}
+
+// handler installation (shared by all threads)
+static std::mutex installed_mutex;
+static unsigned installed_count[NSIG];  // threads using the handler
+static struct sigaction installed_old[NSIG]; // previous handler
+
+// actions of signals (thread-local)
+struct SIMLIB_SignalActions {
+  struct {
+    void (*action)();           // function or 0
+    bool stop;                  // stop simulation run
+    bool on;                    // signal is handled
+    bool installed;             // handler installed by this thread
+    unsigned long seen;         // number of handled signals
+  } a[NSIG];
+};
+static thread_local SIMLIB_SignalActions actions;
+
+////////////////////////////////////////////////////////////////////////////
+// Install, Uninstall --- reference counted handler installation
+//
+static bool Install(int sig)
+{
+  std::lock_guard<std::mutex> lock(installed_mutex);
+  if(installed_count[sig] == 0) {
+    struct sigaction sa;
+    sa.sa_handler = SIMLIB_SignalHandler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    if(sigaction(sig, &sa, &installed_old[sig]) != 0)
+      return false;
+  }
+  installed_count[sig]++;
+  return true;
+}
+
+static void Uninstall(int sig)
+{
+  std::lock_guard<std::mutex> lock(installed_mutex);
+  if(--installed_count[sig] == 0)
+    sigaction(sig, &installed_old[sig], 0);
+}
+
+// thread exit: remove handlers installed by thread
+static void UninstallAll()
+{
+  for(int sig = 1; sig < NSIG; sig++)
+    if(actions.a[sig].installed) {
+      actions.a[sig].installed = false;
+      Uninstall(sig);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+// CheckSignals --- called by SIMLIB_Poll()
+//
+static void CheckSignals()
+{
+  for(int sig = 1; sig < NSIG; sig++) {
+    if(!actions.a[sig].on)
+      continue;
+    unsigned long n = pending[sig].load(std::memory_order_relaxed);
+    if(n == actions.a[sig].seen)
+      continue;
+    actions.a[sig].seen = n;      // signals received meanwhile are merged
+    Dprintf(("signal %d at time %g", sig, double(Time)));
+    if(actions.a[sig].action)
+      actions.a[sig].action();
+    if(actions.a[sig].stop)
+      Stop();
+  }
+}
+
+// polling of signals is on if any signal is handled
+static void InstallCheck()
+{
+  bool any = false;
+  for(int i = 1; i < NSIG; i++)
+    any = any || actions.a[i].on;
+  INSTALL_HOOK(Signals, any ? CheckSignals : 0);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// OnSignal --- set action for signal
+//
+void OnSignal(int sig, void (*action)(), bool stop)
+{
+  Dprintf(("OnSignal(%d,%p,%d)", sig, (void*)action, stop));
+  if(sig <= 0 || sig >= NSIG)
+    SIMLIB_error(SignalError);
+  static thread_local bool registered = false;
+  bool on = action != 0 || stop;
+  actions.a[sig].action = action;
+  actions.a[sig].stop = stop;
+  actions.a[sig].seen = pending[sig].load(std::memory_order_relaxed);
+  if(on && !actions.a[sig].installed) {
+    if(!Install(sig))
+      SIMLIB_error(SignalError);
+    actions.a[sig].installed = true;
+    if(!registered) {
+      SIMLIB_atexit(UninstallAll);
+      registered = true;
+    }
+  }
+  else if(!on && actions.a[sig].installed) {
+    actions.a[sig].installed = false;
+    Uninstall(sig);
+  }
+  actions.a[sig].on = on;
+  InstallCheck();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// SIMLIB_SignalGet, SIMLIB_SignalInherit --- actions for new thread
+// (the handler is kept installed by the calling thread)
+//
+const SIMLIB_SignalActions *SIMLIB_SignalGet()
+{
+  return &actions;
+}
+
+void SIMLIB_SignalInherit(const SIMLIB_SignalActions *parent)
+{
+  for(int sig = 1; sig < NSIG; sig++) {
+    actions.a[sig] = parent->a[sig];
+    actions.a[sig].installed = false;
+  }
+  InstallCheck();
+}
+
+}
+// end
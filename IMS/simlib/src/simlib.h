@@ -52,6 +52,9 @@
 #include <cstdlib>      // size_t
 #include <list>         // std::list<>
 #include <string>       // std::string
+#include <type_traits>  // std::is_trivially_copyable<>
+#include <typeinfo>     // std::type_info
+#include <vector>       // std::vector<>
 
 // /////////////////////////////////////////////////////////////////////////
 //! \namespace simlib3  Main SIMLIB (version 3+) namespace.
@@ -117,10 +120,14 @@ class     Queue;                // priority queue
 class   Stat;                   // statistics
 class   TStat;                  // time dependent statistics
 class   Histogram;              // histogram
+class   ReplicationStat;        // results of replications
+class   LogicalProcess;         // partition of parallel model
 class   Facility;               // SOL-like facility
+class   FacilityPool;           // multi-server facility
 class   Store;                  // SOL-like store
 class   Barrier;                // barrier
 class   Semaphore;              // semaphore
+class Checkpoint;               // checkpoint file (state of simulation)
 // continuous:
 class   aBlock;                 // abstract block
 class     aContiBlock;          // blocks with continuous output
@@ -149,28 +156,31 @@ const double SIMLIB_MAXTIME = 1.0e30; //!< maximum time (1e30 works for float, t
 
 ////////////////////////////////////////////////////////////////////////////
 // CATEGORY: global variables
-// Warning: NOT THREAD-SAFE! --- TODO: change to methods of SimulationContext
+// Simulation context: the state of simulation (time, calendar, lists of
+// blocks, conditions, random generator, ...) is thread-local, each thread
+// can run independent simulation experiment. Model objects should be
+// created and used by single thread. Print() output is shared.
 
-extern Entity *const &Current;    //!< pointer to active (now running) entity
+extern thread_local Entity *const &Current; //!< pointer to active (now running) entity
 
 // time values:
-extern const double & StartTime;       //!< time of simulation start
-extern const double & NextTime;        //!< next-event time
-extern const double & EndTime;         //!< time of simulation end
+extern thread_local const double & StartTime;   //!< time of simulation start
+extern thread_local const double & NextTime;    //!< next-event time
+extern thread_local const double & EndTime;     //!< time of simulation end
 
 // WARNING: Time cannot be used in block expressions!
-extern const double & Time;            //!< model time (is NOT the block)
+extern thread_local const double & Time;        //!< model time (is NOT the block)
 extern aContiBlock  & T;               //!< model time (continuous block)
 
 // read-only step limits of numerical integration method
-extern const double &MinStep;     //!< minimal step size
-extern const double &StepSize;    //!< current step size
-extern const double &OptStep;     //!< optimal step size
-extern const double &MaxStep;     //!< maximal step size
+extern thread_local const double &MinStep;      //!< minimal step size
+extern thread_local const double &StepSize;     //!< current step size
+extern thread_local const double &OptStep;      //!< optimal step size
+extern thread_local const double &MaxStep;      //!< maximal step size
 
 // error params for numerical integration methods
-extern const double &AbsoluteError; //!< max absolute error
-extern const double &RelativeError; //!< max relative error
+extern thread_local const double &AbsoluteError; //!< max absolute error
+extern thread_local const double &RelativeError; //!< max relative error
 
 ////////////////////////////////////////////////////////////////////////////
 // CATEGORY: global functions ...
@@ -187,6 +197,103 @@ inline void Init(double t0, double t1=SIMLIB_MAXTIME) {
 //! @param name String identification of calendar: "list", "cq"
 void SetCalendar(const char *name);
 
+//! Set size of process stacks.
+//! Processes started later run on own stack with guard page (stack
+//! overflow faults immediately), stacks are allocated on first use and
+//! reused after process termination.
+//! @param size  stack size in bytes, 0 = default (stack copying)
+void SetProcessStackSize(size_t size);
+
+//! Start recording of simulation trace (activations, queues, facilities,
+//! stores) to ring buffer in memory. The oldest records are overwritten,
+//! Init() clears the buffer. The trace is thread-local.
+//! @param records  size of ring buffer
+void TraceStart(unsigned long records=1000000);
+//! Stop recording, the trace is kept for TraceExport()
+void TraceStop();
+//! Write recorded trace in Chrome trace event format (JSON), it can be
+//! viewed by chrome://tracing or Perfetto UI
+//! @param filename   output file name
+//! @param wallclock  use wall-clock time (default is model time in s)
+void TraceExport(const char *filename, bool wallclock=false);
+
+//! Report progress of long simulation runs: model time, % of EndTime,
+//! number of events and steps, calendar size, speed, memory (RSS) and
+//! estimated remaining wall-clock time. Reports are written at given
+//! wall-clock interval and at the end of Run(), the clock is checked
+//! after batches of events (no per-event cost).
+//! @param interval  seconds between reports, 0 = off
+//! @param filename  status file rewritten by each report (default stderr)
+void SetProgress(double interval, const char *filename=0);
+
+//! Set action for signal (e.g. SIGINT, SIGUSR1). The signal handler only
+//! marks the signal, Run() checks it after batches of events, finishes
+//! the current event, calls action (e.g. SaveCheckpoint) and stops the
+//! run if required. OnSignal(sig, 0, false) restores default handling.
+//! Actions are thread-local, threads of RunParallel() and RunReplications()
+//! inherit actions of the calling thread (running LPs and replications
+//! are stopped). The previous handler is restored when no thread uses
+//! the signal.
+//! @param sig     signal number
+//! @param action  function called at safe point or 0
+//! @param stop    stop simulation run (statistics are kept)
+void OnSignal(int sig, void (*action)()=0, bool stop=true);
+
+//! Record following simulation runs: order of events (entity, time) and
+//! random numbers generated by each event are written to file.
+void RecordStart(const char *filename);
+//! Replay: check following simulation runs against record, the first
+//! difference (entity, time, random numbers) is reported and the run
+//! is stopped.
+void ReplayStart(const char *filename);
+//! Stop recording or replay, close file
+//! @return false if replayed run differs from record
+bool RecordStop();
+
+//! Save state of simulation run to file (checkpoint): time, calendar,
+//! entities, listed objects, integrators, status variables and random
+//! generator. Entities save own data by SaveState(), entity classes
+//! must be registered by CHECKPOINT_ENTITY. Process with stack can be
+//! saved only before its start (use Event or StepProcess).
+//! Called from Event behavior, the current event is saved only
+//! if it is scheduled.
+//! @param filename  output file name (file is replaced atomically)
+//! @param objects   Facility, FacilityPool, Store, Queue, Stat, TStat,
+//!                  Histogram
+void SaveCheckpoint(const char *filename,
+                    const std::vector<SimObject*> &objects);
+//! Restore state saved by SaveCheckpoint, use after Init() (model
+//! objects are created, calendar is cleared) and continue by Run().
+//! Integrators and status variables are initialized by saved values.
+//! @param filename  input file name
+//! @param objects   the same objects (in the same order) as saved
+void RestoreCheckpoint(const char *filename,
+                       const std::vector<SimObject*> &objects);
+
+//! Run independent replications of simulation experiment.
+//! Each replication uses own part of random number sequence (streams
+//! do not overlap), results do not depend on number of threads.
+//! Replication runs: setup(i) (Init, model initialization), Run(),
+//! collect(i) (record results to ReplicationStat objects).
+//! @param count    number of replications
+//! @param threads  number of parallel workers, 0 = number of CPUs
+//! @param setup    model initialization
+//! @param collect  result recording
+//! @param processes  use worker processes instead of threads
+//!                   (for models with global objects)
+void RunReplications(unsigned count, unsigned threads,
+                     void (*setup)(unsigned), void (*collect)(unsigned),
+                     bool processes=false);
+
+//! Run model partitioned to logical processes (conservative parallel
+//! simulation). Each LogicalProcess runs in own thread, all threads
+//! advance in time windows limited by lookahead. Results are the same
+//! for parallel and sequential (one LP at a time) execution.
+//! @param t0  simulation start time
+//! @param t1  simulation end time
+//! @param sequential  run logical processes one at a time
+void RunParallel(double t0, double t1, bool sequential=false);
+
 //! Set integration step interval.
 //! @param dtmin  min. step size
 //! @param dtmax  max. step size (can be slightly increased)
@@ -204,6 +311,14 @@ void SetAccuracy(double abserr, double relerr);
 //! @param relerr  tolerance relative to integrator value
 void SetAccuracy(double relerr);
 
+//! set location of state events (changes of Condition)
+//! <br> Enabled: time of change is found by root finding on cubic
+//! interpolation of integrators and the step is cut there (fewer
+//! evaluations of model). Disabled (default): the step is halved until
+//! the min. step size. Models with Status blocks always use halving.
+//! @param on  enable location
+void SetEventLocation(bool on);
+
 //! run simulation experiment
 void Run();
 //! stop current simulation run
@@ -248,15 +363,41 @@ void ContractStep(double time);
 ////////////////////////////////////////////////////////////////////////////
 // CATEGORY: pseudorandom number generators
 
-//! initialize random number seed
+//! stream of pseudorandom numbers (generator xoshiro256++)
+//! the period is 2^256-1, independent streams are created by jumps
+//! of 2^128 numbers (each stream can be used for any simulation run)
+class RandomStream {
+  unsigned long long s[4];      // state of generator
+ public:
+  //! stream initialized by seed (splitmix64 expansion of seed)
+  explicit RandomStream(unsigned long long seed = 1537);
+  //! independent stream i of seed (starts 2^128*i numbers later)
+  RandomStream(unsigned long long seed, unsigned long i);
+  void Seed(unsigned long long seed);   //!< initialize state by seed
+  unsigned long long Next();            //!< next 64 random bits
+  double Random() { return (Next() >> 11) * (1.0/9007199254740992.0); } //!< 0-0.999..
+  void Jump();                          //!< skip 2^128 numbers
+  void LongJump();                      //!< skip 2^192 numbers
+  bool operator==(const RandomStream &a) const;
+  bool operator!=(const RandomStream &a) const { return !(*this == a); }
+};
+
+//! select stream used by Random(), returns previous stream
+//! @param s stream (nullptr selects default stream initialized by RandomSeed)
+//! all generators of distributions use selected stream
+RandomStream *SetRandomStream(RandomStream *s);
+
+//! initialize random number seed (of default stream)
 //! @param seed initial value of generator state
 void   RandomSeed(long seed);
 //! base uniform generator (range 0-0.999999...)
-//! the default implementation is simple LCG 32bit
+//! the default implementation uses selected RandomStream
 double Random();
 //! set another random generator
-//! default Random() implementation can be replaced
-//! @param new_gen pointer to user-defined function
+//! default Random() implementation can be replaced (it is used instead of
+//! stream selected by SetRandomStream(), generators with explicit stream
+//! argument use the stream)
+//! @param new_gen pointer to user-defined function (nullptr: default)
 void   SetBaseRandomGenerator(double (*new_gen)());
 
 // following generators depend on Random()
@@ -286,6 +427,27 @@ double Uniform(double l, double h);
 //! Weibul distribution generator @param lambda @param alfa
 double Weibul(double lambda, double alfa);
 
+// the same generators using explicit stream s (common random numbers:
+// each part of model has own stream, changes of other parts of model
+// do not change its random numbers); they always draw from s, also if
+// the base generator is replaced by SetBaseRandomGenerator()
+double Random(RandomStream &s);
+double Beta(RandomStream &s, double th, double fi, double min, double max);
+double Erlang(RandomStream &s, double alfa, int beta);
+double Exponential(RandomStream &s, double mv);
+double Gamma(RandomStream &s, double alfa, double beta);
+int    Geom(RandomStream &s, double q);
+int    HyperGeom(RandomStream &s, double p, int n, int m);
+double Logar(RandomStream &s, double mi, double delta);
+int    NegBinM(RandomStream &s, double p, int m);
+int    NegBin(RandomStream &s, double q, int k);
+double Normal(RandomStream &s, double mi, double sigma);
+int    Poisson(RandomStream &s, double lambda);
+double Rayle(RandomStream &s, double delta);
+double Triag(RandomStream &s, double mod, double min, double max);
+double Uniform(RandomStream &s, double l, double h);
+double Weibul(RandomStream &s, double lambda, double alfa);
+
 
 ////////////////////////////////////////////////////////////////////////////
 // CATEGORY: basics
@@ -305,7 +467,9 @@ class SimObject {
         _HAS_NAME_FLAG   = 1<<2         // object has name (in dictionary)
   };
  protected:
-  unsigned _flags;      //!< bool flags for internal use (TODO bitfield?)
+  unsigned _flags:8;    //!< bool flags for internal use
+  mutable unsigned _serial:24;  //!< number assigned by trace (0: none)
+  friend unsigned SIMLIB_TraceSerial(const SimObject *o); // (trace.cc)
  public:
   bool TestAndSetFlag(bool new_value, unsigned n); // internal use only
   SimObject();
@@ -316,6 +480,9 @@ class SimObject {
   void operator delete[](void *ptr) = delete;
 // TODO: FIXME inconsistent name:
   bool isAllocated() const { return (_flags & _ALLOCATED_FLAG)!=0; }
+  //! number of object assigned by trace (0: not traced), it wraps
+  //! <br> address and serial number identify object in trace
+  unsigned Serial() const { return _serial; }
 
   virtual std::string Name() const;    //!< get object name
   bool HasName() const { return (_flags & _HAS_NAME_FLAG)!=0; }
@@ -364,6 +531,26 @@ typedef signed char EntityPriority_t;
 //! Service priority (see Facility::Seize)
 typedef unsigned char ServicePriority_t;
 
+//! priority attribute of entity (Entity::Priority), used as EntityPriority_t
+//! <br> change of priority of entity waiting in Queue updates the index
+//! of the queue (priority insert uses current priorities)
+class EntityPriority {
+    EntityPriority_t value;
+    void Set(EntityPriority_t p);       // change value (entity.cc)
+  public:
+    EntityPriority(EntityPriority_t p) : value(p) {}
+    EntityPriority(const EntityPriority &) = delete;
+    operator EntityPriority_t() const { return value; }
+    EntityPriority &operator=(const EntityPriority &p) { Set(p.value); return *this; }
+    EntityPriority &operator=(EntityPriority_t p) { Set(p); return *this; }
+    EntityPriority &operator+=(int d) { Set(EntityPriority_t(value + d)); return *this; }
+    EntityPriority &operator-=(int d) { Set(EntityPriority_t(value - d)); return *this; }
+    EntityPriority &operator++() { return *this += 1; }
+    EntityPriority &operator--() { return *this -= 1; }
+    EntityPriority_t operator++(int) { EntityPriority_t v = value; *this += 1; return v; }
+    EntityPriority_t operator--(int) { EntityPriority_t v = value; *this -= 1; return v; }
+};
+
 //! struct EventNotice is  private to calendar implementation
 struct EventNotice;     // we use only pointer to this class here
 
@@ -374,7 +561,7 @@ struct EventNotice;     // we use only pointer to this class here
 //! \ingroup simlib
 class Entity : public Link {
   protected:
-    static unsigned long _Number;   //!< current number of entities
+    static thread_local unsigned long _Number; //!< current number of entities
     unsigned long _Ident;           //!< unique identification number of entity
     ////////////////////////////////////////////////////////////////////////////
     // TODO: next attributes will be changed/removed:
@@ -382,6 +569,7 @@ class Entity : public Link {
     // Queue stores insertion time for statistics:
     friend class Queue;             // ### remove
     double _MarkTime;               // beginning of waiting in queue ###!!!
+    long _QueueKey;                 // ordering key in sorted queue
     // Facility and Store use these data
     friend class Facility;
     friend class Store;
@@ -396,7 +584,7 @@ class Entity : public Link {
     unsigned long id() const { return _Ident; }
     typedef EntityPriority_t Priority_t;
     //! priority of the entity (scheduling,queues)
-    Priority_t Priority;                //!< priority of the entity
+    EntityPriority Priority;            //!< priority of the entity
     Entity(Priority_t p = DEFAULT_PRIORITY);
     virtual ~Entity();
 
@@ -413,8 +601,13 @@ class Entity : public Link {
     void Cancel() { Terminate(); }      //!< end Behavior() and remove entity
 //    virtual void Into(Queue *q);         // insert itself into queue
     virtual void Out() override;        //!< remove entity from queue
+    //! save user data of entity (see SaveCheckpoint)
+    virtual void SaveState(Checkpoint &) const {}
+    //! restore user data of entity (see RestoreCheckpoint)
+    virtual void RestoreState(Checkpoint &) {}
 
   private:
+    friend class Checkpoint;
     // Simulation control algorithm interface:
     virtual void _Run() noexcept = 0;   //!< run the Behavior() function
     // friends:
@@ -454,6 +647,10 @@ class Process : public Entity {
   bool _wait_until;                     // waiting for condition
   void _WaitUntilRemove();
 
+  bool _own_stack;                      // _context is own stack (not copy)
+  void _RunOnStack();                   // dispatch of process with own stack
+  friend class Checkpoint;              // saves prepared processes only
+
  public:
   Process(Priority_t p=DEFAULT_PRIORITY);
   virtual ~Process();
@@ -469,11 +666,19 @@ class Process : public Entity {
 //! wait until the condition is true (lazy evaluation of condition)
 # define WaitUntil(condition)  while(_WaitUntil(condition)) /*empty body*/;
 #endif
+  void _ObserveBegin();                 //!< start of WaitUntilObserved test
+  bool _WaitUntilObserved(bool test);   //!< wait for change of Observable
+//! wait until the condition is true, the condition is tested again only
+//! after change of Observable variables read by the last test
+# define WaitUntilObserved(condition) \
+    while(_ObserveBegin(), _WaitUntilObserved(condition)) /*empty body*/;
   void Interrupt(); //!< test of WaitUntil list, allow running others
   virtual void Terminate() override;             //!< kill process
 
   void Seize(Facility &f, ServicePriority_t sp=0);  //!< seize facility
   void Release(Facility &f);                        //!< release facility
+  void Seize(FacilityPool &p);                      //!< seize any server
+  void Release(FacilityPool &p);                    //!< release server
   void Enter(Store &s, unsigned long ReqCap=1); //!< acquire some capacity
   void Leave(Store &s, unsigned long ReqCap=1); //!< return some capacity
 
@@ -481,6 +686,55 @@ class Process : public Entity {
   virtual void Into(Queue &q);          //!< insert process into queue
 };
 
+////////////////////////////////////////////////////////////////////////////
+//! process testing WaitUntilObserved condition or nullptr
+extern thread_local Process *SIMLIB_Observer;
+
+////////////////////////////////////////////////////////////////////////////
+//! abstract base class of model variables observed by WaitUntilObserved
+//! <br> Reading the value in condition registers the process, change of
+//! the value moves registered processes to the test after current event
+//! (as WaitUntil, but other processes are not tested).
+//! \ingroup process
+class aObservable {
+  struct Waiting {              // registered process
+    Process *process;
+    unsigned long id;           // identification of process
+    unsigned long test;         // number of test of condition
+  };
+  mutable std::vector<Waiting> waiting;
+  mutable std::size_t limit;    // size for removing of old records
+  void Observe() const;
+ protected:
+  void Read() const { if(SIMLIB_Observer) Observe(); } //!< value is read
+  void Changed();                               //!< value is changed
+ public:
+  aObservable() : limit(16) {}
+  aObservable(const aObservable &) = delete;
+  aObservable &operator=(const aObservable &) = delete;
+};
+
+////////////////////////////////////////////////////////////////////////////
+//! model variable observed by WaitUntilObserved (only changes of the value
+//! are reported)
+//! \ingroup process
+template <class T>
+class Observable : public aObservable {
+  T value;
+ public:
+  explicit Observable(const T &x = T()) : value(x) {}
+  operator T() const { Read(); return value; }          //!< read value
+  T Value() const    { Read(); return value; }          //!< read value
+  Observable &operator=(const T &x) {                   //!< change value
+    if(!(value == x)) { value = x; Changed(); }
+    return *this;
+  }
+  Observable &operator+=(const T &x) { return *this = value + x; }
+  Observable &operator-=(const T &x) { return *this = value - x; }
+  Observable &operator++() { return *this = value + 1; }
+  Observable &operator--() { return *this = value - 1; }
+};
+
 ////////////////////////////////////////////////////////////////////////////
 //! abstract base class for events
 //! Event behavior is simple function (can not be interrupted)
@@ -499,12 +753,57 @@ class Event : public Entity {
   using Entity::Activate;               // inherited: Activate()
 };
 
+////////////////////////////////////////////////////////////////////////////
+//! stackless process: behavior is a sequence of resumable steps
+//! Behavior() is called again after each blocking operation and continues
+//! at the saved resume point (see STEP_BEGIN, STEP_AWAIT, STEP_END).
+//! There is no stack saving, local variables of Behavior() are lost
+//! at each blocking point -- use data members instead.
+//! \ingroup simlib
+class StepProcess : public Event {
+  unsigned _step;                       //!< resume point (0 == start)
+  virtual void _Run() noexcept override;
+ public:
+  enum { STEP_FINISHED = ~0u };         //!< resume point after STEP_END
+  StepProcess(Priority_t p=DEFAULT_PRIORITY);
+  virtual ~StepProcess();
+  virtual void Output() const override;          //!< print object to default output
+  virtual std::string Name() const override;     //!< name of object
+  virtual void Terminate() override;             //!< end of behavior, remove
+  unsigned _GetStep() const { return _step; }    //!< internal: resume point
+  void _SetStep(unsigned s) { _step = s; }       //!< internal: resume point
+  // blocking operations return true if the process has to be suspended
+  bool Wait(double dtime);                          //!< wait for dtime interval
+  bool Seize(Facility &f, ServicePriority_t sp=0);  //!< seize facility
+  void Release(Facility &f);                        //!< release facility
+  bool Seize(FacilityPool &p);                      //!< seize any server
+  void Release(FacilityPool &p);                    //!< release server
+  bool Enter(Store &s, unsigned long ReqCap=1);     //!< acquire some capacity
+  void Leave(Store &s, unsigned long ReqCap=1);     //!< return some capacity
+  using Entity::Into;
+  void Into(Queue &q);                  //!< insert process into queue
+};
+
+//! start of StepProcess::Behavior() body
+#define STEP_BEGIN      switch(_GetStep()) { case 0:
+//! blocking operation, Behavior() continues after it when reactivated
+//! (use at most one STEP_AWAIT per source line)
+#define STEP_AWAIT(op)  do { _SetStep(__LINE__); \
+                             if(!(op)) { case __LINE__:; } else return; \
+                        } while(0)
+//! suspend until next activation (e.g. after Passivate())
+#define STEP_YIELD()    STEP_AWAIT(true)
+//! end of StepProcess::Behavior() body
+#define STEP_END        default:; } _SetStep(StepProcess::STEP_FINISHED)
+//! terminate StepProcess from Behavior()
+#define STEP_EXIT()     do { Terminate(); return; } while(0)
+
 ////////////////////////////////////////////////////////////////////////////
 //! objects of this class call global function periodically
 //!  (typicaly used for output of continuous model)
 //! \ingroup simlib
 class Sampler: public Event {
-    static Sampler *First;              // list of objects TODO: use container
+    static thread_local Sampler *First; // list of objects TODO: use container
     Sampler *Next;                      // next object
   protected:
     void (*function)(); //!< function to call periodically
@@ -574,7 +873,7 @@ class Stat : public SimObject {
   virtual void Clear();         //!< initialize
   void operator () (double x);  //!< record the value
 // Stat &operator = (Stat &x);  // TODO: copy semantics
-// Stat &operator += (Stat &x); // sum two statistics + template operator +
+  Stat &operator += (const Stat &x); //!< add records of other statistics
   virtual void Output() const override;  //!< print statistics
   unsigned long Number() const { return n; }
   double Min() const           { /* TODO: test n==0 */ return min; }
@@ -583,6 +882,8 @@ class Stat : public SimObject {
   double SumSquare() const     { return sx2; }
   double MeanValue() const;
   double StdDev() const;
+  friend class ReplicationStat;
+  friend class Checkpoint;
 };
 
 
@@ -602,6 +903,7 @@ class TStat : public SimObject {
   friend class Facility; // needs to correct n -- TODO: remove
   friend class Store;
   friend class Queue;
+  friend class Checkpoint;
  public:
   explicit TStat(double initval=0.0);
   explicit TStat(const char *name, double initval=0.0);
@@ -681,11 +983,37 @@ class List : public Link { // circular list of Link items
 ////////////////////////////////////////////////////////////////////////////
 //! priority queue
 //
+// Queue sorted by priority has index of runs of entities with equal
+// priority (the last entity of each run), priority insert finds its
+// position in O(log k) and updates the index in O(k), k is the number
+// of distinct priorities in queue (k <= 256). The index is dropped if
+// an entity is inserted out of order, till the entity leaves the queue.
+//
 //! \ingroup simlib
 class Queue : public List { // don't inherit interface for now
 //TODO:remove
     friend class Facility;
     friend class Store;
+    friend class EntityPriority;        // KeyChanged()
+    //! ordering of entities in queue
+    enum { EMPTY, PRIORITY_KEY, SERVICE_KEY };
+    struct Run {                        // entities with equal key
+        long key;
+        Entity *last;                   // last entity of run
+        unsigned count;
+    };
+    std::vector<Run> runs;              // descending keys
+    unsigned indexed;                   // number of entities in index
+    unsigned char keys;                 // ordering of entities
+    Entity *unsorted;                   // out of order entity (no index)
+    long Key(Entity *e) const;
+    void Rebuild();
+    bool Find(Entity *e, unsigned char k, iterator &pos);
+    std::vector<Run>::iterator FindRun(long key);
+    void IndexIn(Entity *e);
+    void IndexOut(Entity *e, iterator pred);
+  protected:
+    virtual void KeyChanged(Entity *e); // priority of entity changed
   public:
     typedef List::iterator iterator;
     TStat StatN;
@@ -742,10 +1070,79 @@ class Histogram : public SimObject {
   double Step() const    { return step; }
   unsigned Count() const { return count; }
   unsigned operator [](unsigned i) const;  // # of items in interval[i]
+  Histogram &operator += (const Histogram &x); //!< add counts (same intervals)
+  friend class ReplicationStat;
+  friend class Checkpoint;
+};
+
+
+////////////////////////////////////////////////////////////////////////////
+//! results of independent replications (see RunReplications)
+//! <br> records single value per replication (value, mean of Stat,
+//! TStat or Histogram), merges records of Stat and Histogram,
+//! prints mean value with confidence interval
+//! \ingroup simlib
+class ReplicationStat : public SimObject {
+  Stat values;               // single value per replication
+  Stat pooled;               // merged Stat/Histogram records
+  Histogram *histo;          // merged histogram (if any)
+  void _Record(int kind, const double *data, unsigned n);
+ public:
+  ReplicationStat();
+  explicit ReplicationStat(const char *name);
+  ~ReplicationStat();
+  virtual void Clear();                 //!< initialize
+  virtual void Output() const override; //!< print statistics
+  void operator () (double x);          //!< record result of replication
+  void operator () (const Stat &s);     //!< record mean value, merge records
+  void operator () (const TStat &s);    //!< record time average
+  void operator () (const Histogram &h);//!< record mean value, merge counts
+  unsigned long Number() const { return values.Number(); }
+  double MeanValue() const     { return values.MeanValue(); }
+  double StdDev() const        { return values.StdDev(); }
+  double HalfWidth(double level=0.95) const; //!< confidence interval
+  const Stat &Values() const   { return values; }
+  const Stat &Pooled() const   { return pooled; }
+  const Histogram *PooledHistogram() const { return histo; }
+  void _Apply(int kind, const double *data); // internal use only
 };
 
 
 
+////////////////////////////////////////////////////////////////////////////
+//! logical process for conservative parallel simulation (see RunParallel)
+//! <br> each logical process has own thread and simulation context
+//! (calendar, time, random stream), model objects are created by setup
+//! function in that thread. New entities are passed to other logical
+//! process by Send(), not earlier than Time+lookahead of the sender.
+//! \ingroup simlib
+class LogicalProcess : public SimObject {
+  struct Message { double time; Entity *entity; };
+  double lookahead;             // min. delay of messages sent by this LP
+  void (*setup)();              // model initialization
+  void (*finish)();             // results (called in order of LPs)
+  unsigned index;               // position in list of LPs
+  double next;                  // next event time (for synchronization)
+  bool done;                    // simulation run finished
+  unsigned long windows;        // number of time windows
+  unsigned long messages;       // number of received messages
+  std::vector< std::vector<Message> > out; // messages for each LP
+  void _Thread(double t0, double t1, RandomStream base);
+  double _Synchronize();
+  friend class LP_Sync;
+  friend struct LP_State;
+  friend void RunParallel(double t0, double t1, bool sequential);
+ public:
+  LogicalProcess(const char *name, double lookahead,
+                 void (*setup)(), void (*finish)()=0);
+  ~LogicalProcess();
+  virtual void Output() const override;  //!< print statistics
+  double Lookahead() const { return lookahead; }
+  //! activate new entity (Event or Process not started yet) in this LP
+  void Send(Entity *e, double t);
+};
+
+
 ////////////////////////////////////////////////////////////////////////////
 //! (SOL-like) facility
 //! Facility with exclusive access and service priority
@@ -776,6 +1173,56 @@ class Facility : public SimObject {
   virtual void Clear();                          //!< initialize
  protected:
   virtual void QueueIn2(Entity *e);              // go into Q2
+  friend class Checkpoint;
+};
+
+////////////////////////////////////////////////////////////////////////////
+//! pool of identical facilities (multi-server station) with single
+//! input queue, replaces array of Facility objects
+//! <br> Idle server with the lowest number is seized (bitmap search),
+//! release passes the server to the first entity in queue. There are no
+//! service priorities (interrupts). Statistics: number of busy servers
+//! and utilization of each server.
+//! \ingroup simlib
+class FacilityPool : public SimObject {
+  unsigned char _Qflag;         //!< true if pool is owner of input queue
+  struct ServerData {           // server data and statistics
+    Entity *in;                 // entity in service or nullptr
+    unsigned long n;            // number of requests
+    double busy;                // total time of finished services
+    double start;               // start of current service
+  };
+  std::vector<ServerData> servers;
+  std::vector<unsigned long> idle; // bitmap of idle servers
+  unsigned nbusy;               // number of busy servers
+  unsigned FirstIdle() const;
+  void Start(unsigned i, Entity *e);
+ protected:
+  Queue *Q;                     //!< input queue
+  TStat tstat;                  //!< number of busy servers
+ public:
+  explicit FacilityPool(unsigned n);
+  FacilityPool(const char *_name, unsigned n);
+  FacilityPool(const char *_name, unsigned n, Queue *queue);
+  virtual ~FacilityPool();
+  virtual void Output() const override;                 //!< print statistics
+  operator FacilityPool* () { return this; }
+  void SetQueue(Queue *queue);                          //!< change input queue
+  bool OwnQueue() const;                                //!< test for default queue
+  unsigned Servers() const { return servers.size(); }   //!< number of servers
+  unsigned Busy() const { return nbusy; }               //!< busy servers
+  bool Full() const { return nbusy == servers.size(); } //!< no idle server
+  Entity *In(unsigned i) const;                 //!< entity at server i or nullptr
+  int Server(Entity *e) const;                  //!< server of entity or -1
+  unsigned long Requests(unsigned i) const;     //!< served requests of server i
+  double Utilization(unsigned i) const;         //!< utilization of server i
+  double Utilization() const;                   //!< mean utilization of servers
+  unsigned QueueLen() const { return Q->size(); }
+  virtual void Seize(Entity *e);                //!< seize idle server or wait
+  virtual void Release(Entity *e);              //!< release server of entity
+  virtual void QueueIn(Entity *e);              //!< go into input queue
+  virtual void Clear();                         //!< initialize
+  friend class Checkpoint;
 };
 
 ////////////////////////////////////////////////////////////////////////////
@@ -784,6 +1231,7 @@ class Facility : public SimObject {
 //! \ingroup simlib
 class Store : public SimObject {
   unsigned char _Qflag;         //!< true if store is owner of input queue
+  class IndexedQueue;           //!< own input queue (see store.cc)
  protected:
   unsigned long capacity;       //!< Capacity of store
   unsigned long used;           //!< Currently used capacity
@@ -811,7 +1259,65 @@ class Store : public SimObject {
   virtual void Leave(unsigned long rcap);               //!< deallocate capacity
   virtual void QueueIn(Entity *e, unsigned long c);     //!< insert entity into queue
   virtual void Clear();                                 //!< initialize
+  friend class Checkpoint;
+};
+
+
+////////////////////////////////////////////////////////////////////////////
+//! checkpoint file (see SaveCheckpoint, RestoreCheckpoint)
+//! <br> Entity::SaveState() writes data members of entity by Write(),
+//! Entity::RestoreState() reads them in the same order by Read().
+//! References to other entities are written by WriteEntity() (the
+//! referenced entity is saved too) and read by ReadEntity().
+//! \ingroup simlib
+class Checkpoint {
+  struct Data;                  // implementation (checkpoint.cc)
+  Data *data;
+  explicit Checkpoint(Data *d) : data(d) {}
+  Checkpoint(const Checkpoint &) = delete;
+  Checkpoint &operator=(const Checkpoint &) = delete;
+  void SaveEntityData(Entity *e);
+  void RestoreEntityData(Entity *e);
+  void SaveObject(SimObject *o);
+  void RestoreObject(SimObject *o);
+  friend void SaveCheckpoint(const char *, const std::vector<SimObject*> &);
+  friend void RestoreCheckpoint(const char *, const std::vector<SimObject*> &);
+ public:
+  void Write(const void *ptr, size_t size);     //!< write bytes
+  void Read(void *ptr, size_t size);            //!< read bytes
+  //! write value (numbers, structures without pointers)
+  template <class T> void Write(const T &x) {
+    static_assert(std::is_trivially_copyable<T>::value &&
+                  !std::is_pointer<T>::value,
+                  "Checkpoint: use WriteEntity() for pointers");
+    Write(&x, sizeof(x));
+  }
+  //! read value
+  template <class T> void Read(T &x) {
+    static_assert(std::is_trivially_copyable<T>::value &&
+                  !std::is_pointer<T>::value,
+                  "Checkpoint: use ReadEntity() for pointers");
+    Read(&x, sizeof(x));
+  }
+  void Write(const std::string &s);             //!< write string
+  void Read(std::string &s);                    //!< read string
+  void WriteEntity(const Entity *e);            //!< write reference (or nullptr)
+  Entity *ReadEntity();                         //!< read reference
+  //! internal: register entity class (see CHECKPOINT_ENTITY)
+  static void _Register(const std::type_info &type, const char *name,
+                        Entity *(*create)());
+};
+
+//! registration of entity class for RestoreCheckpoint, the class
+//! needs default constructor
+template <class T> struct CheckpointEntity {
+  explicit CheckpointEntity(const char *name) {
+    Checkpoint::_Register(typeid(T), name, []() -> Entity* { return new T; });
+  }
 };
+//! register entity class T (use at global scope)
+#define CHECKPOINT_ENTITY(T) \
+  static simlib3::CheckpointEntity<T> SIMLIB_checkpoint_entity_##T(#T)
 
 
 ////////////////////////////////////////////////////////////////////////////
@@ -825,6 +1331,11 @@ class Store : public SimObject {
 class aBlock : public SimObject {               // base class
 };
 
+class EvaluationTape;   // compiled continuous model (internal, see tape.cc)
+class LUDecomposition;  // linear equations (internal, see lu.cc)
+//! internal: evaluation tape is valid (cleared by change of connections)
+extern thread_local bool SIMLIB_TapeValid;
+
 ////////////////////////////////////////////////////////////////////////////
 //! abstract base for continuous blocks with single output
 //! suitable for expression-tree building and evaluation
@@ -840,6 +1351,9 @@ class aContiBlock : public aBlock {
     //! get block output value <br>
     //! this method should be defined in classes derived from aContiBlock
     virtual double Value() = 0;
+    //! internal: add block to evaluation tape, returns result slot
+    //! (default: Value() is called)
+    virtual unsigned _Compile(EvaluationTape &t);
 };
 
 ////////////////////////////////////////////////////////////////////////////
@@ -850,6 +1364,7 @@ class Constant : public aContiBlock {
  public:
   explicit Constant(double x) : value(x) {}
   virtual double Value ()  override      { return value; }
+  virtual unsigned _Compile(EvaluationTape &t) override;
 };
 
 ////////////////////////////////////////////////////////////////////////////
@@ -857,10 +1372,12 @@ class Constant : public aContiBlock {
 //! \ingroup simlib
 class Variable : public aContiBlock {
   double value;
+  friend class Ensemble;
  public:
   explicit Variable(double x=0) : value(x) {}
   Variable &operator= (double x)  { value = x; return *this; }
   virtual double Value ()  override        { return value; }
+  virtual unsigned _Compile(EvaluationTape &t) override;
 };
 
 ////////////////////////////////////////////////////////////////////////////
@@ -868,10 +1385,12 @@ class Variable : public aContiBlock {
 //! \ingroup simlib
 class Parameter : public aContiBlock {
   double value;
+  friend class Ensemble;
  public:
   explicit Parameter(double x) : value(x) {}
   Parameter &operator= (double x) { value = x; return *this; }
   virtual double Value ()  override        { return value; }
+  virtual unsigned _Compile(EvaluationTape &t) override;
 };
 
 
@@ -895,6 +1414,7 @@ class Parameter : public aContiBlock {
 class Input {
   aContiBlock *bp;
   Input() = delete; // disable default constructor
+  friend class EvaluationTape;
  public:
   //! transparent copy of block reference
   Input(const Input &i): bp(i.bp) { RegisterReference(bp); }
@@ -916,6 +1436,7 @@ class Input {
       bp=i.bp;
       RegisterReference(bp);
       // TODO: LoopCheck();
+      SIMLIB_TapeValid = false;
       return p; // returns old value
   }
 
@@ -925,6 +1446,7 @@ class Input {
       bp = x.bp;
       RegisterReference(bp);
       // TODO: LoopCheck();
+      SIMLIB_TapeValid = false;
       return *this;
   }
 
@@ -939,6 +1461,7 @@ class Input {
 //! \ingroup simlib
 class aContiBlock1 : public aContiBlock {
   Input input;
+  friend class EvaluationTape;
  public:
   explicit aContiBlock1(Input i);
   double InputValue() { return input.Value(); }
@@ -951,6 +1474,7 @@ class aContiBlock1 : public aContiBlock {
 struct Expression : public aContiBlock1 {
   explicit Expression(Input i) : aContiBlock1(i) {}
   double Value() override;       //!< Evaluate expression and return the value
+  unsigned _Compile(EvaluationTape &t) override;
 };
 
 ////////////////////////////////////////////////////////////////////////////
@@ -959,6 +1483,7 @@ struct Expression : public aContiBlock1 {
 class aContiBlock2 : public aContiBlock {
   Input input1;
   Input input2;
+  friend class EvaluationTape;
  public:
   aContiBlock2(Input i1, Input i2);
   double Input1Value() { return input1.Value(); }
@@ -985,7 +1510,10 @@ class aContiBlock3 : public aContiBlock {
 //TODO: move to implementation header
 class IntegratorContainer {
 private:
-  static std::list<Integrator*> * ListPtr;  // list of integrators
+  static thread_local std::list<Integrator*> * ListPtr;  // list of integrators
+  // values of integrators in contiguous arrays (index = order in list)
+  struct Arrays { std::vector<double> s, sl, d, dl; };
+  static thread_local Arrays *ArraysPtr;
   IntegratorContainer();  // forbid constructor
   static std::list<Integrator*> * Instance(void);  // return list (& create)
 public:
@@ -1012,6 +1540,11 @@ public:
   static void EvaluateAll();       // evaluate all integrators
   static void LtoN();              // last -> now
   static void NtoL();              // now -> last
+  // arrays of states and derivatives (used by integration methods)
+  static double *State(void)    { return ArraysPtr->s.data(); }
+  static double *OldState(void) { return ArraysPtr->sl.data(); }
+  static double *Diff(void)     { return ArraysPtr->d.data(); }
+  static double *OldDiff(void)  { return ArraysPtr->dl.data(); }
 }; // class IntegratorContainer
 
 
@@ -1020,7 +1553,7 @@ public:
 //TODO: move to implementation header
 class StatusContainer {
 private:
-  static std::list<Status*>* ListPtr;  // list of integrators
+  static thread_local std::list<Status*>* ListPtr;  // list of integrators
   StatusContainer();  // forbid constructor
   static std::list<Status*>* Instance(void);  // return list (& create)
 public:
@@ -1059,8 +1592,8 @@ class IntegrationMethod {
     IntegrationMethod(const IntegrationMethod&) = delete;
     IntegrationMethod&operator=(const IntegrationMethod&) = delete;
 private:
-  static IntegrationMethod* CurrentMethodPtr;  // method used at present
-  static std::list<IntegrationMethod*>* MthLstPtr; // list of registrated methods
+  static thread_local IntegrationMethod* CurrentMethodPtr;  // method used at present
+  static thread_local std::list<IntegrationMethod*>* MthLstPtr; // list of registrated methods
   std::list<IntegrationMethod*>::iterator ItList;  // position in the list
   const char* method_name;  // C-string --- the name of the method
 protected:  //## repair
@@ -1069,14 +1602,16 @@ protected:  //## repair
 private:   //## repair
   size_t PrevINum;  // # of integrators in previous step
   std::list<Memory*> MList;  // list of auxiliary memories
-  static std::list<Memory*> * PtrMList;  // pointer to list being filled
+  static thread_local std::list<Memory*> * PtrMList;  // pointer to list being filled
   IntegrationMethod();  // forbid implicit constructor
   IntegrationMethod(IntegrationMethod&);  // forbid implicit copy-constructor
   static bool Prepare(void);  // prepare system for integration step
   static void Iterate(void);  // compute new values of state blocks
   static void Summarize(void);  // set up new state after integration
+  static void DenseEvents(void);  // samplers inside the step, end at event
 protected:
-  static bool IsEndStepEvent; // flag - will be event at the end of the step?
+  static thread_local bool IsEndStepEvent; // flag - will be event at the end of the step?
+  static thread_local double EndStepTime;  // time of the event at the end of the step
   typedef IntegratorContainer::iterator Iterator;  // iterator of intg. list
   static Iterator FirstIntegrator(void) {  // it. to first integrator in list
     return IntegratorContainer::Begin();
@@ -1106,6 +1641,7 @@ protected:
         //         (long unsigned)ind, arr[ind]));
         return arr[ind];
       }
+      double *Data(void) { return arr; }  // the array (for vector kernels)
       virtual void Resize(size_t cs); // change size, content will be undefined!
   }; // class Memory
 
@@ -1117,6 +1653,10 @@ public:
   virtual void Integrate(void) = 0;  // the method does integration
   virtual bool PrepareStep(void);  // prepare object for integration step
   virtual void Resize(size_t size);  // resize all memories to given size
+  virtual bool HasDenseOutput(void) { return false; } // can interpolate step?
+  // state of integrators in time t inside of the last step (if possible)
+  virtual bool DenseOutput(double t, double *y) { (void)t; (void)y; return false; }
+  static bool Interpolate(double t, double *y);  // dense output of current method
   static void StepSim(void);  // single step of numerical integration method
   static void IntegrationDone(void) {  // terminate integration
     CurrentMethodPtr->TurnOff();  // suspend present method
@@ -1188,7 +1728,7 @@ private:
   StatusMethod(const StatusMethod&) = delete;
   size_t PrevStatusNum;  // # of status variables in previous step
   std::list<Memory*> StatusMList;  // list of auxiliary memories
-  static std::list<Memory*>* PtrStatusMList;  // pointer to list being filled
+  static thread_local std::list<Memory*>* PtrStatusMList;  // pointer to list being filled
 protected:
   typedef StatusContainer::iterator StatusIterator;  // iterator of intg. list
   static StatusIterator FirstStatus(void) {  // it. to first status in list
@@ -1237,7 +1777,10 @@ public:
 //
 
 //! select the integration method
-//! @param name  "abm4", "euler", "fw", "rke"(default), "rkf3", "rkf5", "rkf8"
+//! @param name  "abm4", "bdf", "dopri5", "euler", "fw", "rke"(default),
+//!               "rkf3", "rkf5", "rkf8", "ros4" ("bdf" and "ros4" are for
+//!               stiff systems, "dopri5" interpolates samples and events
+//!               inside of its steps)
 //! \ingroup simlib
 inline void SetMethod(const char* name)
 {
@@ -1287,10 +1830,12 @@ inline const char* GetStarter(void)
 //! \ingroup simlib
 class Integrator : public aContiBlock {   // integrator
   Integrator &operator= (const Integrator &x) = delete; // disable assignment
-  double dd;                           // input value: y'=f(t,y)
-  double ddl;                          // the same from previous step
-  double ss;                           // status: y = S f(t,y) dt
-  double ssl;                          // the same from previous step
+  // input value y'=f(t,y), status y = S f(t,y) dt and the same from
+  // previous step are in IntegratorContainer arrays
+  std::size_t index;                   // position in arrays
+  friend class EvaluationTape;
+  friend class IntegratorContainer;
+  friend class Ensemble;
  protected:
   Input input;                         //!< input expression: f(t,y)
   double initval;                      //!< initial value: y(t0)
@@ -1311,20 +1856,21 @@ class Integrator : public aContiBlock {   // integrator
   Input SetInput(Input inp) { return input.Set(inp); }
   void Eval() override;                         // integrator input evaluation
   double Value() override;                      //!< the state of integrator
+  unsigned _Compile(EvaluationTape &t) override;
   double InputValue() { return input.Value(); } //!< current input value
   //virtual const char *Name() const;
 
   // private interface
-  void Save(void) { ddl=dd; ssl=ss; }     // save status
-  void Restore(void) { dd=ddl; ss=ssl; }  // restore saved status
-  void SetState(double s) { ss=s; }
-  double GetState(void) { return ss; }
-  void SetOldState(double s) { ssl=s; }
-  double GetOldState(void) { return ssl; }
-  void SetDiff(double d) { dd=d; }
-  double GetDiff(void) { return dd; }
-  void SetOldDiff(double d) { ddl=d; }
-  double GetOldDiff(void) { return ddl; }
+  void Save(void) { SetOldDiff(GetDiff()); SetOldState(GetState()); }
+  void Restore(void) { SetDiff(GetOldDiff()); SetState(GetOldState()); }
+  void SetState(double s) { IntegratorContainer::State()[index] = s; }
+  double GetState(void) { return IntegratorContainer::State()[index]; }
+  void SetOldState(double s) { IntegratorContainer::OldState()[index] = s; }
+  double GetOldState(void) { return IntegratorContainer::OldState()[index]; }
+  void SetDiff(double d) { IntegratorContainer::Diff()[index] = d; }
+  double GetDiff(void) { return IntegratorContainer::Diff()[index]; }
+  void SetOldDiff(double d) { IntegratorContainer::OldDiff()[index] = d; }
+  double GetOldDiff(void) { return IntegratorContainer::OldDiff()[index]; }
 };
 
 
@@ -1455,6 +2001,7 @@ class Function1 : public aContiBlock1 {
  public:
   Function1(Input i, double (*pf)(double));
   virtual double Value() override;
+  virtual unsigned _Compile(EvaluationTape &t) override;
   //virtual const char *Name() const;
 };
 
@@ -1469,6 +2016,7 @@ class Function2 : public aContiBlock2 {
  public:
   Function2(Input i1, Input i2, double (*pf)(double,double));
   virtual double Value() override;
+  virtual unsigned _Compile(EvaluationTape &t) override;
   //virtual const char *Name() const;
 };
 
@@ -1482,7 +2030,7 @@ class Function2 : public aContiBlock2 {
 //! changes its boolean value
 //! \ingroup simlib
 class aCondition : public aBlock {
-  static aCondition *First;            // list of all state conditions
+  static thread_local aCondition *First; // list of all state conditions
   aCondition *Next;                    // next condition in list
   void operator= (const aCondition&) = delete;
   aCondition(const aCondition&) = delete;
@@ -1494,11 +2042,14 @@ class aCondition : public aBlock {
   static void TestAll();
   static void AllActions();
   static bool isAny();
+  static bool Locate(double &t);       // time of first change in step
  private:
   virtual void Init()=0;               //!< initialize
   virtual void SetNewStatus()=0;       //!< update
   virtual bool Test()=0;               //!< test of the condition
   virtual void Action()=0;             //!< state event description
+  virtual bool Changed() { return false; } //!< changed in this step
+  virtual double Function() { return 0; }  //!< crossing function (>=0)
 };
 
 ////////////////////////////////////////////////////////////////////////////
@@ -1509,6 +2060,8 @@ class Condition : public aCondition {  // state condition
   unsigned char ccl;                   //!< old state
   virtual void Init() override;
   virtual void SetNewStatus() override;
+  virtual bool Changed() override { return Change(); }
+  virtual double Function() override { return in.Value(); }
  protected:
   virtual bool Test() override;         // test function (input >= 0.0)
   bool Up()     { return ccl<cc; }      // change: FALSE->TRUE
@@ -1726,6 +2279,101 @@ class Newton : public AlgLoop {
 };
 
 
+class LoopVariable;
+
+////////////////////////////////////////////////////////////////////////////
+//! system of coupled algebraic loops solved by Newton's method
+//! all loop variables (LoopVariable) are solved together, the Jacobian is
+//! computed by forward mode differentiation of the compiled inputs
+//! (differences if the inputs contain blocks evaluated by Value()),
+//! the iteration starts from the last solution
+//
+//! \ingroup simlib
+class AlgLoopSystem {
+  AlgLoopSystem(const AlgLoopSystem &) = delete;
+  AlgLoopSystem &operator= (const AlgLoopSystem &) = delete;
+  std::vector<LoopVariable *> var;     // loop variables
+  std::vector<double> x;               // solution (current guess)
+  std::vector<double> g, dx, x0, J;    // inputs, step, Jacobian dg/dx
+  EvaluationTape *tape;                // compiled inputs of variables
+  LUDecomposition *lu;                 // iteration matrix I - dg/dx
+  unsigned long built;                 // version of integrator tape
+  bool compiled;                       // tape is valid
+  bool compiling;                      // variables are compiled as leaves
+  bool solving;                        // variables return current guess
+  double Eps;                          // required accuracy
+  unsigned long MaxIt;                 // max. number of iterations
+  unsigned long iterations;            // statistics
+  friend class LoopVariable;
+  void Compile();                      // compile inputs of variables
+  double Residual();                   // evaluate inputs, max |x-g(x)|
+  void Linearize();                    // Jacobian dg/dx
+  void Solve();
+ public:
+  explicit AlgLoopSystem(double eps=1e-10, unsigned long max_it=100);
+  ~AlgLoopSystem();
+  void Set(double eps, unsigned long max_it); // set parameters
+  //! total number of Newton iterations
+  unsigned long Iterations() const { return iterations; }
+};
+
+
+////////////////////////////////////////////////////////////////////////////
+//! variable of algebraic loop system: output is solution of equation
+//! output = input, where input depends on variables of the same system
+//
+//! \ingroup simlib
+class LoopVariable : public aContiBlock {
+  LoopVariable &operator= (const LoopVariable &) = delete;
+  AlgLoopSystem &system;               // owner
+  std::size_t index;                   // position in system
+  Input input;                         // equation: x = input(x)
+  friend class AlgLoopSystem;
+ public:
+  LoopVariable(AlgLoopSystem &s, double x0=0);  // input = 0 (see SetInput)
+  LoopVariable(AlgLoopSystem &s, Input i, double x0=0);
+  ~LoopVariable();
+  //! set input block expression
+  Input SetInput(Input inp) { return input.Set(inp); }
+  double Value() override;             //!< solution of the system
+  unsigned _Compile(EvaluationTape &t) override;
+};
+
+
+////////////////////////////////////////////////////////////////////////////
+//! ensemble of continuous model with different parameters
+//! integrates the model (all Integrators) for many members: each member
+//! has own values of selected Parameter/Variable blocks and initial
+//! values. The compiled model is evaluated for groups of members at once
+//! (lanes of vector instructions), members of group share the step of
+//! Dormand-Prince 5(4) method, groups run in parallel threads.
+//! Only continuous models with compiled inputs (no user blocks evaluated
+//! by Value()), no events and state conditions in Ensemble::Run.
+//! Accuracy and step limits are taken from SetAccuracy and SetStep.
+//
+//! \ingroup simlib
+class Ensemble {
+  Ensemble(const Ensemble &) = delete;
+  Ensemble &operator= (const Ensemble &) = delete;
+  struct Data;                         // implementation (ensemble.cc)
+  Data *data;
+  double *Member(const double *p, unsigned member);
+ public:
+  explicit Ensemble(unsigned members, unsigned lanes=8);
+  ~Ensemble();
+  unsigned Size() const;               //!< number of members
+  //! set parameter value of member (default: current value of block)
+  void Set(Parameter &p, unsigned member, double value);
+  void Set(Variable &v, unsigned member, double value);
+  //! set initial value of integrator for member (default: initial value)
+  void Init(Integrator &i, unsigned member, double value);
+  void Init(double t0);                //!< compile model, initial state
+  void Run(double t1, unsigned threads=0); //!< integrate all members to t1
+  double Value(Integrator &i, unsigned member) const; //!< state of member
+  unsigned long Steps() const;         //!< number of steps (all groups)
+};
+
+
 ////////////////////////////////////////////////////////////////////////////
 // CATEGORY: global functions
 
@@ -1744,8 +2392,9 @@ std::string GetName(SimObject *o);
 
 ////////////////////////////////////////////////////////////////////////////
 //! InstallBreak --- set function for checking if user breaks simulation
-//! @param f is called at each step of simulation
+//! @param f is called after each event and each step of simulation
 //!        f can call Stop() or Abort()
+//! \sa OnSignal (no per-event cost)
 //! \ingroup simlib
 void InstallBreak(void (*f)());
 
@@ -1814,7 +2463,7 @@ struct SIMLIB_statistics_t {
 };
 
 //! interface to internal run-time statistics structure
-extern const SIMLIB_statistics_t & SIMLIB_statistics;
+extern thread_local const SIMLIB_statistics_t & SIMLIB_statistics;
 
 } // namespace simlib3
 
@@ -82,6 +82,23 @@ void Stat::Clear()
 }
 
 
+////////////////////////////////////////////////////////////////////////////
+// Stat::operator += --- add records of other statistics
+//
+Stat &Stat::operator += (const Stat &x)
+{
+  if(x.n==0) return *this;
+  if(n==0) { min = x.min; max = x.max; }
+  else {
+    if(x.min<min) min = x.min;
+    if(x.max>max) max = x.max;
+  }
+  sx  += x.sx;
+  sx2 += x.sx2;
+  n   += x.n;
+  return *this;
+}
+
 ////////////////////////////////////////////////////////////////////////////
 //  Stat::MeanValue
 //
@@ -0,0 +1,161 @@
+/////////////////////////////////////////////////////////////////////////////
+//! \file stepproc.cc  Stackless processes (resumable steps)
+//
+// Copyright (c) 1991-2018 Petr Peringer
+//
+// This library is licensed under GNU Library GPL. See the file COPYING.
+//
+
+//
+// StepProcess is Event with saved resume point. Behavior() is written
+// using STEP_* macros (switch-based continuation, see simlib.h).
+// Blocking operations use the same Facility/Store/Queue interface as
+// class Process, the entity is suspended if it is linked in a queue
+// after the operation. No stack is saved or copied.
+//
+
+////////////////////////////////////////////////////////////////////////////
+// interface
+//
+
+#include "simlib.h"
+#include "internal.h"
+
+////////////////////////////////////////////////////////////////////////////
+// implementation
+//
+
+namespace simlib3 {
+
+SIMLIB_IMPLEMENTATION;
+
+////////////////////////////////////////////////////////////////////////////
+/// constructor, behavior starts at the beginning
+StepProcess::StepProcess(Priority_t p) : Event(p), _step(0)
+{
+  Dprintf(("StepProcess::StepProcess(%d)", p));
+}
+
+////////////////////////////////////////////////////////////////////////////
+/// destructor, removes process from queue/calendar
+StepProcess::~StepProcess()
+{
+  Dprintf(("StepProcess::~StepProcess()"));
+  _step = STEP_FINISHED;
+  if(Where() != 0)      // if waiting in queue
+      Out();            // remove from queue, no warning
+  if(!Idle())           // if scheduled
+      SQS::Get(this);   // remove from calendar
+}
+
+////////////////////////////////////////////////////////////////////////////
+/// get name of process. It is generic "StepProcess#" if not explicitly named
+std::string StepProcess::Name() const
+{
+    const std::string name = SimObject::Name();
+    if(!name.empty())   return name; // has explicit name
+    else                return SIMLIB_create_tmp_name("StepProcess#%lu", _Ident);
+}
+
+////////////////////////////////////////////////////////////////////////////
+/// activation method, called from simulation control algorithm
+/// Behavior() continues from the saved resume point
+void StepProcess::_Run() noexcept
+{
+  Dprintf(("StepProcess#%lu._Run() step=%u", _Ident, _step));
+  if(_step == STEP_FINISHED)
+      SIMLIB_error(ProcessNotInitialized);
+  Behavior();
+  if(_step == STEP_FINISHED) {  // end of behavior
+      Terminate();
+      if(isAllocated())
+          delete this;          // it is not used by dispatcher any more
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////
+/// Terminate the process
+/// if called by other entity, the allocated process is destroyed
+void StepProcess::Terminate()
+{
+  Dprintf(("StepProcess#%lu.Terminate()", _Ident));
+  _step = STEP_FINISHED;
+  if(Where() != 0)      // Entity linked in queue
+      Out();            // remove from queue, no warning
+  if(!Idle())
+      SQS::Get(this);   // remove from calendar
+  if(isAllocated() && this != SIMLIB_Current)
+      delete this;      // Remove passive process
+}
+
+////////////////////////////////////////////////////////////////////////////
+/// Wait for dtime interval, always suspends
+bool StepProcess::Wait(double dtime)
+{
+  Dprintf(("StepProcess#%lu.Wait(%g)", _Ident, dtime));
+  Entity::Activate(double (Time) + dtime);    // scheduling
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////
+/// Seize facility f with optional priority of service sp
+/// returns true if waiting in input queue
+bool StepProcess::Seize(Facility & f, ServicePriority_t sp /* = 0 */ )
+{
+  f.Seize(this, sp);    // polymorphic interface
+  return Where() != 0;  // waiting, activated by Release()
+}
+
+////////////////////////////////////////////////////////////////////////////
+/// Release facility f
+void StepProcess::Release(Facility & f)
+{
+  f.Release(this);      // polymorphic interface
+}
+
+////////////////////////////////////////////////////////////////////////////
+/// Seize idle server of pool p
+/// returns true if waiting in input queue
+bool StepProcess::Seize(FacilityPool & p)
+{
+  p.Seize(this);        // polymorphic interface
+  return Where() != 0;  // waiting, activated by Release()
+}
+
+////////////////////////////////////////////////////////////////////////////
+/// Release server of pool p
+void StepProcess::Release(FacilityPool & p)
+{
+  p.Release(this);      // polymorphic interface
+}
+
+////////////////////////////////////////////////////////////////////////////
+/// Enter - use cap capacity of store s
+/// returns true if waiting in input queue
+bool StepProcess::Enter(Store & s, unsigned long cap)
+{
+  s.Enter(this, cap);   // polymorphic interface
+  return Where() != 0;  // waiting, activated by Leave()
+}
+
+////////////////////////////////////////////////////////////////////////////
+/// Leave - return cap capacity of store s
+void StepProcess::Leave(Store & s, unsigned long cap)
+{
+  s.Leave(cap);         // polymorphic interface
+}
+
+////////////////////////////////////////////////////////////////////////////
+/// insert process into queue
+/// The process can be at most in single queue.
+void StepProcess::Into(Queue & q)
+{
+  if(Where() != 0) {
+      SIMLIB_warning("Process already in (other) queue");
+      Out();            // if already in queue then remove
+  }
+  q.Insert(this);       // polymorphic interface
+}
+
+} // namespace
+
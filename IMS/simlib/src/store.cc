@@ -9,6 +9,15 @@
 //
 //  implementation of store class (SOL-like)
 //
+//  Own input queue of store has index of waiting entities by required
+//  capacity: Leave() looks only at the first entity of each capacity
+//  that fits into free capacity (the first of them in queue order is
+//  allocated, as by the scan of the whole queue). The order of entities
+//  is given by their current priority and position in queue: the index
+//  is rebuilt if priority of waiting entity changes, it is dropped
+//  (scan is used) while the queue is not sorted by priority. External
+//  queue is always scanned.
+//
 
 ////////////////////////////////////////////////////////////////////////////
 //  interface
@@ -18,6 +27,9 @@
 #include "internal.h"
 
 #include <cstdio>
+#include <map>
+#include <set>
+#include <unordered_map>
 
 
 ////////////////////////////////////////////////////////////////////////////
@@ -32,6 +44,98 @@ SIMLIB_IMPLEMENTATION;
 
 #define CHECKQUEUE(qptr) do { if (!qptr) SIMLIB_error(QueueRefError); }while(0)
 
+////////////////////////////////////////////////////////////////////////////
+//  IndexedQueue --- own input queue with index by required capacity
+//
+class Store::IndexedQueue : public Queue {
+  // position in queue: higher priority first, then insertion order
+  typedef std::pair<std::pair<int,unsigned long>, Entity*> Item;
+  std::map<unsigned long, std::set<Item>> waiting; // by capacity
+  std::unordered_map<Entity*, std::pair<Item,unsigned long>> items;
+  unsigned long seq;            // insertion counter
+  bool valid;                   // index can be used
+  Entity *unsorted;             // entity out of order (index dropped)
+  void Add(Entity *e, int prio) {
+    Item i(std::make_pair(-prio, seq++), e);
+    waiting[e->_RequiredCapacity].insert(i);
+    items[e] = std::make_pair(i, e->_RequiredCapacity);
+  }
+  void Reset() {
+    waiting.clear();
+    items.clear();
+    seq = 0;
+    valid = true;
+    unsorted = 0;
+  }
+  void Rebuild() {              // index of current content
+    Reset();
+    int prio = 0;
+    for(iterator p = begin(); p != end(); ++p) {
+      Entity *e = static_cast<Entity*>(*p);
+      if(p != begin() && e->Priority > prio) {
+        valid = false;          // not sorted by priority
+        unsorted = e;
+        return;
+      }
+      prio = e->Priority;
+      Add(e, prio);
+    }
+  }
+ public:
+  IndexedQueue() : Queue("Q") { Reset(); }
+  ~IndexedQueue() { clear(); }
+  virtual void Insert(Entity *e) override {
+    Queue::Insert(e);
+    if(!valid)
+      return;
+    if(items.size() + 1 != size())      // List operations
+      Rebuild();
+    else
+      Add(e, e->Priority);
+  }
+  virtual Entity *Get(iterator pos) override {
+    Entity *e = Queue::Get(pos);
+    if(empty())
+      Reset();
+    else if(!valid) {
+      if(e == unsorted)         // the rest can be sorted
+        Rebuild();
+    }
+    else {
+      auto i = items.find(e);
+      if(i == items.end() || items.size() != size() + 1)
+        Rebuild();
+      else {
+        auto w = waiting.find(i->second.second);
+        w->second.erase(i->second.first);
+        if(w->second.empty())
+          waiting.erase(w);
+        items.erase(i);
+      }
+    }
+    return e;
+  }
+  //! priority of waiting entity changed: index by queue position
+  virtual void KeyChanged(Entity *e) override {
+    Queue::KeyChanged(e);
+    Rebuild();
+  }
+  //! first entity in queue with required capacity <= free, false: scan
+  bool First(unsigned long free, Entity *&first) {
+    if(valid && items.size() != size())
+      Rebuild();
+    if(!valid)
+      return false;
+    const Item *best = 0;
+    for(std::map<unsigned long, std::set<Item>>::iterator w = waiting.begin();
+        w != waiting.end() && w->first <= free; ++w)
+      if(best == 0 || *w->second.begin() < *best)
+        best = &*w->second.begin();
+    first = best ? best->second : 0;
+    return true;
+  }
+};
+
 ////////////////////////////////////////////////////////////////////////////
 //  constructors
 //
@@ -39,7 +143,7 @@ Store::Store() :
   _Qflag(_OWNQ),
   capacity(1L),
   used(0L),
-  Q(new Queue("Q"))
+  Q(new IndexedQueue)
 {
   Dprintf(("Store::Store()"));
 }
@@ -48,7 +152,7 @@ Store::Store(unsigned long _capacity) :
   _Qflag(_OWNQ),
   capacity(_capacity),
   used(0L),
-  Q(new Queue("Q"))
+  Q(new IndexedQueue)
 {
   Dprintf(("Store::Store(%lu)",_capacity));
 }
@@ -57,7 +161,7 @@ Store::Store(const char * name, unsigned long _capacity) :
   _Qflag(_OWNQ),
   capacity(_capacity),
   used(0L),
-  Q(new Queue("Q"))
+  Q(new IndexedQueue)
 {
   Dprintf(("Store::Store(\"%s\",%lu)",name,_capacity));
   ::SetName(this,name);
@@ -144,6 +248,7 @@ void Store::Enter(Entity *e, unsigned long rcap)
   }
   used += rcap;         // allocate capacity
   tstat(used);          // update statistics
+  SIMLIB_TRACE(TRACE_ENTER, this, e, used);
 }
 
 ////////////////////////////////////////////////////////////////////////////
@@ -156,8 +261,26 @@ void Store::Leave(unsigned long rcap)
     SIMLIB_error(LeaveManyError);
   used -= rcap ;           // free capacity
   tstat(used);  tstat.n--; // fix: correction
+  SIMLIB_TRACE(TRACE_LEAVE, this, 0, used);
   if(Q->empty())
     return;
+  Entity *e;
+  if (OwnQueue() &&
+      static_cast<IndexedQueue*>(Q)->First(Free(), e)) { // indexed queue
+    while (e != 0) {
+      e->Out();                      // remove from queue
+      Dprintf(("%s.Enter(%s,%lu) from queue",
+                Name().c_str(), e->Name().c_str(), e->_RequiredCapacity));
+      used += e->_RequiredCapacity;  // allocate capacity
+      tstat(used);                   // update statistics
+      SIMLIB_TRACE(TRACE_ENTER, this, e, used);
+      e->Activate();                 // reactivate now
+      if (Full())
+        break;
+      static_cast<IndexedQueue*>(Q)->First(Free(), e);
+    }
+    return;
+  }
   // satisfy entities waiting in queue (starting from begin)
   Queue::iterator pp = Q->begin();   // first item in queue
   while( pp != Q->end() && !Full() ) {
@@ -170,6 +293,7 @@ void Store::Leave(unsigned long rcap)
                 Name().c_str(), p->Name().c_str(), p->_RequiredCapacity));
       used += p->_RequiredCapacity;  // allocate capacity
       tstat(used);                   // update statistics
+      SIMLIB_TRACE(TRACE_ENTER, this, p, used);
       p->Activate();                 // reactivate now
       // will go to Store::Enter REACTIVATION
   } // while
@@ -0,0 +1,424 @@
+/////////////////////////////////////////////////////////////////////////////
+//! \file tape.cc  Evaluation tape of continuous model
+//
+// Copyright (c) 1991-2018 Petr Peringer
+//
+// This library is licensed under GNU Library GPL. See the file COPYING.
+//
+
+//
+// Inputs of integrators are compiled to flat sequence of instructions
+// (depth-first, inputs before block), each instruction writes single
+// slot. Blocks define _Compile(), default is call of Value() (used for
+// user blocks, Status blocks, algebraic loops, ...). Results of pure
+// blocks (without calls) are reused if the block is shared.
+// The tape is compiled at start of Run() and after change of
+// connections (Input::Set, new or deleted Integrator).
+// Tape without calls can be differentiated (forward mode): each
+// instruction has local partial derivatives, tangents are propagated for
+// each state variable (Jacobian of implicit integration methods).
+// Other tapes (inputs of AlgLoopSystem variables) are compiled again
+// after each Build().
+// Tape without calls can be evaluated for several members of ensemble
+// at once (lanes): slot k of lane l is s[k*w+l], inner loops run over
+// lanes (vectorized).
+//
+
+////////////////////////////////////////////////////////////////////////////
+// interface
+//
+
+#include "simlib.h"
+#include "internal.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <typeinfo>
+
+////////////////////////////////////////////////////////////////////////////
+// implementation
+//
+
+namespace simlib3 {
+
+SIMLIB_IMPLEMENTATION;
+
+thread_local bool SIMLIB_TapeValid = false;
+thread_local EvaluationTape *EvaluationTape::instance = 0;
+thread_local unsigned long EvaluationTape::builds = 0;
+
+////////////////////////////////////////////////////////////////////////////
+// new slot
+//
+unsigned EvaluationTape::Slot(bool p)
+{
+  slot.push_back(0);
+  pure.push_back(p);
+  return slot.size() - 1;
+}
+
+EvaluationTape::Instruction &EvaluationTape::Emit(Op op, unsigned r)
+{
+  Instruction i;
+  i.op = op;
+  i.r = r;
+  i.a = i.b = 0;
+  i.p = 0;
+  if(op == CALL || op == EVAL)
+    linear = false;             // value of block can not be differentiated
+  code.push_back(i);
+  return code.back();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Compile --- compile block output, algebraic loop is error
+//
+unsigned EvaluationTape::Compile(aContiBlock *b)
+{
+  auto i = done.find(b);
+  if(i != done.end())
+    return i->second;
+  if(b->TestAndSetFlag(true, SimObject::_EVAL_FLAG))   // in progress
+    SIMLIB_error(AlgLoopDetected);
+  unsigned r = b->_Compile(*this);
+  b->TestAndSetFlag(false, SimObject::_EVAL_FLAG);
+  if(pure[r])
+    done[b] = r;
+  return r;
+}
+
+unsigned EvaluationTape::Const(double x)
+{
+  unsigned r = Slot(true);
+  slot[r] = x;
+  return r;
+}
+
+unsigned EvaluationTape::Load(const double *p)
+{
+  unsigned r = Slot(true);
+  Emit(LOAD, r).p = p;
+  return r;
+}
+
+unsigned EvaluationTape::Call(aContiBlock *b)
+{
+  unsigned r = Slot(false);
+  Emit(CALL, r).block = b;
+  return r;
+}
+
+unsigned EvaluationTape::Unary(Op op, aContiBlock1 *b)
+{
+  unsigned a = Compile(b->input);
+  unsigned r = Slot(pure[a]);
+  Emit(op, r).a = a;
+  return r;
+}
+
+unsigned EvaluationTape::Binary(Op op, aContiBlock2 *b)
+{
+  unsigned a = Compile(b->input1);
+  unsigned c = Compile(b->input2);
+  unsigned r = Slot(pure[a] && pure[c]);
+  Instruction &i = Emit(op, r);
+  i.a = a;
+  i.b = c;
+  return r;
+}
+
+unsigned EvaluationTape::Function(double (*f)(double), aContiBlock1 *b)
+{
+  unsigned a = Compile(b->input);
+  unsigned r = Slot(pure[a]);
+  Instruction &i = Emit(FUN1, r);
+  i.a = a;
+  i.f1 = f;
+  return r;
+}
+
+unsigned EvaluationTape::Function(double (*f)(double, double), aContiBlock2 *b)
+{
+  unsigned a = Compile(b->input1);
+  unsigned c = Compile(b->input2);
+  unsigned r = Slot(pure[a] && pure[c]);
+  Instruction &i = Emit(FUN2, r);
+  i.a = a;
+  i.b = c;
+  i.f2 = f;
+  return r;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Clear --- start new tape
+//
+void EvaluationTape::Clear()
+{
+  code.clear();
+  slot.clear();
+  pure.clear();
+  done.clear();
+  linear = true;
+  lanes = 0;
+}
+
+void EvaluationTape::Store(unsigned a, double *q)
+{
+  Emit(STORE, 0).q = q;
+  code.back().a = a;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Build --- compile inputs of all integrators
+//
+void EvaluationTape::Build()
+{
+  Dprintf(("EvaluationTape::Build()"));
+  Clear();
+  IntegratorContainer::iterator i, end = IntegratorContainer::End();
+  for(i = IntegratorContainer::Begin(); i != end; ++i) {
+    Integrator *p = *i;
+    if(typeid(*p) != typeid(Integrator)) {      // can redefine Eval()
+      Emit(EVAL, 0).integrator = p;
+      continue;
+    }
+    Store(Compile(p->input), &IntegratorContainer::Diff()[p->index]);
+  }
+  done.clear();
+  SIMLIB_TapeValid = true;
+  builds++;
+  Dprintf(("EvaluationTape: %lu instructions, %lu slots",
+           (unsigned long)code.size(), (unsigned long)slot.size()));
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Run --- evaluate all instructions
+//
+void EvaluationTape::Run()
+{
+  double *s = slot.data();
+  for(const Instruction &i : code) {
+    switch(i.op) {
+      case LOAD:  s[i.r] = *i.p;                    break;
+      case CALL:  s[i.r] = i.block->Value();        break;
+      case NEG:   s[i.r] = -s[i.a];                 break;
+      case ADD:   s[i.r] = s[i.a] + s[i.b];         break;
+      case SUB:   s[i.r] = s[i.a] - s[i.b];         break;
+      case MUL:   s[i.r] = s[i.a] * s[i.b];         break;
+      case DIV:   s[i.r] = s[i.a] / s[i.b];         break;
+      case FUN1:  s[i.r] = i.f1(s[i.a]);            break;
+      case FUN2:  s[i.r] = i.f2(s[i.a], s[i.b]);    break;
+      case STORE: *i.q = s[i.a];                    break;
+      case EVAL:  i.integrator->Eval();             break;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Evaluate --- evaluate inputs of all integrators (see SIMLIB_Dynamic)
+//
+void EvaluationTape::Evaluate()
+{
+  if(instance == 0) {
+    instance = new EvaluationTape;
+    SIMLIB_atexit([]{ delete instance; instance = 0; });
+  }
+  if(!SIMLIB_TapeValid)
+    instance->Build();
+  instance->Run();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// derivatives of functions (Function1, Function2), unknown functions are
+// differentiated numerically
+//
+static double Derivative(double (*f)(double), double x)
+{
+  typedef double (*F)(double);
+  if(f == F(sin))   return cos(x);
+  if(f == F(cos))   return -sin(x);
+  if(f == F(tan))   { double t = tan(x); return 1 + t*t; }
+  if(f == F(asin))  return 1 / sqrt(1 - x*x);
+  if(f == F(acos))  return -1 / sqrt(1 - x*x);
+  if(f == F(atan))  return 1 / (1 + x*x);
+  if(f == F(exp))   return exp(x);
+  if(f == F(log))   return 1 / x;
+  if(f == F(log10)) return 1 / (x * log(10.0));
+  if(f == F(sqrt))  return 0.5 / sqrt(x);
+  if(f == F(fabs))  return x > 0 ? 1 : x < 0 ? -1 : 0;
+  double h = std::cbrt(DBL_EPSILON) * max(1.0, fabs(x));
+  double d = (f(x + h) - f(x - h)) / (2*h);
+  if(!std::isfinite(d))                 // domain boundary
+    d = (f(x + h) - f(x)) / h;
+  return d;
+}
+
+static void Derivative(double (*f)(double, double), double x, double y,
+                       double &dx, double &dy)
+{
+  typedef double (*F)(double, double);
+  if(f == F(min))   { dx = x <= y; dy = 1 - dx; return; }
+  if(f == F(max))   { dx = x >= y; dy = 1 - dx; return; }
+  if(f == F(atan2)) {
+    double r = x*x + y*y;
+    dx = y / r;
+    dy = -x / r;
+    return;
+  }
+  if(f == F(pow)) {
+    double r = pow(x, y);
+    dx = y == 0 ? 0 : y * pow(x, y - 1);
+    dy = x > 0 ? r * log(x) : 0;
+    return;
+  }
+  double hx = std::cbrt(DBL_EPSILON) * max(1.0, fabs(x));
+  double hy = std::cbrt(DBL_EPSILON) * max(1.0, fabs(y));
+  dx = (f(x + hx, y) - f(x - hx, y)) / (2*hx);
+  dy = (f(x, y + hy) - f(x, y - hy)) / (2*hy);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Linearize --- Jacobian J[i*n+j] = d(output f[i])/d(variable x[j]) and
+// dfdt[i] = d(output f[i])/dt in current state (after Run)
+//
+bool EvaluationTape::Linearize(const double *x, std::size_t n,
+                               const double *f, double *J, double *dfdt)
+{
+  if(!linear)
+    return false;
+  const double *s = slot.data();
+  const std::size_t m = code.size();
+  const unsigned none = ~0U;
+  da.assign(m, 0);
+  db.assign(m, 0);
+  for(std::size_t k = 0; k < m; k++) {  // local partial derivatives
+    Instruction &i = code[k];
+    switch(i.op) {
+      case LOAD:                        // b = index of variable
+        i.b = (i.p >= x && i.p < x + n) ? unsigned(i.p - x)
+            : (i.p == &SIMLIB_Time)     ? unsigned(n) : none;
+        break;
+      case NEG:   da[k] = -1;                                   break;
+      case ADD:   da[k] = 1;  db[k] = 1;                        break;
+      case SUB:   da[k] = 1;  db[k] = -1;                       break;
+      case MUL:   da[k] = s[i.b];  db[k] = s[i.a];              break;
+      case DIV:   da[k] = 1 / s[i.b];  db[k] = -s[i.r] / s[i.b]; break;
+      case FUN1:  da[k] = Derivative(i.f1, s[i.a]);             break;
+      case FUN2:  Derivative(i.f2, s[i.a], s[i.b], da[k], db[k]); break;
+      default:                                                  break;
+    }
+  }
+  std::fill(J, J + n*n, 0.0);
+  if(dfdt)
+    std::fill(dfdt, dfdt + n, 0.0);
+  ds.assign(slot.size(), 0);
+  double *t = ds.data();
+  const std::size_t columns = dfdt ? n + 1 : n;
+  for(std::size_t c = 0; c < columns; c++) {    // tangents
+    for(std::size_t k = 0; k < m; k++) {
+      const Instruction &i = code[k];
+      switch(i.op) {
+        case LOAD:  t[i.r] = i.b == c;                          break;
+        case NEG:
+        case FUN1:  t[i.r] = da[k] * t[i.a];                    break;
+        case ADD:
+        case SUB:
+        case MUL:
+        case DIV:
+        case FUN2:  t[i.r] = da[k] * t[i.a] + db[k] * t[i.b];   break;
+        case STORE:
+          if(c < n) J[(i.q - f)*n + c] = t[i.a];
+          else      dfdt[i.q - f] = t[i.a];
+          break;
+        default:                                                break;
+      }
+    }
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Jacobian --- derivatives of integrator inputs, false if the model
+// contains blocks without known derivatives (calls of Value())
+//
+bool EvaluationTape::Jacobian(double *J, double *dfdt)
+{
+  Evaluate();                           // values in current state
+  return instance->Linearize(IntegratorContainer::State(),
+                             IntegratorContainer::Size(),
+                             IntegratorContainer::Diff(), J, dfdt);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Bind --- LOAD: b = index of input (nx = Time, ~0 = common value),
+// STORE: b = index of output
+//
+bool EvaluationTape::Bind(const double *const *x, std::size_t nx,
+                          const double *f)
+{
+  if(!linear)
+    return false;
+  std::unordered_map<const double *, unsigned> input;
+  for(std::size_t k = 0; k < nx; k++)
+    input[x[k]] = k;
+  for(Instruction &i : code) {
+    if(i.op == LOAD) {
+      auto p = input.find(i.p);
+      i.b = p != input.end()         ? p->second
+          : (i.p == &SIMLIB_Time)    ? unsigned(nx) : ~0U;
+    } else if(i.op == STORE)
+      i.b = unsigned(i.q - f);
+  }
+  lanes = nx;
+  return true;
+}
+
+void EvaluationTape::InitLanes(std::size_t w, double *s) const
+{
+  for(std::size_t k = 0; k < slot.size(); k++)
+    for(std::size_t l = 0; l < w; l++)
+      s[k*w + l] = slot[k];
+}
+
+////////////////////////////////////////////////////////////////////////////
+// RunLanes --- evaluate lanes: input k of lane l is x[k*w+l], output k
+// of lane l is f[k*w+l], t is common time (after Bind)
+//
+void EvaluationTape::RunLanes(std::size_t w, const double *x, double t,
+                              double *f, double *s) const
+{
+  std::size_t l;
+  for(const Instruction &i : code) {
+    double *r = s + i.r*w;
+    const double *a = s + i.a*w;
+    const double *b = s + (i.op == LOAD || i.op == STORE ? 0 : i.b*w);
+    switch(i.op) {
+      case LOAD:
+        if(i.b < lanes)       for(l=0; l<w; l++) r[l] = x[i.b*w + l];
+        else if(i.b == lanes) for(l=0; l<w; l++) r[l] = t;
+        else                  for(l=0; l<w; l++) r[l] = *i.p;
+        break;
+      case NEG:   for(l=0; l<w; l++) r[l] = -a[l];                 break;
+      case ADD:   for(l=0; l<w; l++) r[l] = a[l] + b[l];           break;
+      case SUB:   for(l=0; l<w; l++) r[l] = a[l] - b[l];           break;
+      case MUL:   for(l=0; l<w; l++) r[l] = a[l] * b[l];           break;
+      case DIV:   for(l=0; l<w; l++) r[l] = a[l] / b[l];           break;
+      case FUN1:  for(l=0; l<w; l++) r[l] = i.f1(a[l]);            break;
+      case FUN2:  for(l=0; l<w; l++) r[l] = i.f2(a[l], b[l]);      break;
+      case STORE: for(l=0; l<w; l++) f[i.b*w + l] = a[l];          break;
+      default:                                                     break;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////
+// _Compile --- default: value of block is computed by Value()
+//
+unsigned aContiBlock::_Compile(EvaluationTape &t)
+{
+  return t.Call(this);
+}
+
+}
+// end
@@ -0,0 +1,391 @@
+/////////////////////////////////////////////////////////////////////////////
+//! \file trace.cc  Binary trace of simulation run, Chrome trace export
+//
+// Copyright (c) 1991-2018 Petr Peringer
+//
+// This library is licensed under GNU Library GPL. See the file COPYING.
+//
+
+//
+// Trace records (fixed size, binary) are stored in ring buffer, the
+// names of entities and objects are stored once in name tables and they
+// are removed with the last record using them (memory is limited by the
+// size of ring buffer).  Objects are identified by address and serial
+// number assigned at their first record (the address can be reused).  Wall-clock time is read at the start and end
+// of entity behavior only, other records use the start time of current
+// behavior.  Recording is enabled by TraceStart(), the test in
+// SIMLIB_TRACE macro is the only cost of disabled tracing.
+// TraceExport() writes Chrome trace event format:
+//   pid 1 - entities (thread per entity): run, activate, passivate, queue
+//   pid 2 - resources: facility usage (async spans), store and queue
+//           counters
+//
+
+////////////////////////////////////////////////////////////////////////////
+// interface
+//
+
+#include "simlib.h"
+#include "internal.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <unordered_map>
+
+////////////////////////////////////////////////////////////////////////////
+// implementation
+//
+
+namespace simlib3 {
+
+SIMLIB_IMPLEMENTATION;
+
+thread_local bool SIMLIB_Tracing = false;
+
+////////////////////////////////////////////////////////////////////////////
+// trace record
+//
+struct TraceRecord {
+  double time;                  // model time
+  double value;                 // depends on type
+  unsigned long long wall;      // wall-clock time [ns] from TraceStart
+  unsigned entity;              // entity name slot or NONE
+  unsigned object;              // object name slot or NONE
+  unsigned type;                // SIMLIB_TraceType_t
+};
+const unsigned NONE = ~0U;
+
+////////////////////////////////////////////////////////////////////////////
+// table of names used by records in ring buffer
+// slot is referenced by records, free slots are reused
+//
+class TraceNames {
+  struct Slot {
+    unsigned long key;          // entity id or object address
+    unsigned serial;            // object serial number (entity: 0)
+    unsigned refs;              // number of references (0 = free)
+    std::string name;
+  };
+  std::vector<Slot> slots;
+  std::vector<unsigned> free;
+  std::unordered_map<unsigned long, unsigned> index; // key -> last slot
+  unsigned last;                // last used slot (fast path)
+ public:
+  TraceNames(): last(NONE) {}
+  void Clear() {
+    slots.clear();
+    free.clear();
+    index.clear();
+    last = NONE;
+  }
+  // slot of object (new reference)
+  unsigned Get(unsigned long key, unsigned serial, const SimObject *o) {
+    if(last != NONE && slots[last].refs > 0 && slots[last].key == key &&
+       slots[last].serial == serial) {
+      slots[last].refs++;
+      return last;
+    }
+    auto i = index.find(key);
+    if(i != index.end() && slots[i->second].serial == serial) {
+      slots[i->second].refs++;
+      return last = i->second;
+    }                           // else new object at reused address
+    unsigned n;
+    if(free.empty()) {
+      n = slots.size();
+      slots.push_back(Slot());
+    } else {
+      n = free.back();
+      free.pop_back();
+    }
+    slots[n].key = key;
+    slots[n].serial = serial;
+    slots[n].refs = 1;
+    slots[n].name = o->Name();
+    index[key] = n;
+    return last = n;
+  }
+  // remove reference, the last one frees the slot
+  void Release(unsigned n) {
+    if(n == NONE || --slots[n].refs > 0)
+      return;
+    auto i = index.find(slots[n].key);
+    if(i != index.end() && i->second == n)
+      index.erase(i);
+    slots[n].name.clear();
+    free.push_back(n);
+  }
+  unsigned Size() const { return slots.size(); }
+  bool Used(unsigned n) const { return slots[n].refs > 0; }
+  unsigned long Key(unsigned n) const { return slots[n].key; }
+  const std::string &Name(unsigned n) const { return slots[n].name; }
+};
+
+////////////////////////////////////////////////////////////////////////////
+// trace data (thread-local)
+//
+struct TraceData {
+  std::vector<TraceRecord> buffer;              // ring buffer
+  unsigned long next;                           // next record position
+  unsigned long count;                          // number of records
+  TraceNames objects;
+  TraceNames entities;
+  std::chrono::steady_clock::time_point start;  // wall-clock start
+  unsigned long long wall;                      // wall-clock for records
+  // current entity behavior
+  unsigned run_entity;                          // slot (referenced)
+  double run_time;
+
+  unsigned long long Wall() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - start).count();
+  }
+  void Clear() {
+    next = count = 0;
+    objects.Clear();
+    entities.Clear();
+    start = std::chrono::steady_clock::now();
+    wall = 0;
+    run_entity = NONE;
+  }
+  // the record replaces the oldest one (its names are released)
+  void Add(const TraceRecord &r) {
+    if(count >= buffer.size()) {
+      entities.Release(buffer[next].entity);
+      objects.Release(buffer[next].object);
+    }
+    buffer[next] = r;
+    if(++next == buffer.size()) next = 0;
+    count++;
+  }
+};
+static thread_local TraceData *trace = 0;
+
+////////////////////////////////////////////////////////////////////////////
+// name slots of object and entity
+//
+static unsigned ObjectSlot(const SimObject *o)
+{
+  return o ? trace->objects.Get(reinterpret_cast<unsigned long>(o),
+                                SIMLIB_TraceSerial(o), o) : NONE;
+}
+
+static unsigned EntitySlot(const Entity *e)
+{
+  return e ? trace->entities.Get(e->id(), 0, e) : NONE;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// SIMLIB_TraceSerial --- serial number of object (assigned when traced)
+//
+unsigned SIMLIB_TraceSerial(const SimObject *o)
+{
+  static thread_local unsigned serial = 0;
+  if(o->_serial == 0) {
+    if(++serial == 1U << 24)    // 24 bits, 0 = not assigned
+      serial = 1;
+    o->_serial = serial;
+  }
+  return o->_serial;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// SIMLIB_TraceRecord --- add record (called by SIMLIB_TRACE)
+//
+void SIMLIB_TraceRecord(SIMLIB_TraceType_t t, const SimObject *o,
+                        const Entity *e, double value)
+{
+  TraceRecord r;
+  r.time = Time;
+  r.value = value;
+  r.wall = trace->wall;
+  r.entity = EntitySlot(e);
+  r.object = ObjectSlot(o);
+  r.type = t;
+  trace->Add(r);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// behavior of entity, record includes wall-clock duration
+// (entity can be deleted at the end)
+//
+void SIMLIB_TraceRunBegin(const Entity *e)
+{
+  trace->entities.Release(trace->run_entity);   // TraceStop() in behavior
+  trace->run_entity = EntitySlot(e);
+  trace->run_time = Time;
+  trace->wall = trace->Wall();
+}
+
+void SIMLIB_TraceRunEnd()
+{
+  TraceRecord r;
+  r.time = trace->run_time;
+  r.wall = trace->wall;
+  trace->wall = trace->Wall();
+  r.value = double(trace->wall - r.wall);
+  r.entity = trace->run_entity;         // reference moves to record
+  trace->run_entity = NONE;
+  r.object = NONE;
+  r.type = TRACE_RUN;
+  trace->Add(r);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Init() clears the trace
+//
+static void TraceClear()
+{
+  if(trace)
+    trace->Clear();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// TraceStart --- start recording
+//
+void TraceStart(unsigned long records)
+{
+  Dprintf(("TraceStart(%lu)", records));
+  if(records == 0)
+    records = 1;
+  if(trace == 0) {
+    trace = new TraceData;
+    INSTALL_HOOK(TraceInit, TraceClear);
+    SIMLIB_atexit([]{ delete trace; trace = 0; SIMLIB_Tracing = false; });
+  }
+  trace->buffer.resize(records);
+  trace->Clear();
+  SIMLIB_Tracing = true;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// TraceStop --- stop recording
+//
+void TraceStop()
+{
+  Dprintf(("TraceStop()"));
+  SIMLIB_Tracing = false;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// TraceExport --- Chrome trace event format
+//
+
+// print JSON string
+static void PrintString(FILE *f, const std::string &s)
+{
+  std::fputc('"', f);
+  for(unsigned char c : s) {
+    if(c == '"' || c == '\\')   std::fprintf(f, "\\%c", c);
+    else if(c < 0x20)           std::fprintf(f, "\\u%04x", c);
+    else                        std::fputc(c, f);
+  }
+  std::fputc('"', f);
+}
+
+void TraceExport(const char *filename, bool wallclock)
+{
+  Dprintf(("TraceExport(\"%s\")", filename));
+  FILE *f = std::fopen(filename, "w");
+  if(f == 0)
+    SIMLIB_error(TraceFileError);
+  unsigned long n = 0, first = 0;
+  if(trace) {
+    n = trace->count < trace->buffer.size() ? trace->count
+                                            : trace->buffer.size();
+    first = trace->count > n ? trace->next : 0;
+  }
+  std::fprintf(f, "{\"displayTimeUnit\":\"ms\",\n"
+                  "\"otherData\":{\"clock\":\"%s\",\"records\":%lu,\"lost\":%lu},\n"
+                  "\"traceEvents\":[\n",
+               wallclock ? "wall" : "model", n, trace ? trace->count - n : 0);
+  std::fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+                  "\"args\":{\"name\":\"entities\"}},\n"
+                  "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,"
+                  "\"args\":{\"name\":\"resources\"}}");
+  if(trace) {
+    const TraceNames &en = trace->entities;
+    std::vector<std::pair<unsigned long, unsigned> > ids; // (id, slot)
+    for(unsigned i = 0; i < en.Size(); i++)
+      if(en.Used(i))
+        ids.push_back(std::make_pair(en.Key(i), i));
+    std::sort(ids.begin(), ids.end());
+    for(auto &id : ids) {
+      std::fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                      "\"tid\":%lu,\"args\":{\"name\":", id.first);
+      PrintString(f, en.Name(id.second));
+      std::fprintf(f, "}}");
+    }
+    const TraceNames &on = trace->objects;
+    for(unsigned i = 0; i < on.Size(); i++) {
+      if(!on.Used(i))
+        continue;
+      std::fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":2,"
+                      "\"tid\":%u,\"args\":{\"name\":", i);
+      PrintString(f, on.Name(i));
+      std::fprintf(f, "}}");
+    }
+  }
+  for(unsigned long k = 0; k < n; k++) {
+    const TraceRecord &r = trace->buffer[(first + k) % trace->buffer.size()];
+    double ts = wallclock ? r.wall*1e-3 : r.time*1e6;   // [us]
+    const std::string *name = r.object != NONE ?
+                              &trace->objects.Name(r.object) : 0;
+    unsigned long entity = r.entity != NONE ?
+                           trace->entities.Key(r.entity) : ~0UL;
+    std::fprintf(f, ",\n{");
+    switch(r.type) {
+      case TRACE_RUN:
+        std::fprintf(f, "\"name\":\"run\",\"ph\":\"X\",\"dur\":%.3f,"
+                        "\"args\":{\"time\":%.17g}",
+                     wallclock ? r.value*1e-3 : 0.0, r.time);
+        break;
+      case TRACE_ACTIVATE:
+        std::fprintf(f, "\"name\":\"activate\",\"ph\":\"i\",\"s\":\"t\","
+                        "\"args\":{\"at\":%.17g}", r.value);
+        break;
+      case TRACE_PASSIVATE:
+        std::fprintf(f, "\"name\":\"passivate\",\"ph\":\"i\",\"s\":\"t\"");
+        break;
+      case TRACE_QUEUE_IN:
+      case TRACE_QUEUE_OUT:
+        std::fprintf(f, "\"name\":");
+        PrintString(f, *name);
+        std::fprintf(f, ",\"ph\":\"C\",\"pid\":2,\"tid\":%u,"
+                        "\"args\":{\"length\":%.17g},\"ts\":%.3f},\n{",
+                     r.object, r.value, ts);
+        std::fprintf(f, "\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\","
+                        "\"args\":{\"queue\":",
+                     r.type == TRACE_QUEUE_IN ? "queue in" : "queue out");
+        PrintString(f, *name);
+        std::fprintf(f, "}");
+        break;
+      case TRACE_SEIZE:
+      case TRACE_RELEASE:
+        std::fprintf(f, "\"name\":");
+        PrintString(f, *name);
+        std::fprintf(f, ",\"cat\":\"facility\",\"ph\":\"%s\",\"id\":%lu,"
+                        "\"pid\":2,\"tid\":%u",
+                     r.type == TRACE_SEIZE ? "b" : "e", entity, r.object);
+        break;
+      case TRACE_ENTER:
+      case TRACE_LEAVE:
+        std::fprintf(f, "\"name\":");
+        PrintString(f, *name);
+        std::fprintf(f, ",\"ph\":\"C\",\"pid\":2,\"tid\":%u,"
+                        "\"args\":{\"used\":%.17g}",
+                     r.object, r.value);
+        break;
+    }
+    if(r.type != TRACE_SEIZE && r.type != TRACE_RELEASE &&
+       r.type != TRACE_ENTER && r.type != TRACE_LEAVE)
+      std::fprintf(f, ",\"pid\":1,\"tid\":%lu", entity);
+    std::fprintf(f, ",\"ts\":%.3f}", ts);
+  }
+  std::fprintf(f, "\n]}\n");
+  std::fclose(f);
+}
+
+}
+// end
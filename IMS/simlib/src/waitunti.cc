@@ -13,13 +13,21 @@
 //  better implementation will use objects in WUexpressions
 //
 // 199808  updated:  uses standard list<>
+//
+//  WaitUntilObserved --- condition is tested again only after change of
+//  Observable variable read in the last test: the reading registers the
+//  process in the variable, the change moves valid registrations to the
+//  list of ready processes (tested first by WU_hook). Old registrations
+//  are invalidated by test number and removed lazily.
 
 ////////////////////////////////////////////////////////////////////////////
 // interface
 //
 #include "simlib.h"
 #include "internal.h"
+#include <iterator>
 #include <list>
+#include <unordered_map>
 
 
 ////////////////////////////////////////////////////////////////////////////
@@ -36,7 +44,7 @@ SIMLIB_IMPLEMENTATION;
 class WaitUntilList {
     typedef std::list<Process *> container_t;
     container_t l;
-    static WaitUntilList *instance;   // unique list
+    static thread_local WaitUntilList *instance; // unique list (in thread)
   public:
     typedef container_t::iterator iterator;
     static iterator begin() { return instance->l.begin(); }
@@ -48,7 +56,25 @@ class WaitUntilList {
     static void Remove(Process *p) { // find and remove p
         Dprintf(("WaitUntil::Remove(Process#%ld)", p->id()));
         instance->l.remove(p); // should be in list
+        RemoveObserver(p);
+    }
+    // WaitUntilObserved
+    struct Observer {                    // state of observing process
+        unsigned long id;                // process identification
+        unsigned long test;              // number of last test
+        unsigned long count;             // registrations in last test
+        unsigned long seq;               // order of start of waiting
+        bool ready;                      // is in ready list
+    };
+    typedef std::unordered_map<Process *, Observer> observers_t;
+    static Observer &BeginObserver(Process *p); // start of test
+    static void RemoveObserver(Process *p);     // end of waiting
+    static bool Valid(Process *p, unsigned long id, unsigned long test) {
+        observers_t::iterator i = instance->observers.find(p);
+        return i != instance->observers.end() &&
+               i->second.id == id && i->second.test == test;
     }
+    static void Ready(Process *p);       // insert into ready list
     static void clear();    // empty
     static void create() {  // create single instance
         if(instance==0) instance = new WaitUntilList;
@@ -62,10 +88,12 @@ class WaitUntilList {
         instance = 0;
     }
   private:
+    container_t ready;                   // observers after change
+    observers_t observers;               // observers waiting for change
     WaitUntilList() { Dprintf(("WaitUntilList::WaitUntilList()")); }
     ~WaitUntilList() { Dprintf(("WaitUntilList::~WaitUntilList()")); }
     // destructor never called ###???
-    static iterator current;
+    static thread_local iterator current;
 #ifndef NDEBUG
     friend void WU_print();
 #endif
@@ -82,18 +110,28 @@ class WaitUntilList {
 #endif
 
 // WaitUntilList single instance
-WaitUntilList *WaitUntilList::instance = 0; // static
-WaitUntilList::iterator WaitUntilList::current; // static
+thread_local WaitUntilList *WaitUntilList::instance = 0; // static
+thread_local WaitUntilList::iterator WaitUntilList::current; // static
 
 ////////////////////////////////////////////////////////////////////////////
-static bool flag = false; // valid iterator in WUList
+static thread_local bool flag = false; // valid iterator in WUList
 ////////////////////////////////////////////////////////////////////////////
 // main WUlist interface function
 void WaitUntilList::WU_hook() { // get ptr to next process in WUlist or 0
     Dprintf(("WaitUntilList::WU_hook"));
-    //  PRECONDITION: WUList not empty
-    if(WaitUntilList::empty()) // this should never happen
-        SIMLIB_internal_error();
+    if(!instance->ready.empty()) { // observers first (any order is valid)
+        flag = false;
+        SIMLIB_Current = instance->ready.front();
+        instance->ready.pop_front();
+        instance->observers[static_cast<Process*>(SIMLIB_Current)].ready = false;
+        if(empty() && instance->ready.empty())
+            INSTALL_HOOK(WUget_next, 0);
+        return;
+    }
+    if(WaitUntilList::empty()) { // observers only
+        SIMLIB_Current = 0;
+        return;
+    }
 
     if(!flag) { // start processing, (first call or after remove)
         current = WaitUntilList::begin(); // reset to first process
@@ -136,6 +174,42 @@ bool Process::_WaitUntil(bool test)
   }
 }
 
+////////////////////////////////////////////////////////////////////////////
+// _ObserveBegin --- start of WaitUntilObserved condition test
+//
+thread_local Process *SIMLIB_Observer = 0;
+
+void Process::_ObserveBegin()
+{
+  Dprintf(("Process#%ld._ObserveBegin()", id()));
+  if (SIMLIB_Current != this) SIMLIB_internal_error();
+  WaitUntilList::BeginObserver(this);
+  SIMLIB_Observer = this;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// _WaitUntilObserved --- wait to condition with Observable variables
+// this is hidden by macro WaitUntilObserved(b), useable in Process::Behavior
+//
+bool Process::_WaitUntilObserved(bool test)
+{
+  Dprintf(("Process#%ld._WaitUntilObserved(%s)", id(), test?"true":"false" ));
+  unsigned long count = WaitUntilList::BeginObserver(this).count;
+  SIMLIB_Observer = 0;
+  if(test) {                    // true --- end of wait
+    WaitUntilList::RemoveObserver(this);
+    _wait_until = false;
+    return false;
+  }
+  if(count == 0) {
+    WaitUntilList::RemoveObserver(this);
+    SIMLIB_error(WaitUntilObservedError); // would wait forever
+  }
+  _wait_until = true;           // registered in Observable variables
+  Passivate();                  // deactivation = wait
+  return true;                  // repeat test (after change)
+}
+
 ////////////////////////////////////////////////////////////////////////////
 // _WaitUntilRemove() --- remove process from WUlist (called from destructor)
 //
@@ -161,13 +235,111 @@ void WaitUntilList::InsertCurrent()
     if(empty())   // it was empty (FIXME: why not at creation time?)
         INSTALL_HOOK(WUget_next, WaitUntilList::WU_hook); // install hook
     iterator pos;
-    for( pos = begin(); // find place from beginning
-         pos != end() && (*pos)->Priority >= e->Priority;  // higher first
-         ++pos ) { /*empty*/ }
+    for( pos = end(); // find place from end (fast for equal priorities)
+         pos != begin() && (*std::prev(pos))->Priority < e->Priority;
+         --pos ) { /*empty*/ }
     instance->l.insert(pos,e);  // insert at position
     //e->_wait_until = true; // mark process as inserted
 }
 
+////////////////////////////////////////////////////////////////////////////
+// BeginObserver --- new test of condition, old registrations are invalid
+//
+WaitUntilList::Observer &WaitUntilList::BeginObserver(Process *p)
+{
+    if(instance==0)
+        create();
+    observers_t::iterator i = instance->observers.find(p);
+    if(i == instance->observers.end()) {
+        static thread_local unsigned long seq = 0;
+        Observer o = { p->id(), 0, 0, ++seq, false };
+        return instance->observers[p] = o;
+    }
+    Observer &o = i->second;
+    if(SIMLIB_Observer == p)    // registration in current test
+        return o;
+    if(o.ready) {               // activated before test from ready list
+        instance->ready.remove(p);
+        o.ready = false;
+    }
+    o.test++;
+    o.count = 0;
+    return o;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// RemoveObserver --- process does not wait for change
+//
+void WaitUntilList::RemoveObserver(Process *p)
+{
+    observers_t::iterator i = instance->observers.find(p);
+    if(i == instance->observers.end())
+        return;
+    if(i->second.ready)
+        instance->ready.remove(p);
+    instance->observers.erase(i);
+    if(empty() && instance->ready.empty())
+        INSTALL_HOOK(WUget_next, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Ready --- insert process after changed Observable
+//            (in priority order, FIFO as in WUlist)
+//
+void WaitUntilList::Ready(Process *p)
+{
+    Observer &o = instance->observers[p];
+    o.test++;                   // invalidate other registrations
+    o.ready = true;
+    iterator pos;
+    for( pos = instance->ready.end(); pos != instance->ready.begin(); --pos ) {
+        Process *q = *std::prev(pos);
+        if(q->Priority > p->Priority ||
+           (q->Priority == p->Priority && instance->observers[q].seq < o.seq))
+            break;
+    }
+    instance->ready.insert(pos, p);
+    INSTALL_HOOK(WUget_next, WaitUntilList::WU_hook);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// aObservable::Observe --- register process testing the condition
+//
+void aObservable::Observe() const
+{
+    Process *p = SIMLIB_Observer;
+    WaitUntilList::Observer &o = WaitUntilList::BeginObserver(p);
+    if(!waiting.empty() && waiting.back().process == p &&
+       waiting.back().id == o.id && waiting.back().test == o.test)
+        return;                 // registered already
+    o.count++;
+    if(waiting.size() >= limit) { // remove old registrations
+        std::size_t n = 0;
+        for(const Waiting &w : waiting)
+            if(WaitUntilList::Valid(w.process, w.id, w.test))
+                waiting[n++] = w;
+        waiting.resize(n);
+        limit = n < 8 ? 16 : 2*n;
+    }
+    Waiting w = { p, o.id, o.test };
+    waiting.push_back(w);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// aObservable::Changed --- move registered processes to ready list
+//
+void aObservable::Changed()
+{
+    if(waiting.empty())
+        return;
+    Dprintf(("Observable changed, %lu waiting", (unsigned long)waiting.size()));
+    std::vector<Waiting> w;
+    w.swap(waiting);
+    for(const Waiting &x : w)
+        if(WaitUntilList::Valid(x.process, x.id, x.test))
+            WaitUntilList::Ready(x.process);
+}
+
 ////////////////////////////////////////////////////////////////////////////
 // GetCurrent --- get selected process from WUlist
 //                (called from Process::* )
@@ -179,7 +351,7 @@ void WaitUntilList::GetCurrent()
   Process *p = *current;
   Dprintf(("WaitUntilList.Get(); // \"Process#%ld\" ", p->id()));
   instance->l.erase(current); // remove item pointed by iterator (fast)
-  if(empty())
+  if(empty() && instance->ready.empty())
     INSTALL_HOOK(WUget_next, 0); // uninstall hook if last item removed
   flag = false;           // iterator invalid, start from beginning
 }
@@ -201,6 +373,13 @@ void WaitUntilList::clear()
     }
     if(!instance->l.empty())
         SIMLIB_internal_error(); // for sure
+    while(!instance->observers.empty()) { // waiting for Observable change
+       Process *p = instance->observers.begin()->first;
+       p->_WaitUntilRemove();
+       instance->observers.erase(p);      // if not waiting
+       if( p->isAllocated() ) delete p;
+    }
+    instance->ready.clear();
     INSTALL_HOOK(WUget_next, 0); // uninstall hook if empty
 }
 
@@ -40,7 +40,7 @@ SIMLIB_IMPLEMENTATION;
 //
 class SIMLIB_ZDelayTimer {
     typedef std::list<ZDelayTimer *> container_t; // type of container we use
-    static container_t *container;      // list of delay objects -- singleton
+    static thread_local container_t *container; // list of delay objects -- singleton
   public: // interface
     static void Register(ZDelayTimer *p) { // called from ZDelayTimer constructor
         if( container == nullptr )
@@ -74,7 +74,7 @@ class SIMLIB_ZDelayTimer {
 };
 
 // SINGLETON: static member must be initializad
-SIMLIB_ZDelayTimer::container_t * SIMLIB_ZDelayTimer::container = 0;
+thread_local SIMLIB_ZDelayTimer::container_t * SIMLIB_ZDelayTimer::container = 0;
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -82,7 +82,7 @@ SIMLIB_ZDelayTimer::container_t * SIMLIB_ZDelayTimer::container = 0;
 //
 
 // singleton -- default ZDelayTimer
-ZDelayTimer * ZDelay::default_clock = 0;
+thread_local ZDelayTimer * ZDelay::default_clock = 0;
 
 /////////////////////////////////////////////////////////////////////////////
 // ZDelayTimer::ZDelayContainer --- container for associated ZDelay blocks
@@ -66,7 +66,7 @@ class ZDelay : public aContiBlock1 {
     double old_value;   // output value (delayed signal)
   protected: // parameters
     double initval;     // initial output value
-    static ZDelayTimer * default_clock;
+    static thread_local ZDelayTimer * default_clock;
   public: // interface
     explicit ZDelay( Input i, ZDelayTimer * clock = default_clock, double initvalue = 0 );
     ZDelay( Input i, double initvalue );
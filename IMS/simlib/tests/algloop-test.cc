@@ -0,0 +1,89 @@
+////////////////////////////////////////////////////////////////////////////
+// algloop-test.cc
+//
+// coupled algebraic loops (scalar loop blocks can not be nested if the
+// variables are shared): system solved by Newton's method with Jacobian
+// from evaluation tape and by differences (inputs evaluated by Value()
+// calls), warm start from the last solution
+//
+#include "simlib.h"
+#include <cmath>
+#include <cstdlib>
+
+long evaluations = 0;
+
+// user block: input is evaluated by Value() (not compiled)
+class Opaque : public aContiBlock {
+  public:
+    Input in;
+    Opaque() : in(0.0) {}
+    double Value() override { evaluations++; return in.Value(); }
+};
+
+// x = 0.5 sin(y) + u,  y = 0.5 cos(x + 0.4 y) - 0.1 t,  u' = cos(t) - x
+Input fx(Input x, Input y, Input u) { return 0.5 * Sin(y) + u; }
+Input fy(Input x, Input y, Input u) { return 0.5 * Cos(x + 0.4 * y) - 0.1 * T; }
+Input wrap(Input i, bool opaque) {
+    if(!opaque)
+        return i;
+    Opaque *o = new Opaque;
+    o->in.Set(i);
+    return o;
+}
+
+struct SystemModel {
+    AlgLoopSystem s;
+    LoopVariable x, y;
+    Integrator u;
+    SystemModel(bool opaque) : s(1e-12, 50), x(s), y(s), u(Input(0.0), 1.0) {
+        x.SetInput(wrap(fx(x, y, u), opaque));
+        y.SetInput(wrap(fy(x, y, u), opaque));
+        u.SetInput(Cos(T) - x);
+    }
+    double X() { return x.Value(); }
+    double Y() { return y.Value(); }
+};
+
+double sx, sy;                  // solution (system)
+
+long run(SystemModel &m, const char *name) {
+    evaluations = 0;
+    SetMethod("rkf5");
+    SetStep(1e-6, 0.1);
+    SetAccuracy(1e-10, 1e-8);
+    Init(0, 10);
+    Run();
+    long n = evaluations;
+    double x = m.X(), y = m.Y();
+    double r = std::fabs(x - (0.5 * std::sin(y) + m.u.Value()));
+    r = std::max(r, std::fabs(y - (0.5 * std::cos(x + 0.4 * y) - 0.1 * Time)));
+    Print("%-19s x = %.8f  y = %.8f  residual %s\n",
+          name, x, y, r < 1e-10 ? "ok" : "LARGE");
+    if(sx == 0) {
+        sx = x; sy = y;
+    } else if(std::fabs(x - sx) + std::fabs(y - sy) > 1e-8)
+        Print("  different solution\n");
+    return n;
+}
+
+int main() {
+    Print("algloop-test\n");
+    unsigned long it1, it2;
+    long n;
+    {
+        SystemModel m(false);
+        run(m, "system/tape");
+        it1 = m.s.Iterations();
+    }
+    {
+        SystemModel m(true);
+        n = run(m, "system/differences");
+        it2 = m.s.Iterations();
+    }
+    // differences: n+1 evaluations of inputs in each iteration
+    bool same = std::labs(long(it1) - long(it2)) * 100 < long(it1);
+    Print("Newton iterations (tape, differences): %s\n", same ? "same" : "DIFFERENT");
+    Print("evaluations of inputs (differences): %s\n",
+          n / 2 < 5 * long(it2) ? "ok" : "TOO MANY");
+    return 0;
+}
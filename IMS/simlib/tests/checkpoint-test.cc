@@ -0,0 +1,149 @@
+////////////////////////////////////////////////////////////////////////////
+// checkpoint-test.cc
+//
+// checkpoint and restore: run saved at time 500 and restored from the
+// file gives the same results as uninterrupted run
+//
+#include "simlib.h"
+#include <cmath>
+
+const char *FILENAME = "checkpoint-test.dat";
+
+Facility  F("F");
+Store     S("S", 3);
+Queue     Q("Q");
+Stat      served("time in system");
+Histogram H("time in system", 0, 5, 10);
+Integrator v(-0.001*v, 1);      // continuous part: exp(-0.001 t)
+
+class Customer : public StepProcess {
+    double t0;                  // arrival time
+    Entity *gen;                // reference to other entity
+    void Behavior() {
+      STEP_BEGIN;
+        t0 = Time;
+        STEP_AWAIT(Enter(S, 1));
+        STEP_AWAIT(Seize(F));
+        STEP_AWAIT(Wait(Exponential(0.8)));
+        Release(F);
+        Leave(S, 1);
+        if(Random() < 0.2) {    // some customers wait for signal
+            Into(Q);
+            Passivate();
+            STEP_YIELD();
+        }
+        served(Time - t0);
+        H(Time - t0);
+      STEP_END;
+    }
+    void SaveState(Checkpoint &c) const {
+        c.Write(t0);
+        c.WriteEntity(gen);
+    }
+    void RestoreState(Checkpoint &c) {
+        c.Read(t0);
+        gen = c.ReadEntity();
+    }
+  public:
+    Customer(Entity *g = 0) : t0(0), gen(g) {}
+};
+CHECKPOINT_ENTITY(Customer);
+
+// process is saved before start only
+class Audit : public Process {
+    void Behavior() {
+        Wait(1);
+        Print("audit at %g: queue %u, served %lu\n", Time, Q.Length(), served.Number());
+    }
+};
+CHECKPOINT_ENTITY(Audit);
+
+class Signal : public Event {
+    void Behavior() {
+        if(!Q.Empty())
+            Q.GetFirst()->Activate();
+        Activate(Time + 3);
+    }
+};
+CHECKPOINT_ENTITY(Signal);
+
+class Generator : public Event {
+    unsigned long num;
+    void Behavior() {
+        (new Customer(this))->Activate();
+        if(++num % 100 == 0)
+            (new Audit)->Activate(Time + 10);
+        Activate(Time + Exponential(1));
+    }
+    void SaveState(Checkpoint &c) const { c.Write(num); }
+    void RestoreState(Checkpoint &c)    { c.Read(num); }
+  public:
+    Generator() : num(0) {}
+};
+CHECKPOINT_ENTITY(Generator);
+
+class Save : public Event {
+    void Behavior() {
+        Print("checkpoint at %g\n", Time);
+        SaveCheckpoint(FILENAME, { &F, &S, &Q, &served, &H });
+    }
+};
+
+struct Results {
+    double mean, hmean, stat_q, v;
+    unsigned long n;
+};
+
+Results results(const char *title) {
+    Print("\n===== %s =====\n", title);
+    Results r = { served.MeanValue(), H.stat.MeanValue(),
+                  Q.StatN.MeanValue(), v.Value(),
+                  served.Number() };
+    Print("served %lu, mean time %g, v = %.10f\n", r.n, r.mean, r.v);
+    return r;
+}
+
+bool same(const Results &a, const Results &b) {
+    return a.mean == b.mean && a.hmean == b.hmean &&
+           a.stat_q == b.stat_q && a.n == b.n &&
+           std::abs(a.v - b.v) < 1e-9;
+}
+
+void clear() {
+    F.Clear(); S.Clear(); Q.Clear(); served.Clear(); H.Clear();
+}
+
+int main() {
+    Print("checkpoint-test\n");
+    SetStep(0.1, 10);
+    RandomSeed(1234);
+    Init(0, 1000);
+    clear();
+    (new Generator)->Activate();
+    (new Signal)->Activate();
+    Run();
+    Results r1 = results("uninterrupted run");
+
+    RandomSeed(1234);
+    Init(0, 1000);
+    clear();
+    (new Generator)->Activate();
+    (new Signal)->Activate();
+    (new Save)->Activate(500);
+    Run();
+    Results r2 = results("run with checkpoint");
+
+    RandomSeed(1);
+    Init(0, 1000);
+    clear();
+    RestoreCheckpoint(FILENAME, { &F, &S, &Q, &served, &H });
+    Print("restored at %g\n", Time);
+    Run();
+    Results r3 = results("restored run");
+    F.Output();
+    H.Output();
+
+    Print("\ncheckpoint: %s\n", same(r1, r2) ? "identical" : "DIFFERENT");
+    Print("restored: %s\n", same(r1, r3) ? "identical" : "DIFFERENT");
+    return 0;
+}
@@ -0,0 +1,53 @@
+// delay-test3.cc
+//
+// Delay of smooth signal: linear and cubic interpolation of delayed
+// values, long delay (many samples in buffer), variable delay time
+//
+
+#include "simlib.h"
+#include "delay.h"
+#include <cmath>
+
+const double dt = 50;
+
+Delay       d1( Sin(T), dt );           // linear interpolation
+Delay       d3( Sin(T), dt );           // cubic interpolation
+Delay       d2( Sin(T), dt );           // variable delay time
+Integrator  x( d1 );                    // continuous simulation
+
+double err1 = 0, err3 = 0, err2 = 0;
+
+void Sample() {
+    if( Time <= dt ) return;            // initial value
+    err1 = std::max(err1, std::fabs(d1.Value() - std::sin(Time - dt)));
+    err3 = std::max(err3, std::fabs(d3.Value() - std::sin(Time - dt)));
+}
+Sampler s(Sample, 0.37);                // between samples of delays
+
+class Change : public Event {           // shorter delay
+    void Behavior() { d2.Set(dt - 10); }
+};
+
+void Sample2() {
+    if( Time <= dt ) return;
+    double delay = Time < 150 ? dt : dt - 10;
+    err2 = std::max(err2, std::fabs(d2.Value() - std::sin(Time - delay)));
+}
+Sampler s2(Sample2, 0.37);
+
+int main()
+{
+    Print("delay-test3\n");
+    d3.SetOrder(3);
+    d2.SetOrder(3);
+    SetStep(1e-6, 0.2);
+    SetAccuracy(1e-10, 1e-8);
+    Init(0, 1000);
+    (new Change)->Activate(150);
+    Run();
+    Print("linear interpolation: max. error %s\n", err1 < 1e-2 ? "ok" : "LARGE");
+    Print("cubic interpolation:  max. error %s\n", err3 < 1e-4 ? "ok" : "LARGE");
+    Print("cubic/linear error:   %s\n", err3 * 100 < err1 ? "< 1/100" : "NOT SMALLER");
+    Print("variable delay:       max. error %s\n", err2 < 1e-4 ? "ok" : "LARGE");
+    return 0;
+}
@@ -0,0 +1,142 @@
+////////////////////////////////////////////////////////////////////////////
+// dopri5-test.cc
+//
+// Dormand-Prince method: samples, events and delays inside of the steps
+// use dense output (no reduction of steps), state events are located,
+// results are compared with analytic solutions
+//
+#include "simlib.h"
+#include "delay.h"
+#include <cmath>
+
+unsigned long evals;            // evaluations of model
+
+// user block: counts evaluations
+class Counter : public aContiBlock1 {
+  public:
+    explicit Counter(Input i) : aContiBlock1(i) {}
+    double Value() override { evals++; return InputValue(); }
+};
+
+// y' = -y + sin(t), y(t0) = y0
+double exact(double t, double t0, double y0) {
+    double p = 0.5 * (std::sin(t) - std::cos(t));
+    double p0 = 0.5 * (std::sin(t0) - std::cos(t0));
+    return (y0 - p0) * std::exp(t0 - t) + p;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// periodic samples and event inside of the step
+Integrator *y;
+unsigned samples;
+double max_error;
+double reset_time = 4.25;       // event: y = 0
+
+void Sample() {
+    if(!y) return;
+    double t = T.Value();
+    double e = t < reset_time ? exact(t, 0, 1) : exact(t, reset_time, 0);
+    e = std::fabs(y->Value() - e);
+    if(e > max_error) max_error = e;
+    samples++;
+}
+Sampler sampler(Sample, 0.01);
+
+class Reset : public Event {
+    void Behavior() override { *y = 0; }
+};
+
+void sampling(const char *method) {
+    y = new Integrator(Input(0.0), 1.0);
+    y->SetInput(new Counter(-Input(*y) + Sin(T)));
+    SetMethod(method);
+    Init(0, 10);
+    SetStep(1e-8, 1);
+    SetAccuracy(1e-9, 1e-9);
+    evals = samples = 0;
+    max_error = 0;
+    sampler.SetStep(0.01);
+    (new Reset)->Activate(reset_time);
+    Run();
+    Print("%-6s samples %u, error %s, end at %g\n", method, samples,
+          max_error < 1e-7 ? "< 1e-7" : "TOO LARGE", T.Value());
+    delete y;
+    y = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// bouncing ball (state events)
+const double g = 9.81;
+const double K = 0.8;
+const unsigned N = 10;
+
+class Ball : ConditionDown {
+    Integrator v, h;
+    void Action() override {
+        times[count++] = T.Value();
+        v = -K * v.Value();
+        h = 0;
+        if(count >= N)
+            Stop();
+    }
+  public:
+    unsigned count;
+    double times[N];
+    Ball() : ConditionDown(h), v(-g), h(v, 1.0), count(0) {}
+};
+
+double bounce(unsigned i) {
+    double t = std::sqrt(2/g), v = g*t, tb = t;
+    for(unsigned k = 1; k <= i; k++) {
+        v *= K;
+        tb += 2*v/g;
+    }
+    return tb;
+}
+
+void bouncing() {
+    Ball ball;
+    SetMethod("dopri5");
+    SetEventLocation(true);
+    Init(0, 100);
+    SetStep(1e-10, 0.5);
+    SetAccuracy(1e-8, 1e-8);
+    sampler.SetStep(0);
+    Run();
+    double err = 0;
+    for(unsigned i = 0; i < ball.count; i++)
+        err = std::fmax(err, std::fabs(ball.times[i] - bounce(i)));
+    Print("dopri5 bounces %u, last at %.7f, max error %s\n", ball.count,
+          ball.times[ball.count-1], err < 1e-7 ? "< 1e-7" : "TOO LARGE");
+    SetEventLocation(false);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// y' = -y(t-1), y = 1 for t <= 0: y(3) = -1/6
+double delay(const char *method) {
+    Integrator x(Input(0.0), 1.0);
+    Delay d(x, 1.0, 1.0);
+    x.SetInput(-Input(d));
+    SetMethod(method);
+    Init(0, 3);
+    SetStep(1e-8, 0.5);
+    SetAccuracy(1e-9, 1e-9);
+    sampler.SetStep(0);
+    Run();
+    return std::fabs(x.Value() + 1.0/6);
+}
+
+int main() {
+    Print("dopri5-test\n");
+    sampling("rkf5");
+    unsigned long n1 = evals;
+    sampling("dopri5");
+    unsigned long n2 = evals;
+    Print("dopri5 evaluations: %s\n", 5 * n2 < n1 ? "much less than rkf5" : "NOT LESS");
+    bouncing();
+    double e1 = delay("rkf5");
+    double e2 = delay("dopri5");
+    Print("delay: rkf5 error %s, dopri5 error %s\n", e1 < 0.05 ? "< 0.05" : "TOO LARGE",
+          e2 < 0.005 ? "< 0.005" : "TOO LARGE");
+    return 0;
+}
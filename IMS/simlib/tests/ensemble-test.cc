@@ -0,0 +1,75 @@
+////////////////////////////////////////////////////////////////////////////
+// ensemble-test.cc
+//
+// damped oscillator with different parameters and initial values:
+// ensemble (groups of members integrated together, worker threads)
+// compared with exact solution and with single simulation runs
+//
+#include "simlib.h"
+#include <cmath>
+
+const unsigned K = 200;
+
+// x'' + c x' + k x = 0
+Parameter k(1), c(0.1);
+Integrator v(Input(0.0)), x(v, 1.0);
+
+double stiffness(unsigned m) { return 1 + 0.02 * m; }
+double damping(unsigned m)   { return 0.1 + 0.001 * m; }
+double initial(unsigned m)   { return 1 + 0.01 * m; }
+
+double exact(unsigned m, double t) {    // underdamped solution
+    double kk = stiffness(m), cc = damping(m), x0 = initial(m);
+    double a = cc / 2, w = std::sqrt(kk - a * a);
+    return x0 * std::exp(-a * t) * (std::cos(w * t) + a / w * std::sin(w * t));
+}
+
+double single(unsigned m, double t1) {  // simulation run
+    k = stiffness(m);
+    c = damping(m);
+    x.Init(initial(m));
+    Init(0, t1);
+    Run();
+    return x.Value();
+}
+
+int main() {
+    Print("ensemble-test\n");
+    v.SetInput(-k * x - c * v);
+    SetMethod("dopri5");
+    SetStep(1e-6, 0.5);
+    SetAccuracy(1e-10, 1e-8);
+
+    Ensemble e(K), e1(K);
+    for(unsigned m = 0; m < K; m++) {
+        e.Set(k, m, stiffness(m));
+        e.Set(c, m, damping(m));
+        e.Init(x, m, initial(m));
+        e1.Set(k, m, stiffness(m));
+        e1.Set(c, m, damping(m));
+        e1.Init(x, m, initial(m));
+    }
+    e.Init(0);
+    e1.Init(0);
+    double err = 0;
+    for(int i = 1; i <= 4; i++) {       // output times
+        double t = 5.0 * i;
+        e.Run(t, 4);
+        e1.Run(t, 1);
+        for(unsigned m = 0; m < K; m++)
+            err = std::max(err, std::fabs(e.Value(x, m) - exact(m, t)));
+        Print("t = %4.1f  x[0] = % .8f  x[%u] = % .8f\n", t,
+              e.Value(x, 0), K - 1, e.Value(x, K - 1));
+    }
+    bool same = true;
+    for(unsigned m = 0; m < K; m++)
+        if(e.Value(x, m) != e1.Value(x, m) || e.Value(v, m) != e1.Value(v, m))
+            same = false;
+    Print("error of ensemble: %s\n", err < 1e-6 ? "ok" : "LARGE");
+    Print("4 threads and 1 thread: %s\n", same ? "identical" : "DIFFERENT");
+    double diff = 0;
+    for(unsigned m = 0; m < K; m += 66)
+        diff = std::max(diff, std::fabs(single(m, 20) - e.Value(x, m)));
+    Print("single runs: %s\n", diff < 1e-6 ? "same" : "DIFFERENT");
+    return 0;
+}
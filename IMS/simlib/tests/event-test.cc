@@ -0,0 +1,77 @@
+////////////////////////////////////////////////////////////////////////////
+// event-test.cc
+//
+// bouncing ball: state events located by root finding are at the same
+// (analytic) times as with step halving, with fewer evaluations of model
+//
+#include "simlib.h"
+#include <cmath>
+
+const double g = 9.81;          // gravity acceleration
+const double H = 1.0;           // initial position
+const double K = 0.8;           // energy loss
+const unsigned N = 10;          // number of bounces
+
+unsigned long evals;            // evaluations of model
+
+class Gravity : public aContiBlock {
+    double Value() override { evals++; return -g; }
+};
+
+class Ball : ConditionDown {
+    Gravity a;
+    Integrator v, y;
+    void Action() override {
+        times[count++] = T.Value();
+        v = -K * v.Value();
+        y = 0;
+        if(count >= N)
+            Stop();
+    }
+  public:
+    unsigned count;
+    double times[N];
+    Ball() : ConditionDown(y), v(a), y(v, H), count(0) {}
+};
+
+Ball ball;
+
+// analytic time of bounce
+double bounce(unsigned i) {
+    double t = std::sqrt(2*H/g), v = g*t, tb = t;
+    for(unsigned k = 1; k <= i; k++) {
+        v *= K;
+        tb += 2*v/g;
+    }
+    return tb;
+}
+
+double run(bool locate) {
+    Print("\n===== %s =====\n", locate ? "event location" : "step halving");
+    SetEventLocation(locate);
+    Init(0, 100);
+    SetStep(1e-10, 0.5);
+    SetAccuracy(1e-8, 1e-8);
+    ball.count = 0;
+    evals = 0;
+    Run();
+    double err = 0;
+    for(unsigned i = 0; i < ball.count; i++) {
+        double e = std::fabs(ball.times[i] - bounce(i));
+        if(e > err) err = e;
+    }
+    Print("bounces %u, last at %.9f, max error %s\n", ball.count,
+          ball.times[ball.count-1], err < 1e-7 ? "< 1e-7" : "TOO LARGE");
+    return err;
+}
+
+int main() {
+    Print("event-test\n");
+    double e1 = run(false);
+    unsigned long n1 = evals;
+    double e2 = run(true);
+    unsigned long n2 = evals;
+    Print("\nevaluations: halving %lu, location %lu\n", n1, n2);
+    Print("event location: %s\n", e2 < 1e-7 && e1 < 1e-7 && n2 < n1 ? "ok" : "FAILED");
+    return 0;
+}
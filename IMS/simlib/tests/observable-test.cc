@@ -0,0 +1,92 @@
+////////////////////////////////////////////////////////////////////////////
+// observable-test.cc
+//
+// consumers of tank with random demand and priority wait for enough
+// content and open valve: WaitUntilObserved with Observable variables
+// gives the same results as classic WaitUntil (tests after each event)
+//
+#define I_REALLY_KNOW_HOW_TO_USE_WAITUNTIL
+#include "simlib.h"
+
+long level1 = 0;                // classic WaitUntil
+bool open1 = true;
+Observable<long> level2(0);     // WaitUntilObserved
+Observable<bool> open2(true);
+Stat wait1("waiting time (WaitUntil)");
+Stat wait2("waiting time (WaitUntilObserved)");
+bool observed;
+
+class Consumer1 : public Process {
+    long need;
+    void Behavior() {
+        double t0 = Time;
+        WaitUntil(open1 && level1 >= need);
+        level1 -= need;
+        wait1(Time - t0);
+    }
+  public:
+    Consumer1(Priority_t p, long n) : Process(p), need(n) {}
+};
+
+class Consumer2 : public Process {
+    long need;
+    void Behavior() {
+        double t0 = Time;
+        WaitUntilObserved(open2 && level2 >= need);
+        level2 -= need;
+        wait2(Time - t0);
+    }
+  public:
+    Consumer2(Priority_t p, long n) : Process(p), need(n) {}
+};
+
+class Generator : public Event {
+    void Behavior() {
+        Priority_t p = Priority_t(Random()*3);
+        long n = 1 + long(Random()*10);
+        if(observed) (new Consumer2(p, n))->Activate();
+        else         (new Consumer1(p, n))->Activate();
+        Activate(Time + Exponential(1));
+    }
+};
+
+class Supply : public Event {
+    void Behavior() {
+        long n = long(Random()*12);
+        if(observed) level2 += n;
+        else         level1 += n;
+        Activate(Time + Exponential(2));
+    }
+};
+
+class Valve : public Event {
+    void Behavior() {
+        if(observed) open2 = !open2;
+        else         open1 = !open1;
+        Activate(Time + Uniform(5, 20));
+    }
+};
+
+void run(bool obs, Stat &w) {
+    observed = obs;
+    RandomSeed(1234);
+    Init(0, 5000);
+    w.Clear();
+    (new Generator)->Activate();
+    (new Supply)->Activate();
+    (new Valve)->Activate();
+    Run();
+    w.Output();
+}
+
+int main() {
+    Print("observable-test\n");
+    run(false, wait1);
+    run(true, wait2);
+    Print("level %ld, %ld\n", level1, level2.Value());
+    bool same = wait1.Number() == wait2.Number() &&
+                wait1.MeanValue() == wait2.MeanValue() &&
+                level1 == level2;
+    Print("WaitUntil and WaitUntilObserved: %s\n", same ? "identical" : "DIFFERENT");
+    return 0;
+}
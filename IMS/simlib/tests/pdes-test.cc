@@ -0,0 +1,124 @@
+////////////////////////////////////////////////////////////////////////////
+// pdes-test.cc
+//
+// conservative parallel simulation: two logical processes (dismantling
+// centres with trucks, plant), trucks travel between them,
+// parallel and sequential runs give the same results
+//
+#include "simlib.h"
+
+const double TRAVEL = 5;        // minimal travel time = lookahead
+
+void centres_setup();
+void centres_finish();
+void plant_setup();
+void plant_finish();
+
+LogicalProcess centres_lp("centres", TRAVEL, centres_setup, centres_finish);
+LogicalProcess plant_lp("plant", TRAVEL, plant_setup, plant_finish);
+
+// state of logical processes (objects are created in its thread)
+struct Centres {
+    Store trucks;
+    Stat waiting;
+    unsigned long returned;
+    Centres() : trucks("trucks", 10), waiting("waiting for truck"), returned(0) {}
+};
+thread_local Centres *centres = 0;
+
+struct Plant {
+    Facility line;
+    Stat delivery;
+    unsigned long processed;
+    Plant() : line("line"), delivery("delivery time"), processed(0) {}
+};
+thread_local Plant *plant = 0;
+
+// results of run
+double r_waiting, r_delivery;
+unsigned long r_returned, r_processed;
+
+// centres LP: truck is back
+struct TruckBack : public Event {
+    void Behavior() {
+        centres->trucks.Leave(1);
+        centres->returned++;
+    }
+};
+
+// plant LP: processing of delivered load
+struct Delivery : public Process {
+    double departure;
+    void Behavior() {
+        plant->delivery(Time - departure);
+        Seize(plant->line);
+        Wait(Exponential(1.5));
+        Release(plant->line);
+        plant->processed++;
+        centres_lp.Send(new TruckBack, Time + TRAVEL + Uniform(0, 2));
+    }
+    Delivery(double t) : departure(t) {}
+};
+
+// centres LP: load is waiting for truck
+struct Load : public Process {
+    void Behavior() {
+        double t0 = Time;
+        Enter(centres->trucks, 1);
+        centres->waiting(Time - t0);
+        plant_lp.Send(new Delivery(Time), Time + TRAVEL + Exponential(3));
+    }
+};
+
+struct Generator : public Event {
+    void Behavior() {
+        (new Load)->Activate();
+        Activate(Time + Exponential(2));
+    }
+};
+
+void centres_setup() {
+    centres = new Centres;
+    (new Generator)->Activate();
+}
+
+void centres_finish() {
+    Print("centres: returned trucks %lu\n", centres->returned);
+    centres->trucks.Output();
+    centres->waiting.Output();
+    r_waiting = centres->waiting.MeanValue();
+    r_returned = centres->returned;
+    delete centres;
+}
+
+void plant_setup() {
+    plant = new Plant;
+}
+
+void plant_finish() {
+    Print("plant: processed loads %lu\n", plant->processed);
+    plant->line.Output();
+    plant->delivery.Output();
+    r_delivery = plant->delivery.MeanValue();
+    r_processed = plant->processed;
+    delete plant;
+}
+
+int main() {
+    Print("pdes-test\n");
+    Print("\n===== parallel =====\n");
+    RandomSeed(42);
+    RunParallel(0, 1000);
+    centres_lp.Output();
+    plant_lp.Output();
+    double w = r_waiting, d = r_delivery;
+    unsigned long r = r_returned, p = r_processed;
+
+    Print("\n===== sequential =====\n");
+    RandomSeed(42);
+    RunParallel(0, 1000, true);
+    bool same = w == r_waiting && d == r_delivery &&
+                r == r_returned && p == r_processed;
+    Print("\nparallel and sequential run: %s\n", same ? "identical" : "DIFFERENT");
+    return 0;
+}
@@ -0,0 +1,93 @@
+////////////////////////////////////////////////////////////////////////////
+// pool-test.cc
+//
+// facility pool: 3-server station gives the same results as Store with
+// capacity 3, per-server statistics, checkpoint of busy pool
+//
+#include "simlib.h"
+
+const unsigned SERVERS = 3;
+const char *FILENAME = "pool-test.dat";
+
+FacilityPool P("station", SERVERS);
+Store S("store", SERVERS);
+Stat wait_p("waiting time (pool)");
+Stat wait_s("waiting time (store)");
+bool use_pool = true;
+
+class Customer : public StepProcess {
+    double t0;
+    void Behavior() {
+      STEP_BEGIN;
+        t0 = Time;
+        if(use_pool) {
+            STEP_AWAIT(Seize(P));
+            wait_p(Time - t0);
+        } else {
+            STEP_AWAIT(Enter(S, 1));
+            wait_s(Time - t0);
+        }
+        STEP_AWAIT(Wait(Exponential(2.7)));
+        if(use_pool)
+            Release(P);
+        else
+            Leave(S, 1);
+      STEP_END;
+    }
+    void SaveState(Checkpoint &c) const { c.Write(t0); }
+    void RestoreState(Checkpoint &c)    { c.Read(t0); }
+  public:
+    Customer() : t0(0) {}
+};
+CHECKPOINT_ENTITY(Customer);
+
+class Generator : public Event {
+    void Behavior() {
+        (new Customer)->Activate();
+        Activate(Time + Exponential(1));
+    }
+};
+CHECKPOINT_ENTITY(Generator);
+
+class Save : public Event {
+    void Behavior() {
+        SaveCheckpoint(FILENAME, { &P, &wait_p });
+    }
+};
+
+void run(bool pool, double t, bool save) {
+    use_pool = pool;
+    RandomSeed(1234);
+    Init(0, t);
+    P.Clear(); wait_p.Clear();
+    S.Clear(); wait_s.Clear();
+    (new Generator)->Activate();
+    if(save)
+        (new Save)->Activate(t/2);
+    Run();
+}
+
+int main() {
+    Print("pool-test\n");
+    run(true, 10000, true);
+    P.Output();
+    wait_p.Output();
+    double u = P.Utilization(), w = wait_p.MeanValue();
+    unsigned long n = wait_p.Number();
+
+    run(false, 10000, false);
+    S.Output();
+    bool same = w == wait_s.MeanValue() && n == wait_s.Number();
+    Print("pool and store: %s\n", same ? "identical" : "DIFFERENT");
+
+    // restore pool at half of the run
+    Init(0, 10000);
+    P.Clear(); wait_p.Clear();
+    RestoreCheckpoint(FILENAME, { &P, &wait_p });
+    Print("restored at %g: %u busy, queue %u\n", double(Time), P.Busy(), P.QueueLen());
+    use_pool = true;
+    Run();
+    same = u == P.Utilization() && w == wait_p.MeanValue() && n == wait_p.Number();
+    Print("restored run: %s\n", same ? "identical" : "DIFFERENT");
+    return 0;
+}
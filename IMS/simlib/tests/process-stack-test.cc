@@ -0,0 +1,90 @@
+////////////////////////////////////////////////////////////////////////////
+// process-stack-test.cc
+//
+// processes with own stack (SetProcessStackSize): deep recursion with
+// interruptions, many concurrent processes, stack reuse (free stacks are
+// reused by next run with the same stack size: no new mappings)
+//
+#include "simlib.h"
+#include <dlfcn.h>
+#include <sys/mman.h>
+
+// number of mapped process stacks (calls of mmap by simlib)
+long mapped = 0;
+extern "C" void *mmap(void *addr, size_t len, int prot, int flags,
+                      int fd, off_t offset) noexcept {
+    typedef void *(*mmap_t)(void *, size_t, int, int, int, off_t);
+    static mmap_t real = (mmap_t) dlsym(RTLD_NEXT, "mmap");
+    if(flags & MAP_NORESERVE)   // process stack
+        mapped++;
+    return real(addr, len, prot, flags, fd, offset);
+}
+
+long sum = 0;
+int  active = 0, maxactive = 0;
+
+struct Recursive : public Process {
+    int depth;
+    long down(int n) {          // uses about 1KiB of stack per level
+        volatile char buffer[1000];
+        buffer[0] = (char) (n % 100);
+        if(n % 100 == 0)
+            Wait(1);            // interrupted deep in recursion
+        if(n == 0)
+            return 0;
+        return buffer[0] + down(n-1);
+    }
+    void Behavior() {
+        Print("Recursive: start at %g\n", Time);
+        long r = down(depth);
+        Print("Recursive: end at %g, result %ld\n", Time, r);
+        sum += r;
+    }
+    Recursive(int d) : depth(d) {}
+};
+
+struct Customer : public Process {
+    void Behavior() {
+        double t = Time;
+        if(++active > maxactive) maxactive = active;
+        Wait(Exponential(100));
+        Wait(Uniform(0, 10));
+        --active;
+        sum += (long)(Time - t);
+    }
+};
+
+class Generator : public Event {
+    int n;
+    void Behavior() {
+        (new Customer)->Activate();
+        if(++n < 5000)
+            Activate(Time + Exponential(0.1));
+    }
+  public:
+    Generator() : n(0) {}
+};
+
+void experiment(const char *title, size_t stack_size) {
+    Print("\n===== %s =====\n", title);
+    SetProcessStackSize(stack_size);
+    RandomSeed(1);
+    sum = 0; active = 0; maxactive = 0;
+    mapped = 0;
+    Init(0);
+    (new Recursive(1000))->Activate();
+    (new Recursive(500))->Activate(10);
+    (new Generator)->Activate();
+    Run();
+    Print("sum = %ld, max. active processes = %d\n", sum, maxactive);
+    Print("new stacks mapped: %ld\n", mapped);
+}
+
+int main() {
+    Print("process-stack-test\n");
+    experiment("stack copying", 0);
+    experiment("own stacks", 2*1024*1024);
+    experiment("own stacks, reused", 2*1024*1024);
+    SetProcessStackSize(0);
+    return 0;
+}
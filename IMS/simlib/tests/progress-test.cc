@@ -0,0 +1,59 @@
+////////////////////////////////////////////////////////////////////////////
+// progress-test.cc
+//
+// progress reports: status file contains the final report of Run()
+// (wall-clock data are not printed)
+//
+#include "simlib.h"
+#include <cstdio>
+#include <cstring>
+
+const char *FILENAME = "progress-test.status";
+
+Facility F("F");
+Integrator v(-0.001*v, 1);      // continuous part: integration steps
+
+class Customer : public Process {
+    void Behavior() {
+        Seize(F);
+        Wait(Exponential(0.8));
+        Release(F);
+    }
+};
+
+class Generator : public Event {
+    void Behavior() {
+        (new Customer)->Activate();
+        Activate(Time + Exponential(1));
+    }
+};
+
+// print status file up to wall-clock data
+void status() {
+    char line[256] = "";
+    FILE *f = std::fopen(FILENAME, "r");
+    if(f) {
+        if(!std::fgets(line, sizeof(line), f))
+            line[0] = 0;
+        std::fclose(f);
+    }
+    char *p = std::strstr(line, " |");
+    if(p)
+        *p = 0;
+    Print("status: %s\n", line);
+}
+
+int main() {
+    Print("progress-test\n");
+    std::remove(FILENAME);
+    SetProgress(0.001, FILENAME);
+    SetStep(0.1, 10);
+    RandomSeed(1234);
+    Init(0, 10000);
+    (new Generator)->Activate();
+    Run();
+    status();
+    Print("v = %g\n", v.Value());
+    SetProgress(0);
+    return 0;
+}
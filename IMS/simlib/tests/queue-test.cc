@@ -0,0 +1,121 @@
+////////////////////////////////////////////////////////////////////////////
+// queue-test.cc
+//
+// priority queue: order of entities is the same as by linear search
+// (random inserts, removals, inserts at position and changes of priority
+// of waiting entities), facility with service priorities
+//
+#include "simlib.h"
+#include <vector>
+
+struct Item : public Event {
+    unsigned long n;
+    void Behavior() {}
+    Item(unsigned long i, Priority_t p) : Event(p), n(i) {}
+};
+
+// reference: priority insert by linear search from the end
+void ref_insert(std::vector<Item*> &v, Item *e) {
+    std::size_t i = v.size();
+    while(i > 0 && v[i-1]->Priority < e->Priority)
+        i--;
+    v.insert(v.begin() + i, e);
+}
+
+bool same(Queue &q, const std::vector<Item*> &v) {
+    if(q.size() != v.size())
+        return false;
+    std::size_t i = 0;
+    for(Queue::iterator p = q.begin(); p != q.end(); ++p, ++i)
+        if(*p != v[i])
+            return false;
+    return true;
+}
+
+bool random_test(Queue &q, int priorities, unsigned long ops) {
+    std::vector<Item*> v;
+    for(unsigned long n = 0; n < ops; n++) {
+        double r = Random();
+        Item *e = new Item(n, Item::Priority_t(int(Random()*priorities) - priorities/2));
+        if(r < 0.5 || v.empty()) {
+            q.Insert(e);
+            ref_insert(v, e);
+        } else if(r < 0.52) {   // out of order
+            q.InsFirst(e);
+            v.insert(v.begin(), e);
+        } else if(r < 0.54) {
+            q.InsLast(e);
+            v.push_back(e);
+        } else if(r < 0.56) {   // priority of waiting entity changed
+            std::size_t i = std::size_t(Random()*v.size());
+            v[i]->Priority = e->Priority;
+            delete e;
+        } else {
+            delete e;
+            std::size_t i = r < 0.8 ? 0 : std::size_t(Random()*v.size());
+            Entity *x = i == 0 ? q.GetFirst() : (v[i]->Out(), v[i]);
+            if(x != v[i])
+                return false;
+            v.erase(v.begin() + i);
+            delete x;
+        }
+        if(!same(q, v))
+            return false;
+    }
+    q.Clear();
+    return true;
+}
+
+// priority of entity in the middle of run changed: a b c (5), b -> 9,
+// insert d (7) goes after b
+bool middle_test(Queue &q) {
+    Item a(0, 5), b(1, 5), c(2, 5), d(3, 7);
+    q.Insert(&a); q.Insert(&b); q.Insert(&c);
+    b.Priority = 9;
+    q.Insert(&d);
+    std::vector<Item*> v = { &a, &b, &d, &c };
+    bool ok = same(q, v);
+    q.Clear();
+    return ok;
+}
+
+Facility F("F");
+Stat waiting("waiting time");
+
+class Customer : public Process {
+    ServicePriority_t sp;
+    void Behavior() {
+        double t0 = Time;
+        Seize(F, sp);
+        waiting(Time - t0);
+        Wait(Exponential(0.9));
+        Release(F);
+    }
+  public:
+    Customer(Priority_t p, ServicePriority_t s) : Process(p), sp(s) {}
+};
+
+class Generator : public Event {
+    void Behavior() {
+        (new Customer(int(Random()*3), Random() < 0.05 ? 1 : 0))->Activate();
+        Activate(Time + Exponential(1));
+    }
+};
+
+int main() {
+    Print("queue-test\n");
+    RandomSeed(1234);
+    Queue q("q");
+    Print("one priority: %s\n", random_test(q, 1, 20000) ? "ok" : "DIFFERENT");
+    Print("priorities 0..2: %s\n", random_test(q, 3, 20000) ? "ok" : "DIFFERENT");
+    Print("priorities -50..49: %s\n", random_test(q, 100, 20000) ? "ok" : "DIFFERENT");
+    Print("priority changed in run: %s\n", middle_test(q) ? "ok" : "DIFFERENT");
+    q.Output();
+
+    Init(0, 10000);
+    (new Generator)->Activate();
+    Run();
+    F.Output();
+    waiting.Output();
+    return 0;
+}
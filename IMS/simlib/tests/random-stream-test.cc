@@ -0,0 +1,134 @@
+////////////////////////////////////////////////////////////////////////////
+// random-stream-test.cc          SIMLIB/C++
+//
+// Test of random number streams (xoshiro256++, jumps, stream selection)
+//
+
+#include "simlib.h"
+#include <cmath>
+
+// reference implementation of xoshiro256++ (state by splitmix64)
+struct Xoshiro {
+  unsigned long long s[4];
+  static unsigned long long rotl(unsigned long long x, int k) {
+    return (x << k) | (x >> (64 - k));
+  }
+  Xoshiro(unsigned long long seed) {
+    for(int i = 0; i < 4; i++) {
+      unsigned long long z = (seed += 0x9e3779b97f4a7c15ULL);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      s[i] = z ^ (z >> 31);
+    }
+  }
+  unsigned long long next() {
+    const unsigned long long result = rotl(s[0] + s[3], 23) + s[0];
+    const unsigned long long t = s[1] << 17;
+    s[2] ^= s[0]; s[3] ^= s[1]; s[1] ^= s[2]; s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+  }
+};
+
+// user defined base generator
+static double Half() { return 0.5; }
+
+int main()
+{
+  SetOutput("random-stream-test.out");
+  Print("Test of random number streams\n");
+
+  // the generator
+  RandomStream g(12345);
+  Xoshiro x(12345);
+  int errors = 0;
+  for(int i = 0; i < 1000000; i++)
+    if(g.Next() != x.next())
+      errors++;
+  Print("xoshiro256++ sequence: %d differences\n", errors);
+
+  // jump commutes with steps of generator
+  RandomStream a(777), b(777);
+  for(int i = 0; i < 1000; i++)
+    a.Next();
+  a.Jump();
+  b.Jump();
+  for(int i = 0; i < 1000; i++)
+    b.Next();
+  Print("Jump after/before 1000 steps: %s\n", a == b ? "equal" : "different");
+  a.LongJump();
+  b.LongJump();
+  Print("LongJump: %s\n", a == b ? "equal" : "different");
+  RandomStream s3(777, 3), c(777);
+  c.Jump(); c.Jump(); c.Jump();
+  Print("stream 3 == 3 jumps: %s\n", s3 == c ? "equal" : "different");
+
+  // streams are not correlated
+  const int N = 1000000;
+  RandomStream s0(1, 0), s1(1, 1);
+  double sx = 0, sy = 0, sxy = 0, sxx = 0, syy = 0;
+  for(int i = 0; i < N; i++) {
+    double u = s0.Random(), v = s1.Random();
+    sx += u; sy += v; sxy += u*v; sxx += u*u; syy += v*v;
+  }
+  double mx = sx/N, my = sy/N;
+  double r = (sxy/N - mx*my) / sqrt((sxx/N - mx*mx) * (syy/N - my*my));
+  Print("mean %.3f %.3f, correlation |r| < 0.005: %s\n", mx, my,
+        fabs(r) < 0.005 ? "yes" : "no");
+
+  // selection of stream for Random() and distributions
+  RandomSeed(1234);
+  double r1 = Random();
+  RandomStream own(99);
+  RandomStream *old = SetRandomStream(&own);
+  double e = Uniform(2, 4);
+  SetRandomStream(old);
+  double r2 = Random();
+  RandomSeed(1234);
+  double q1 = Random(), q2 = Random();
+  Print("default stream not used by selected stream: %s\n",
+        r1 == q1 && r2 == q2 ? "yes" : "no");
+  RandomStream own2(99);
+  Print("Uniform from selected stream: %s\n",
+        e == 2 + 2*own2.Random() ? "yes" : "no");
+  for(int i = 0; i < 5; i++)
+    Print("%g\n", Random());
+
+  // generators with explicit stream (common random numbers): draws from
+  // stream of arrivals do not depend on draws from stream of service
+  double sum[2] = { 0, 0 };
+  for(int scenario = 0; scenario < 2; scenario++) {
+    RandomStream arrivals(2021, 0), service(2021, 1);
+    RandomSeed(5);
+    for(int i = 0; i < 1000; i++) {
+      sum[scenario] += Exponential(arrivals, 10);
+      for(int j = 0; j <= scenario; j++)
+        Normal(service, 5, 1);
+      Random();
+    }
+  }
+  Print("arrivals in scenarios: %s (sum %g)\n",
+        sum[0] == sum[1] ? "equal" : "different", sum[0]);
+  RandomSeed(5);
+  RandomStream x1(7), x2(7);
+  double g1 = Gamma(x1, 2, 3);
+  RandomStream *prev = SetRandomStream(&x2);
+  double g2 = Gamma(2, 3);
+  SetRandomStream(prev);
+  Print("Gamma(s,...) == Gamma(...) with selected s: %s\n",
+        g1 == g2 ? "yes" : "no");
+  RandomStream d(5);
+  RandomSeed(5);
+  Print("default stream unchanged: %s\n", Random() == d.Random() ? "yes" : "no");
+
+  // explicit stream is used with replaced base generator
+  SetBaseRandomGenerator(Half);
+  RandomStream y1(11), y2(11);
+  double u1 = Uniform(y1, 0, 10);
+  double h = Random();
+  SetBaseRandomGenerator(0);
+  Print("explicit stream with base generator replaced: %s, base %g\n",
+        u1 == 10*y2.Random() ? "yes" : "no", h);
+  return 0;
+}
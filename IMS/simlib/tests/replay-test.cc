@@ -0,0 +1,68 @@
+////////////////////////////////////////////////////////////////////////////
+// replay-test.cc
+//
+// record and replay: replay of the same model (also with other
+// calendar) is identical, changed model is stopped at the first
+// difference
+//
+#include "simlib.h"
+
+const char *FILENAME = "replay-test.dat";
+
+Facility F("F");
+Stat served("time in system");
+bool changed = false;           // model with extra random number
+
+class Customer : public Process {
+    void Behavior() {
+        double t0 = Time;
+        Seize(F);
+        Wait(Exponential(0.8));
+        Release(F);
+        if(changed && Time > 500)
+            Random();
+        served(Time - t0);
+    }
+};
+
+class Generator : public Event {
+    void Behavior() {
+        (new Customer)->Activate();
+        Activate(Time + Exponential(1));
+    }
+};
+
+void run(const char *title) {
+    Print("\n===== %s =====\n", title);
+    RandomSeed(1234);
+    Init(0, 1000);
+    F.Clear();
+    served.Clear();
+    (new Generator)->Activate();
+    Run();
+    Print("end at %g, served %lu, mean time %g\n",
+          double(Time), served.Number(), served.MeanValue());
+}
+
+int main() {
+    Print("replay-test\n");
+    RecordStart(FILENAME);
+    run("record");
+    RecordStop();
+
+    ReplayStart(FILENAME);
+    run("replay");
+    Print("replay: %s\n", RecordStop() ? "identical" : "DIFFERENT");
+
+    SetCalendar("cq");
+    ReplayStart(FILENAME);
+    run("replay, calendar queue");
+    Print("replay: %s\n", RecordStop() ? "identical" : "DIFFERENT");
+    SetCalendar("list");
+
+    changed = true;
+    ReplayStart(FILENAME);
+    run("replay, changed model");
+    Print("replay: %s\n", RecordStop() ? "identical" : "DIFFERENT");
+    return 0;
+}
@@ -0,0 +1,89 @@
+////////////////////////////////////////////////////////////////////////////
+// replication-test.cc
+//
+// independent replications (RunReplications): results do not depend on
+// number of threads, worker processes give the same results
+//
+#include "simlib.h"
+
+// model objects are created by setup() for each replication
+struct Model {
+    Queue Q;
+    Facility F;
+    Stat time;
+    Histogram histo;
+    Model() : F("F", Q), histo("time in system", 0, 2, 10) {}
+};
+thread_local Model *model = 0;
+
+struct Customer : public Process {
+    void Behavior() {
+        double t0 = Time;
+        Seize(model->F);
+        Wait(Exponential(0.8));
+        Release(model->F);
+        model->time(Time - t0);
+        model->histo(Time - t0);
+    }
+};
+
+struct Generator : public Event {
+    void Behavior() {
+        (new Customer)->Activate();
+        Activate(Time + Exponential(1));
+    }
+};
+
+ReplicationStat r_time("time in system");
+ReplicationStat r_wait("queue length");
+ReplicationStat r_histo("time in system");
+ReplicationStat r_served("served customers");
+
+void setup(unsigned) {
+    Init(0, 1000);
+    model = new Model;
+    (new Generator)->Activate();
+}
+
+void collect(unsigned) {
+    r_time(model->time);
+    r_wait(model->Q.StatN);
+    r_histo(model->histo);
+    r_served(model->time.Number());
+    delete model;
+    model = 0;
+}
+
+struct Results {
+    double mean, sd, hw, pooled, wait, histo;
+};
+
+Results run(const char *title, unsigned threads, bool processes) {
+    r_time.Clear(); r_wait.Clear(); r_histo.Clear(); r_served.Clear();
+    RandomSeed(1234);
+    RunReplications(20, threads, setup, collect, processes);
+    Results r = { r_time.MeanValue(), r_time.StdDev(), r_time.HalfWidth(),
+                  r_time.Pooled().MeanValue(), r_wait.MeanValue(),
+                  r_histo.PooledHistogram()->stat.MeanValue() };
+    Print("%-22s: mean = %g +- %g\n", title, r.mean, r.hw);
+    return r;
+}
+
+bool same(const Results &a, const Results &b) {
+    return a.mean == b.mean && a.sd == b.sd && a.hw == b.hw &&
+           a.pooled == b.pooled && a.wait == b.wait && a.histo == b.histo;
+}
+
+int main() {
+    Print("replication-test\n");
+    Results r1 = run("1 thread", 1, false);
+    Results r4 = run("4 threads", 4, false);
+    Results rp = run("3 worker processes", 3, true);
+    Print("threads: %s\n", same(r1, r4) ? "identical" : "DIFFERENT");
+    Print("processes: %s\n", same(r1, rp) ? "identical" : "DIFFERENT");
+    r_time.Output();
+    r_wait.Output();
+    r_served.Output();
+    r_histo.Output();
+    return 0;
+}
@@ -0,0 +1,117 @@
+////////////////////////////////////////////////////////////////////////////
+// signal-test.cc
+//
+// signal-driven stop: signal raised in event is handled after the event
+// (action writes checkpoint, run is stopped), the restored run goes on
+//
+#include "simlib.h"
+#include <atomic>
+#include <csignal>
+
+const char *FILENAME = "signal-test.dat";
+
+Facility F("F");
+Stat served("time in system");
+
+class Customer : public StepProcess {
+    double t0;
+    void Behavior() {
+      STEP_BEGIN;
+        t0 = Time;
+        STEP_AWAIT(Seize(F));
+        STEP_AWAIT(Wait(Exponential(0.8)));
+        Release(F);
+        served(Time - t0);
+      STEP_END;
+    }
+    void SaveState(Checkpoint &c) const { c.Write(t0); }
+    void RestoreState(Checkpoint &c)    { c.Read(t0); }
+  public:
+    Customer() : t0(0) {}
+};
+CHECKPOINT_ENTITY(Customer);
+
+class Generator : public Event {
+    void Behavior() {
+        (new Customer)->Activate();
+        Activate(Time + Exponential(1));
+    }
+};
+CHECKPOINT_ENTITY(Generator);
+
+// "user" sends signal during simulation
+class Interrupt : public Event {
+    void Behavior() {
+        Print("raise SIGUSR1 at %g\n", Time);
+        std::raise(SIGUSR1);
+        Print("event finished\n");
+    }
+};
+
+void snapshot() {
+    Print("snapshot at %g\n", Time);
+    SaveCheckpoint(FILENAME, { &F, &served });
+}
+
+// replications in two threads: signal raised by replication 0 stops
+// both running replications (actions are inherited from main thread)
+std::atomic<bool> started1(false), raised(false);
+double end_time[4];
+
+class Step : public Event {
+    unsigned r;
+    void Behavior() {
+        if(r == 0 && Time == 50)
+            while(!started1) { /* wait for replication 1 */ }
+        if(r == 0 && Time == 100) {
+            std::raise(SIGUSR2);
+            raised = true;
+        }
+        if(r == 1 && Time == 1) {
+            started1 = true;
+            while(!raised) { /* wait for signal */ }
+        }
+        Activate(Time + 1);
+    }
+  public:
+    Step(unsigned i) : r(i) {}
+};
+
+void setup(unsigned i) {
+    Init(0, 100000);
+    (new Step(i))->Activate();
+}
+
+void collect(unsigned i) {
+    end_time[i] = Time;
+}
+
+int main() {
+    Print("signal-test\n");
+    OnSignal(SIGUSR1, snapshot);
+    RandomSeed(1234);
+    Init(0, 1000);
+    (new Generator)->Activate();
+    (new Interrupt)->Activate(300);
+    Run();
+    Print("stopped at %g (%s), served %lu\n", Time,
+          Time < 400 ? "ok" : "NOT STOPPED", served.Number());
+
+    // no action: signal is ignored by simulation
+    OnSignal(SIGUSR1, 0, false);
+    OnSignal(SIGUSR2, 0, true);
+    Init(0, 1000);
+    F.Clear(); served.Clear();
+    RestoreCheckpoint(FILENAME, { &F, &served });
+    Print("restored at %g\n", Time);
+    Run();
+    Print("end at %g, served %lu\n", Time, served.Number());
+    F.Output();
+
+    RunReplications(4, 2, setup, collect);
+    for(unsigned i = 0; i < 4; i++)
+        Print("replication %u: %s\n", i,
+              end_time[i] < 100000 ? "stopped" : "finished");
+    OnSignal(SIGUSR2, 0, false);
+    return 0;
+}
@@ -36,12 +36,15 @@ int main() {
   PRINT_SIZE(Entity) << ",  parent = Link" ;
   PRINT_SIZE(Process) << ",  parent = Entity" ;
   PRINT_SIZE(Event) << ",  parent = Entity" ;
+  PRINT_SIZE(StepProcess) << ",  parent = Event" ;
   PRINT_SIZE(Sampler) << ",  parent = Event" ;
   PRINT_SIZE(Stat) << ",  parent = SimObject" ;
   PRINT_SIZE(TStat) << ",  parent = SimObject" ;
   PRINT_SIZE(List) << ",  parent = SimObject" ;
   PRINT_SIZE(Queue) << ",  parent = List" ;
   PRINT_SIZE(Histogram) << ",  parent = SimObject" ;
+  PRINT_SIZE(ReplicationStat) << ",  parent = SimObject" ;
+  PRINT_SIZE(LogicalProcess) << ",  parent = SimObject" ;
   PRINT_SIZE(Facility) << ",  parent = SimObject" ;
   PRINT_SIZE(Store) << ",  parent = SimObject" ;
   PRINT_SIZE(aBlock) << ",  parent = SimObject" ;
@@ -79,6 +82,7 @@ int main() {
   PRINT_SIZE(Bisect) << ",  parent = AlgLoop" ;
   PRINT_SIZE(RegulaFalsi) << ",  parent = AlgLoop" ;
   PRINT_SIZE(Newton) << ",  parent = AlgLoop" ;
+  PRINT_SIZE(LoopVariable) << ",  parent = aContiBlock" ;
   PRINT_SIZE(Semaphore) << ",  parent = SimObject" ;
   PRINT_SIZE(Barrier) << ",  parent = SimObject" ;
 
@@ -0,0 +1,71 @@
+////////////////////////////////////////////////////////////////////////////
+// stepprocess-test.cc
+//
+// stackless processes: Facility, Store, Queue, Wait
+//
+#include "simlib.h"
+
+Facility  F("F");
+Store     S("S", 2);
+Queue     Q("Q");
+
+class Customer : public StepProcess {
+    int n;
+    double t0;          // state is in data members, not in locals
+    void Behavior() {
+      STEP_BEGIN;
+        t0 = Time;
+        Print("%d: start at %g\n", n, Time);
+        STEP_AWAIT(Enter(S, 1));
+        Print("%d: entered S at %g\n", n, Time);
+        STEP_AWAIT(Seize(F));
+        Print("%d: seized F at %g\n", n, Time);
+        STEP_AWAIT(Wait(Exponential(2)));
+        Release(F);
+        STEP_AWAIT(Wait(Uniform(1, 3)));
+        Leave(S, 1);
+        if(n % 3 == 0) {        // some customers wait for signal
+            Into(Q);
+            Passivate();
+            STEP_YIELD();
+            Print("%d: signaled at %g\n", n, Time);
+        }
+        Print("%d: end at %g, time in system %g\n", n, Time, Time - t0);
+      STEP_END;
+    }
+  public:
+    Customer(int i) : n(i) {}
+    ~Customer() { Print("%d: delete at %g\n", n, Time); }
+};
+
+class Signal : public Event {
+    void Behavior() {
+        if(!Q.Empty())
+            Q.GetFirst()->Activate();
+        Activate(Time + 5);
+    }
+};
+
+class Generator : public Event {
+    int num;
+    void Behavior() {
+        (new Customer(++num))->Activate();
+        if(num < 20)
+            Activate(Time + Exponential(1));
+    }
+  public:
+    Generator() : num(0) {}
+};
+
+int main() {
+    Print("stepprocess-test\n");
+    RandomSeed(12345);
+    Init(0, 100);
+    (new Generator)->Activate();
+    (new Signal)->Activate();
+    Run();
+    F.Output();
+    S.Output();
+    Q.Output();
+    return 0;
+}
@@ -0,0 +1,54 @@
+////////////////////////////////////////////////////////////////////////////
+// stiff-test.cc
+//
+// Robertson's chemical reaction (stiff system): methods for stiff systems
+// with Jacobian from evaluation tape and by differences (model evaluated
+// by Value() calls), compared with explicit method
+//
+#include "simlib.h"
+
+long evaluations = 0;
+
+// user block: input is evaluated by Value() (not compiled)
+class Opaque : public aContiBlock1 {
+  public:
+    explicit Opaque(Input i) : aContiBlock1(i) {}
+    double Value() override { evaluations++; return InputValue(); }
+};
+
+struct Robertson {
+    Integrator y1, y2, y3;
+    Robertson(bool opaque) : y1(Input(0.0), 1.0), y2(Input(0.0)), y3(Input(0.0)) {
+        Input i1 = -0.04 * Input(y1) + 1e4 * Input(y2) * Input(y3);
+        Input i3 = 3e7 * Input(y2) * Input(y2);
+        Input i2 = 0.04 * Input(y1) - 1e4 * Input(y2) * Input(y3) - i3;
+        y1.SetInput(opaque ? Input(new Opaque(i1)) : i1);
+        y2.SetInput(opaque ? Input(new Opaque(i2)) : i2);
+        y3.SetInput(opaque ? Input(new Opaque(i3)) : i3);
+    }
+};
+
+long run(const char *method, bool opaque) {
+    Robertson r(opaque);
+    evaluations = 0;
+    SetMethod(method);
+    SetStep(1e-12, 10);
+    SetAccuracy(1e-10, 1e-6);
+    Init(0, 40);
+    Run();
+    Print("%-4s %-11s y1 = %.5f  y2 = %.4e  y3 = %.5f\n", method,
+          opaque ? "differences" : "tape", r.y1.Value(), r.y2.Value(), r.y3.Value());
+    return evaluations / 3;
+}
+
+int main() {
+    Print("stiff-test\n");
+    run("bdf", false);
+    run("ros4", false);
+    long bdf = run("bdf", true);
+    long ros4 = run("ros4", true);
+    long rkf5 = run("rkf5", true);
+    Print("bdf  needs %s evaluations than rkf5\n", 20 * bdf < rkf5 ? "much less" : "NOT LESS");
+    Print("ros4 needs %s evaluations than rkf5\n", 20 * ros4 < rkf5 ? "much less" : "NOT LESS");
+    return 0;
+}
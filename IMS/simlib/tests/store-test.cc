@@ -0,0 +1,103 @@
+////////////////////////////////////////////////////////////////////////////
+// store-test.cc
+//
+// store with requests of different capacity and priority: own (indexed)
+// input queue gives the same results as external queue (scan of queue),
+// also if priority of waiting entity changes
+//
+#include "simlib.h"
+
+const unsigned long CAPS[] = { 1, 2, 5, 20, 60, 100 };
+
+Queue ext("external queue");
+Store S1("indexed store", 100);
+Store S2("scanned store", 100, &ext);
+Stat wait1("waiting time (indexed)");
+Stat wait2("waiting time (scanned)");
+Store *S;
+Stat *W;
+
+class Customer : public Process {
+    unsigned long cap;
+    void Behavior() {
+        double t0 = Time;
+        Enter(*S, cap);
+        (*W)(Time - t0);
+        Wait(Exponential(2));
+        Leave(*S, cap);
+    }
+  public:
+    Customer(Priority_t p, unsigned long c) : Process(p), cap(c) {}
+};
+
+class Generator : public Event {
+    void Behavior() {
+        (new Customer(Priority_t(Random()*3), CAPS[int(Random()*6)]))->Activate();
+        Activate(Time + Exponential(0.1));
+    }
+};
+
+void run(Store &s, Stat &w) {
+    S = &s; W = &w;
+    RandomSeed(1234);
+    Init(0, 2000);
+    s.Clear(); w.Clear(); ext.Clear();
+    (new Generator)->Activate();
+    Run();
+    s.Output();
+    w.Output();
+}
+
+// A (priority 0) waits, is raised to priority 5, then B (priority 3)
+// waits: A gets the capacity first
+Queue ext2("external queue");
+Store T1("indexed store", 1);
+Store T2("scanned store", 1, &ext2);
+Store *PS;
+char order[3];
+class User : public Process {
+    char name;
+    double t;
+    void Behavior() {
+        Wait(t);
+        Enter(*PS, 1);
+        order[name == 'H' ? 0 : order[1] ? 2 : 1] = name;
+        Wait(10);
+        Leave(*PS, 1);
+    }
+  public:
+    User(char n, Priority_t p, double t0) : Process(p), name(n), t(t0) {}
+};
+class Raise : public Event {
+    Process *p;
+    void Behavior() { p->Priority = 5; }
+  public:
+    Raise(Process *a) : p(a) {}
+};
+
+const char *priority_test(Store &s) {
+    PS = &s;
+    order[0] = order[1] = order[2] = 0;
+    Init(0, 100);
+    s.Clear(); ext2.Clear();
+    (new User('H', 0, 0))->Activate();
+    Process *a = new User('A', 0, 1);
+    a->Activate();
+    (new Raise(a))->Activate(2);
+    (new User('B', 3, 3))->Activate();
+    Run();
+    return order[1] == 'A' && order[2] == 'B' ? "A B" : "B A";
+}
+
+int main() {
+    Print("store-test\n");
+    run(S1, wait1);
+    run(S2, wait2);
+    bool same = wait1.Number() == wait2.Number() &&
+                wait1.MeanValue() == wait2.MeanValue() &&
+                S1.QueueLen() == S2.QueueLen();
+    Print("indexed and scanned queue: %s\n", same ? "identical" : "DIFFERENT");
+    Print("priority raised while waiting: indexed %s, scanned %s\n",
+          priority_test(T1), priority_test(T2));
+    return 0;
+}
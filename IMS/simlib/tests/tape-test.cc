@@ -0,0 +1,70 @@
+////////////////////////////////////////////////////////////////////////////
+// tape-test.cc
+//
+// heat conduction in rod (N integrators, shared expressions, functions,
+// variable changed by event): model evaluated by evaluation tape gives
+// the same results as the same model evaluated by Value() calls
+//
+#include "simlib.h"
+#include <cmath>
+
+const int N = 200;
+
+// user block: input is evaluated by Value() (not compiled)
+class Opaque : public aContiBlock1 {
+  public:
+    explicit Opaque(Input i) : aContiBlock1(i) {}
+    double Value() override { return InputValue(); }
+};
+
+double heater(double t) { return std::sin(t) > 0 ? 1 : 0; }
+double period(double t, double p) { return std::fmod(t, p); }
+
+struct Rod {
+    Integrator *u[N];
+    Variable power;
+    Parameter k;
+    Rod(bool opaque) : power(1), k(50) {
+        for(int i = 0; i < N; i++)
+            u[i] = new Integrator;
+        Expression *loss = new Expression(0.01 * Input(new Function2(T, 1.0, period)));
+        for(int i = 0; i < N; i++) {
+            Input left  = i > 0   ? Input(u[i-1]) : Input(u[i]);
+            Input right = i < N-1 ? Input(u[i+1]) : Input(u[i]);
+            Input in = k * (left - 2 * Input(u[i]) + right) / 2.0 - *loss;
+            if(i == 0)
+                in = in + power * Input(new Function1(T, heater));
+            u[i]->SetInput(opaque ? Input(new Opaque(in)) : in);
+        }
+    }
+};
+
+Rod *compiled, *reference;
+
+class Switch : public Event {
+    void Behavior() {
+        double p = compiled->power.Value() > 1 ? 1 : 3;
+        compiled->power = p;
+        reference->power = p;
+        Activate(Time + 2.5);
+    }
+};
+
+int main() {
+    Print("tape-test\n");
+    compiled = new Rod(false);
+    reference = new Rod(true);
+    SetStep(1e-6, 0.1);
+    SetAccuracy(1e-8, 1e-6);
+    Init(0, 20);
+    (new Switch)->Activate(1);
+    Run();
+    bool same = true;
+    for(int i = 0; i < N; i++)
+        if(compiled->u[i]->Value() != reference->u[i]->Value())
+            same = false;
+    for(int i = 0; i < N; i += 40)
+        Print("u[%d] = %.10f\n", i, compiled->u[i]->Value());
+    Print("tape and Value() evaluation: %s\n", same ? "identical" : "DIFFERENT");
+    return 0;
+}
@@ -0,0 +1,91 @@
+////////////////////////////////////////////////////////////////////////////
+// thread-test.cc
+//
+// independent simulation experiments in parallel threads
+// (each thread has own simulation context), names of objects are
+// visible in all threads
+//
+#include "simlib.h"
+#include <string>
+#include <thread>
+#include <vector>
+
+Stat shared("shared statistics");       // named by main thread
+
+// discrete part
+struct Customer : public Process {
+    Facility &f;
+    Stat &st;
+    void Behavior() {
+        double t0 = Time;
+        Seize(f);
+        Wait(Exponential(0.8));
+        Release(f);
+        st(Time - t0);
+    }
+    Customer(Facility &ff, Stat &s) : f(ff), st(s) {}
+};
+
+struct Generator : public Event {
+    Facility &f;
+    Stat &st;
+    int n;
+    void Behavior() {
+        (new Customer(f, st))->Activate();
+        if(++n < 2000)
+            Activate(Time + Exponential(1));
+    }
+    Generator(Facility &ff, Stat &s) : f(ff), st(s), n(0) {}
+};
+
+struct Result {
+    double mean, wait, y, t;
+    unsigned long events;
+    std::string names;
+};
+
+// the model: all objects are local to the experiment
+void experiment(long seed, Result &r) {
+    RandomSeed(seed);
+    Init(0, 2500);
+    Queue Q("Q");
+    Facility F("F", Q);
+    Stat st("time in system");
+    Integrator v(-0.001*v, 1);  // continuous part: exp(-0.001 t)
+    Integrator y(v);
+    SetStep(1e-3, 0.5);
+    (new Generator(F, st))->Activate();
+    Run();
+    r.mean = st.MeanValue();
+    r.wait = Q.StatDT.MeanValue();
+    r.y = y.Value();
+    r.t = Time;
+    r.events = SIMLIB_statistics.EventCount;
+    r.names = F.Name() + ", " + shared.Name();
+}
+
+int main() {
+    Print("thread-test\n");
+    const int N = 4;
+    Result seq[N], par[N];
+
+    for(int i = 0; i < N; i++)          // sequential
+        experiment(1000 + i, seq[i]);
+
+    std::vector<std::thread> threads;   // parallel
+    for(int i = 0; i < N; i++)
+        threads.emplace_back(experiment, 1000 + i, std::ref(par[i]));
+    for(auto &t : threads)
+        t.join();
+
+    for(int i = 0; i < N; i++) {
+        Print("seed %ld: mean=%g wait=%g y=%g Time=%g events=%lu\n",
+              1000L + i, seq[i].mean, seq[i].wait, seq[i].y, seq[i].t,
+              seq[i].events);
+        bool same = seq[i].mean == par[i].mean && seq[i].wait == par[i].wait &&
+                    seq[i].y == par[i].y && seq[i].events == par[i].events;
+        Print("  parallel run: %s\n", same ? "identical" : "DIFFERENT");
+        Print("  names in thread: %s\n", par[i].names.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,104 @@
+////////////////////////////////////////////////////////////////////////////
+// trace-test.cc
+//
+// trace recording (TraceStart) and export to Chrome trace format
+//
+#include "simlib.h"
+#include <cstdio>
+#include <cstring>
+
+Facility  F("F");
+Store     S("S", 2);
+
+class Customer : public Process {
+    void Behavior() {
+        Enter(S, 1);
+        Seize(F);
+        Wait(2);
+        Release(F);
+        Wait(1);
+        Leave(S, 1);
+    }
+};
+
+class Generator : public Event {
+    int n;
+    void Behavior() {
+        (new Customer)->Activate();
+        if(++n < 4)
+            Activate(Time + 1);
+    }
+  public:
+    Generator() : n(0) {}
+};
+
+void experiment(unsigned long records) {
+    TraceStart(records);
+    Init(0, 100);
+    F.Clear();
+    S.Clear();
+    (new Generator)->Activate();
+    Run();
+    TraceStop();
+    TraceExport("trace-test.json");
+}
+
+// many short-lived entities (names are kept for records in buffer only)
+class Short : public Event {
+    int n;
+    void Behavior() {
+        if(n > 0)
+            (new Short(n - 1))->Activate(Time + 1);
+    }
+  public:
+    Short(int k) : n(k) {}
+};
+
+// number of names of entities and objects in exported file
+void count_names(const char *name) {
+    FILE *f = std::fopen(name, "r");
+    char line[1000];
+    int entities = 0, objects = 0;
+    while(f && std::fgets(line, sizeof(line), f)) {
+        if(std::strstr(line, "\"thread_name\",\"ph\":\"M\",\"pid\":1"))
+            entities++;
+        if(std::strstr(line, "\"thread_name\",\"ph\":\"M\",\"pid\":2"))
+            objects++;
+    }
+    if(f)
+        std::fclose(f);
+    Print("names: %d entities, %d objects\n", entities, objects);
+}
+
+// print exported file
+void print_file(const char *name, bool header_only) {
+    FILE *f = std::fopen(name, "r");
+    char line[1000];
+    while(f && std::fgets(line, sizeof(line), f)) {
+        Print("%s", line);
+        if(header_only && line[0] == '"')
+            break;
+    }
+    if(f)
+        std::fclose(f);
+}
+
+int main() {
+    Print("trace-test\n");
+    experiment(1000);
+    print_file("trace-test.json", false);
+    Print("\n===== ring buffer of 10 records =====\n");
+    experiment(10);
+    print_file("trace-test.json", true);
+    count_names("trace-test.json");
+    Print("\n===== 10000 entities, ring buffer of 50 records =====\n");
+    TraceStart(50);
+    Init(0, 100000);
+    (new Short(10000))->Activate();
+    Run();
+    TraceStop();
+    TraceExport("trace-test.json");
+    print_file("trace-test.json", true);
+    count_names("trace-test.json");
+    return 0;
+}
@@ -0,0 +1,92 @@
+////////////////////////////////////////////////////////////////////////////
+// ziggurat-test.cc               SIMLIB/C++
+//
+// Test of Normal() and Exponential() (ziggurat method): moments are
+// compared with the previous implementations and exact values
+//
+
+#include "simlib.h"
+#include <cmath>
+
+// previous implementations
+static double OldNormal(double mi, double sigma)
+{
+  double sum = 0.0;
+  for(int i = 0; i < 12; i++)
+    sum += Random();
+  return (sum - 6.0)*sigma + mi;
+}
+
+static double OldExponential(double mv)
+{
+  return -mv * log(1.0 - Random());
+}
+
+// base generator counting calls
+static unsigned long calls = 0;
+static RandomStream counted(1);
+static double CountedRandom()
+{
+  calls++;
+  return counted.Random();
+}
+
+// moments of n samples: mean, variance, skewness, kurtosis, P(x > limit)
+static void Moments(const char *name, double (*gen)(double, double),
+                    double a, double b, double limit)
+{
+  const int n = 2000000;
+  double s1 = 0, s2 = 0, s3 = 0, s4 = 0;
+  long over = 0;
+  calls = 0;
+  for(int i = 0; i < n; i++) {
+    double x = gen(a, b);
+    s1 += x; s2 += x*x; s3 += x*x*x; s4 += x*x*x*x;
+    if(x > limit)
+      over++;
+  }
+  double m = s1/n;
+  double v = s2/n - m*m;
+  double m3 = s3/n - 3*m*s2/n + 2*m*m*m;
+  double m4 = s4/n - 4*m*s3/n + 6*m*m*s2/n - 3*m*m*m*m;
+  Print("%-16s mean %6.3f  var %6.3f  skew %6.3f  kurt %6.3f"
+        "  P(x>%g) %.5f  uniforms %.3f\n", name, m, v, m3/pow(v, 1.5),
+        m4/(v*v), limit, double(over)/n, double(calls)/n);
+}
+
+static double Normal01(double, double) { return Normal(0, 1); }
+static double OldNormal01(double, double) { return OldNormal(0, 1); }
+static double Exponential1(double, double) { return Exponential(1); }
+static double OldExponential1(double, double) { return OldExponential(1); }
+static double NormalMS(double m, double s) { return Normal(m, s); }
+static double ExponentialM(double m, double) { return Exponential(m); }
+
+int main()
+{
+  SetOutput("ziggurat-test.out");
+  Print("Test of ziggurat Normal() and Exponential()\n");
+  SetBaseRandomGenerator(CountedRandom);
+  Print("exact N(0,1)     mean  0.000  var  1.000  skew  0.000  kurt  3.000"
+        "  P(x>3) %.5f\n", 0.5*erfc(3/sqrt(2.0)));
+  Moments("Normal(0,1)", Normal01, 0, 1, 3);
+  Moments("old Normal(0,1)", OldNormal01, 0, 1, 3);
+  Moments("Normal(10,2)", NormalMS, 10, 2, 16);
+  Print("exact Exp(1)     mean  1.000  var  1.000  skew  2.000  kurt  9.000"
+        "  P(x>8) %.5f\n", exp(-8.0));
+  Moments("Exponential(1)", Exponential1, 0, 0, 8);
+  Moments("old Exp(1)", OldExponential1, 0, 0, 8);
+  Moments("Exponential(5)", ExponentialM, 5, 0, 40);
+  SetBaseRandomGenerator(0);
+
+  // far tails (layer 0 of ziggurat)
+  RandomSeed(99);
+  long n4 = 0, n12 = 0;
+  const long n = 10000000;
+  for(long i = 0; i < n; i++) {
+    if(fabs(Normal(0, 1)) > 4) n4++;
+    if(Exponential(1) > 12) n12++;
+  }
+  Print("P(|N|>4)  %.2e (exact %.2e)\n", double(n4)/n, erfc(4/sqrt(2.0)));
+  Print("P(E>12)   %.2e (exact %.2e)\n", double(n12)/n, exp(-12.0));
+  return 0;
+}